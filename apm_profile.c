@@ -0,0 +1,85 @@
+#include "apm_profile.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static const ApmProfile presets[] = {
+    // Old fixed setup: AEC only, nothing that costs CPU or colours the voice
+    { "low-cpu",  APM_LEVEL_LOW,      APM_LEVEL_OFF,      APM_AGC_OFF,      0 },
+    { "standard", APM_LEVEL_MODERATE, APM_LEVEL_MODERATE, APM_AGC_OFF,      1 },
+    // Conference rooms: loud echo, fans, people far from the microphone
+    { "full",     APM_LEVEL_HIGH,     APM_LEVEL_HIGH,     APM_AGC_ADAPTIVE, 1 },
+};
+
+#define PRESET_COUNT (sizeof(presets) / sizeof(presets[0]))
+
+static const char* const level_names[] = { "off", "low", "moderate", "high", "very-high" };
+static const char* const agc_names[] = { "off", "adaptive", "fixed" };
+
+int apm_profile_preset(const char* name, ApmProfile* profile) {
+    if (!name || !profile) return -1;
+    for (size_t i = 0; i < PRESET_COUNT; i++) {
+        if (strcmp(name, presets[i].name) == 0) {
+            *profile = presets[i];
+            return 0;
+        }
+    }
+    return -1;
+}
+
+const char* const* apm_profile_names(void) {
+    static const char* names[PRESET_COUNT + 1];
+    for (size_t i = 0; i < PRESET_COUNT; i++) names[i] = presets[i].name;
+    names[PRESET_COUNT] = NULL;
+    return names;
+}
+
+void apm_profile_clamp(ApmProfile* profile) {
+    if (!profile) return;
+    // The echo canceller has no "off" level; disabling it is "echo_cancellation"
+    if (profile->echo_suppression < APM_LEVEL_LOW) profile->echo_suppression = APM_LEVEL_LOW;
+    if (profile->echo_suppression > APM_LEVEL_HIGH) profile->echo_suppression = APM_LEVEL_HIGH;
+    if (profile->noise_suppression < APM_LEVEL_OFF) profile->noise_suppression = APM_LEVEL_OFF;
+    if (profile->noise_suppression > APM_LEVEL_VERY_HIGH) profile->noise_suppression = APM_LEVEL_VERY_HIGH;
+    if (profile->agc < APM_AGC_OFF || profile->agc > APM_AGC_FIXED) profile->agc = APM_AGC_OFF;
+    profile->high_pass = profile->high_pass ? 1 : 0;
+    profile->name[sizeof(profile->name) - 1] = '\0';
+}
+
+const char* apm_level_name(int level) {
+    if (level < APM_LEVEL_OFF || level > APM_LEVEL_VERY_HIGH) return "?";
+    return level_names[level];
+}
+
+int apm_level_from_name(const char* name) {
+    if (!name) return -1;
+    for (int i = 0; i <= APM_LEVEL_VERY_HIGH; i++) {
+        if (strcmp(name, level_names[i]) == 0) return i;
+    }
+    return -1;
+}
+
+const char* apm_agc_name(int agc) {
+    if (agc < APM_AGC_OFF || agc > APM_AGC_FIXED) return "?";
+    return agc_names[agc];
+}
+
+int apm_agc_from_name(const char* name) {
+    if (!name) return -1;
+    for (int i = 0; i <= APM_AGC_FIXED; i++) {
+        if (strcmp(name, agc_names[i]) == 0) return i;
+    }
+    return -1;
+}
+
+void apm_profile_format(const ApmProfile* profile, char* buf, size_t len) {
+    if (!buf || !len) return;
+    if (!profile) {
+        snprintf(buf, len, "none");
+        return;
+    }
+    snprintf(buf, len, "%s (AEC %s, NS %s, AGC %s, HPF %s)",
+             profile->name[0] ? profile->name : "custom",
+             apm_level_name(profile->echo_suppression), apm_level_name(profile->noise_suppression),
+             apm_agc_name(profile->agc), profile->high_pass ? "on" : "off");
+}
@@ -0,0 +1,63 @@
+#ifndef APM_PROFILE_H
+#define APM_PROFILE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+// Audio processing profile for the microphone path: how hard the WebRTC
+// APM works on each call. Plain data so the GUI and tools can parse and
+// save it without the WebRTC headers; the sample rate follows the codec
+// (CVSD 8 kHz, mSBC 16 kHz).
+
+// Suppression levels (echo: LOW..HIGH, noise: OFF..VERY_HIGH)
+#define APM_LEVEL_OFF 0
+#define APM_LEVEL_LOW 1
+#define APM_LEVEL_MODERATE 2
+#define APM_LEVEL_HIGH 3
+#define APM_LEVEL_VERY_HIGH 4
+
+// Automatic gain control
+#define APM_AGC_OFF 0
+#define APM_AGC_ADAPTIVE 1               // Adaptive digital
+#define APM_AGC_FIXED 2                  // Fixed digital gain + limiter
+
+#define APM_PROFILE_DEFAULT "low-cpu"
+
+typedef struct {
+    char name[16];                       // Preset name or "custom"
+    int echo_suppression;                // APM_LEVEL_LOW..HIGH
+    int noise_suppression;               // APM_LEVEL_OFF..VERY_HIGH
+    int agc;                             // APM_AGC_*
+    int high_pass;                       // 0/1
+} ApmProfile;
+
+// Presets: "low-cpu" (AEC only, low suppression), "standard", "full"
+// (high AEC + NS, adaptive AGC, high-pass filter)
+// Returns 0 if name is a preset, -1 otherwise (profile left unchanged)
+int apm_profile_preset(const char* name, ApmProfile* profile);
+
+// NULL-terminated list of preset names, for menus
+const char* const* apm_profile_names(void);
+
+// Bring every field into its valid range
+void apm_profile_clamp(ApmProfile* profile);
+
+// "off", "low", "moderate", "high", "very-high" and back (-1 = unknown)
+const char* apm_level_name(int level);
+int apm_level_from_name(const char* name);
+
+// "off", "adaptive", "fixed" and back (-1 = unknown)
+const char* apm_agc_name(int agc);
+int apm_agc_from_name(const char* name);
+
+// "full (AEC high, NS high, AGC adaptive, HPF on)"
+void apm_profile_format(const ApmProfile* profile, char* buf, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // APM_PROFILE_H
@@ -0,0 +1,624 @@
+#include "at_engine.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#define AT_WAIT_SLICE_MS 50          // at_engine_command() re-checks timeouts this often
+
+typedef struct {
+    char command[AT_COMMAND_MAX];
+    int timeout_ms;
+    AtCallback callback;
+    void *user_data;
+} AtCommand;
+
+// A finished command, delivered after the lock is dropped
+typedef struct {
+    AtCallback callback;
+    void *user_data;
+    char command[AT_COMMAND_MAX];
+    char info[AT_INFO_MAX];
+    AtResult result;
+    int cme_error;
+    double rtt_ms;
+    int timeout_ms;
+} AtCompletion;
+
+struct AtEngine {
+    AtEngineConfig cfg;
+    char name[16];
+
+    pthread_mutex_t lock;
+    pthread_cond_t cond;             // Completions and the end of a pump
+    int fd;
+    int dead;                        // A write failed: detach at the next chance
+    char out[AT_COMMAND_MAX + 1];    // Command written in part, the rest waits for POLLOUT
+    size_t out_len;
+    size_t out_off;
+    int write_wait;                  // on_write_wait(1) told, not yet (0)
+    int pumping;
+    pthread_t pumper;
+    int timer_fd;                    // Deadline of the command in flight (event loop)
+    int has_loop_thread;
+    pthread_t loop_thread;           // Last thread in at_engine_process()
+
+    AtCommand queue[AT_QUEUE_MAX];
+    int head;
+    int count;
+    int in_flight;                   // queue[head] is written, waiting for its result
+    int64_t sent_us;
+    int64_t deadline_us;
+    char prefix[24];                 // Information line prefix of the command in flight
+    int call_control;                // The command in flight is ATD / ATA
+    char info[AT_INFO_MAX];
+    size_t info_len;
+
+    AtRecordCallback handlers[AT_KW_COUNT];
+    AtFramer *framer;                // Pumping thread only
+
+    AtEngineStats stats;
+    uint64_t answered;               // Completions with a result code, for the average
+};
+
+static int64_t monotonic_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void timed_wait(AtEngine *at, int ms) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    ts.tv_sec += ms / 1000;
+    ts.tv_nsec += (long)(ms % 1000) * 1000000L;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+    pthread_cond_timedwait(&at->cond, &at->lock, &ts);
+}
+
+static void log_fmt(AtEngine *at, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+static void log_fmt(AtEngine *at, const char *fmt, ...) {
+    if (!at->cfg.log) return;
+    char msg[256];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(msg, sizeof(msg), fmt, ap);
+    va_end(ap);
+    at->cfg.log(msg, at->cfg.user_data);
+}
+
+// "AT+CIND=?" -> "+CIND"; commands without + have no information lines
+static void command_prefix(const char *command, char *prefix, size_t len) {
+    prefix[0] = '\0';
+    if (strncmp(command, "AT+", 3) != 0) return;
+    size_t n = 0;
+    for (const char *p = command + 2; *p && *p != '=' && *p != '?' && n + 1 < len; p++) {
+        prefix[n++] = *p;
+    }
+    prefix[n] = '\0';
+}
+
+static AtResult keyword_result(AtKeyword keyword) {
+    switch (keyword) {
+        case AT_KW_OK: return AT_RESULT_OK;
+        case AT_KW_CME_ERROR: return AT_RESULT_CME_ERROR;
+        case AT_KW_NO_CARRIER: return AT_RESULT_NO_CARRIER;
+        case AT_KW_BUSY: return AT_RESULT_BUSY;
+        case AT_KW_NO_ANSWER: return AT_RESULT_NO_ANSWER;
+        default: return AT_RESULT_ERROR;
+    }
+}
+
+static void arm_timer(AtEngine *at, int timeout_ms) {
+    if (at->timer_fd < 0) return;
+    struct itimerspec its = {
+        .it_value = { .tv_sec = timeout_ms / 1000, .tv_nsec = (long)(timeout_ms % 1000) * 1000000L },
+    };
+    timerfd_settime(at->timer_fd, 0, &its, NULL);
+}
+
+static void write_wait_locked(AtEngine *at, int wait) {
+    if (at->write_wait == wait) return;
+    at->write_wait = wait;
+    if (at->cfg.on_write_wait) at->cfg.on_write_wait(at->fd, wait, at->cfg.user_data);
+}
+
+// Write what the socket takes now, never blocking: on EAGAIN the rest
+// waits for the fd to be writable. Returns 0, -1 if the link failed
+static int flush_locked(AtEngine *at) {
+    while (at->out_off < at->out_len) {
+        ssize_t n = send(at->fd, at->out + at->out_off, at->out_len - at->out_off,
+                         MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                write_wait_locked(at, 1);
+                return 0;
+            }
+            at->dead = 1;
+            at->out_len = at->out_off = 0;
+            return -1;
+        }
+        at->out_off += (size_t)n;
+    }
+    at->out_len = at->out_off = 0;
+    write_wait_locked(at, 0);
+    return 0;
+}
+
+// Write the head of the queue if nothing is in flight. A command that
+// timed out half written is finished first, the AG must see whole lines
+static void start_locked(AtEngine *at) {
+    if (at->in_flight || at->count == 0 || at->fd < 0 || at->dead || at->out_len) return;
+
+    AtCommand *c = &at->queue[at->head];
+    at->out_len = (size_t)snprintf(at->out, sizeof(at->out), "%s\r", c->command);
+    at->out_off = 0;
+    if (flush_locked(at) < 0) return;
+    at->in_flight = 1;
+    at->sent_us = monotonic_us();
+    at->deadline_us = at->sent_us + (int64_t)c->timeout_ms * 1000;
+    arm_timer(at, c->timeout_ms);
+    command_prefix(c->command, at->prefix, sizeof(at->prefix));
+    at->call_control = strncmp(c->command, "ATD", 3) == 0 || strcmp(c->command, "ATA") == 0;
+    at->info[0] = '\0';
+    at->info_len = 0;
+}
+
+// Pop the head into done and start the next command
+static void finish_locked(AtEngine *at, AtResult result, int cme_error, AtCompletion *done) {
+    AtCommand *c = &at->queue[at->head];
+    done->callback = c->callback;
+    done->user_data = c->user_data;
+    done->result = result;
+    done->cme_error = cme_error;
+    done->timeout_ms = c->timeout_ms;
+    memcpy(done->command, c->command, sizeof(done->command));
+    done->info[0] = '\0';
+    done->rtt_ms = 0.0;
+
+    if (at->in_flight) {
+        memcpy(done->info, at->info, at->info_len + 1);
+        done->rtt_ms = (monotonic_us() - at->sent_us) / 1000.0;
+    }
+
+    AtEngineStats *st = &at->stats;
+    st->commands++;
+    if (result == AT_RESULT_TIMEOUT) st->timeouts++;
+    if (result == AT_RESULT_ERROR || result == AT_RESULT_CME_ERROR) st->errors++;
+    if (at->in_flight && result != AT_RESULT_TIMEOUT && result != AT_RESULT_CLOSED) {
+        at->answered++;
+        st->rtt_avg_ms += (done->rtt_ms - st->rtt_avg_ms) / (double)at->answered;
+        if (done->rtt_ms > st->rtt_max_ms) st->rtt_max_ms = done->rtt_ms;
+    }
+
+    if (at->in_flight) arm_timer(at, 0);
+    at->in_flight = 0;
+    at->prefix[0] = '\0';
+    at->head = (at->head + 1) % AT_QUEUE_MAX;
+    at->count--;
+    start_locked(at);
+    pthread_cond_broadcast(&at->cond);
+}
+
+static void deliver(AtEngine *at, AtCompletion *done) {
+    switch (done->result) {
+        case AT_RESULT_OK:
+            log_fmt(at, "⏱️ [%s] %s: OK in %.1f ms", at->name, done->command, done->rtt_ms);
+            break;
+        case AT_RESULT_TIMEOUT:
+            log_fmt(at, "⚠️ [%s] %s: no response in %d ms", at->name, done->command, done->timeout_ms);
+            break;
+        case AT_RESULT_CLOSED:
+            log_fmt(at, "⚠️ [%s] %s: link closed", at->name, done->command);
+            break;
+        case AT_RESULT_CME_ERROR:
+            log_fmt(at, "⚠️ [%s] %s: +CME ERROR %d in %.1f ms", at->name, done->command,
+                    done->cme_error, done->rtt_ms);
+            break;
+        default:
+            log_fmt(at, "⚠️ [%s] %s: %s in %.1f ms", at->name, done->command,
+                    at_result_name(done->result), done->rtt_ms);
+            break;
+    }
+
+    if (!done->callback) return;
+    AtResponse resp = {
+        .command = done->command,
+        .result = done->result,
+        .cme_error = done->cme_error,
+        .info = done->info,
+        .rtt_ms = done->rtt_ms,
+    };
+    done->callback(&resp, done->user_data);
+}
+
+// Time out the command in flight
+static void expire(AtEngine *at) {
+    AtCompletion done;
+    pthread_mutex_lock(&at->lock);
+    int due = at->in_flight && monotonic_us() >= at->deadline_us;
+    if (due) finish_locked(at, AT_RESULT_TIMEOUT, -1, &done);
+    pthread_mutex_unlock(&at->lock);
+    if (due) deliver(at, &done);
+}
+
+// NO CARRIER / BUSY / NO ANSWER end ATD or ATA; during any other command
+// they report the call ending and go to the handlers
+static int ends_command(const AtEngine *at, const AtRecord *rec) {
+    if (!rec->final) return 0;
+    switch (rec->keyword) {
+        case AT_KW_NO_CARRIER:
+        case AT_KW_BUSY:
+        case AT_KW_NO_ANSWER:
+            return at->call_control;
+        default:
+            return 1;
+    }
+}
+
+static void dispatch(AtEngine *at, const AtRecord *rec) {
+    AtCompletion done;
+
+    pthread_mutex_lock(&at->lock);
+    if (at->in_flight && ends_command(at, rec)) {
+        int cme_error = rec->keyword == AT_KW_CME_ERROR ? atoi(rec->args) : -1;
+        finish_locked(at, keyword_result(rec->keyword), cme_error, &done);
+        pthread_mutex_unlock(&at->lock);
+        deliver(at, &done);
+        return;
+    }
+
+    size_t plen = strlen(at->prefix);
+    if (at->in_flight && plen && strncmp(rec->line, at->prefix, plen) == 0 && rec->line[plen] == ':') {
+        int w = snprintf(at->info + at->info_len, sizeof(at->info) - at->info_len, "%s%s",
+                         at->info_len ? "\n" : "", rec->line);
+        if (w > 0) {
+            at->info_len += (size_t)w;
+            if (at->info_len >= sizeof(at->info)) at->info_len = sizeof(at->info) - 1;
+        }
+        pthread_mutex_unlock(&at->lock);
+        return;
+    }
+
+    at->stats.unsolicited++;
+    pthread_mutex_unlock(&at->lock);
+    if (at->cfg.on_unsolicited) at->cfg.on_unsolicited(rec, at->cfg.user_data);
+    if (at->handlers[rec->keyword]) at->handlers[rec->keyword](rec, at->cfg.user_data);
+}
+
+AtEngine* at_engine_create(const AtEngineConfig* config) {
+    AtEngine *at = calloc(1, sizeof(AtEngine));
+    if (!at) return NULL;
+    if (config) at->cfg = *config;
+    snprintf(at->name, sizeof(at->name), "%s", at->cfg.name ? at->cfg.name : "at");
+    at->cfg.name = at->name;
+    at->cfg.handlers = NULL;
+    at->fd = -1;
+    at->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    for (int i = 0; config && i < config->handler_count; i++) {
+        const AtHandler *h = &config->handlers[i];
+        if (h->keyword >= 0 && h->keyword < AT_KW_COUNT) at->handlers[h->keyword] = h->handler;
+    }
+    at->framer = at_framer_create();
+    if (!at->framer) {
+        if (at->timer_fd >= 0) close(at->timer_fd);
+        free(at);
+        return NULL;
+    }
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&at->cond, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_mutex_init(&at->lock, NULL);
+    return at;
+}
+
+void at_engine_destroy(AtEngine* at) {
+    if (!at) return;
+    at_engine_detach(at);
+    pthread_cond_destroy(&at->cond);
+    pthread_mutex_destroy(&at->lock);
+    at_framer_destroy(at->framer);
+    if (at->timer_fd >= 0) close(at->timer_fd);
+    free(at);
+}
+
+void at_engine_attach(AtEngine* at, int fd) {
+    if (!at) return;
+    at_engine_detach(at);
+    pthread_mutex_lock(&at->lock);
+    at->fd = fd;
+    at->dead = 0;
+    at->out_len = at->out_off = 0;
+    at->write_wait = 0;
+    at_framer_reset(at->framer);
+    memset(&at->stats, 0, sizeof(at->stats));
+    at->answered = 0;
+    pthread_mutex_unlock(&at->lock);
+}
+
+void at_engine_detach(AtEngine* at) {
+    if (!at) return;
+    pthread_mutex_lock(&at->lock);
+    at->fd = -1;
+    at->out_len = at->out_off = 0;
+    at->write_wait = 0;
+    while (at->count > 0) {
+        AtCompletion done;
+        finish_locked(at, AT_RESULT_CLOSED, -1, &done);
+        pthread_mutex_unlock(&at->lock);
+        deliver(at, &done);
+        pthread_mutex_lock(&at->lock);
+    }
+    pthread_cond_broadcast(&at->cond);
+    pthread_mutex_unlock(&at->lock);
+}
+
+int at_engine_fd(AtEngine* at) {
+    if (!at) return -1;
+    pthread_mutex_lock(&at->lock);
+    int fd = at->fd;
+    pthread_mutex_unlock(&at->lock);
+    return fd;
+}
+
+int at_engine_send(AtEngine* at, const char* command, int timeout_ms,
+                   AtCallback callback, void* user_data) {
+    if (!at || !command) return -1;
+
+    pthread_mutex_lock(&at->lock);
+    if (at->fd < 0 || at->dead || at->count >= AT_QUEUE_MAX) {
+        pthread_mutex_unlock(&at->lock);
+        return -1;
+    }
+    AtCommand *c = &at->queue[(at->head + at->count) % AT_QUEUE_MAX];
+    snprintf(c->command, sizeof(c->command), "%s", command);
+    c->timeout_ms = timeout_ms > 0 ? timeout_ms : AT_TIMEOUT_MS;
+    c->callback = callback;
+    c->user_data = user_data;
+    at->count++;
+    start_locked(at);
+    pthread_mutex_unlock(&at->lock);
+    return 0;
+}
+
+// One read straight into the framer's ring (it only keeps a partial line
+// between reads, so there is always room), complete lines dispatched
+// Returns 1 if data arrived, 0 if none, -1 if the link is closed
+static int read_lines(AtEngine *at, int fd, int flags) {
+    size_t space;
+    char *dst = at_framer_write_ptr(at->framer, &space);
+    ssize_t n = recv(fd, dst, space, flags);
+    if (n > 0) {
+        AtRecord rec;
+        at_framer_commit(at->framer, (size_t)n);
+        while (at_framer_next(at->framer, &rec)) dispatch(at, &rec);
+        AtFramerStats fs;
+        at_framer_get_stats(at->framer, &fs);
+        pthread_mutex_lock(&at->lock);
+        at->stats.overlong = fs.overlong;
+        pthread_mutex_unlock(&at->lock);
+        return 1;
+    }
+    if (n == 0 || (errno != EINTR && errno != EAGAIN)) return -1;
+    return 0;
+}
+
+// Mark this thread as the reader. Returns the fd, -1 if closed (detached
+// already), -2 if another thread reads
+static int begin_read(AtEngine *at) {
+    pthread_mutex_lock(&at->lock);
+    if (at->dead) {
+        pthread_mutex_unlock(&at->lock);
+        at_engine_detach(at);
+        return -1;
+    }
+    if (at->fd < 0) {
+        pthread_mutex_unlock(&at->lock);
+        return -1;
+    }
+    if (at->pumping) {
+        pthread_mutex_unlock(&at->lock);
+        return -2;
+    }
+    at->pumping = 1;
+    at->pumper = pthread_self();
+    int fd = at->fd;
+    pthread_mutex_unlock(&at->lock);
+    return fd;
+}
+
+static int end_read(AtEngine *at, int got) {
+    pthread_mutex_lock(&at->lock);
+    at->pumping = 0;
+    int closed = got < 0 || at->dead;
+    pthread_cond_broadcast(&at->cond);
+    pthread_mutex_unlock(&at->lock);
+
+    if (closed) {
+        at_engine_detach(at);
+        return -1;
+    }
+    return got;
+}
+
+int at_engine_pump(AtEngine* at, int timeout_ms) {
+    if (!at) return -1;
+
+    int fd = begin_read(at);
+    if (fd == -1) return -1;
+    if (fd == -2) {
+        // Another thread reads the link; nested calls from a callback return
+        pthread_mutex_lock(&at->lock);
+        if (at->pumping && !pthread_equal(at->pumper, pthread_self())) timed_wait(at, timeout_ms);
+        pthread_mutex_unlock(&at->lock);
+        return 0;
+    }
+
+    int wait = timeout_ms;
+    pthread_mutex_lock(&at->lock);
+    if (at->in_flight) {
+        int64_t left = (at->deadline_us - monotonic_us() + 999) / 1000;
+        if (left < wait) wait = left > 0 ? (int)left : 0;
+    }
+    pthread_mutex_unlock(&at->lock);
+
+    pthread_mutex_lock(&at->lock);
+    short events = POLLIN | (at->out_len ? POLLOUT : 0);
+    pthread_mutex_unlock(&at->lock);
+
+    int got = 0;
+    struct pollfd pfd = { .fd = fd, .events = events };
+    int ret = poll(&pfd, 1, wait);
+    if (ret > 0 && (pfd.revents & POLLOUT) && at_engine_flush(at) < 0) {
+        got = -1;
+    } else if (ret > 0 && (pfd.revents & ~POLLOUT)) {
+        got = read_lines(at, fd, 0);
+    } else if (ret < 0 && errno != EINTR) {
+        got = -1;
+    }
+    expire(at);
+    return end_read(at, got);
+}
+
+int at_engine_process(AtEngine* at) {
+    if (!at) return -1;
+
+    int fd = begin_read(at);
+    if (fd < 0) return fd == -1 ? -1 : 0;
+    pthread_mutex_lock(&at->lock);
+    at->loop_thread = pthread_self();
+    at->has_loop_thread = 1;
+    pthread_mutex_unlock(&at->lock);
+
+    return end_read(at, read_lines(at, fd, MSG_DONTWAIT));
+}
+
+void at_engine_expire(AtEngine* at) {
+    if (!at) return;
+    uint64_t ticks;
+    if (at->timer_fd >= 0) {
+        ssize_t n = read(at->timer_fd, &ticks, sizeof(ticks));
+        (void)n;
+    }
+    expire(at);
+}
+
+int at_engine_flush(AtEngine* at) {
+    if (!at) return -1;
+    pthread_mutex_lock(&at->lock);
+    int ret = -1;
+    if (at->fd >= 0 && !at->dead) {
+        ret = flush_locked(at);
+        if (ret == 0) start_locked(at);
+        if (at->dead) ret = -1;
+    }
+    pthread_mutex_unlock(&at->lock);
+    return ret;
+}
+
+int at_engine_timer_fd(AtEngine* at) {
+    return at ? at->timer_fd : -1;
+}
+
+typedef struct {
+    AtEngine *at;
+    int done;
+    AtResult result;
+    char *info;
+    size_t info_len;
+} AtWait;
+
+static void wait_done(const AtResponse *response, void *user_data) {
+    AtWait *w = user_data;
+    if (w->info && w->info_len) snprintf(w->info, w->info_len, "%s", response->info);
+    pthread_mutex_lock(&w->at->lock);
+    w->result = response->result;
+    w->done = 1;
+    pthread_cond_broadcast(&w->at->cond);
+    pthread_mutex_unlock(&w->at->lock);
+}
+
+AtResult at_engine_command(AtEngine* at, const char* command, int timeout_ms,
+                           char* info, size_t info_len) {
+    if (info && info_len) info[0] = '\0';
+    if (!at) return AT_RESULT_CLOSED;
+
+    pthread_mutex_lock(&at->lock);
+    int nested = at->pumping && pthread_equal(at->pumper, pthread_self());
+    int on_loop = at->cfg.event_loop && at->has_loop_thread && pthread_equal(at->loop_thread, pthread_self());
+    pthread_mutex_unlock(&at->lock);
+    if (nested || on_loop) {
+        log_fmt(at, "⚠️ [%s] %s: not waited for inside a callback", at->name, command);
+        return AT_RESULT_ERROR;
+    }
+
+    AtWait w = { .at = at, .info = info, .info_len = info_len };
+    if (at_engine_send(at, command, timeout_ms, wait_done, &w) < 0) return AT_RESULT_CLOSED;
+
+    pthread_mutex_lock(&at->lock);
+    while (!w.done) {
+        if (at->pumping || at->cfg.event_loop) {
+            // The owner thread (or the event loop) reads the link and wakes
+            // us; a stuck owner (long callback) does not stop the timeout
+            timed_wait(at, AT_WAIT_SLICE_MS);
+            int dead = at->dead;
+            pthread_mutex_unlock(&at->lock);
+            expire(at);
+            if (dead) at_engine_detach(at);
+        } else {
+            pthread_mutex_unlock(&at->lock);
+            at_engine_pump(at, AT_WAIT_SLICE_MS);
+        }
+        pthread_mutex_lock(&at->lock);
+    }
+    pthread_mutex_unlock(&at->lock);
+    return w.result;
+}
+
+void at_engine_get_stats(AtEngine* at, AtEngineStats* stats) {
+    if (!stats) return;
+    if (!at) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+    pthread_mutex_lock(&at->lock);
+    *stats = at->stats;
+    pthread_mutex_unlock(&at->lock);
+}
+
+void at_engine_format_stats(const AtEngineStats* stats, char* buf, size_t len) {
+    if (!stats || !buf || !len) return;
+    snprintf(buf, len, "%llu commands, rtt avg %.1f ms (max %.1f), %llu timeouts, %llu errors, %llu unsolicited",
+             (unsigned long long)stats->commands, stats->rtt_avg_ms, stats->rtt_max_ms,
+             (unsigned long long)stats->timeouts, (unsigned long long)stats->errors,
+             (unsigned long long)stats->unsolicited);
+}
+
+const char* at_result_name(AtResult result) {
+    switch (result) {
+        case AT_RESULT_OK: return "OK";
+        case AT_RESULT_ERROR: return "ERROR";
+        case AT_RESULT_CME_ERROR: return "+CME ERROR";
+        case AT_RESULT_NO_CARRIER: return "NO CARRIER";
+        case AT_RESULT_BUSY: return "BUSY";
+        case AT_RESULT_NO_ANSWER: return "NO ANSWER";
+        case AT_RESULT_TIMEOUT: return "timeout";
+        case AT_RESULT_CLOSED: return "closed";
+    }
+    return "?";
+}
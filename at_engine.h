@@ -0,0 +1,146 @@
+#ifndef AT_ENGINE_H
+#define AT_ENGINE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "at_framer.h"
+
+// AT command engine for one HFP RFCOMM link: commands are queued and
+// written one at a time, the next one the moment the previous gets its
+// final result code (OK, ERROR, +CME ERROR; NO CARRIER, BUSY, NO ANSWER
+// only for ATD / ATA, otherwise they are unsolicited) or runs into its own
+// timeout. Reads go into an AtFramer, one record per line. Information
+// lines with the command's prefix (+CIND: for AT+CIND?)
+// go to the command, everything else (RING, +CIEV, +CLIP, +BCS) to the
+// handler registered for its keyword. Whoever calls at_engine_pump()
+// drives the link; at_engine_command() waits for it, or pumps itself if
+// nobody does. With an event loop (config.event_loop) the loop drives it:
+// at_engine_process() when the fd is readable, at_engine_expire() when
+// at_engine_timer_fd() is (armed at the deadline of the command in flight).
+// Writes never block: what the socket does not take (RFCOMM flow control)
+// stays in the engine until the fd is writable, at_engine_flush().
+
+#define AT_TIMEOUT_MS 2000           // Default per command
+#define AT_DIAL_TIMEOUT_MS 5000      // ATD: the phone may check the number first
+#define AT_QUEUE_MAX 16
+#define AT_COMMAND_MAX 128
+#define AT_INFO_MAX 512
+
+typedef enum {
+    AT_RESULT_OK,
+    AT_RESULT_ERROR,
+    AT_RESULT_CME_ERROR,
+    AT_RESULT_NO_CARRIER,
+    AT_RESULT_BUSY,
+    AT_RESULT_NO_ANSWER,
+    AT_RESULT_TIMEOUT,
+    AT_RESULT_CLOSED,                // Link detached or lost while queued
+} AtResult;
+
+typedef struct {
+    const char* command;             // As queued, without the \r
+    AtResult result;
+    int cme_error;                   // +CME ERROR: <n>, -1 otherwise
+    const char* info;                // Information lines, '\n' separated ("" if none)
+    double rtt_ms;                   // Write to final result code
+} AtResponse;
+
+// Callbacks run on the thread that pumps, without engine locks held
+typedef void (*AtCallback)(const AtResponse* response, void* user_data);
+typedef void (*AtRecordCallback)(const AtRecord* record, void* user_data);
+typedef void (*AtLogCallback)(const char* msg, void* user_data);
+
+// wait 1: a command is only partly written, watch fd for writability and
+// call at_engine_flush(); 0: all written. Runs with the engine lock held,
+// from whichever thread sent or flushed: must not call into the engine
+typedef void (*AtWriteWaitCallback)(int fd, int wait, void* user_data);
+
+// Unsolicited dispatch table entry
+typedef struct {
+    AtKeyword keyword;
+    AtRecordCallback handler;
+} AtHandler;
+
+typedef struct {
+    const char* name;                // For the log: "listen", "dial"
+    const AtHandler* handlers;       // Copied at create
+    int handler_count;
+    AtRecordCallback on_unsolicited; // Every unsolicited record first (optional, logging)
+    AtLogCallback log;               // Round trip of every command, timeouts
+    AtWriteWaitCallback on_write_wait;  // Event loop: writability wanted (optional)
+    void* user_data;
+    int event_loop;                  // Driven by an event loop, at_engine_command() never reads
+} AtEngineConfig;
+
+typedef struct {
+    uint64_t commands;               // Completed, any result
+    uint64_t timeouts;
+    uint64_t errors;                 // ERROR / +CME ERROR
+    uint64_t unsolicited;
+    uint64_t overlong;               // Lines cut at AT_LINE_MAX
+    double rtt_avg_ms;
+    double rtt_max_ms;
+} AtEngineStats;
+
+typedef struct AtEngine AtEngine;
+
+// The engine outlives links: attach a socket per connection
+AtEngine* at_engine_create(const AtEngineConfig* config);
+void at_engine_destroy(AtEngine* at);
+
+// Start using fd (not owned); clears the line buffer and the stats
+void at_engine_attach(AtEngine* at, int fd);
+
+// Stop using the fd: queued commands complete with AT_RESULT_CLOSED
+void at_engine_detach(AtEngine* at);
+
+// Attached fd, -1 if none
+int at_engine_fd(AtEngine* at);
+
+// Queue a command ("AT+CHUP", no \r); timeout_ms <= 0 means AT_TIMEOUT_MS
+// callback may be NULL. Returns 0, -1 if not attached or the queue is full
+int at_engine_send(AtEngine* at, const char* command, int timeout_ms,
+                   AtCallback callback, void* user_data);
+
+// Queue and wait for the final result code. info (optional) receives the
+// information lines. Must not be called from an engine callback, nor from
+// the event loop thread
+AtResult at_engine_command(AtEngine* at, const char* command, int timeout_ms,
+                           char* info, size_t info_len);
+
+// Wait up to timeout_ms for data, dispatch complete lines, expire commands
+// Returns 1 if data arrived, 0 on timeout (or another thread pumps),
+// -1 if the link is closed or not attached
+int at_engine_pump(AtEngine* at, int timeout_ms);
+
+// Event loop side: the fd is readable. One read, complete lines
+// dispatched; returns as at_engine_pump(), never blocks
+int at_engine_process(AtEngine* at);
+
+// Event loop side: the timer fd is readable, time out the command in flight
+void at_engine_expire(AtEngine* at);
+
+// Event loop side: the fd is writable, write what is left of the command
+// in flight (then the next one). Returns 0, -1 if the link failed
+int at_engine_flush(AtEngine* at);
+
+// One-shot timerfd for the command deadline (valid from create to destroy)
+int at_engine_timer_fd(AtEngine* at);
+
+void at_engine_get_stats(AtEngine* at, AtEngineStats* stats);
+
+// "12 commands, rtt avg 41.2 ms (max 180.3), 0 timeouts, 1 error, 9 unsolicited"
+void at_engine_format_stats(const AtEngineStats* stats, char* buf, size_t len);
+
+const char* at_result_name(AtResult result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AT_ENGINE_H
@@ -0,0 +1,230 @@
+#include "at_framer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define AT_FRAMER_MASK (AT_FRAMER_SIZE - 1)
+
+_Static_assert((AT_FRAMER_SIZE & AT_FRAMER_MASK) == 0, "AT_FRAMER_SIZE must be a power of two");
+_Static_assert(AT_FRAMER_SIZE > AT_LINE_MAX, "a full line must fit the ring");
+
+struct AtFramer {
+    // Free running positions, masked on access
+    uint32_t head;                   // First unconsumed byte
+    uint32_t scan;                   // Searched for a line end up to here
+    uint32_t tail;                   // Next byte to write
+    int discarding;                  // Dropping an overlong line up to its end
+    AtFramerStats stats;
+    char scratch[AT_LINE_MAX];       // Lines that wrap the ring
+    char buf[AT_FRAMER_SIZE + 1];    // +1: NUL after a line that ends at the ring end
+};
+
+typedef struct {
+    const char *text;
+    uint8_t len;
+    AtKeyword keyword;
+} AtKeywordEntry;
+
+// Bare result codes: the whole line
+static const AtKeywordEntry codes[] = {
+    { "OK", 2, AT_KW_OK },
+    { "ERROR", 5, AT_KW_ERROR },
+    { "NO CARRIER", 10, AT_KW_NO_CARRIER },
+    { "BUSY", 4, AT_KW_BUSY },
+    { "NO ANSWER", 9, AT_KW_NO_ANSWER },
+    { "RING", 4, AT_KW_RING },
+};
+
+// "+XXX:" results, matched on the name before the colon
+static const AtKeywordEntry extended[] = {
+    { "+CIEV", 5, AT_KW_CIEV },
+    { "+CLIP", 5, AT_KW_CLIP },
+    { "+CCWA", 5, AT_KW_CCWA },
+    { "+BCS", 4, AT_KW_BCS },
+    { "+BRSF", 5, AT_KW_BRSF },
+    { "+CIND", 5, AT_KW_CIND },
+    { "+CHLD", 5, AT_KW_CHLD },
+    { "+CLCC", 5, AT_KW_CLCC },
+    { "+COPS", 5, AT_KW_COPS },
+    { "+CNUM", 5, AT_KW_CNUM },
+    { "+BIND", 5, AT_KW_BIND },
+    { "+BSIR", 5, AT_KW_BSIR },
+    { "+BTRH", 5, AT_KW_BTRH },
+    { "+BVRA", 5, AT_KW_BVRA },
+    { "+VGS", 4, AT_KW_VGS },
+    { "+VGM", 4, AT_KW_VGM },
+    { "+CME ERROR", 10, AT_KW_CME_ERROR },
+};
+
+static const char *const keyword_names[AT_KW_COUNT] = {
+    "?", "OK", "ERROR", "+CME ERROR", "NO CARRIER", "BUSY", "NO ANSWER", "RING",
+    "+CIEV", "+CLIP", "+CCWA", "+BCS", "+BRSF", "+CIND", "+CHLD", "+CLCC", "+COPS",
+    "+CNUM", "+BIND", "+BSIR", "+BTRH", "+BVRA", "+VGS", "+VGM",
+};
+
+AtKeyword at_keyword_parse(const char* line, size_t len, const char** args) {
+    const char *dummy;
+    if (!args) args = &dummy;
+    *args = line;
+    if (!line || len == 0) return AT_KW_UNKNOWN;
+
+    if (line[0] != '+') {
+        for (size_t i = 0; i < sizeof(codes) / sizeof(codes[0]); i++) {
+            if (codes[i].len == len && codes[i].text[0] == line[0] &&
+                memcmp(codes[i].text, line, len) == 0) {
+                *args = line + len;
+                return codes[i].keyword;
+            }
+        }
+        return AT_KW_UNKNOWN;
+    }
+
+    const char *colon = memchr(line, ':', len);
+    if (!colon) return AT_KW_UNKNOWN;
+    size_t name_len = (size_t)(colon - line);
+    for (size_t i = 0; i < sizeof(extended) / sizeof(extended[0]); i++) {
+        if (extended[i].len == name_len && extended[i].text[1] == line[1] &&
+            memcmp(extended[i].text, line, name_len) == 0) {
+            const char *p = colon + 1;
+            while (p < line + len && *p == ' ') p++;
+            *args = p;
+            return extended[i].keyword;
+        }
+    }
+    return AT_KW_UNKNOWN;
+}
+
+const char* at_keyword_name(AtKeyword keyword) {
+    return keyword >= 0 && keyword < AT_KW_COUNT ? keyword_names[keyword] : "?";
+}
+
+int at_keyword_is_final(AtKeyword keyword) {
+    return keyword >= AT_KW_OK && keyword <= AT_KW_NO_ANSWER;
+}
+
+AtFramer* at_framer_create(void) {
+    return calloc(1, sizeof(AtFramer));
+}
+
+void at_framer_destroy(AtFramer* framer) {
+    free(framer);
+}
+
+void at_framer_reset(AtFramer* framer) {
+    if (!framer) return;
+    framer->head = framer->scan = framer->tail = 0;
+    framer->discarding = 0;
+    memset(&framer->stats, 0, sizeof(framer->stats));
+}
+
+char* at_framer_write_ptr(AtFramer* framer, size_t* space) {
+    uint32_t off = framer->tail & AT_FRAMER_MASK;
+    uint32_t free_bytes = AT_FRAMER_SIZE - (framer->tail - framer->head);
+    uint32_t run = AT_FRAMER_SIZE - off;
+    *space = run < free_bytes ? run : free_bytes;
+    return framer->buf + off;
+}
+
+void at_framer_commit(AtFramer* framer, size_t bytes) {
+    framer->tail += (uint32_t)bytes;
+    framer->stats.bytes += bytes;
+}
+
+size_t at_framer_push(AtFramer* framer, const void* data, size_t len) {
+    size_t done = 0;
+    while (done < len) {
+        size_t space;
+        char *dst = at_framer_write_ptr(framer, &space);
+        if (space == 0) break;
+        size_t n = len - done < space ? len - done : space;
+        memcpy(dst, (const char *)data + done, n);
+        at_framer_commit(framer, n);
+        done += n;
+    }
+    return done;
+}
+
+static inline int is_eol(char ch) {
+    return ch == '\r' || ch == '\n';
+}
+
+// First \r or \n in [from, to), to if none; memchr over contiguous runs
+static uint32_t find_eol(const AtFramer *framer, uint32_t from, uint32_t to) {
+    while (from != to) {
+        uint32_t off = from & AT_FRAMER_MASK;
+        uint32_t n = to - from;
+        if (n > AT_FRAMER_SIZE - off) n = AT_FRAMER_SIZE - off;
+        const char *seg = framer->buf + off;
+        const char *cr = memchr(seg, '\r', n);
+        size_t limit = cr ? (size_t)(cr - seg) : n;
+        const char *lf = memchr(seg, '\n', limit);
+        if (lf) return from + (uint32_t)(lf - seg);
+        if (cr) return from + (uint32_t)limit;
+        from += n;
+    }
+    return to;
+}
+
+int at_framer_next(AtFramer* framer, AtRecord* record) {
+    const char *buf = framer->buf;
+    for (;;) {
+        // Blank lines and the \n of \r\n
+        if (!framer->discarding) {
+            while (framer->head != framer->tail && is_eol(buf[framer->head & AT_FRAMER_MASK])) {
+                framer->head++;
+            }
+        }
+        if ((int32_t)(framer->scan - framer->head) < 0) framer->scan = framer->head;
+        framer->scan = find_eol(framer, framer->scan, framer->tail);
+
+        uint32_t len = framer->scan - framer->head;
+        if (framer->scan == framer->tail) {
+            // No line end yet; a line that cannot fit is dropped up to its end
+            if (len >= AT_LINE_MAX) {
+                if (!framer->discarding) framer->stats.overlong++;
+                framer->discarding = 1;
+                framer->head = framer->scan;
+            }
+            return 0;
+        }
+        if (framer->discarding || len >= AT_LINE_MAX) {
+            if (!framer->discarding) framer->stats.overlong++;
+            framer->discarding = 0;
+            framer->head = framer->scan;
+            continue;
+        }
+
+        uint32_t start = framer->head & AT_FRAMER_MASK;
+        char *line;
+        if (start + len <= AT_FRAMER_SIZE) {
+            // In place: the line end (or the spare byte) becomes the NUL
+            line = framer->buf + start;
+            line[len] = '\0';
+        } else {
+            uint32_t first = AT_FRAMER_SIZE - start;
+            memcpy(framer->scratch, buf + start, first);
+            memcpy(framer->scratch + first, buf, len - first);
+            framer->scratch[len] = '\0';
+            line = framer->scratch;
+            framer->stats.wrapped++;
+        }
+        framer->head = framer->scan + 1;
+        framer->scan = framer->head;
+        framer->stats.lines++;
+
+        record->line = line;
+        record->len = len;
+        record->keyword = at_keyword_parse(line, len, &record->args);
+        record->final = at_keyword_is_final(record->keyword);
+        return 1;
+    }
+}
+
+void at_framer_get_stats(const AtFramer* framer, AtFramerStats* stats) {
+    if (!stats) return;
+    if (!framer) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+    *stats = framer->stats;
+}
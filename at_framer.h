@@ -0,0 +1,98 @@
+#ifndef AT_FRAMER_H
+#define AT_FRAMER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Incremental line framer for the AT stream of an RFCOMM link. Reads go
+// straight into a ring buffer (at_framer_write_ptr / at_framer_commit),
+// at_framer_next() hands out one record per line: the line is terminated
+// in place (its \r or \n becomes the NUL), only a line that wraps around
+// the end of the ring is copied. Lines split across reads wait for their
+// end, several lines in one read come out one by one. Each line is
+// classified once through a keyword table, so handlers can be picked by
+// keyword instead of strstr() over the whole read.
+
+#define AT_FRAMER_SIZE 2048          // Ring bytes, power of two
+#define AT_LINE_MAX 512              // Longer lines are dropped (counted as overlong)
+
+typedef enum {
+    AT_KW_UNKNOWN,                   // Text or +XXX not in the table
+    // Final result codes
+    AT_KW_OK,
+    AT_KW_ERROR,
+    AT_KW_CME_ERROR,
+    AT_KW_NO_CARRIER,
+    AT_KW_BUSY,
+    AT_KW_NO_ANSWER,
+    // Unsolicited results and information lines
+    AT_KW_RING,
+    AT_KW_CIEV,
+    AT_KW_CLIP,
+    AT_KW_CCWA,
+    AT_KW_BCS,
+    AT_KW_BRSF,
+    AT_KW_CIND,
+    AT_KW_CHLD,
+    AT_KW_CLCC,
+    AT_KW_COPS,
+    AT_KW_CNUM,
+    AT_KW_BIND,
+    AT_KW_BSIR,
+    AT_KW_BTRH,
+    AT_KW_BVRA,
+    AT_KW_VGS,
+    AT_KW_VGM,
+    AT_KW_COUNT
+} AtKeyword;
+
+typedef struct {
+    const char* line;                // NUL terminated, valid until the next framer call
+    size_t len;
+    AtKeyword keyword;
+    int final;                       // Final result code (OK ... NO ANSWER)
+    const char* args;                // After "+XXX:" and blanks; "" for bare codes, line if unknown
+} AtRecord;
+
+typedef struct {
+    uint64_t bytes;                  // Committed
+    uint64_t lines;                  // Records handed out
+    uint64_t wrapped;                // Lines copied because they wrapped the ring
+    uint64_t overlong;               // Lines dropped at AT_LINE_MAX
+} AtFramerStats;
+
+typedef struct AtFramer AtFramer;
+
+AtFramer* at_framer_create(void);
+void at_framer_destroy(AtFramer* framer);
+
+// Drop buffered bytes and counters (new link)
+void at_framer_reset(AtFramer* framer);
+
+// Contiguous free space for read(); *space = 0 means call at_framer_next()
+char* at_framer_write_ptr(AtFramer* framer, size_t* space);
+void at_framer_commit(AtFramer* framer, size_t bytes);
+
+// Copying variant of write_ptr + commit. Returns bytes taken
+size_t at_framer_push(AtFramer* framer, const void* data, size_t len);
+
+// Next complete line: 1 and *record filled, 0 if more data is needed
+// Call until 0 after every commit
+int at_framer_next(AtFramer* framer, AtRecord* record);
+
+void at_framer_get_stats(const AtFramer* framer, AtFramerStats* stats);
+
+// Classify one line (no terminator); *args as in AtRecord
+AtKeyword at_keyword_parse(const char* line, size_t len, const char** args);
+const char* at_keyword_name(AtKeyword keyword);
+int at_keyword_is_final(AtKeyword keyword);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AT_FRAMER_H
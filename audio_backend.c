@@ -0,0 +1,198 @@
+#include "audio_backend_impl.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <pulse/simple.h>
+#include <pulse/error.h>
+
+struct AudioStream {
+    const AudioBackendOps *ops;
+    void *impl;
+};
+
+// ============================================================================
+// DISPATCH
+// ============================================================================
+
+// AUTO order: first entry that opens wins
+static const AudioBackendOps *const auto_order[] = {
+#ifdef HAVE_PIPEWIRE
+    &audio_backend_pipewire_ops,
+#endif
+    &audio_backend_pulse_ops,
+    &audio_backend_pulse_simple_ops,
+#ifdef HAVE_ALSA
+    &audio_backend_alsa_ops,     // Last: no sound server running
+#endif
+};
+
+static const AudioBackendOps* backend_ops(AudioBackendType backend) {
+    switch (backend) {
+        case AUDIO_BACKEND_PULSE:        return &audio_backend_pulse_ops;
+        case AUDIO_BACKEND_PULSE_SIMPLE: return &audio_backend_pulse_simple_ops;
+        case AUDIO_BACKEND_LOOPBACK:     return &audio_backend_loopback_ops;
+#ifdef HAVE_PIPEWIRE
+        case AUDIO_BACKEND_PIPEWIRE:     return &audio_backend_pipewire_ops;
+#endif
+#ifdef HAVE_ALSA
+        case AUDIO_BACKEND_ALSA:         return &audio_backend_alsa_ops;
+#endif
+        default:                         return NULL;
+    }
+}
+
+AudioStream* audio_stream_open(AudioBackendType backend, const AudioStreamConfig* config,
+                               char* err, size_t err_len) {
+    if (!config) return NULL;
+    if (err && err_len) err[0] = '\0';
+
+    const AudioBackendOps *single = backend_ops(backend);
+    const AudioBackendOps *const *order = single ? &single : auto_order;
+    size_t count = single ? 1 : sizeof(auto_order) / sizeof(auto_order[0]);
+
+    for (size_t i = 0; i < count; i++) {
+        void *impl = order[i]->open(config, err, err_len);
+        if (!impl) continue;
+
+        AudioStream *stream = calloc(1, sizeof(AudioStream));
+        if (!stream) {
+            order[i]->close(impl);
+            return NULL;
+        }
+        stream->ops = order[i];
+        stream->impl = impl;
+        return stream;
+    }
+    return NULL;
+}
+
+int audio_stream_write(AudioStream* stream, const void* data, size_t bytes) {
+    if (!stream) return -1;
+    return stream->ops->write(stream->impl, data, bytes);
+}
+
+int audio_stream_read(AudioStream* stream, void* data, size_t bytes) {
+    if (!stream) return -1;
+    return stream->ops->read(stream->impl, data, bytes);
+}
+
+int64_t audio_stream_latency_us(AudioStream* stream) {
+    if (!stream || !stream->ops->latency_us) return -1;
+    return stream->ops->latency_us(stream->impl);
+}
+
+uint64_t audio_stream_xruns(AudioStream* stream) {
+    if (!stream || !stream->ops->xruns) return 0;
+    return stream->ops->xruns(stream->impl);
+}
+
+void audio_stream_drain(AudioStream* stream) {
+    if (!stream || !stream->ops->drain) return;
+    stream->ops->drain(stream->impl);
+}
+
+void audio_stream_flush(AudioStream* stream) {
+    if (!stream || !stream->ops->flush) return;
+    stream->ops->flush(stream->impl);
+}
+
+void audio_stream_close(AudioStream* stream) {
+    if (!stream) return;
+    stream->ops->close(stream->impl);
+    free(stream);
+}
+
+const char* audio_stream_backend_name(const AudioStream* stream) {
+    return stream ? stream->ops->name : "none";
+}
+
+AudioBackendType audio_backend_from_name(const char* name) {
+    if (!name) return AUDIO_BACKEND_AUTO;
+    if (strcmp(name, "pulse") == 0) return AUDIO_BACKEND_PULSE;
+    if (strcmp(name, "pulse-simple") == 0) return AUDIO_BACKEND_PULSE_SIMPLE;
+    if (strcmp(name, "pipewire") == 0) return AUDIO_BACKEND_PIPEWIRE;
+    if (strcmp(name, "alsa") == 0) return AUDIO_BACKEND_ALSA;
+    if (strcmp(name, "loopback") == 0) return AUDIO_BACKEND_LOOPBACK;
+    return AUDIO_BACKEND_AUTO;
+}
+
+const char* audio_backend_name(AudioBackendType backend) {
+    switch (backend) {
+        case AUDIO_BACKEND_PULSE:        return "pulse";
+        case AUDIO_BACKEND_PULSE_SIMPLE: return "pulse-simple";
+        case AUDIO_BACKEND_PIPEWIRE:     return "pipewire";
+        case AUDIO_BACKEND_ALSA:         return "alsa";
+        case AUDIO_BACKEND_LOOPBACK:     return "loopback";
+        default:                         return "auto";
+    }
+}
+
+// ============================================================================
+// PULSEAUDIO SIMPLE (fallback)
+// ============================================================================
+
+static void* simple_open(const AudioStreamConfig* config, char* err, size_t err_len) {
+    pa_sample_spec ss = {
+        .format = PA_SAMPLE_S16LE,
+        .rate = (uint32_t)config->sample_rate,
+        .channels = (uint8_t)config->channels
+    };
+
+    int error = 0;
+    pa_simple *s = pa_simple_new(
+        NULL,                    // default server
+        config->app_name,
+        config->direction == AUDIO_STREAM_PLAYBACK ? PA_STREAM_PLAYBACK : PA_STREAM_RECORD,
+        config->device,
+        config->stream_name,
+        &ss,
+        NULL,                    // default channel map
+        NULL,                    // default buffering
+        &error
+    );
+    if (!s && err && err_len) {
+        snprintf(err, err_len, "%s", pa_strerror(error));
+    }
+    return s;
+}
+
+static int simple_write(void* impl, const void* data, size_t bytes) {
+    int error;
+    return pa_simple_write((pa_simple *)impl, data, bytes, &error) < 0 ? -1 : 0;
+}
+
+static int simple_read(void* impl, void* data, size_t bytes) {
+    int error;
+    return pa_simple_read((pa_simple *)impl, data, bytes, &error) < 0 ? -1 : 0;
+}
+
+static int64_t simple_latency_us(void* impl) {
+    int error;
+    pa_usec_t usec = pa_simple_get_latency((pa_simple *)impl, &error);
+    return usec == (pa_usec_t)-1 ? -1 : (int64_t)usec;
+}
+
+static void simple_drain(void* impl) {
+    pa_simple_drain((pa_simple *)impl, NULL);
+}
+
+static void simple_flush(void* impl) {
+    pa_simple_flush((pa_simple *)impl, NULL);
+}
+
+static void simple_close(void* impl) {
+    pa_simple_free((pa_simple *)impl);
+}
+
+const AudioBackendOps audio_backend_pulse_simple_ops = {
+    .name = "pulse-simple",
+    .open = simple_open,
+    .write = simple_write,
+    .read = simple_read,
+    .latency_us = simple_latency_us,
+    .drain = simple_drain,
+    .close = simple_close,
+    .flush = simple_flush,
+};
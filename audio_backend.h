@@ -0,0 +1,76 @@
+#ifndef AUDIO_BACKEND_H
+#define AUDIO_BACKEND_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Call audio device I/O (speaker / microphone), independent of sound server
+typedef enum {
+    AUDIO_BACKEND_AUTO = 0,      // Best available, falls back in order
+    AUDIO_BACKEND_PULSE,         // pa_threaded_mainloop + pa_stream (low latency)
+    AUDIO_BACKEND_PULSE_SIMPLE,  // pa_simple (blocking, server default buffering)
+    AUDIO_BACKEND_PIPEWIRE,      // Native pw_stream, quantum = SCO packet (HAVE_PIPEWIRE)
+    AUDIO_BACKEND_ALSA,          // Direct ALSA PCM, mmap, no sound server (HAVE_ALSA)
+    AUDIO_BACKEND_LOOPBACK       // In-process virtual card, playback -> capture (tests, never AUTO)
+} AudioBackendType;
+
+typedef enum {
+    AUDIO_STREAM_PLAYBACK,
+    AUDIO_STREAM_CAPTURE
+} AudioStreamDirection;
+
+typedef struct {
+    AudioStreamDirection direction;
+    int sample_rate;             // 8000 / 16000
+    int channels;                // 1
+    size_t period_bytes;         // Chunk size the caller reads/writes (SCO packet)
+    int latency_ms;              // Target device buffer latency
+    const char *app_name;
+    const char *stream_name;
+    const char *device;          // NULL = default (sink/source name, PipeWire target, ALSA PCM)
+} AudioStreamConfig;
+
+typedef struct AudioStream AudioStream;
+
+// Open stream on the given backend (AUTO tries each backend in turn)
+// err: optional message buffer, filled on failure
+AudioStream* audio_stream_open(AudioBackendType backend, const AudioStreamConfig* config,
+                               char* err, size_t err_len);
+
+// Blocking write / read of exactly `bytes`
+// Returns 0 on success, -1 on error
+int audio_stream_write(AudioStream* stream, const void* data, size_t bytes);
+int audio_stream_read(AudioStream* stream, void* data, size_t bytes);
+
+// Current device latency in microseconds, -1 if unknown
+int64_t audio_stream_latency_us(AudioStream* stream);
+
+// Underruns (playback) / overruns (capture) seen by the device so far
+uint64_t audio_stream_xruns(AudioStream* stream);
+
+// Play out buffered audio (playback only)
+void audio_stream_drain(AudioStream* stream);
+
+// Discard captured audio nobody has read yet (capture only), so a stream
+// opened ahead of the call starts with fresh samples
+void audio_stream_flush(AudioStream* stream);
+
+// Close stream
+void audio_stream_close(AudioStream* stream);
+
+// Name of the backend actually used by the stream
+const char* audio_stream_backend_name(const AudioStream* stream);
+
+// settings.json name <-> type ("auto", "pipewire", "pulse", "pulse-simple", "alsa", "loopback")
+AudioBackendType audio_backend_from_name(const char* name);
+const char* audio_backend_name(AudioBackendType backend);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUDIO_BACKEND_H
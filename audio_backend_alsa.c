@@ -0,0 +1,312 @@
+#include "audio_backend_impl.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <alsa/asoundlib.h>
+
+// Direct ALSA PCM for setups without a sound server. mmap access with small
+// periods; plugin devices that cannot mmap fall back to readi/writei.
+// Xruns are recovered in place (prepare + restart) so the call continues.
+
+#define ALSA_WAIT_MS 100
+#define ALSA_CAPTURE_PERIODS 4   // Capture buffer in periods
+
+typedef struct {
+    snd_pcm_t *pcm;
+    AudioStreamDirection direction;
+    int mmap;                    // mmap access, else readi/writei
+    size_t frame_bytes;
+    snd_pcm_uframes_t period;
+    snd_pcm_uframes_t buffer;
+    snd_pcm_uframes_t start_threshold;
+    unsigned int rate;
+    uint64_t xruns;
+} AlsaStream;
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+// Xrun (-EPIPE) or suspend (-ESTRPIPE): re-prepare, restart capture
+static int alsa_recover(AlsaStream *as, int err) {
+    if (err == -EPIPE || err == -ESTRPIPE) {
+        as->xruns++;
+    }
+    err = snd_pcm_recover(as->pcm, err, 1);
+    if (err < 0) return err;
+    if (as->direction == AUDIO_STREAM_CAPTURE) {
+        err = snd_pcm_start(as->pcm);
+        if (err < 0 && err != -EBADFD) return err;
+    }
+    return 0;
+}
+
+static int set_hw_params(AlsaStream *as, const AudioStreamConfig *config, snd_pcm_access_t access) {
+    snd_pcm_hw_params_t *hw;
+    snd_pcm_hw_params_alloca(&hw);
+
+    int err = snd_pcm_hw_params_any(as->pcm, hw);
+    if (err < 0) return err;
+    if ((err = snd_pcm_hw_params_set_rate_resample(as->pcm, hw, 1)) < 0) return err;
+    if ((err = snd_pcm_hw_params_set_access(as->pcm, hw, access)) < 0) return err;
+    if ((err = snd_pcm_hw_params_set_format(as->pcm, hw, SND_PCM_FORMAT_S16_LE)) < 0) return err;
+    if ((err = snd_pcm_hw_params_set_channels(as->pcm, hw, (unsigned int)config->channels)) < 0) return err;
+
+    // The call threads read / write exactly this rate: a hw: device that only
+    // offers 44.1 / 48 kHz is refused, not run 3-6x too fast
+    as->rate = (unsigned int)config->sample_rate;
+    if ((err = snd_pcm_hw_params_set_rate_near(as->pcm, hw, &as->rate, NULL)) < 0) return err;
+    if (as->rate != (unsigned int)config->sample_rate) return -EINVAL;
+
+    snd_pcm_uframes_t period = config->period_bytes ? config->period_bytes / as->frame_bytes
+                                                    : (snd_pcm_uframes_t)(as->rate / 100);
+    int dir = 0;
+    if ((err = snd_pcm_hw_params_set_period_size_near(as->pcm, hw, &period, &dir)) < 0) return err;
+
+    // Playback: buffer = latency target; capture: a few periods of headroom
+    snd_pcm_uframes_t buffer = (snd_pcm_uframes_t)config->latency_ms * as->rate / 1000;
+    if (as->direction == AUDIO_STREAM_CAPTURE || buffer < 2 * period) {
+        buffer = period * (as->direction == AUDIO_STREAM_CAPTURE ? ALSA_CAPTURE_PERIODS : 2);
+    }
+    if ((err = snd_pcm_hw_params_set_buffer_size_near(as->pcm, hw, &buffer)) < 0) return err;
+
+    if ((err = snd_pcm_hw_params(as->pcm, hw)) < 0) return err;
+
+    snd_pcm_hw_params_get_period_size(hw, &as->period, &dir);
+    snd_pcm_hw_params_get_buffer_size(hw, &as->buffer);
+    as->mmap = (access == SND_PCM_ACCESS_MMAP_INTERLEAVED);
+    return 0;
+}
+
+static int set_sw_params(AlsaStream *as) {
+    snd_pcm_sw_params_t *sw;
+    snd_pcm_sw_params_alloca(&sw);
+
+    int err = snd_pcm_sw_params_current(as->pcm, sw);
+    if (err < 0) return err;
+
+    // Start playback as soon as one period is queued: minimum latency
+    as->start_threshold = as->direction == AUDIO_STREAM_PLAYBACK ? as->period : 1;
+    if ((err = snd_pcm_sw_params_set_start_threshold(as->pcm, sw, as->start_threshold)) < 0) return err;
+    if ((err = snd_pcm_sw_params_set_avail_min(as->pcm, sw, as->period)) < 0) return err;
+    return snd_pcm_sw_params(as->pcm, sw);
+}
+
+// Wait for room / data; errors go through recovery
+static int alsa_wait(AlsaStream *as) {
+    int err = snd_pcm_wait(as->pcm, ALSA_WAIT_MS);
+    if (err < 0) return alsa_recover(as, err);
+    return 0;
+}
+
+// ============================================================================
+// BACKEND
+// ============================================================================
+
+static void alsa_close(void* impl) {
+    AlsaStream *as = impl;
+    if (!as) return;
+    if (as->pcm) {
+        if (as->direction == AUDIO_STREAM_CAPTURE) {
+            snd_pcm_drop(as->pcm);
+        }
+        snd_pcm_close(as->pcm);
+    }
+    free(as);
+}
+
+static void* alsa_open(const AudioStreamConfig* config, char* err, size_t err_len) {
+    AlsaStream *as = calloc(1, sizeof(AlsaStream));
+    if (!as) return NULL;
+    as->direction = config->direction;
+    as->frame_bytes = (size_t)config->channels * 2;
+
+    const char *device = config->device ? config->device : "default";
+    const char *failure = "open";
+    int ret = snd_pcm_open(&as->pcm, device,
+                           config->direction == AUDIO_STREAM_PLAYBACK ? SND_PCM_STREAM_PLAYBACK : SND_PCM_STREAM_CAPTURE,
+                           0);
+    if (ret < 0) goto fail;
+
+    failure = "hw params";
+    ret = set_hw_params(as, config, SND_PCM_ACCESS_MMAP_INTERLEAVED);
+    if (ret < 0) {
+        ret = set_hw_params(as, config, SND_PCM_ACCESS_RW_INTERLEAVED);
+    }
+    if (ret < 0) goto fail;
+
+    failure = "sw params";
+    if ((ret = set_sw_params(as)) < 0) goto fail;
+
+    failure = "prepare";
+    if ((ret = snd_pcm_prepare(as->pcm)) < 0) goto fail;
+    if (as->direction == AUDIO_STREAM_CAPTURE && (ret = snd_pcm_start(as->pcm)) < 0) goto fail;
+    return as;
+
+fail:
+    if (err && err_len) {
+        if (as->rate && as->rate != (unsigned int)config->sample_rate) {
+            snprintf(err, err_len, "alsa (%s): %d Hz not supported (device offers %u Hz), use a plughw: device",
+                     device, config->sample_rate, as->rate);
+        } else {
+            snprintf(err, err_len, "alsa %s (%s): %s", failure, device, snd_strerror(ret));
+        }
+    }
+    alsa_close(as);
+    return NULL;
+}
+
+static int alsa_write(void* impl, const void* data, size_t bytes) {
+    AlsaStream *as = impl;
+    const uint8_t *p = data;
+    snd_pcm_uframes_t frames = bytes / as->frame_bytes;
+
+    while (frames > 0) {
+        if (!as->mmap) {
+            snd_pcm_sframes_t n = snd_pcm_writei(as->pcm, p, frames);
+            if (n < 0) {
+                if (alsa_recover(as, (int)n) < 0) return -1;
+                continue;
+            }
+            p += (size_t)n * as->frame_bytes;
+            frames -= (snd_pcm_uframes_t)n;
+            continue;
+        }
+
+        snd_pcm_sframes_t avail = snd_pcm_avail_update(as->pcm);
+        if (avail < 0) {
+            if (alsa_recover(as, (int)avail) < 0) return -1;
+            continue;
+        }
+        if (avail == 0) {
+            if (snd_pcm_state(as->pcm) == SND_PCM_STATE_PREPARED) {
+                // Buffer full but not started (threshold above what fits)
+                snd_pcm_start(as->pcm);
+            }
+            if (alsa_wait(as) < 0) return -1;
+            continue;
+        }
+
+        const snd_pcm_channel_area_t *areas;
+        snd_pcm_uframes_t offset;
+        snd_pcm_uframes_t n = frames < (snd_pcm_uframes_t)avail ? frames : (snd_pcm_uframes_t)avail;
+        int ret = snd_pcm_mmap_begin(as->pcm, &areas, &offset, &n);
+        if (ret < 0) {
+            if (alsa_recover(as, ret) < 0) return -1;
+            continue;
+        }
+
+        uint8_t *dst = (uint8_t *)areas[0].addr + (areas[0].first + offset * areas[0].step) / 8;
+        memcpy(dst, p, n * as->frame_bytes);
+
+        snd_pcm_sframes_t committed = snd_pcm_mmap_commit(as->pcm, offset, n);
+        if (committed < 0 || (snd_pcm_uframes_t)committed != n) {
+            if (alsa_recover(as, committed < 0 ? (int)committed : -EPIPE) < 0) return -1;
+            continue;
+        }
+        p += n * as->frame_bytes;
+        frames -= n;
+
+        // mmap_commit does not auto-start: start once the threshold is queued
+        if (snd_pcm_state(as->pcm) == SND_PCM_STATE_PREPARED &&
+            as->buffer - (snd_pcm_uframes_t)(avail - (snd_pcm_sframes_t)n) >= as->start_threshold) {
+            ret = snd_pcm_start(as->pcm);
+            if (ret < 0 && alsa_recover(as, ret) < 0) return -1;
+        }
+    }
+    return 0;
+}
+
+static int alsa_read(void* impl, void* data, size_t bytes) {
+    AlsaStream *as = impl;
+    uint8_t *p = data;
+    snd_pcm_uframes_t frames = bytes / as->frame_bytes;
+
+    while (frames > 0) {
+        if (!as->mmap) {
+            snd_pcm_sframes_t n = snd_pcm_readi(as->pcm, p, frames);
+            if (n < 0) {
+                if (alsa_recover(as, (int)n) < 0) return -1;
+                continue;
+            }
+            p += (size_t)n * as->frame_bytes;
+            frames -= (snd_pcm_uframes_t)n;
+            continue;
+        }
+
+        snd_pcm_sframes_t avail = snd_pcm_avail_update(as->pcm);
+        if (avail < 0) {
+            if (alsa_recover(as, (int)avail) < 0) return -1;
+            continue;
+        }
+        if (avail == 0) {
+            if (alsa_wait(as) < 0) return -1;
+            continue;
+        }
+
+        const snd_pcm_channel_area_t *areas;
+        snd_pcm_uframes_t offset;
+        snd_pcm_uframes_t n = frames < (snd_pcm_uframes_t)avail ? frames : (snd_pcm_uframes_t)avail;
+        int ret = snd_pcm_mmap_begin(as->pcm, &areas, &offset, &n);
+        if (ret < 0) {
+            if (alsa_recover(as, ret) < 0) return -1;
+            continue;
+        }
+
+        const uint8_t *src = (const uint8_t *)areas[0].addr + (areas[0].first + offset * areas[0].step) / 8;
+        memcpy(p, src, n * as->frame_bytes);
+
+        snd_pcm_sframes_t committed = snd_pcm_mmap_commit(as->pcm, offset, n);
+        if (committed < 0 || (snd_pcm_uframes_t)committed != n) {
+            if (alsa_recover(as, committed < 0 ? (int)committed : -EPIPE) < 0) return -1;
+            continue;
+        }
+        p += n * as->frame_bytes;
+        frames -= n;
+    }
+    return 0;
+}
+
+static int64_t alsa_latency_us(void* impl) {
+    AlsaStream *as = impl;
+    snd_pcm_sframes_t delay = 0;
+    if (snd_pcm_delay(as->pcm, &delay) < 0 || delay < 0) return -1;
+    return (int64_t)delay * 1000000 / as->rate;
+}
+
+static void alsa_drain(void* impl) {
+    AlsaStream *as = impl;
+    if (as->direction != AUDIO_STREAM_PLAYBACK) return;
+    if (snd_pcm_state(as->pcm) == SND_PCM_STATE_RUNNING) {
+        snd_pcm_drain(as->pcm);
+    }
+}
+
+// Idle capture has overrun long ago: restart it empty
+static void alsa_flush(void* impl) {
+    AlsaStream *as = impl;
+    if (as->direction != AUDIO_STREAM_CAPTURE) return;
+    snd_pcm_drop(as->pcm);
+    if (snd_pcm_prepare(as->pcm) == 0) {
+        snd_pcm_start(as->pcm);
+    }
+}
+
+static uint64_t alsa_xruns(void* impl) {
+    return ((AlsaStream *)impl)->xruns;
+}
+
+const AudioBackendOps audio_backend_alsa_ops = {
+    .name = "alsa",
+    .open = alsa_open,
+    .write = alsa_write,
+    .read = alsa_read,
+    .latency_us = alsa_latency_us,
+    .drain = alsa_drain,
+    .close = alsa_close,
+    .xruns = alsa_xruns,
+    .flush = alsa_flush,
+};
@@ -0,0 +1,30 @@
+#ifndef AUDIO_BACKEND_IMPL_H
+#define AUDIO_BACKEND_IMPL_H
+
+// Internal interface between audio_backend.c and the backend implementations
+
+#include "audio_backend.h"
+
+typedef struct {
+    const char *name;
+    void* (*open)(const AudioStreamConfig* config, char* err, size_t err_len);
+    int (*write)(void* impl, const void* data, size_t bytes);
+    int (*read)(void* impl, void* data, size_t bytes);
+    int64_t (*latency_us)(void* impl);
+    void (*drain)(void* impl);
+    void (*close)(void* impl);
+    uint64_t (*xruns)(void* impl);   // Optional
+    void (*flush)(void* impl);       // Optional, capture
+} AudioBackendOps;
+
+extern const AudioBackendOps audio_backend_pulse_ops;
+extern const AudioBackendOps audio_backend_pulse_simple_ops;
+extern const AudioBackendOps audio_backend_loopback_ops;
+#ifdef HAVE_PIPEWIRE
+extern const AudioBackendOps audio_backend_pipewire_ops;
+#endif
+#ifdef HAVE_ALSA
+extern const AudioBackendOps audio_backend_alsa_ops;
+#endif
+
+#endif // AUDIO_BACKEND_IMPL_H
@@ -0,0 +1,234 @@
+#include "audio_backend_impl.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// In-process virtual sound card: what the playback stream plays comes back
+// on the capture stream, both paced by CLOCK_MONOTONIC like a real device.
+// One playback and one capture stream at a time, mono only. Not part of
+// AUTO; tools/latency_harness uses it to measure the call pipeline without
+// audio hardware or a sound server.
+
+#define LOOP_HISTORY 65536           // Played samples kept for capture (power of two)
+#define LOOP_MAX_SLEEP_NS 2000000    // Re-check the clock at least every 2 ms
+
+typedef struct {
+    pthread_mutex_t lock;
+    int users;
+    int rate;
+    int64_t start_ns;
+    uint64_t write_pos;              // Next sample index playback fills
+    int16_t history[LOOP_HISTORY];
+} LoopCard;
+
+static LoopCard card = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+typedef struct {
+    AudioStreamDirection direction;
+    uint64_t target;                 // Playback: samples queued ahead of the play cursor
+    uint64_t period;                 // Capture: samples delivered per device period
+    uint64_t read_pos;               // Capture: next sample index to return
+    int started;
+    uint64_t xruns;
+} LoopStream;
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+static int64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Sample index the virtual DAC is playing right now (lock held)
+static uint64_t play_pos(void) {
+    int64_t elapsed = monotonic_ns() - card.start_ns;
+    return elapsed > 0 ? (uint64_t)(elapsed * card.rate / 1000000000LL) : 0;
+}
+
+static void sleep_samples(uint64_t samples, int rate) {
+    int64_t ns = (int64_t)samples * 1000000000LL / rate;
+    if (ns > LOOP_MAX_SLEEP_NS) ns = LOOP_MAX_SLEEP_NS;
+    if (ns < 50000) ns = 50000;
+    struct timespec ts = { 0, (long)ns };
+    nanosleep(&ts, NULL);
+}
+
+// ============================================================================
+// BACKEND
+// ============================================================================
+
+static void loop_close(void* impl) {
+    LoopStream *ls = impl;
+    if (!ls) return;
+    pthread_mutex_lock(&card.lock);
+    card.users--;
+    pthread_mutex_unlock(&card.lock);
+    free(ls);
+}
+
+static void* loop_open(const AudioStreamConfig* config, char* err, size_t err_len) {
+    if (config->channels != 1) {
+        if (err && err_len) snprintf(err, err_len, "loopback: mono only");
+        return NULL;
+    }
+
+    LoopStream *ls = calloc(1, sizeof(LoopStream));
+    if (!ls) return NULL;
+    ls->direction = config->direction;
+
+    uint64_t period = config->period_bytes ? config->period_bytes / 2 : (uint64_t)config->sample_rate / 100;
+    if (period == 0) period = 1;
+    ls->period = period;
+    ls->target = (uint64_t)config->latency_ms * config->sample_rate / 1000;
+    if (ls->target < 2 * period) ls->target = 2 * period;
+
+    pthread_mutex_lock(&card.lock);
+    if (card.users == 0) {
+        // Card starts running with the first stream
+        card.rate = config->sample_rate;
+        card.start_ns = monotonic_ns();
+        card.write_pos = 0;
+    } else if (card.rate != config->sample_rate) {
+        pthread_mutex_unlock(&card.lock);
+        if (err && err_len) snprintf(err, err_len, "loopback: card runs at %d Hz", card.rate);
+        free(ls);
+        return NULL;
+    }
+    card.users++;
+    ls->read_pos = play_pos() / period * period;
+    pthread_mutex_unlock(&card.lock);
+    return ls;
+}
+
+static int loop_write(void* impl, const void* data, size_t bytes) {
+    LoopStream *ls = impl;
+    const int16_t *p = data;
+    uint64_t frames = bytes / 2;
+
+    while (frames > 0) {
+        pthread_mutex_lock(&card.lock);
+        uint64_t play = play_pos();
+        if (card.write_pos < play) {
+            // Underrun: the DAC played silence meanwhile
+            for (uint64_t i = card.write_pos; i < play && i - card.write_pos < LOOP_HISTORY; i++) {
+                card.history[i & (LOOP_HISTORY - 1)] = 0;
+            }
+            if (ls->started) ls->xruns++;
+            card.write_pos = play;
+        }
+
+        uint64_t queued = card.write_pos - play;
+        if (queued >= ls->target) {
+            pthread_mutex_unlock(&card.lock);
+            sleep_samples(queued - ls->target + 1, card.rate);
+            continue;
+        }
+
+        uint64_t n = ls->target - queued;
+        if (n > frames) n = frames;
+        for (uint64_t i = 0; i < n; i++) {
+            card.history[(card.write_pos + i) & (LOOP_HISTORY - 1)] = p[i];
+        }
+        card.write_pos += n;
+        ls->started = 1;
+        pthread_mutex_unlock(&card.lock);
+
+        p += n;
+        frames -= n;
+    }
+    return 0;
+}
+
+static int loop_read(void* impl, void* data, size_t bytes) {
+    LoopStream *ls = impl;
+    int16_t *p = data;
+    uint64_t frames = bytes / 2;
+
+    while (frames > 0) {
+        pthread_mutex_lock(&card.lock);
+        // Capture delivers whole periods, like a real device
+        uint64_t captured = play_pos() / ls->period * ls->period;
+        if (captured > ls->read_pos + LOOP_HISTORY / 2) {
+            // Reader stalled: drop the oldest audio (overrun)
+            ls->xruns++;
+            ls->read_pos = captured - ls->period;
+        }
+        if (captured <= ls->read_pos) {
+            uint64_t wait = ls->read_pos + ls->period - play_pos();
+            pthread_mutex_unlock(&card.lock);
+            sleep_samples(wait, card.rate);
+            continue;
+        }
+
+        uint64_t n = captured - ls->read_pos;
+        if (n > frames) n = frames;
+        for (uint64_t i = 0; i < n; i++) {
+            uint64_t pos = ls->read_pos + i;
+            // Never written (playback not running or behind): silence
+            *p++ = pos < card.write_pos ? card.history[pos & (LOOP_HISTORY - 1)] : 0;
+        }
+        ls->read_pos += n;
+        pthread_mutex_unlock(&card.lock);
+        frames -= n;
+    }
+    return 0;
+}
+
+static int64_t loop_latency_us(void* impl) {
+    LoopStream *ls = impl;
+    pthread_mutex_lock(&card.lock);
+    uint64_t play = play_pos();
+    int64_t samples;
+    if (ls->direction == AUDIO_STREAM_PLAYBACK) {
+        samples = card.write_pos > play ? (int64_t)(card.write_pos - play) : 0;
+    } else {
+        samples = play > ls->read_pos ? (int64_t)(play - ls->read_pos) : 0;
+    }
+    int64_t us = samples * 1000000 / card.rate;
+    pthread_mutex_unlock(&card.lock);
+    return us;
+}
+
+static void loop_drain(void* impl) {
+    LoopStream *ls = impl;
+    if (ls->direction != AUDIO_STREAM_PLAYBACK) return;
+    int64_t us = loop_latency_us(ls);
+    if (us > 0) {
+        struct timespec ts = { (time_t)(us / 1000000), (long)(us % 1000000) * 1000 };
+        nanosleep(&ts, NULL);
+    }
+}
+
+static void loop_flush(void* impl) {
+    LoopStream *ls = impl;
+    if (ls->direction != AUDIO_STREAM_CAPTURE) return;
+    pthread_mutex_lock(&card.lock);
+    ls->read_pos = play_pos() / ls->period * ls->period;
+    pthread_mutex_unlock(&card.lock);
+}
+
+static uint64_t loop_xruns(void* impl) {
+    LoopStream *ls = impl;
+    pthread_mutex_lock(&card.lock);
+    uint64_t xruns = ls->xruns;
+    pthread_mutex_unlock(&card.lock);
+    return xruns;
+}
+
+const AudioBackendOps audio_backend_loopback_ops = {
+    .name = "loopback",
+    .open = loop_open,
+    .write = loop_write,
+    .read = loop_read,
+    .latency_us = loop_latency_us,
+    .drain = loop_drain,
+    .close = loop_close,
+    .xruns = loop_xruns,
+    .flush = loop_flush,
+};
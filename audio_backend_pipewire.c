@@ -0,0 +1,321 @@
+#include "audio_backend_impl.h"
+#include "audio_ring.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <pipewire/pipewire.h>
+#include <spa/param/audio/format-utils.h>
+
+// Native PipeWire stream. The process callback (thread loop, lock held)
+// moves audio between the PipeWire buffer and an AudioRing; the caller's
+// thread blocks on the loop condition until there is room / data.
+// node.latency is set to the SCO packet so the graph runs at that quantum.
+
+#define PW_OPEN_TIMEOUT_S 3
+
+typedef struct {
+    struct pw_thread_loop *loop;
+    struct pw_stream *stream;
+    AudioStreamDirection direction;
+    AudioRing *ring;
+    size_t frame_bytes;          // channels * 2
+    size_t bytes_per_s;
+    size_t target_bytes;         // Playback: ring fill limit
+    enum pw_stream_state state;
+    int started;                 // Playback: caller has written audio
+    uint64_t underruns;          // Playback cycles padded with silence
+    char error[96];
+} PwStream;
+
+// ============================================================================
+// CALLBACKS (thread loop, lock held)
+// ============================================================================
+
+static void on_state_changed(void *userdata, enum pw_stream_state old,
+                             enum pw_stream_state state, const char *error) {
+    (void)old;
+    PwStream *ps = userdata;
+    ps->state = state;
+    if (state == PW_STREAM_STATE_ERROR && error) {
+        snprintf(ps->error, sizeof(ps->error), "%s", error);
+    }
+    pw_thread_loop_signal(ps->loop, false);
+}
+
+static void on_process(void *userdata) {
+    PwStream *ps = userdata;
+    struct pw_buffer *b = pw_stream_dequeue_buffer(ps->stream);
+    if (!b) return;
+
+    struct spa_buffer *buf = b->buffer;
+    struct spa_data *d = &buf->datas[0];
+    uint8_t *data = d->data;
+    if (!data) {
+        pw_stream_queue_buffer(ps->stream, b);
+        return;
+    }
+
+    if (ps->direction == AUDIO_STREAM_PLAYBACK) {
+        size_t bytes = d->maxsize;
+        if (b->requested && b->requested * ps->frame_bytes < bytes) {
+            bytes = b->requested * ps->frame_bytes;
+        }
+        bytes -= bytes % ps->frame_bytes;
+
+        // Whatever the caller has written, silence for the rest
+        size_t have = audio_ring_available(ps->ring);
+        if (have > bytes) have = bytes;
+        have -= have % ps->frame_bytes;
+        if (have) {
+            audio_ring_read(ps->ring, data, have);
+            ps->started = 1;
+        }
+        if (have < bytes) {
+            memset(data + have, 0, bytes - have);
+            if (ps->started) ps->underruns++;
+        }
+
+        d->chunk->offset = 0;
+        d->chunk->stride = (int32_t)ps->frame_bytes;
+        d->chunk->size = (uint32_t)bytes;
+    } else {
+        uint32_t offset = d->chunk->offset % d->maxsize;
+        uint32_t size = d->chunk->size;
+        if (size > d->maxsize - offset) size = d->maxsize - offset;
+        audio_ring_write(ps->ring, data + offset, size);
+    }
+
+    pw_stream_queue_buffer(ps->stream, b);
+    pw_thread_loop_signal(ps->loop, false);
+}
+
+static const struct pw_stream_events stream_events = {
+    PW_VERSION_STREAM_EVENTS,
+    .state_changed = on_state_changed,
+    .process = on_process,
+};
+
+static int stream_ok(const PwStream *ps) {
+    return ps->state != PW_STREAM_STATE_ERROR && ps->state != PW_STREAM_STATE_UNCONNECTED;
+}
+
+// ============================================================================
+// BACKEND
+// ============================================================================
+
+static void pipewire_close(void* impl) {
+    PwStream *ps = impl;
+    if (!ps) return;
+
+    if (ps->loop) {
+        pw_thread_loop_stop(ps->loop);
+    }
+    if (ps->stream) {
+        pw_stream_destroy(ps->stream);
+    }
+    if (ps->loop) {
+        pw_thread_loop_destroy(ps->loop);
+    }
+    audio_ring_destroy(ps->ring);
+    free(ps);
+}
+
+static void* pipewire_open(const AudioStreamConfig* config, char* err, size_t err_len) {
+    pw_init(NULL, NULL);
+
+    PwStream *ps = calloc(1, sizeof(PwStream));
+    if (!ps) return NULL;
+    ps->direction = config->direction;
+    ps->frame_bytes = (size_t)config->channels * 2;
+    ps->bytes_per_s = (size_t)config->sample_rate * ps->frame_bytes;
+    ps->state = PW_STREAM_STATE_CONNECTING;
+
+    size_t bytes_per_ms = ps->bytes_per_s / 1000;
+    size_t period = config->period_bytes ? config->period_bytes : bytes_per_ms * 10;
+    ps->target_bytes = (size_t)config->latency_ms * bytes_per_ms;
+    if (ps->target_bytes < 2 * period) ps->target_bytes = 2 * period;
+
+    // Capture keeps more headroom: the caller may stall briefly (AEC, send)
+    ps->ring = audio_ring_create(ps->direction == AUDIO_STREAM_PLAYBACK ? ps->target_bytes
+                                                                        : ps->target_bytes * 4);
+    ps->loop = pw_thread_loop_new("pcphone-audio", NULL);
+    if (!ps->ring || !ps->loop) {
+        if (err && err_len) snprintf(err, err_len, "pipewire: setup failed");
+        pipewire_close(ps);
+        return NULL;
+    }
+
+    // Quantum matched to the SCO packet (e.g. 24/8000 = 3 ms for CVSD)
+    char latency[32];
+    snprintf(latency, sizeof(latency), "%zu/%d", period / ps->frame_bytes, config->sample_rate);
+
+    struct pw_properties *props = pw_properties_new(
+        PW_KEY_MEDIA_TYPE, "Audio",
+        PW_KEY_MEDIA_CATEGORY, config->direction == AUDIO_STREAM_PLAYBACK ? "Playback" : "Capture",
+        PW_KEY_MEDIA_ROLE, "Communication",
+        PW_KEY_APP_NAME, config->app_name,
+        PW_KEY_NODE_LATENCY, latency,
+        NULL);
+    if (config->device) {
+        pw_properties_set(props, PW_KEY_TARGET_OBJECT, config->device);
+    }
+
+    pw_thread_loop_lock(ps->loop);
+
+    ps->stream = pw_stream_new_simple(pw_thread_loop_get_loop(ps->loop), config->stream_name,
+                                      props, &stream_events, ps);
+    if (!ps->stream) {
+        // No PipeWire daemon: AUTO falls through to PulseAudio
+        pw_thread_loop_unlock(ps->loop);
+        if (err && err_len) snprintf(err, err_len, "pipewire: %s", strerror(errno));
+        pipewire_close(ps);
+        return NULL;
+    }
+
+    uint8_t pod_buf[1024];
+    struct spa_pod_builder b = SPA_POD_BUILDER_INIT(pod_buf, sizeof(pod_buf));
+    struct spa_audio_info_raw info = {
+        .format = SPA_AUDIO_FORMAT_S16_LE,
+        .rate = (uint32_t)config->sample_rate,
+        .channels = (uint32_t)config->channels,
+    };
+    const struct spa_pod *params[1];
+    params[0] = spa_format_audio_raw_build(&b, SPA_PARAM_EnumFormat, &info);
+
+    int ret = pw_stream_connect(ps->stream,
+                                config->direction == AUDIO_STREAM_PLAYBACK ? PW_DIRECTION_OUTPUT : PW_DIRECTION_INPUT,
+                                PW_ID_ANY,
+                                PW_STREAM_FLAG_AUTOCONNECT | PW_STREAM_FLAG_MAP_BUFFERS,
+                                params, 1);
+
+    if (ret >= 0 && pw_thread_loop_start(ps->loop) < 0) ret = -1;
+
+    // Wait until the stream is linked (PAUSED/STREAMING) or fails
+    int waited = 0;
+    while (ret >= 0 && stream_ok(ps) &&
+           ps->state != PW_STREAM_STATE_PAUSED && ps->state != PW_STREAM_STATE_STREAMING) {
+        if (pw_thread_loop_timed_wait(ps->loop, 1) == ETIMEDOUT && ++waited >= PW_OPEN_TIMEOUT_S) {
+            snprintf(ps->error, sizeof(ps->error), "connect timeout");
+            ret = -1;
+        }
+    }
+    pw_thread_loop_unlock(ps->loop);
+
+    if (ret < 0 || !stream_ok(ps)) {
+        if (err && err_len) {
+            snprintf(err, err_len, "pipewire: %s", ps->error[0] ? ps->error : "stream connect failed");
+        }
+        pipewire_close(ps);
+        return NULL;
+    }
+    return ps;
+}
+
+static int pipewire_write(void* impl, const void* data, size_t bytes) {
+    PwStream *ps = impl;
+    const uint8_t *p = data;
+    int result = 0;
+
+    pw_thread_loop_lock(ps->loop);
+    while (bytes > 0) {
+        if (!stream_ok(ps)) {
+            result = -1;
+            break;
+        }
+        size_t fill = audio_ring_available(ps->ring);
+        size_t room = fill < ps->target_bytes ? ps->target_bytes - fill : 0;
+        size_t space = audio_ring_space(ps->ring);
+        if (room > space) room = space;
+        if (room == 0) {
+            pw_thread_loop_wait(ps->loop);
+            continue;
+        }
+        size_t n = bytes < room ? bytes : room;
+        audio_ring_write(ps->ring, p, n);
+        p += n;
+        bytes -= n;
+    }
+    pw_thread_loop_unlock(ps->loop);
+    return result;
+}
+
+static int pipewire_read(void* impl, void* data, size_t bytes) {
+    PwStream *ps = impl;
+    int result = 0;
+
+    pw_thread_loop_lock(ps->loop);
+    while (audio_ring_available(ps->ring) < bytes) {
+        if (!stream_ok(ps)) {
+            result = -1;
+            break;
+        }
+        pw_thread_loop_wait(ps->loop);
+    }
+    if (result == 0) {
+        audio_ring_read(ps->ring, data, bytes);
+    }
+    pw_thread_loop_unlock(ps->loop);
+    return result;
+}
+
+static int64_t pipewire_latency_us(void* impl) {
+    PwStream *ps = impl;
+    int64_t result = -1;
+
+    pw_thread_loop_lock(ps->loop);
+    struct pw_time t;
+    if (pw_stream_get_time_n(ps->stream, &t, sizeof(t)) == 0 && t.rate.denom) {
+        // Graph delay (in graph clock ticks) plus what sits in our ring
+        int64_t graph_us = t.delay * 1000000LL * t.rate.num / t.rate.denom;
+        int64_t ring_us = (int64_t)(audio_ring_available(ps->ring) * 1000000ULL / ps->bytes_per_s);
+        result = graph_us + ring_us;
+    }
+    pw_thread_loop_unlock(ps->loop);
+    return result;
+}
+
+static uint64_t pipewire_xruns(void* impl) {
+    PwStream *ps = impl;
+    if (ps->direction == AUDIO_STREAM_CAPTURE) {
+        return audio_ring_overruns(ps->ring);
+    }
+    pw_thread_loop_lock(ps->loop);
+    uint64_t xruns = ps->underruns;
+    pw_thread_loop_unlock(ps->loop);
+    return xruns;
+}
+
+static void pipewire_drain(void* impl) {
+    PwStream *ps = impl;
+    if (ps->direction != AUDIO_STREAM_PLAYBACK) return;
+
+    pw_thread_loop_lock(ps->loop);
+    while (audio_ring_available(ps->ring) > 0 && ps->state == PW_STREAM_STATE_STREAMING) {
+        if (pw_thread_loop_timed_wait(ps->loop, 1) == ETIMEDOUT) break;
+    }
+    pw_thread_loop_unlock(ps->loop);
+}
+
+static void pipewire_flush(void* impl) {
+    PwStream *ps = impl;
+    if (ps->direction != AUDIO_STREAM_CAPTURE) return;
+
+    pw_thread_loop_lock(ps->loop);
+    audio_ring_skip(ps->ring, audio_ring_available(ps->ring));
+    pw_thread_loop_unlock(ps->loop);
+}
+
+const AudioBackendOps audio_backend_pipewire_ops = {
+    .name = "pipewire",
+    .open = pipewire_open,
+    .write = pipewire_write,
+    .read = pipewire_read,
+    .latency_us = pipewire_latency_us,
+    .drain = pipewire_drain,
+    .close = pipewire_close,
+    .xruns = pipewire_xruns,
+    .flush = pipewire_flush,
+};
@@ -0,0 +1,342 @@
+#include "audio_backend_impl.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <pulse/pulseaudio.h>
+
+// Asynchronous PulseAudio stream with explicit buffer attributes.
+// The caller's thread blocks on the threaded mainloop condition until the
+// server requests data (playback) or delivers a fragment (capture).
+
+typedef struct {
+    pa_threaded_mainloop *mainloop;
+    pa_context *context;
+    pa_stream *stream;
+    AudioStreamDirection direction;
+    const uint8_t *peek_data;    // Current capture fragment
+    size_t peek_len;
+    int64_t latency_us;          // Last latency update, -1 = none yet
+    uint64_t xruns;              // Underflow (playback) / overflow (capture)
+} PulseStream;
+
+// ============================================================================
+// CALLBACKS (mainloop thread)
+// ============================================================================
+
+static void context_state_cb(pa_context *c, void *userdata) {
+    (void)c;
+    PulseStream *ps = userdata;
+    pa_threaded_mainloop_signal(ps->mainloop, 0);
+}
+
+static void stream_state_cb(pa_stream *s, void *userdata) {
+    (void)s;
+    PulseStream *ps = userdata;
+    pa_threaded_mainloop_signal(ps->mainloop, 0);
+}
+
+static void stream_request_cb(pa_stream *s, size_t nbytes, void *userdata) {
+    (void)s; (void)nbytes;
+    PulseStream *ps = userdata;
+    pa_threaded_mainloop_signal(ps->mainloop, 0);
+}
+
+static void stream_latency_cb(pa_stream *s, void *userdata) {
+    PulseStream *ps = userdata;
+    pa_usec_t usec;
+    int negative = 0;
+    if (pa_stream_get_latency(s, &usec, &negative) == 0) {
+        ps->latency_us = negative ? 0 : (int64_t)usec;
+    }
+    pa_threaded_mainloop_signal(ps->mainloop, 0);
+}
+
+static void stream_xrun_cb(pa_stream *s, void *userdata) {
+    (void)s;
+    PulseStream *ps = userdata;
+    ps->xruns++;
+}
+
+static void stream_success_cb(pa_stream *s, int success, void *userdata) {
+    (void)s; (void)success;
+    PulseStream *ps = userdata;
+    pa_threaded_mainloop_signal(ps->mainloop, 0);
+}
+
+// ============================================================================
+// BACKEND
+// ============================================================================
+
+static void pulse_close(void* impl) {
+    PulseStream *ps = impl;
+    if (!ps) return;
+
+    if (ps->mainloop) {
+        pa_threaded_mainloop_stop(ps->mainloop);
+    }
+    if (ps->stream) {
+        pa_stream_disconnect(ps->stream);
+        pa_stream_unref(ps->stream);
+    }
+    if (ps->context) {
+        pa_context_disconnect(ps->context);
+        pa_context_unref(ps->context);
+    }
+    if (ps->mainloop) {
+        pa_threaded_mainloop_free(ps->mainloop);
+    }
+    free(ps);
+}
+
+static void* pulse_open(const AudioStreamConfig* config, char* err, size_t err_len) {
+    PulseStream *ps = calloc(1, sizeof(PulseStream));
+    if (!ps) return NULL;
+    ps->direction = config->direction;
+    ps->latency_us = -1;
+
+    const char *failure = "mainloop";
+
+    ps->mainloop = pa_threaded_mainloop_new();
+    if (!ps->mainloop) goto fail_unlocked;
+
+    ps->context = pa_context_new(pa_threaded_mainloop_get_api(ps->mainloop), config->app_name);
+    if (!ps->context) goto fail_unlocked;
+    pa_context_set_state_callback(ps->context, context_state_cb, ps);
+
+    if (pa_threaded_mainloop_start(ps->mainloop) < 0) goto fail_unlocked;
+    pa_threaded_mainloop_lock(ps->mainloop);
+
+    // Server connection
+    failure = "context";
+    if (pa_context_connect(ps->context, NULL, PA_CONTEXT_NOFLAGS, NULL) < 0) goto fail;
+    for (;;) {
+        pa_context_state_t state = pa_context_get_state(ps->context);
+        if (state == PA_CONTEXT_READY) break;
+        if (!PA_CONTEXT_IS_GOOD(state)) goto fail;
+        pa_threaded_mainloop_wait(ps->mainloop);
+    }
+
+    // Stream
+    failure = "stream";
+    pa_sample_spec ss = {
+        .format = PA_SAMPLE_S16LE,
+        .rate = (uint32_t)config->sample_rate,
+        .channels = (uint8_t)config->channels
+    };
+    ps->stream = pa_stream_new(ps->context, config->stream_name, &ss, NULL);
+    if (!ps->stream) goto fail;
+
+    pa_stream_set_state_callback(ps->stream, stream_state_cb, ps);
+    pa_stream_set_latency_update_callback(ps->stream, stream_latency_cb, ps);
+    if (config->direction == AUDIO_STREAM_PLAYBACK) {
+        pa_stream_set_write_callback(ps->stream, stream_request_cb, ps);
+        pa_stream_set_underflow_callback(ps->stream, stream_xrun_cb, ps);
+    } else {
+        pa_stream_set_read_callback(ps->stream, stream_request_cb, ps);
+        pa_stream_set_overflow_callback(ps->stream, stream_xrun_cb, ps);
+    }
+
+    // Buffer sized to the SCO packet and the latency target instead of the
+    // server default (~2 s tlength)
+    size_t period = config->period_bytes ? config->period_bytes : pa_usec_to_bytes(10000, &ss);
+    size_t target = pa_usec_to_bytes((pa_usec_t)config->latency_ms * 1000, &ss);
+    if (target < 2 * period) target = 2 * period;
+
+    pa_buffer_attr attr;
+    attr.maxlength = (uint32_t)-1;
+    attr.tlength = (uint32_t)-1;
+    attr.prebuf = (uint32_t)-1;
+    attr.minreq = (uint32_t)-1;
+    attr.fragsize = (uint32_t)-1;
+
+    pa_stream_flags_t flags = PA_STREAM_ADJUST_LATENCY |
+                              PA_STREAM_INTERPOLATE_TIMING |
+                              PA_STREAM_AUTO_TIMING_UPDATE;
+    int ret;
+    if (config->direction == AUDIO_STREAM_PLAYBACK) {
+        attr.tlength = (uint32_t)target;
+        attr.minreq = (uint32_t)period;
+        ret = pa_stream_connect_playback(ps->stream, config->device, &attr, flags, NULL, NULL);
+    } else {
+        attr.fragsize = (uint32_t)period;
+        ret = pa_stream_connect_record(ps->stream, config->device, &attr, flags);
+    }
+    if (ret < 0) goto fail;
+
+    for (;;) {
+        pa_stream_state_t state = pa_stream_get_state(ps->stream);
+        if (state == PA_STREAM_READY) break;
+        if (!PA_STREAM_IS_GOOD(state)) goto fail;
+        pa_threaded_mainloop_wait(ps->mainloop);
+    }
+
+    pa_threaded_mainloop_unlock(ps->mainloop);
+    return ps;
+
+fail:
+    if (err && err_len) {
+        snprintf(err, err_len, "%s: %s", failure, pa_strerror(pa_context_errno(ps->context)));
+    }
+    pa_threaded_mainloop_unlock(ps->mainloop);
+    pulse_close(ps);
+    return NULL;
+
+fail_unlocked:
+    if (err && err_len) {
+        snprintf(err, err_len, "%s: setup failed", failure);
+    }
+    pulse_close(ps);
+    return NULL;
+}
+
+static int pulse_write(void* impl, const void* data, size_t bytes) {
+    PulseStream *ps = impl;
+    const uint8_t *p = data;
+    int result = 0;
+
+    pa_threaded_mainloop_lock(ps->mainloop);
+    while (bytes > 0) {
+        if (!PA_STREAM_IS_GOOD(pa_stream_get_state(ps->stream))) {
+            result = -1;
+            break;
+        }
+        size_t n = pa_stream_writable_size(ps->stream);
+        if (n == (size_t)-1) {
+            result = -1;
+            break;
+        }
+        if (n == 0) {
+            pa_threaded_mainloop_wait(ps->mainloop);
+            continue;
+        }
+        if (n > bytes) n = bytes;
+        if (pa_stream_write(ps->stream, p, n, NULL, 0, PA_SEEK_RELATIVE) < 0) {
+            result = -1;
+            break;
+        }
+        p += n;
+        bytes -= n;
+    }
+    pa_threaded_mainloop_unlock(ps->mainloop);
+    return result;
+}
+
+static int pulse_read(void* impl, void* data, size_t bytes) {
+    PulseStream *ps = impl;
+    uint8_t *p = data;
+    int result = 0;
+
+    pa_threaded_mainloop_lock(ps->mainloop);
+    while (bytes > 0) {
+        if (!PA_STREAM_IS_GOOD(pa_stream_get_state(ps->stream))) {
+            result = -1;
+            break;
+        }
+        if (ps->peek_len == 0) {
+            const void *frag = NULL;
+            size_t frag_len = 0;
+            if (pa_stream_peek(ps->stream, &frag, &frag_len) < 0) {
+                result = -1;
+                break;
+            }
+            if (frag_len == 0) {
+                pa_threaded_mainloop_wait(ps->mainloop);
+                continue;
+            }
+            if (!frag) {
+                // Hole in the record buffer
+                pa_stream_drop(ps->stream);
+                continue;
+            }
+            ps->peek_data = frag;
+            ps->peek_len = frag_len;
+        }
+
+        size_t n = ps->peek_len < bytes ? ps->peek_len : bytes;
+        memcpy(p, ps->peek_data, n);
+        p += n;
+        bytes -= n;
+        ps->peek_data += n;
+        ps->peek_len -= n;
+        if (ps->peek_len == 0) {
+            pa_stream_drop(ps->stream);
+        }
+    }
+    pa_threaded_mainloop_unlock(ps->mainloop);
+    return result;
+}
+
+static int64_t pulse_latency_us(void* impl) {
+    PulseStream *ps = impl;
+    int64_t result;
+
+    pa_threaded_mainloop_lock(ps->mainloop);
+    pa_usec_t usec;
+    int negative = 0;
+    if (pa_stream_get_latency(ps->stream, &usec, &negative) == 0) {
+        result = negative ? 0 : (int64_t)usec;
+    } else {
+        result = ps->latency_us;
+    }
+    pa_threaded_mainloop_unlock(ps->mainloop);
+    return result;
+}
+
+static uint64_t pulse_xruns(void* impl) {
+    PulseStream *ps = impl;
+    pa_threaded_mainloop_lock(ps->mainloop);
+    uint64_t xruns = ps->xruns;
+    pa_threaded_mainloop_unlock(ps->mainloop);
+    return xruns;
+}
+
+static void pulse_drain(void* impl) {
+    PulseStream *ps = impl;
+    if (ps->direction != AUDIO_STREAM_PLAYBACK) return;
+
+    pa_threaded_mainloop_lock(ps->mainloop);
+    pa_operation *op = pa_stream_drain(ps->stream, stream_success_cb, ps);
+    if (op) {
+        while (pa_operation_get_state(op) == PA_OPERATION_RUNNING &&
+               PA_STREAM_IS_GOOD(pa_stream_get_state(ps->stream))) {
+            pa_threaded_mainloop_wait(ps->mainloop);
+        }
+        pa_operation_unref(op);
+    }
+    pa_threaded_mainloop_unlock(ps->mainloop);
+}
+
+static void pulse_flush(void* impl) {
+    PulseStream *ps = impl;
+    if (ps->direction != AUDIO_STREAM_CAPTURE) return;
+
+    pa_threaded_mainloop_lock(ps->mainloop);
+    if (ps->peek_len) {
+        pa_stream_drop(ps->stream);
+        ps->peek_data = NULL;
+        ps->peek_len = 0;
+    }
+    pa_operation *op = pa_stream_flush(ps->stream, stream_success_cb, ps);
+    if (op) {
+        while (pa_operation_get_state(op) == PA_OPERATION_RUNNING &&
+               PA_STREAM_IS_GOOD(pa_stream_get_state(ps->stream))) {
+            pa_threaded_mainloop_wait(ps->mainloop);
+        }
+        pa_operation_unref(op);
+    }
+    pa_threaded_mainloop_unlock(ps->mainloop);
+}
+
+const AudioBackendOps audio_backend_pulse_ops = {
+    .name = "pulse",
+    .open = pulse_open,
+    .write = pulse_write,
+    .read = pulse_read,
+    .latency_us = pulse_latency_us,
+    .drain = pulse_drain,
+    .close = pulse_close,
+    .xruns = pulse_xruns,
+    .flush = pulse_flush,
+};
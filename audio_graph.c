@@ -0,0 +1,170 @@
+#include "audio_graph.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+    AudioStageProcess process;
+    void *ctx;
+    AudioStageStats stats;
+} AudioStage;
+
+struct AudioGraph {
+    char name[32];
+    int sample_rate;
+    int16_t *buf[2];
+    int capacity;
+    AudioStage stages[AUDIO_GRAPH_MAX_STAGES];
+    int count;
+};
+
+static int64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+AudioGraph* audio_graph_create(const char* name, int sample_rate, int capacity) {
+    if (sample_rate <= 0 || capacity <= 0) return NULL;
+
+    AudioGraph *g = calloc(1, sizeof(AudioGraph));
+    if (!g) return NULL;
+    snprintf(g->name, sizeof(g->name), "%s", name ? name : "audio");
+    g->sample_rate = sample_rate;
+    g->capacity = capacity;
+    g->buf[0] = calloc((size_t)capacity, sizeof(int16_t));
+    g->buf[1] = calloc((size_t)capacity, sizeof(int16_t));
+    if (!g->buf[0] || !g->buf[1]) {
+        audio_graph_destroy(g);
+        return NULL;
+    }
+    return g;
+}
+
+void audio_graph_destroy(AudioGraph* graph) {
+    if (!graph) return;
+    free(graph->buf[0]);
+    free(graph->buf[1]);
+    free(graph);
+}
+
+int audio_graph_add(AudioGraph* graph, AudioStageType type, const char* name, int flags,
+                    AudioStageProcess process, void* ctx) {
+    if (!graph || !process || graph->count >= AUDIO_GRAPH_MAX_STAGES) return -1;
+    AudioStage *st = &graph->stages[graph->count++];
+    memset(st, 0, sizeof(*st));
+    st->process = process;
+    st->ctx = ctx;
+    st->stats.name = name ? name : audio_stage_type_name(type);
+    st->stats.type = type;
+    st->stats.flags = flags;
+    return 0;
+}
+
+int audio_graph_run(AudioGraph* graph) {
+    if (!graph) return AUDIO_STAGE_ERROR;
+
+    int cur = 0;
+    AudioBlock block[2] = {
+        { .pcm = graph->buf[0], .capacity = graph->capacity },
+        { .pcm = graph->buf[1], .capacity = graph->capacity },
+    };
+
+    int64_t t = monotonic_ns();
+    for (int i = 0; i < graph->count; i++) {
+        AudioStage *st = &graph->stages[i];
+        AudioBlock *in = &block[cur];
+        AudioBlock *out = &block[cur ^ 1];
+        out->samples = 0;
+        out->time_us = in->time_us;
+        int in_samples = in->samples;
+
+        int ret = st->process(st->ctx, in, out);
+
+        int64_t now = monotonic_ns();
+        uint64_t ns = (uint64_t)(now - t);
+        t = now;
+        st->stats.calls++;
+        st->stats.total_ns += ns;
+        if (ns > st->stats.max_ns) st->stats.max_ns = ns;
+
+        if (ret == AUDIO_STAGE_SWAP) cur ^= 1;
+        st->stats.samples += (uint64_t)(i == 0 ? block[cur].samples : in_samples);
+
+        if (ret == AUDIO_STAGE_ERROR) return AUDIO_STAGE_ERROR;
+        if (ret == AUDIO_STAGE_DONE) return 0;
+    }
+    return 1;
+}
+
+int audio_graph_get_stats(const AudioGraph* graph, AudioStageStats* stats, int max) {
+    if (!graph) return 0;
+    int n = graph->count < max ? graph->count : max;
+    for (int i = 0; i < n && stats; i++) {
+        stats[i] = graph->stages[i].stats;
+    }
+    return graph->count;
+}
+
+void audio_graph_format_stats(const AudioGraph* graph, char* buf, size_t len) {
+    if (!graph || !buf || !len) return;
+    buf[0] = '\0';
+
+    // Load: CPU time per audio time of the source, i.e. share of the budget
+    double audio_s = 0.0;
+    if (graph->count > 0) audio_s = (double)graph->stages[0].stats.samples / graph->sample_rate;
+
+    size_t n = 0;
+    double total = 0.0;
+    for (int i = 0; i < graph->count && n < len; i++) {
+        const AudioStageStats *st = &graph->stages[i].stats;
+        double load = audio_s > 0.0 ? st->total_ns / 1e9 / audio_s * 100.0 : 0.0;
+        if (!(st->flags & AUDIO_STAGE_WAITS)) total += load;
+        int w = snprintf(buf + n, len - n, "%s%s %.1f us/10ms (%.1f%%%s, max %.0f us)",
+                         i ? ", " : "", st->name, load * 100.0, load,
+                         st->flags & AUDIO_STAGE_WAITS ? " incl. wait" : "", st->max_ns / 1e3);
+        if (w < 0) return;
+        n += (size_t)w;
+    }
+    if (n < len) snprintf(buf + n, len - n, " | total %.1f%%", total);
+}
+
+const char* audio_graph_name(const AudioGraph* graph) {
+    return graph ? graph->name : "";
+}
+
+const char* audio_stage_type_name(AudioStageType type) {
+    switch (type) {
+        case AUDIO_STAGE_SOURCE: return "source";
+        case AUDIO_STAGE_RESAMPLER: return "resampler";
+        case AUDIO_STAGE_AEC: return "aec";
+        case AUDIO_STAGE_NS: return "ns";
+        case AUDIO_STAGE_GAIN: return "gain";
+        case AUDIO_STAGE_PLC: return "plc";
+        case AUDIO_STAGE_TAP: return "tap";
+        case AUDIO_STAGE_SINK: return "sink";
+    }
+    return "?";
+}
+
+// ============================================================================
+// GAIN
+// ============================================================================
+
+void audio_gain_set_db(AudioGain* gain, double db) {
+    if (!gain) return;
+    gain->gain = (float)pow(10.0, db / 20.0);
+}
+
+int audio_gain_process(void* ctx, AudioBlock* in, AudioBlock* out) {
+    (void)out;
+    const AudioGain *g = ctx;
+    for (int i = 0; i < in->samples; i++) {
+        float v = in->pcm[i] * g->gain;
+        in->pcm[i] = v > 32767.0f ? 32767 : v < -32768.0f ? -32768 : (int16_t)lrintf(v);
+    }
+    return AUDIO_STAGE_NEXT;
+}
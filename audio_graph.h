@@ -0,0 +1,96 @@
+#ifndef AUDIO_GRAPH_H
+#define AUDIO_GRAPH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Audio processing graph for one audio thread: a chain of typed stages that
+// hand a PCM block along. The two block buffers are allocated once at
+// create; a stage either works in place or writes into the spare buffer,
+// which then becomes the current one. Every stage is timed, so the log
+// shows which one uses the real-time budget. Adding DSP means adding a
+// stage, the thread loops only call audio_graph_run().
+
+typedef enum {
+    AUDIO_STAGE_SOURCE,              // Fills the block (device read, SCO receive + decode)
+    AUDIO_STAGE_RESAMPLER,
+    AUDIO_STAGE_AEC,
+    AUDIO_STAGE_NS,
+    AUDIO_STAGE_GAIN,
+    AUDIO_STAGE_PLC,
+    AUDIO_STAGE_TAP,                 // Looks at the block, does not change it (recorder)
+    AUDIO_STAGE_SINK,                // Consumes the block (device write, encode + SCO send)
+} AudioStageType;
+
+// Stage flags
+#define AUDIO_STAGE_WAITS 0x1        // May block on a device: time is not CPU, left out of the load
+
+typedef struct {
+    int16_t* pcm;
+    int samples;                     // Valid samples in pcm
+    int capacity;
+    int64_t time_us;                 // CLOCK_MONOTONIC time of pcm[0] (capture / arrival / play)
+} AudioBlock;
+
+// Stage results
+#define AUDIO_STAGE_NEXT 0           // Block changed in place (or untouched), go on
+#define AUDIO_STAGE_SWAP 1           // Result is in out, go on with it
+#define AUDIO_STAGE_DONE 2           // Nothing to pass on this run (stage is buffering)
+#define AUDIO_STAGE_ERROR (-1)       // Stop: the thread should leave its loop
+
+// in: current block, out: spare buffer (samples = 0, same capacity)
+typedef int (*AudioStageProcess)(void* ctx, AudioBlock* in, AudioBlock* out);
+
+typedef struct {
+    const char* name;
+    AudioStageType type;
+    int flags;
+    uint64_t calls;
+    uint64_t samples;                // Samples handed to the stage (produced, for the first)
+    uint64_t total_ns;
+    uint64_t max_ns;
+} AudioStageStats;
+
+#define AUDIO_GRAPH_MAX_STAGES 12
+
+typedef struct AudioGraph AudioGraph;
+
+// capacity: samples per block buffer; sample_rate for the load figures
+AudioGraph* audio_graph_create(const char* name, int sample_rate, int capacity);
+void audio_graph_destroy(AudioGraph* graph);
+
+// Append a stage; name must stay valid. Returns 0, -1 when full
+int audio_graph_add(AudioGraph* graph, AudioStageType type, const char* name, int flags,
+                    AudioStageProcess process, void* ctx);
+
+// One pass through all stages, starting with an empty block
+// Returns 1 if the block reached the end, 0 if a stage held it back,
+// AUDIO_STAGE_ERROR if a stage failed
+int audio_graph_run(AudioGraph* graph);
+
+// Same thread as audio_graph_run. Returns the stage count
+int audio_graph_get_stats(const AudioGraph* graph, AudioStageStats* stats, int max);
+
+// "aec 412.0 us/10ms (4.1%, max 1900 us), ... | total 4.9%"
+void audio_graph_format_stats(const AudioGraph* graph, char* buf, size_t len);
+
+const char* audio_graph_name(const AudioGraph* graph);
+const char* audio_stage_type_name(AudioStageType type);
+
+// Built-in gain stage, ctx = AudioGain
+typedef struct {
+    float gain;                      // Linear
+} AudioGain;
+
+void audio_gain_set_db(AudioGain* gain, double db);
+int audio_gain_process(void* ctx, AudioBlock* in, AudioBlock* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUDIO_GRAPH_H
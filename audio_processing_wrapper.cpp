@@ -1,35 +1,90 @@
 #include "audio_processing_wrapper.h"
 
 #include <memory>
-#include <vector>
 #include <cstring>
 
 #include <webrtc/modules/audio_processing/include/audio_processing.h>
 #include <webrtc/modules/interface/module_common_types.h>
 #include <webrtc/common.h>
 
+#define AEC_MAX_DELAY_MS 500
+#define AEC_MAX_FRAME 480               // 10ms @ 48kHz
+
+// Frames and scratch live in the handle: no allocation per call
 struct AecHandle {
     std::unique_ptr<webrtc::AudioProcessing> apm;
     webrtc::StreamConfig stream_config;
     int sample_rate;
+    int frame_samples;                  // 10ms
+    int delay_ms;
+    webrtc::AudioFrame render_frame;
+    webrtc::AudioFrame capture_frame;
+    float render_out[AEC_MAX_FRAME];    // ProcessReverseStream output (unused)
 };
 
+static webrtc::EchoCancellation::SuppressionLevel echo_level(int level) {
+    switch (level) {
+        case APM_LEVEL_HIGH:     return webrtc::EchoCancellation::kHighSuppression;
+        case APM_LEVEL_MODERATE: return webrtc::EchoCancellation::kModerateSuppression;
+        default:                 return webrtc::EchoCancellation::kLowSuppression;
+    }
+}
+
+static webrtc::NoiseSuppression::Level noise_level(int level) {
+    switch (level) {
+        case APM_LEVEL_VERY_HIGH: return webrtc::NoiseSuppression::kVeryHigh;
+        case APM_LEVEL_HIGH:      return webrtc::NoiseSuppression::kHigh;
+        case APM_LEVEL_MODERATE:  return webrtc::NoiseSuppression::kModerate;
+        default:                  return webrtc::NoiseSuppression::kLow;
+    }
+}
+
+// Submodule switches only: no Initialize(), so buffers and the adaptive
+// filter state survive a change in the middle of a call
+static int apply_profile(webrtc::AudioProcessing* apm, const ApmProfile* profile) {
+    ApmProfile p = *profile;
+    apm_profile_clamp(&p);
+    int err = 0;
+
+    err |= apm->echo_cancellation()->set_suppression_level(echo_level(p.echo_suppression));
+
+    if (p.noise_suppression != APM_LEVEL_OFF) {
+        err |= apm->noise_suppression()->set_level(noise_level(p.noise_suppression));
+    }
+    err |= apm->noise_suppression()->Enable(p.noise_suppression != APM_LEVEL_OFF);
+
+    // Digital modes only: there is no analog mic level to drive
+    if (p.agc == APM_AGC_FIXED) {
+        err |= apm->gain_control()->set_mode(webrtc::GainControl::kFixedDigital);
+    } else if (p.agc == APM_AGC_ADAPTIVE) {
+        err |= apm->gain_control()->set_mode(webrtc::GainControl::kAdaptiveDigital);
+    }
+    err |= apm->gain_control()->Enable(p.agc != APM_AGC_OFF);
+
+    err |= apm->high_pass_filter()->Enable(p.high_pass != 0);
+    return err ? -1 : 0;
+}
+
 AecHandle* aec_create(int sample_rate) {
-    if (sample_rate <= 0) return nullptr;
+    return aec_create_profile(sample_rate, nullptr);
+}
+
+AecHandle* aec_create_profile(int sample_rate, const ApmProfile* profile) {
+    if (sample_rate <= 0 || sample_rate / 100 > AEC_MAX_FRAME) return nullptr;
+
+    ApmProfile fallback;
+    if (!profile) {
+        apm_profile_preset(APM_PROFILE_DEFAULT, &fallback);
+        profile = &fallback;
+    }
 
     auto apm = std::unique_ptr<webrtc::AudioProcessing>(webrtc::AudioProcessing::Create());
     if (!apm) return nullptr;
 
-    // Configure modules (minimal processing to reduce artifacts)
     apm->echo_cancellation()->Enable(true);
-    apm->echo_cancellation()->set_suppression_level(
-        webrtc::EchoCancellation::kLowSuppression);
-    apm->echo_cancellation()->enable_drift_compensation(true);
-
-    // Disable NS/AGC/HPF to avoid muffled or phantom noise
-    apm->noise_suppression()->Enable(false);
-    apm->gain_control()->Enable(false);
-    apm->high_pass_filter()->Enable(false);
+    // Clock drift is corrected before the AEC (resampler in the audio threads)
+    apm->echo_cancellation()->enable_drift_compensation(false);
+    if (apply_profile(apm.get(), profile) != 0) return nullptr;
 
     webrtc::ProcessingConfig proc_config;
     proc_config.input_stream() = webrtc::StreamConfig(sample_rate, 1);
@@ -40,14 +95,24 @@ AecHandle* aec_create(int sample_rate) {
 
     webrtc::Config extra;
     extra.Set(new webrtc::ExtendedFilter(true));
-    extra.Set(new webrtc::DelayAgnostic(true));
+    // The caller reports the measured delay (aec_set_stream_delay)
+    extra.Set(new webrtc::DelayAgnostic(false));
     apm->SetExtraOptions(extra);
 
-    auto *handle = new AecHandle{
-        std::move(apm),
-        webrtc::StreamConfig(sample_rate, 1),
-        sample_rate
-    };
+    auto *handle = new AecHandle();
+    handle->apm = std::move(apm);
+    handle->stream_config = webrtc::StreamConfig(sample_rate, 1);
+    handle->sample_rate = sample_rate;
+    handle->frame_samples = sample_rate / 100;
+    handle->delay_ms = 0;
+
+    // Frame format is fixed; calls only copy samples in and out
+    handle->render_frame.UpdateFrame(0, 0, nullptr, handle->frame_samples, sample_rate,
+                                     webrtc::AudioFrame::kNormalSpeech,
+                                     webrtc::AudioFrame::kVadUnknown, 1);
+    handle->capture_frame.UpdateFrame(0, 0, nullptr, handle->frame_samples, sample_rate,
+                                      webrtc::AudioFrame::kNormalSpeech,
+                                      webrtc::AudioFrame::kVadUnknown, 1);
 
     return handle;
 }
@@ -56,31 +121,69 @@ void aec_destroy(AecHandle* handle) {
     delete handle;
 }
 
-int aec_process(AecHandle* handle, int16_t* near_end, const int16_t* far_end, int samples) {
-    if (!handle || !near_end || !far_end || samples <= 0) return -1;
+int aec_set_profile(AecHandle* handle, const ApmProfile* profile) {
+    if (!handle || !profile) return -1;
+    return apply_profile(handle->apm.get(), profile);
+}
 
-    const int expected = handle->sample_rate / 100;
-    if (samples != expected) return -1;
+void aec_set_stream_delay(AecHandle* handle, int delay_ms) {
+    if (!handle) return;
+    if (delay_ms < 0) delay_ms = 0;
+    if (delay_ms > AEC_MAX_DELAY_MS) delay_ms = AEC_MAX_DELAY_MS;
+    handle->delay_ms = delay_ms;
+}
 
-    webrtc::AudioFrame render_frame;
-    render_frame.UpdateFrame(0, 0, far_end,
-                             samples, handle->sample_rate,
-                             webrtc::AudioFrame::kNormalSpeech,
-                             webrtc::AudioFrame::kVadUnknown, 1);
-    if (handle->apm->ProcessReverseStream(&render_frame) != 0) {
-        return -1;
-    }
+int aec_process(AecHandle* handle, int16_t* near_end, const int16_t* far_end, int samples) {
+    if (!handle || samples != handle->frame_samples) return -1;
+    return aec_process_batch(handle, near_end, far_end, samples);
+}
 
-    webrtc::AudioFrame capture_frame;
-    capture_frame.UpdateFrame(0, 0, near_end,
-                              samples, handle->sample_rate,
-                              webrtc::AudioFrame::kNormalSpeech,
-                              webrtc::AudioFrame::kVadUnknown, 1);
-    if (handle->apm->ProcessStream(&capture_frame) != 0) {
-        return -1;
+int aec_process_batch(AecHandle* handle, int16_t* near_end, const int16_t* far_end, int samples) {
+    if (!handle || !near_end || !far_end) return -1;
+
+    const int frame = handle->frame_samples;
+    if (samples <= 0 || samples % frame != 0) return -1;
+    const size_t frame_bytes = frame * sizeof(int16_t);
+
+    for (int offset = 0; offset < samples; offset += frame) {
+        std::memcpy(handle->render_frame.data_, far_end + offset, frame_bytes);
+        if (handle->apm->ProcessReverseStream(&handle->render_frame) != 0) {
+            return -1;
+        }
+
+        std::memcpy(handle->capture_frame.data_, near_end + offset, frame_bytes);
+        // Must be set before every ProcessStream, else the AEC refuses the frame
+        handle->apm->set_stream_delay_ms(handle->delay_ms);
+        if (handle->apm->ProcessStream(&handle->capture_frame) != 0) {
+            return -1;
+        }
+        std::memcpy(near_end + offset, handle->capture_frame.data_, frame_bytes);
     }
 
-    std::memcpy(near_end, capture_frame.data_, samples * sizeof(int16_t));
+    return 0;
+}
+
+int aec_process_float(AecHandle* handle, float* const* near_end, const float* const* far_end, int samples) {
+    if (!handle || !near_end || !far_end || !near_end[0] || !far_end[0]) return -1;
+
+    const int frame = handle->frame_samples;
+    if (samples <= 0 || samples % frame != 0) return -1;
+
+    // Processed in place: the APM reads and writes near_end directly
+    float *render_dest[1] = { handle->render_out };
+    for (int offset = 0; offset < samples; offset += frame) {
+        const float *far[1] = { far_end[0] + offset };
+        if (handle->apm->ProcessReverseStream(far, handle->stream_config, handle->stream_config,
+                                              render_dest) != 0) {
+            return -1;
+        }
+
+        float *near[1] = { near_end[0] + offset };
+        handle->apm->set_stream_delay_ms(handle->delay_ms);
+        if (handle->apm->ProcessStream(near, handle->stream_config, handle->stream_config, near) != 0) {
+            return -1;
+        }
+    }
 
     return 0;
 }
@@ -7,15 +7,32 @@ extern "C" {
 
 #include <stdint.h>
 
+#include "apm_profile.h"
+
 typedef struct AecHandle AecHandle;
 
-// Create AEC instance
+// Create AEC instance with the APM_PROFILE_DEFAULT profile
 // sample_rate: e.g. 8000 or 16000
 AecHandle* aec_create(int sample_rate);
 
+// Same with a given profile (NULL = default)
+AecHandle* aec_create_profile(int sample_rate, const ApmProfile* profile);
+
+// Switch suppression levels, AGC and high-pass filter in place, e.g. during
+// a call. Keeps the AudioProcessing instance and its echo path estimate.
+// Not thread safe against aec_process*: callers serialize
+// Returns 0 on success, -1 if a module rejected its setting
+int aec_set_profile(AecHandle* handle, const ApmProfile* profile);
+
 // Destroy AEC instance
 void aec_destroy(AecHandle* handle);
 
+// Render-to-capture delay: time from a far-end frame entering aec_process
+// until its echo is captured = (play time - process time) + (process time
+// - capture time) of the near-end frame. Applied to every following frame.
+// delay_ms: clamped to 0..500
+void aec_set_stream_delay(AecHandle* handle, int delay_ms);
+
 // Process audio frames
 // near_end: mic input (modified in-place)
 // far_end: speaker output (reference signal)
@@ -23,6 +40,14 @@ void aec_destroy(AecHandle* handle);
 // Returns 0 on success, -1 on error
 int aec_process(AecHandle* handle, int16_t* near_end, const int16_t* far_end, int samples);
 
+// Same for N x 10ms in one call (samples a multiple of sample_rate/100),
+// frame by frame with the current stream delay; no allocation
+int aec_process_batch(AecHandle* handle, int16_t* near_end, const int16_t* far_end, int samples);
+
+// Float variant, deinterleaved: one pointer per channel (mono: one),
+// samples in [-1, 1]. near_end is processed in place without copies
+int aec_process_float(AecHandle* handle, float* const* near_end, const float* const* far_end, int samples);
+
 #ifdef __cplusplus
 }
 #endif
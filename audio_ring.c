@@ -0,0 +1,159 @@
+#include "audio_ring.h"
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RING_CACHE_LINE 64
+
+// Producer and consumer state live on separate cache lines so the two
+// audio threads never write to the same line.
+struct AudioRing {
+    // Producer side
+    _Alignas(RING_CACHE_LINE) atomic_size_t head;
+    size_t cached_tail;
+    atomic_uint_fast64_t overruns;
+
+    // Consumer side
+    _Alignas(RING_CACHE_LINE) atomic_size_t tail;
+    size_t cached_head;
+    atomic_uint_fast64_t underruns;
+
+    // Read-only after create
+    _Alignas(RING_CACHE_LINE) size_t capacity;
+    size_t mask;
+    unsigned char *data;
+};
+
+AudioRing* audio_ring_create(size_t min_capacity_bytes) {
+    if (min_capacity_bytes == 0) return NULL;
+
+    size_t capacity = RING_CACHE_LINE;
+    while (capacity < min_capacity_bytes) {
+        capacity <<= 1;
+    }
+
+    size_t ring_size = (sizeof(AudioRing) + RING_CACHE_LINE - 1) & ~(size_t)(RING_CACHE_LINE - 1);
+    AudioRing *ring = aligned_alloc(RING_CACHE_LINE, ring_size);
+    if (!ring) return NULL;
+
+    ring->data = aligned_alloc(RING_CACHE_LINE, capacity);
+    if (!ring->data) {
+        free(ring);
+        return NULL;
+    }
+    memset(ring->data, 0, capacity);
+
+    ring->capacity = capacity;
+    ring->mask = capacity - 1;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->overruns, 0);
+    atomic_init(&ring->underruns, 0);
+    ring->cached_tail = 0;
+    ring->cached_head = 0;
+    return ring;
+}
+
+void audio_ring_destroy(AudioRing* ring) {
+    if (!ring) return;
+    free(ring->data);
+    free(ring);
+}
+
+void audio_ring_reset(AudioRing* ring) {
+    if (!ring) return;
+    atomic_store(&ring->head, 0);
+    atomic_store(&ring->tail, 0);
+    atomic_store(&ring->overruns, 0);
+    atomic_store(&ring->underruns, 0);
+    ring->cached_tail = 0;
+    ring->cached_head = 0;
+}
+
+size_t audio_ring_write(AudioRing* ring, const void* data, size_t bytes) {
+    if (!ring || !data || bytes == 0) return 0;
+
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    if (ring->capacity - (head - ring->cached_tail) < bytes) {
+        // Refresh the consumer index only when the cached one says full
+        ring->cached_tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+        if (ring->capacity - (head - ring->cached_tail) < bytes) {
+            atomic_fetch_add_explicit(&ring->overruns, 1, memory_order_relaxed);
+            return 0;
+        }
+    }
+
+    size_t offset = head & ring->mask;
+    size_t first = ring->capacity - offset;
+    if (first > bytes) first = bytes;
+    memcpy(ring->data + offset, data, first);
+    if (bytes > first) {
+        memcpy(ring->data, (const unsigned char *)data + first, bytes - first);
+    }
+
+    atomic_store_explicit(&ring->head, head + bytes, memory_order_release);
+    return bytes;
+}
+
+size_t audio_ring_read(AudioRing* ring, void* out, size_t bytes) {
+    if (!ring || !out || bytes == 0) return 0;
+
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    if (ring->cached_head - tail < bytes) {
+        ring->cached_head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        if (ring->cached_head - tail < bytes) {
+            atomic_fetch_add_explicit(&ring->underruns, 1, memory_order_relaxed);
+            return 0;
+        }
+    }
+
+    size_t offset = tail & ring->mask;
+    size_t first = ring->capacity - offset;
+    if (first > bytes) first = bytes;
+    memcpy(out, ring->data + offset, first);
+    if (bytes > first) {
+        memcpy((unsigned char *)out + first, ring->data, bytes - first);
+    }
+
+    atomic_store_explicit(&ring->tail, tail + bytes, memory_order_release);
+    return bytes;
+}
+
+size_t audio_ring_skip(AudioRing* ring, size_t bytes) {
+    if (!ring || bytes == 0) return 0;
+
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    ring->cached_head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    size_t avail = ring->cached_head - tail;
+    if (bytes > avail) bytes = avail;
+
+    atomic_store_explicit(&ring->tail, tail + bytes, memory_order_release);
+    return bytes;
+}
+
+size_t audio_ring_available(const AudioRing* ring) {
+    if (!ring) return 0;
+    size_t tail = atomic_load_explicit(&((AudioRing *)ring)->tail, memory_order_acquire);
+    size_t head = atomic_load_explicit(&((AudioRing *)ring)->head, memory_order_acquire);
+    return head - tail;
+}
+
+size_t audio_ring_space(const AudioRing* ring) {
+    if (!ring) return 0;
+    return ring->capacity - audio_ring_available(ring);
+}
+
+size_t audio_ring_capacity(const AudioRing* ring) {
+    return ring ? ring->capacity : 0;
+}
+
+uint64_t audio_ring_overruns(const AudioRing* ring) {
+    if (!ring) return 0;
+    return atomic_load_explicit(&((AudioRing *)ring)->overruns, memory_order_relaxed);
+}
+
+uint64_t audio_ring_underruns(const AudioRing* ring) {
+    if (!ring) return 0;
+    return atomic_load_explicit(&((AudioRing *)ring)->underruns, memory_order_relaxed);
+}
@@ -0,0 +1,49 @@
+#ifndef AUDIO_RING_H
+#define AUDIO_RING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Lock-free single-producer / single-consumer byte ring.
+// Exactly one thread may write and exactly one thread may read.
+typedef struct AudioRing AudioRing;
+
+// Create ring; capacity is rounded up to a power of two
+AudioRing* audio_ring_create(size_t min_capacity_bytes);
+
+// Destroy ring
+void audio_ring_destroy(AudioRing* ring);
+
+// Drop all buffered data and counters
+// Only safe while neither producer nor consumer is running
+void audio_ring_reset(AudioRing* ring);
+
+// Producer: copy all `bytes` into the ring
+// Returns bytes written, or 0 (and counts an overrun) if there is no room
+size_t audio_ring_write(AudioRing* ring, const void* data, size_t bytes);
+
+// Consumer: copy exactly `bytes` out of the ring
+// Returns bytes read, or 0 (and counts an underrun) if not enough is buffered
+size_t audio_ring_read(AudioRing* ring, void* out, size_t bytes);
+
+// Consumer: drop up to `bytes` of the oldest data, returns bytes dropped
+size_t audio_ring_skip(AudioRing* ring, size_t bytes);
+
+// Bytes currently buffered / free (a snapshot, safe from either side)
+size_t audio_ring_available(const AudioRing* ring);
+size_t audio_ring_space(const AudioRing* ring);
+size_t audio_ring_capacity(const AudioRing* ring);
+
+// Counters
+uint64_t audio_ring_overruns(const AudioRing* ring);
+uint64_t audio_ring_underruns(const AudioRing* ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUDIO_RING_H
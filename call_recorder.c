@@ -0,0 +1,345 @@
+#include "call_recorder.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "audio_ring.h"
+
+#ifdef HAVE_SNDFILE
+#include <sndfile.h>
+#endif
+
+#define REC_RING_MS 2000                 // Per side; the writer normally keeps it near empty
+#define REC_BLOCK_MS 20                  // Writer wakeup / encode block
+#define REC_MAX_LAG_MS 200               // One side this far ahead: pad the other with silence
+#define REC_MAX_BLOCK (16000 * REC_BLOCK_MS / 1000)
+
+struct CallRecorder {
+    AudioRing *far;
+    AudioRing *near;
+    atomic_uint_fast64_t far_dropped;    // Written by the producer of each side only
+    atomic_uint_fast64_t near_dropped;
+
+    int rate;
+    int stereo;
+    int format;                          // CALL_REC_* actually used
+    char path[512];
+
+    // Writer thread
+    pthread_t thread;
+    int thread_started;
+    int stop;                            // Under lock; stop_cond wakes the writer at once
+    pthread_mutex_t lock;
+    pthread_cond_t stop_cond;
+#ifdef HAVE_SNDFILE
+    SNDFILE *sf;
+#endif
+    FILE *wav;                           // Built-in WAV writer
+    uint64_t wav_bytes;
+
+    // Updated by the writer only
+    atomic_uint_fast64_t frames_written;
+    atomic_uint_fast64_t gap_samples;
+    atomic_uint_fast64_t write_errors;
+    atomic_int far_peak_ms;
+    atomic_int near_peak_ms;
+
+    int16_t far_block[REC_MAX_BLOCK];
+    int16_t near_block[REC_MAX_BLOCK];
+    int16_t out_block[REC_MAX_BLOCK * 2];
+};
+
+static const char *format_names[] = { "WAV", "FLAC", "Opus" };
+#ifdef HAVE_SNDFILE
+static const char *format_ext[] = { "wav", "flac", "opus" };
+#endif
+
+// ============================================================================
+// FILE OUTPUT
+// ============================================================================
+
+static void put_u32(unsigned char *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = (unsigned char)(v >> (8 * i));
+}
+
+static void put_u16(unsigned char *p, uint16_t v) {
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+}
+
+// 16-bit PCM header; sizes patched when the file is closed
+static int wav_write_header(FILE *f, int rate, int channels, uint64_t data_bytes) {
+    if (data_bytes > 0xFFFFFFFFu - 36) data_bytes = 0xFFFFFFFFu - 36;
+    unsigned char h[44];
+    memcpy(h, "RIFF", 4);
+    put_u32(h + 4, (uint32_t)(36 + data_bytes));
+    memcpy(h + 8, "WAVEfmt ", 8);
+    put_u32(h + 16, 16);
+    put_u16(h + 20, 1);                  // PCM
+    put_u16(h + 22, (uint16_t)channels);
+    put_u32(h + 24, (uint32_t)rate);
+    put_u32(h + 28, (uint32_t)(rate * channels * 2));
+    put_u16(h + 32, (uint16_t)(channels * 2));
+    put_u16(h + 34, 16);
+    memcpy(h + 36, "data", 4);
+    put_u32(h + 40, (uint32_t)data_bytes);
+    return fwrite(h, 1, sizeof(h), f) == sizeof(h) ? 0 : -1;
+}
+
+static int output_open(CallRecorder *rec, const char *base, int format, char *err, size_t err_len) {
+    const int channels = rec->stereo ? 2 : 1;
+
+#ifdef HAVE_SNDFILE
+    int sf_format = 0;
+    if (format == CALL_REC_FLAC) sf_format = SF_FORMAT_FLAC | SF_FORMAT_PCM_16;
+#ifdef SF_FORMAT_OPUS
+    if (format == CALL_REC_OPUS) sf_format = SF_FORMAT_OGG | SF_FORMAT_OPUS;
+#endif
+    if (sf_format) {
+        SF_INFO info = { .samplerate = rec->rate, .channels = channels, .format = sf_format };
+        snprintf(rec->path, sizeof(rec->path), "%s.%s", base, format_ext[format]);
+        rec->sf = sf_open(rec->path, SFM_WRITE, &info);
+        if (rec->sf) {
+            rec->format = format;
+            return 0;
+        }
+        // Encoder not built into this libsndfile: WAV below
+    }
+#endif
+    (void)format;
+
+    snprintf(rec->path, sizeof(rec->path), "%s.wav", base);
+    rec->wav = fopen(rec->path, "wb");
+    if (!rec->wav || wav_write_header(rec->wav, rec->rate, channels, 0) < 0) {
+        if (err && err_len) snprintf(err, err_len, "%s: %s", rec->path, strerror(errno));
+        if (rec->wav) fclose(rec->wav);
+        rec->wav = NULL;
+        return -1;
+    }
+    rec->format = CALL_REC_WAV;
+    return 0;
+}
+
+static int output_write(CallRecorder *rec, const int16_t *pcm, int frames) {
+    const int channels = rec->stereo ? 2 : 1;
+#ifdef HAVE_SNDFILE
+    if (rec->sf) {
+        return sf_writef_short(rec->sf, pcm, frames) == frames ? 0 : -1;
+    }
+#endif
+    if (!rec->wav) return -1;
+    size_t n = (size_t)frames * (size_t)channels;
+    if (fwrite(pcm, sizeof(int16_t), n, rec->wav) != n) return -1;
+    rec->wav_bytes += n * sizeof(int16_t);
+    return 0;
+}
+
+static void output_close(CallRecorder *rec) {
+#ifdef HAVE_SNDFILE
+    if (rec->sf) {
+        sf_close(rec->sf);
+        rec->sf = NULL;
+    }
+#endif
+    if (rec->wav) {
+        if (fseek(rec->wav, 0, SEEK_SET) == 0) {
+            wav_write_header(rec->wav, rec->rate, rec->stereo ? 2 : 1, rec->wav_bytes);
+        }
+        fclose(rec->wav);
+        rec->wav = NULL;
+    }
+}
+
+// ============================================================================
+// WRITER THREAD
+// ============================================================================
+
+static void note_peak(atomic_int *peak, size_t bytes, int rate) {
+    int ms = (int)(bytes / 2 * 1000 / (size_t)rate);
+    if (ms > atomic_load_explicit(peak, memory_order_relaxed)) {
+        atomic_store_explicit(peak, ms, memory_order_relaxed);
+    }
+}
+
+// Encode whatever can be paired; final: flush everything left
+static void writer_drain(CallRecorder *rec, int final) {
+    const size_t block_bytes = (size_t)(rec->rate * REC_BLOCK_MS / 1000) * sizeof(int16_t);
+    const size_t lag_bytes = (size_t)(rec->rate * REC_MAX_LAG_MS / 1000) * sizeof(int16_t);
+
+    note_peak(&rec->far_peak_ms, audio_ring_available(rec->far), rec->rate);
+    note_peak(&rec->near_peak_ms, audio_ring_available(rec->near), rec->rate);
+
+    for (;;) {
+        size_t far_avail = audio_ring_available(rec->far);
+        size_t near_avail = audio_ring_available(rec->near);
+        size_t far_bytes = far_avail < block_bytes ? far_avail : block_bytes;
+        size_t near_bytes = near_avail < block_bytes ? near_avail : block_bytes;
+
+        // Wait until both sides have a block, unless one side stalled or
+        // ended: then keep the other moving and pad with silence
+        int paired = far_bytes == block_bytes && near_bytes == block_bytes;
+        int padded = far_avail >= lag_bytes || near_avail >= lag_bytes || (final && (far_avail || near_avail));
+        if (!paired && !padded) return;
+
+        size_t take = far_bytes > near_bytes ? far_bytes : near_bytes;
+        if (far_bytes) audio_ring_read(rec->far, rec->far_block, far_bytes);
+        if (near_bytes) audio_ring_read(rec->near, rec->near_block, near_bytes);
+        memset((unsigned char *)rec->far_block + far_bytes, 0, take - far_bytes);
+        memset((unsigned char *)rec->near_block + near_bytes, 0, take - near_bytes);
+        atomic_fetch_add_explicit(&rec->gap_samples, (2 * take - far_bytes - near_bytes) / sizeof(int16_t),
+                                  memory_order_relaxed);
+
+        int frames = (int)(take / sizeof(int16_t));
+        if (rec->stereo) {
+            for (int i = 0; i < frames; i++) {
+                rec->out_block[2 * i] = rec->far_block[i];
+                rec->out_block[2 * i + 1] = rec->near_block[i];
+            }
+        } else {
+            for (int i = 0; i < frames; i++) {
+                int v = rec->far_block[i] + rec->near_block[i];
+                rec->out_block[i] = (int16_t)(v > 32767 ? 32767 : v < -32768 ? -32768 : v);
+            }
+        }
+        if (output_write(rec, rec->out_block, frames) < 0) {
+            atomic_fetch_add_explicit(&rec->write_errors, 1, memory_order_relaxed);
+        } else {
+            atomic_fetch_add_explicit(&rec->frames_written, (uint64_t)frames, memory_order_relaxed);
+        }
+    }
+}
+
+static void* writer_thread_func(void *data) {
+    CallRecorder *rec = data;
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    pthread_mutex_lock(&rec->lock);
+    while (!rec->stop) {
+        next.tv_nsec += REC_BLOCK_MS * 1000000L;
+        if (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+        int rc = 0;
+        while (!rec->stop && rc != ETIMEDOUT) {
+            rc = pthread_cond_timedwait(&rec->stop_cond, &rec->lock, &next);
+        }
+        if (rec->stop) break;
+        pthread_mutex_unlock(&rec->lock);
+        writer_drain(rec, 0);
+        pthread_mutex_lock(&rec->lock);
+    }
+    pthread_mutex_unlock(&rec->lock);
+    writer_drain(rec, 1);
+    return NULL;
+}
+
+// ============================================================================
+// API
+// ============================================================================
+
+CallRecorder* call_recorder_create(const CallRecorderConfig* config, char* err, size_t err_len) {
+    if (err && err_len) err[0] = '\0';
+    if (!config || !config->path_base || config->sample_rate <= 0 ||
+        config->sample_rate * REC_BLOCK_MS / 1000 > REC_MAX_BLOCK) {
+        if (err && err_len) snprintf(err, err_len, "invalid recorder config");
+        return NULL;
+    }
+
+    CallRecorder *rec = calloc(1, sizeof(CallRecorder));
+    if (!rec) return NULL;
+    rec->rate = config->sample_rate;
+    rec->stereo = config->stereo ? 1 : 0;
+    pthread_mutex_init(&rec->lock, NULL);
+    pthread_condattr_t ca;
+    pthread_condattr_init(&ca);
+    pthread_condattr_setclock(&ca, CLOCK_MONOTONIC);
+    pthread_cond_init(&rec->stop_cond, &ca);
+    pthread_condattr_destroy(&ca);
+
+    size_t ring_bytes = (size_t)(rec->rate * REC_RING_MS / 1000) * sizeof(int16_t);
+    rec->far = audio_ring_create(ring_bytes);
+    rec->near = audio_ring_create(ring_bytes);
+    int format = config->format >= CALL_REC_WAV && config->format <= CALL_REC_OPUS ? config->format : CALL_REC_WAV;
+    if (!rec->far || !rec->near || output_open(rec, config->path_base, format, err, err_len) < 0) {
+        call_recorder_destroy(rec);
+        return NULL;
+    }
+
+    if (pthread_create(&rec->thread, NULL, writer_thread_func, rec) != 0) {
+        if (err && err_len) snprintf(err, err_len, "writer thread: %s", strerror(errno));
+        call_recorder_destroy(rec);
+        return NULL;
+    }
+    rec->thread_started = 1;
+    return rec;
+}
+
+static void push(AudioRing *ring, atomic_uint_fast64_t *dropped, const int16_t *samples, int count) {
+    if (count <= 0) return;
+    size_t bytes = (size_t)count * sizeof(int16_t);
+    if (audio_ring_write(ring, samples, bytes) == 0) {
+        atomic_fetch_add_explicit(dropped, (uint64_t)count, memory_order_relaxed);
+    }
+}
+
+void call_recorder_push_far(CallRecorder* rec, const int16_t* samples, int count) {
+    if (rec) push(rec->far, &rec->far_dropped, samples, count);
+}
+
+void call_recorder_push_near(CallRecorder* rec, const int16_t* samples, int count) {
+    if (rec) push(rec->near, &rec->near_dropped, samples, count);
+}
+
+void call_recorder_get_stats(const CallRecorder* rec, CallRecorderStats* stats) {
+    if (!stats) return;
+    memset(stats, 0, sizeof(*stats));
+    if (!rec) return;
+    stats->far_overruns = audio_ring_overruns(rec->far);
+    stats->near_overruns = audio_ring_overruns(rec->near);
+    stats->far_dropped = atomic_load_explicit(&rec->far_dropped, memory_order_relaxed);
+    stats->near_dropped = atomic_load_explicit(&rec->near_dropped, memory_order_relaxed);
+    stats->frames_written = atomic_load_explicit(&rec->frames_written, memory_order_relaxed);
+    stats->gap_samples = atomic_load_explicit(&rec->gap_samples, memory_order_relaxed);
+    stats->write_errors = atomic_load_explicit(&rec->write_errors, memory_order_relaxed);
+    stats->far_peak_ms = atomic_load_explicit(&rec->far_peak_ms, memory_order_relaxed);
+    stats->near_peak_ms = atomic_load_explicit(&rec->near_peak_ms, memory_order_relaxed);
+    stats->ring_ms = (int)(audio_ring_capacity(rec->far) / 2 * 1000 / (size_t)rec->rate);
+}
+
+const char* call_recorder_path(const CallRecorder* rec) {
+    return rec ? rec->path : "";
+}
+
+const char* call_recorder_format_name(const CallRecorder* rec) {
+    return rec ? format_names[rec->format] : "";
+}
+
+void call_recorder_stop(CallRecorder* rec) {
+    if (!rec) return;
+    if (rec->thread_started) {
+        pthread_mutex_lock(&rec->lock);
+        rec->stop = 1;
+        pthread_cond_signal(&rec->stop_cond);
+        pthread_mutex_unlock(&rec->lock);
+        pthread_join(rec->thread, NULL);
+        rec->thread_started = 0;
+    }
+    output_close(rec);
+}
+
+void call_recorder_destroy(CallRecorder* rec) {
+    if (!rec) return;
+    call_recorder_stop(rec);
+    audio_ring_destroy(rec->far);
+    audio_ring_destroy(rec->near);
+    pthread_cond_destroy(&rec->stop_cond);
+    pthread_mutex_destroy(&rec->lock);
+    free(rec);
+}
@@ -0,0 +1,72 @@
+#ifndef CALL_RECORDER_H
+#define CALL_RECORDER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Call recorder: the audio threads copy PCM into one lock-free ring per side
+// and never wait; a writer thread pairs the two sides and encodes to disk.
+// A full ring drops the new samples and counts them, so the counters prove
+// that recording never held up an audio thread.
+// FLAC / Opus need libsndfile (HAVE_SNDFILE); otherwise, or if the encoder
+// is missing, the file is written as WAV.
+
+#define CALL_REC_WAV 0
+#define CALL_REC_FLAC 1
+#define CALL_REC_OPUS 2                  // Ogg Opus, libsndfile >= 1.0.29
+
+typedef struct {
+    const char* path_base;               // Without extension, added per format
+    int format;                          // CALL_REC_*
+    int sample_rate;                     // 8000 / 16000
+    int stereo;                          // 1: left = far end (phone), right = near end (mic); 0: mixed mono
+} CallRecorderConfig;
+
+typedef struct {
+    uint64_t far_overruns;               // Ring full events (audio thread side)
+    uint64_t near_overruns;
+    uint64_t far_dropped;                // Samples lost to those
+    uint64_t near_dropped;
+    uint64_t frames_written;             // Per channel
+    uint64_t gap_samples;                // One side silent: padded with zeros
+    uint64_t write_errors;
+    int far_peak_ms;                     // Highest ring level the writer saw
+    int near_peak_ms;
+    int ring_ms;                         // Ring capacity per side
+} CallRecorderStats;
+
+typedef struct CallRecorder CallRecorder;
+
+// Open the file and start the writer thread
+// Returns NULL on error (reason in err)
+CallRecorder* call_recorder_create(const CallRecorderConfig* config, char* err, size_t err_len);
+
+// Audio threads: copy samples in, never block. One producer per side
+void call_recorder_push_far(CallRecorder* rec, const int16_t* samples, int count);
+void call_recorder_push_near(CallRecorder* rec, const int16_t* samples, int count);
+
+// Snapshot, safe from any thread while the recorder exists
+void call_recorder_get_stats(const CallRecorder* rec, CallRecorderStats* stats);
+
+// File actually written (extension and format after any fallback)
+const char* call_recorder_path(const CallRecorder* rec);
+
+// Format name of the file, e.g. "FLAC"
+const char* call_recorder_format_name(const CallRecorder* rec);
+
+// Stop the writer, write what is buffered and close the file.
+// Call once the producers are done; stats stay readable until destroy
+void call_recorder_stop(CallRecorder* rec);
+
+// Stop (if needed) and free
+void call_recorder_destroy(CallRecorder* rec);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CALL_RECORDER_H
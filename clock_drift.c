@@ -0,0 +1,119 @@
+#include "clock_drift.h"
+
+#include <stdlib.h>
+
+#define CD_WINDOW_US 1000000      // Level averaging window
+#define CD_SETTLE_WINDOWS 3       // Windows skipped before taking the setpoint
+
+// Critically damped PI loop with ~20 s time constant:
+// s^2 + Kp s + Ki, Kp = 2w, Ki = w^2, w = 0.05 rad/s
+#define CD_KP 0.1
+#define CD_KI 0.0025
+#define CD_REPORT_WINDOWS 60.0    // Smoothing of the reported drift
+
+struct ClockDrift {
+    int sample_rate;
+    double max_correction;        // As ratio offset (ppm * 1e-6)
+
+    int64_t window_start_us;
+    double level_sum;
+    int level_count;
+    int windows;
+
+    int have_setpoint;
+    double setpoint;
+    double last_error_s;
+
+    double integral;
+    double correction;            // Applied: ratio = 1 - correction
+    double drift;                 // Smoothed correction = drift estimate
+};
+
+ClockDrift* clock_drift_create(int sample_rate, double max_ppm) {
+    if (sample_rate <= 0 || max_ppm <= 0) return NULL;
+
+    ClockDrift *cd = calloc(1, sizeof(ClockDrift));
+    if (!cd) return NULL;
+    cd->sample_rate = sample_rate;
+    cd->max_correction = max_ppm * 1e-6;
+    clock_drift_reset(cd);
+    return cd;
+}
+
+void clock_drift_destroy(ClockDrift* cd) {
+    free(cd);
+}
+
+void clock_drift_reset(ClockDrift* cd) {
+    if (!cd) return;
+    cd->window_start_us = -1;
+    cd->level_sum = 0.0;
+    cd->level_count = 0;
+    cd->windows = 0;
+    cd->have_setpoint = 0;
+    cd->setpoint = 0.0;
+    cd->last_error_s = 0.0;
+    cd->integral = 0.0;
+    cd->correction = 0.0;
+    cd->drift = 0.0;
+}
+
+static double clamp(double v, double limit) {
+    if (v > limit) return limit;
+    if (v < -limit) return -limit;
+    return v;
+}
+
+double clock_drift_update(ClockDrift* cd, double surplus_samples, int64_t now_us) {
+    if (!cd) return 1.0;
+
+    if (cd->window_start_us < 0) {
+        cd->window_start_us = now_us;
+    }
+    cd->level_sum += surplus_samples;
+    cd->level_count++;
+
+    int64_t elapsed = now_us - cd->window_start_us;
+    if (elapsed < CD_WINDOW_US) {
+        return 1.0 - cd->correction;
+    }
+
+    double mean = cd->level_sum / cd->level_count;
+    double dt = elapsed / 1e6;
+    cd->window_start_us = now_us;
+    cd->level_sum = 0.0;
+    cd->level_count = 0;
+    cd->windows++;
+
+    // Startup (buffer priming, sink prefill) is not drift
+    if (!cd->have_setpoint) {
+        if (cd->windows >= CD_SETTLE_WINDOWS) {
+            cd->setpoint = mean;
+            cd->have_setpoint = 1;
+        }
+        return 1.0 - cd->correction;
+    }
+
+    double error_s = (mean - cd->setpoint) / cd->sample_rate;
+    cd->last_error_s = error_s;
+
+    // Integrator clamped to the correction range (anti-windup)
+    cd->integral = clamp(cd->integral + CD_KI * error_s * dt, cd->max_correction);
+    cd->correction = clamp(CD_KP * error_s + cd->integral, cd->max_correction);
+
+    // Once the level holds, the average correction equals the drift
+    cd->drift += (cd->correction - cd->drift) / CD_REPORT_WINDOWS;
+    return 1.0 - cd->correction;
+}
+
+double clock_drift_ratio(const ClockDrift* cd) {
+    return cd ? 1.0 - cd->correction : 1.0;
+}
+
+double clock_drift_ppm(const ClockDrift* cd) {
+    return cd ? cd->drift * 1e6 : 0.0;
+}
+
+double clock_drift_offset_ms(const ClockDrift* cd) {
+    return cd ? cd->last_error_s * 1000.0 : 0.0;
+}
@@ -0,0 +1,44 @@
+#ifndef CLOCK_DRIFT_H
+#define CLOCK_DRIFT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+// Clock drift estimator for a buffer fed by one clock and drained by another.
+// The caller reports the buffer fill level of the resampled side; a PI loop
+// on 1 s averages turns the level trend into a resampler ratio and keeps the
+// fill level at the value it settled at during the first seconds.
+typedef struct ClockDrift ClockDrift;
+
+// max_ppm: largest correction applied to the resampler
+ClockDrift* clock_drift_create(int sample_rate, double max_ppm);
+
+// Destroy estimator
+void clock_drift_destroy(ClockDrift* cd);
+
+// Forget setpoint and estimate (new stream)
+void clock_drift_reset(ClockDrift* cd);
+
+// surplus_samples: how far the resampled stream is ahead of the other clock,
+// with any constant offset (rising = resampled side too fast)
+// now_us: monotonic time. Returns the ratio for resampler_set_ratio()
+double clock_drift_update(ClockDrift* cd, double surplus_samples, int64_t now_us);
+
+// Current resampler ratio
+double clock_drift_ratio(const ClockDrift* cd);
+
+// Estimated drift of the resampled stream's source clock, in ppm
+// (positive = source runs fast)
+double clock_drift_ppm(const ClockDrift* cd);
+
+// Level offset from the setpoint in ms (0 until the setpoint is taken)
+double clock_drift_offset_ms(const ClockDrift* cd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CLOCK_DRIFT_H
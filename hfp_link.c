@@ -0,0 +1,688 @@
+#include "hfp_link.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include <bluetooth/bluetooth.h>
+#include <bluetooth/rfcomm.h>
+
+typedef struct {
+    uint32_t id;                     // 0: free slot
+    HfpRequestKind kind;
+    int sent;                        // In the engine's queue; else held for the SLC
+    int held;
+    char command[AT_COMMAND_MAX];
+    int timeout_ms;
+    AtCallback callback;
+    void *user_data;
+    HfpLink *link;
+} HfpRequest;
+
+typedef struct {
+    int keyword;                     // -1: free slot
+    AtRecordCallback handler;
+    void *user_data;
+} HfpSubscriber;
+
+// A held request that could not be sent, completed after the lock is dropped
+typedef struct {
+    char command[AT_COMMAND_MAX];
+    AtCallback callback;
+    void *user_data;
+} HfpDropped;
+
+struct HfpLink {
+    HfpLinkConfig cfg;
+    char name[16];
+    AtEngine *at;
+
+    pthread_mutex_t lock;            // State, requests, subscribers, stats
+    HfpLinkState state;
+    HfpAgInfo ag;
+    char addr[18];
+    uint8_t channel;
+    int hf_features;
+    HfpAgInfo known;                 // From hfp_link_open(), indicator_count 0: none
+    HfpRequest requests[HFP_LINK_REQUEST_MAX];
+    uint32_t next_id;
+    HfpSubscriber subscribers[HFP_LINK_SUBSCRIBER_MAX];
+    HfpLinkStats stats;
+
+    // Reactor thread only
+    int fd;
+    unsigned slc_step;
+    int use_known;                   // known still matches this AG: no AT+CIND=?
+    int64_t open_us;
+    int64_t slc_us;
+};
+
+static int64_t monotonic_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void log_fmt(HfpLink *link, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+static void log_fmt(HfpLink *link, const char *fmt, ...) {
+    if (!link->cfg.log) return;
+    char msg[256];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(msg, sizeof(msg), fmt, ap);
+    va_end(ap);
+    link->cfg.log(msg, link->cfg.user_data);
+}
+
+static void engine_log(const char *msg, void *user_data) {
+    HfpLink *link = user_data;
+    if (link->cfg.log) link->cfg.log(msg, link->cfg.user_data);
+}
+
+static void notify(HfpLink *link, HfpLinkState state, HfpLinkState previous, int err) {
+    if (link->cfg.on_state) link->cfg.on_state(state, previous, err, link->cfg.user_data);
+}
+
+static void complete_dropped(const HfpDropped *dropped, int count) {
+    for (int i = 0; i < count; i++) {
+        if (!dropped[i].callback) continue;
+        AtResponse resp = {
+            .command = dropped[i].command,
+            .result = AT_RESULT_CLOSED,
+            .cme_error = -1,
+            .info = "",
+        };
+        dropped[i].callback(&resp, dropped[i].user_data);
+    }
+}
+
+static void drop_locked(HfpLink *link, HfpRequest *req, HfpDropped *dropped) {
+    memcpy(dropped->command, req->command, sizeof(dropped->command));
+    dropped->callback = req->callback;
+    dropped->user_data = req->user_data;
+    req->id = 0;
+    link->stats.requests++;
+    if (req->held) link->stats.held++;
+}
+
+// ----------------------------------------------------------------------------
+// Requests
+// ----------------------------------------------------------------------------
+
+// Engine callback (reactor thread, or the thread that detaches)
+static void request_done(const AtResponse *response, void *user_data) {
+    HfpRequest *req = user_data;
+    HfpLink *link = req->link;
+
+    pthread_mutex_lock(&link->lock);
+    AtCallback callback = req->callback;
+    void *cb_data = req->user_data;
+    req->id = 0;
+    link->stats.requests++;
+    if (req->held) link->stats.held++;
+    pthread_mutex_unlock(&link->lock);
+
+    if (callback) callback(response, cb_data);
+}
+
+// at_engine_send() never calls back, so the link lock may be held
+static int send_locked(HfpLink *link, HfpRequest *req) {
+    req->sent = 1;
+    return at_engine_send(link->at, req->command, req->timeout_ms, request_done, req);
+}
+
+// SLC done: held requests go out in the order they were made
+static int flush_held_locked(HfpLink *link, HfpDropped *dropped) {
+    int count = 0;
+    for (;;) {
+        HfpRequest *next = NULL;
+        for (int i = 0; i < HFP_LINK_REQUEST_MAX; i++) {
+            HfpRequest *req = &link->requests[i];
+            if (req->id && !req->sent && (!next || req->id < next->id)) next = req;
+        }
+        if (!next) return count;
+        if (send_locked(link, next) < 0) drop_locked(link, next, &dropped[count++]);
+    }
+}
+
+uint32_t hfp_link_request(HfpLink* link, HfpRequestKind kind, const char* command,
+                          int timeout_ms, AtCallback callback, void* user_data) {
+    if (!link || !command || strlen(command) >= AT_COMMAND_MAX) return 0;
+
+    pthread_mutex_lock(&link->lock);
+    if (link->state == HFP_LINK_DOWN) {
+        pthread_mutex_unlock(&link->lock);
+        return 0;
+    }
+    HfpRequest *req = NULL;
+    for (int i = 0; i < HFP_LINK_REQUEST_MAX; i++) {
+        HfpRequest *r = &link->requests[i];
+        if (!r->id) {
+            if (!req) req = r;
+        } else if (kind != HFP_REQ_COMMAND && r->kind == kind) {
+            req = NULL;                  // One dial / answer / hangup at a time
+            break;
+        }
+    }
+    if (!req) {
+        pthread_mutex_unlock(&link->lock);
+        return 0;
+    }
+
+    uint32_t id = ++link->next_id;
+    if (id == 0) id = ++link->next_id;
+    req->id = id;
+    req->kind = kind;
+    req->sent = 0;
+    req->held = link->state != HFP_LINK_READY;
+    snprintf(req->command, sizeof(req->command), "%s", command);
+    req->timeout_ms = timeout_ms;
+    req->callback = callback;
+    req->user_data = user_data;
+    req->link = link;
+    if (!req->held && send_locked(link, req) < 0) {
+        req->id = 0;
+        id = 0;
+    }
+    pthread_mutex_unlock(&link->lock);
+    return id;
+}
+
+uint32_t hfp_link_dial(HfpLink* link, const char* number, AtCallback callback, void* user_data) {
+    char cmd[AT_COMMAND_MAX];
+    if (!number || !*number || snprintf(cmd, sizeof(cmd), "ATD%s;", number) >= (int)sizeof(cmd)) return 0;
+    return hfp_link_request(link, HFP_REQ_DIAL, cmd, AT_DIAL_TIMEOUT_MS, callback, user_data);
+}
+
+uint32_t hfp_link_answer(HfpLink* link, AtCallback callback, void* user_data) {
+    return hfp_link_request(link, HFP_REQ_ANSWER, "ATA", AT_TIMEOUT_MS, callback, user_data);
+}
+
+uint32_t hfp_link_hangup(HfpLink* link, AtCallback callback, void* user_data) {
+    return hfp_link_request(link, HFP_REQ_HANGUP, "AT+CHUP", AT_TIMEOUT_MS, callback, user_data);
+}
+
+void hfp_link_cancel(HfpLink* link, uint32_t id) {
+    if (!link || !id) return;
+    pthread_mutex_lock(&link->lock);
+    for (int i = 0; i < HFP_LINK_REQUEST_MAX; i++) {
+        HfpRequest *req = &link->requests[i];
+        if (req->id != id) continue;
+        req->callback = NULL;
+        req->kind = HFP_REQ_COMMAND;     // A new dial may go out
+        if (!req->sent) req->id = 0;
+        break;
+    }
+    pthread_mutex_unlock(&link->lock);
+}
+
+// ----------------------------------------------------------------------------
+// Events
+// ----------------------------------------------------------------------------
+
+int hfp_link_subscribe(HfpLink* link, int keyword, AtRecordCallback handler, void* user_data) {
+    if (!link || !handler || keyword < 0 || keyword > HFP_LINK_ANY_EVENT) return -1;
+    int ret = -1;
+    pthread_mutex_lock(&link->lock);
+    for (int i = 0; i < HFP_LINK_SUBSCRIBER_MAX; i++) {
+        HfpSubscriber *s = &link->subscribers[i];
+        if (s->keyword >= 0) continue;
+        s->keyword = keyword;
+        s->handler = handler;
+        s->user_data = user_data;
+        ret = 0;
+        break;
+    }
+    pthread_mutex_unlock(&link->lock);
+    return ret;
+}
+
+// Engine: every unsolicited record
+static void link_on_record(const AtRecord *rec, void *user_data) {
+    HfpLink *link = user_data;
+    HfpSubscriber matched[HFP_LINK_SUBSCRIBER_MAX];
+    int count = 0;
+
+    pthread_mutex_lock(&link->lock);
+    for (int i = 0; i < HFP_LINK_SUBSCRIBER_MAX; i++) {
+        const HfpSubscriber *s = &link->subscribers[i];
+        if (s->keyword == (int)rec->keyword || s->keyword == HFP_LINK_ANY_EVENT) matched[count++] = *s;
+    }
+    pthread_mutex_unlock(&link->lock);
+
+    for (int i = 0; i < count; i++) matched[i].handler(rec, matched[i].user_data);
+}
+
+// ----------------------------------------------------------------------------
+// Connection (reactor thread)
+// ----------------------------------------------------------------------------
+
+static void link_down(HfpLink *link, int err) {
+    IoReactor *reactor = link->cfg.reactor;
+    io_reactor_remove(reactor, at_engine_timer_fd(link->at));
+    if (link->fd >= 0) io_reactor_remove(reactor, link->fd);
+
+    HfpDropped dropped[HFP_LINK_REQUEST_MAX];
+    int count = 0;
+    pthread_mutex_lock(&link->lock);
+    HfpLinkState previous = link->state;
+    link->state = HFP_LINK_DOWN;
+    if (err && previous >= HFP_LINK_SLC) link->stats.lost++;
+    for (int i = 0; i < HFP_LINK_REQUEST_MAX; i++) {
+        HfpRequest *req = &link->requests[i];
+        if (req->id && !req->sent) drop_locked(link, req, &dropped[count++]);
+    }
+    pthread_mutex_unlock(&link->lock);
+
+    // Requests in the engine complete with AT_RESULT_CLOSED
+    at_engine_detach(link->at);
+    if (link->fd >= 0) {
+        shutdown(link->fd, SHUT_RDWR);
+        close(link->fd);
+        link->fd = -1;
+    }
+    complete_dropped(dropped, count);
+    if (previous != HFP_LINK_DOWN) notify(link, HFP_LINK_DOWN, previous, err);
+}
+
+static void link_on_data(int fd, uint32_t events, void *user_data) {
+    (void)fd;
+    HfpLink *link = user_data;
+    if ((events & EPOLLOUT) && at_engine_flush(link->at) < 0) {
+        link_down(link, ECONNRESET);
+        return;
+    }
+    if (!(events & ~EPOLLOUT)) return;
+    if (at_engine_process(link->at) < 0) link_down(link, ECONNRESET);
+}
+
+// Engine: a command is held up by RFCOMM flow control, or went out
+static void link_on_write_wait(int fd, int wait, void *user_data) {
+    HfpLink *link = user_data;
+    io_reactor_modify(link->cfg.reactor, fd, wait ? EPOLLIN | EPOLLOUT : EPOLLIN);
+}
+
+static void link_on_timer(int fd, uint32_t events, void *user_data) {
+    (void)fd; (void)events;
+    HfpLink *link = user_data;
+    at_engine_expire(link->at);
+}
+
+// Posted from an engine callback, which must not detach the engine itself
+static void link_fail_task(void *data) {
+    HfpLink *link = data;
+    if (hfp_link_state(link) == HFP_LINK_SLC) link_down(link, EPROTO);
+}
+
+// SLC handshake: each command is queued from the result callback of the
+// previous one. Optional steps that fail do not stop it
+typedef struct {
+    const char *command;             // NULL: AT+BRSF=<HF features>
+    int (*needed)(HfpLink *link);    // NULL: always
+    // NULL or 0: on to the next step; -1: the handler took over
+    int (*on_result)(HfpLink *link, const AtResponse *response);
+} HfpSlcStep;
+
+enum {
+    SLC_BRSF,
+    SLC_BAC,
+    SLC_CIND_TEST,
+    SLC_CIND,
+    SLC_CMER,
+    SLC_CLIP,
+    SLC_NREC,
+    SLC_STEP_COUNT,
+};
+
+static void slc_send(HfpLink *link, unsigned step);
+
+static void link_forget_known(HfpLink *link, const char *why) {
+    if (!link->use_known) return;
+    link->use_known = 0;
+    log_fmt(link, "🗂 %s: %s, asking AT+CIND=?", link->name, why);
+}
+
+// Without +BRSF there is no HFP gateway on this channel
+static int slc_on_brsf(HfpLink *link, const AtResponse *response) {
+    const char *p = strstr(response->info, "+BRSF:");
+    if (response->result != AT_RESULT_OK || !p) {
+        log_fmt(link, "⚠️ %s: AT+BRSF not answered (%s)", link->name, at_result_name(response->result));
+        io_reactor_post(link->cfg.reactor, link_fail_task, link);
+        return -1;
+    }
+    uint32_t features = (uint32_t)strtoul(p + strlen("+BRSF:"), NULL, 10);
+    pthread_mutex_lock(&link->lock);
+    link->ag.features = features;
+    pthread_mutex_unlock(&link->lock);
+    if (features != link->known.features) link_forget_known(link, "AG features changed");
+    return 0;
+}
+
+static int slc_codecs_needed(HfpLink *link) {
+    return (link->hf_features & HFP_HF_FEATURE_CODEC_NEGOTIATION) &&
+           (hfp_link_ag_features(link) & HFP_AG_FEATURE_CODEC_NEGOTIATION);
+}
+
+static int slc_on_bac(HfpLink *link, const AtResponse *response) {
+    if (response->result == AT_RESULT_OK) log_fmt(link, "🎧 Codecs offered: CVSD, mSBC");
+    return 0;
+}
+
+static int slc_cind_test_needed(HfpLink *link) {
+    return !link->use_known;
+}
+
+// +CIND: ("service",(0,1)),("call",(0,1)),("callsetup",(0-3)),...
+static int slc_on_cind_test(HfpLink *link, const AtResponse *response) {
+    const char *p = strstr(response->info, "+CIND:");
+    if (response->result != AT_RESULT_OK || !p) return 0;
+
+    HfpAgInfo ag = {0};
+    int depth = 0;
+    for (p += strlen("+CIND:"); *p && *p != '\n'; p++) {
+        if (*p == '(') depth++;
+        else if (*p == ')') depth--;
+        else if (*p == '"' && depth == 1) {
+            const char *end = strchr(p + 1, '"');
+            if (!end) break;
+            if (ag.indicator_count < HFP_LINK_INDICATOR_MAX) {
+                int len = (int)(end - p - 1);
+                if (len >= HFP_LINK_INDICATOR_NAME_MAX) len = HFP_LINK_INDICATOR_NAME_MAX - 1;
+                memcpy(ag.indicators[ag.indicator_count++], p + 1, (size_t)len);
+            }
+            p = end;
+        }
+    }
+
+    pthread_mutex_lock(&link->lock);
+    memcpy(link->ag.indicators, ag.indicators, sizeof(ag.indicators));
+    link->ag.indicator_count = ag.indicator_count;
+    pthread_mutex_unlock(&link->lock);
+    return 0;
+}
+
+// The known indicator map holds if AT+CIND? reports as many values
+static int slc_on_cind(HfpLink *link, const AtResponse *response) {
+    if (!link->use_known) return 0;
+    const char *p = strstr(response->info, "+CIND:");
+    int count = 0;
+    if (response->result == AT_RESULT_OK && p) {
+        count = 1;
+        for (p += strlen("+CIND:"); *p && *p != '\n'; p++) count += *p == ',';
+    }
+    if (count != link->known.indicator_count) {
+        link_forget_known(link, "indicators changed");
+        slc_send(link, SLC_CIND_TEST);
+        return -1;
+    }
+
+    pthread_mutex_lock(&link->lock);
+    memcpy(link->ag.indicators, link->known.indicators, sizeof(link->ag.indicators));
+    link->ag.indicator_count = link->known.indicator_count;
+    pthread_mutex_unlock(&link->lock);
+    return 0;
+}
+
+// The AG's EC/NR off, if it has one, only when we cancel the echo ourselves
+static int slc_nrec_needed(HfpLink *link) {
+    return (link->hf_features & HFP_HF_FEATURE_EC_NR) &&
+           (hfp_link_ag_features(link) & HFP_AG_FEATURE_EC_NR);
+}
+
+static const HfpSlcStep slc_steps[SLC_STEP_COUNT] = {
+    [SLC_BRSF] = { NULL, NULL, slc_on_brsf },
+    [SLC_BAC] = { "AT+BAC=1,2", slc_codecs_needed, slc_on_bac },   // Codec negotiation (if both sides support it)
+    [SLC_CIND_TEST] = { "AT+CIND=?", slc_cind_test_needed, slc_on_cind_test },
+    [SLC_CIND] = { "AT+CIND?", NULL, slc_on_cind },
+    [SLC_CMER] = { "AT+CMER=3,0,0,1", NULL, NULL },                // Event reporting active
+    [SLC_CLIP] = { "AT+CLIP=1", NULL, NULL },                      // Caller ID display active
+    [SLC_NREC] = { "AT+NREC=0", slc_nrec_needed, NULL },
+};
+
+static void slc_ready(HfpLink *link) {
+    int64_t now = monotonic_us();
+    HfpDropped dropped[HFP_LINK_REQUEST_MAX];
+
+    pthread_mutex_lock(&link->lock);
+    link->state = HFP_LINK_READY;
+    link->stats.slc_ms = (now - link->slc_us) / 1000.0;
+    link->stats.ready_ms = (now - link->open_us) / 1000.0;
+    link->stats.slc_cached = link->use_known;
+    if (link->use_known) link->stats.cached++;
+    int count = flush_held_locked(link, dropped);
+    pthread_mutex_unlock(&link->lock);
+
+    complete_dropped(dropped, count);
+    notify(link, HFP_LINK_READY, HFP_LINK_SLC, 0);
+}
+
+static void slc_result(const AtResponse *response, void *user_data) {
+    HfpLink *link = user_data;
+    if (response->result == AT_RESULT_CLOSED) return;  // Link gone, link_down() reports it
+    const HfpSlcStep *s = &slc_steps[link->slc_step];
+    if (s->on_result && s->on_result(link, response) < 0) return;
+    slc_send(link, link->slc_step + 1);
+}
+
+static void slc_send(HfpLink *link, unsigned step) {
+    while (step < SLC_STEP_COUNT && slc_steps[step].needed && !slc_steps[step].needed(link)) step++;
+    if (step == SLC_STEP_COUNT) {
+        slc_ready(link);
+        return;
+    }
+
+    char cmd[AT_COMMAND_MAX];
+    if (slc_steps[step].command) {
+        snprintf(cmd, sizeof(cmd), "%s", slc_steps[step].command);
+    } else {
+        snprintf(cmd, sizeof(cmd), "AT+BRSF=%d", link->hf_features);
+    }
+    link->slc_step = step;
+    at_engine_send(link->at, cmd, AT_TIMEOUT_MS, slc_result, link);
+}
+
+// Non-blocking connect finished
+static void link_on_connected(int fd, uint32_t events, void *user_data) {
+    (void)events;
+    HfpLink *link = user_data;
+    int err = 0;
+    socklen_t len = sizeof(err);
+    if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0) err = errno;
+    if (err) {
+        link_down(link, err);
+        return;
+    }
+
+    // Stays non-blocking: a stalled write waits in the engine for EPOLLOUT
+    at_engine_attach(link->at, fd);
+    io_reactor_add(link->cfg.reactor, fd, EPOLLIN, link_on_data, link);
+    io_reactor_add(link->cfg.reactor, at_engine_timer_fd(link->at), EPOLLIN, link_on_timer, link);
+
+    pthread_mutex_lock(&link->lock);
+    link->state = HFP_LINK_SLC;
+    memset(&link->ag, 0, sizeof(link->ag));
+    link->use_known = link->known.indicator_count > 0;
+    link->stats.connects++;
+    pthread_mutex_unlock(&link->lock);
+    link->slc_us = monotonic_us();
+
+    notify(link, HFP_LINK_SLC, HFP_LINK_CONNECTING, 0);
+    slc_send(link, 0);
+}
+
+static void link_open_task(void *data) {
+    HfpLink *link = data;
+
+    pthread_mutex_lock(&link->lock);
+    int connecting = link->state == HFP_LINK_CONNECTING && link->fd < 0;
+    struct sockaddr_rc addr = {0};
+    addr.rc_family = AF_BLUETOOTH;
+    addr.rc_channel = link->channel;
+    str2ba(link->addr, &addr.rc_bdaddr);
+    pthread_mutex_unlock(&link->lock);
+    if (!connecting) return;  // Closed before the task ran
+
+    notify(link, HFP_LINK_CONNECTING, HFP_LINK_DOWN, 0);
+    link->fd = socket(AF_BLUETOOTH, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, BTPROTO_RFCOMM);
+    if (link->fd < 0) {
+        link_down(link, errno);
+        return;
+    }
+    if (connect(link->fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 && errno != EINPROGRESS) {
+        link_down(link, errno);
+        return;
+    }
+    if (io_reactor_add(link->cfg.reactor, link->fd, EPOLLOUT, link_on_connected, link) < 0) {
+        link_down(link, ENOSPC);
+    }
+}
+
+static void link_close_task(void *data) {
+    link_down(data, 0);
+}
+
+// ----------------------------------------------------------------------------
+
+HfpLink* hfp_link_create(const HfpLinkConfig* config) {
+    if (!config || !config->reactor) return NULL;
+    HfpLink *link = calloc(1, sizeof(HfpLink));
+    if (!link) return NULL;
+    link->cfg = *config;
+    snprintf(link->name, sizeof(link->name), "%s", config->name ? config->name : "hfp");
+    link->cfg.name = link->name;
+    link->fd = -1;
+    for (int i = 0; i < HFP_LINK_SUBSCRIBER_MAX; i++) link->subscribers[i].keyword = -1;
+
+    AtEngineConfig at_cfg = {
+        .name = link->name,
+        .on_unsolicited = link_on_record,
+        .log = engine_log,
+        .on_write_wait = link_on_write_wait,
+        .user_data = link,
+        .event_loop = 1,
+    };
+    link->at = at_engine_create(&at_cfg);
+    if (!link->at) {
+        free(link);
+        return NULL;
+    }
+    pthread_mutex_init(&link->lock, NULL);
+    return link;
+}
+
+void hfp_link_destroy(HfpLink* link) {
+    if (!link) return;
+    hfp_link_close(link);
+    at_engine_destroy(link->at);
+    pthread_mutex_destroy(&link->lock);
+    free(link);
+}
+
+int hfp_link_open(HfpLink* link, const char* addr, uint8_t channel, int hf_features,
+                  const HfpAgInfo* known) {
+    if (!link || !addr) return -1;
+
+    pthread_mutex_lock(&link->lock);
+    if (link->state != HFP_LINK_DOWN) {
+        pthread_mutex_unlock(&link->lock);
+        return -1;
+    }
+    link->state = HFP_LINK_CONNECTING;
+    snprintf(link->addr, sizeof(link->addr), "%s", addr);
+    link->channel = channel;
+    link->hf_features = hf_features;
+    if (known) link->known = *known;
+    else memset(&link->known, 0, sizeof(link->known));
+    link->open_us = monotonic_us();
+    pthread_mutex_unlock(&link->lock);
+
+    if (io_reactor_post(link->cfg.reactor, link_open_task, link) < 0) {
+        pthread_mutex_lock(&link->lock);
+        link->state = HFP_LINK_DOWN;
+        pthread_mutex_unlock(&link->lock);
+        return -1;
+    }
+    return 0;
+}
+
+void hfp_link_close(HfpLink* link) {
+    if (!link) return;
+    // On the reactor thread: once this returns nothing reads the socket
+    if (io_reactor_call(link->cfg.reactor, link_close_task, link) < 0) {
+        link_close_task(link);
+    }
+}
+
+HfpLinkState hfp_link_state(HfpLink* link) {
+    if (!link) return HFP_LINK_DOWN;
+    pthread_mutex_lock(&link->lock);
+    HfpLinkState state = link->state;
+    pthread_mutex_unlock(&link->lock);
+    return state;
+}
+
+uint32_t hfp_link_ag_features(HfpLink* link) {
+    if (!link) return 0;
+    pthread_mutex_lock(&link->lock);
+    uint32_t features = link->ag.features;
+    pthread_mutex_unlock(&link->lock);
+    return features;
+}
+
+void hfp_link_get_ag_info(HfpLink* link, HfpAgInfo* info) {
+    if (!info) return;
+    memset(info, 0, sizeof(*info));
+    if (!link) return;
+    pthread_mutex_lock(&link->lock);
+    *info = link->ag;
+    pthread_mutex_unlock(&link->lock);
+}
+
+int hfp_link_indicator(HfpLink* link, const char* name) {
+    if (!link || !name) return 0;
+    int index = 0;
+    pthread_mutex_lock(&link->lock);
+    for (int i = 0; i < link->ag.indicator_count; i++) {
+        if (strcmp(link->ag.indicators[i], name) == 0) {
+            index = i + 1;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&link->lock);
+    return index;
+}
+
+void hfp_link_get_stats(HfpLink* link, HfpLinkStats* stats) {
+    if (!stats) return;
+    memset(stats, 0, sizeof(*stats));
+    if (!link) return;
+    pthread_mutex_lock(&link->lock);
+    *stats = link->stats;
+    pthread_mutex_unlock(&link->lock);
+    at_engine_get_stats(link->at, &stats->at);
+}
+
+void hfp_link_format_stats(const HfpLinkStats* stats, char* buf, size_t len) {
+    if (!stats || !buf || len == 0) return;
+    snprintf(buf, len, "ready in %.0f ms (SLC %.0f ms), %llu requests (%llu held), %llu connects (%llu cached), %llu lost",
+             stats->ready_ms, stats->slc_ms,
+             (unsigned long long)stats->requests, (unsigned long long)stats->held,
+             (unsigned long long)stats->connects, (unsigned long long)stats->cached,
+             (unsigned long long)stats->lost);
+}
+
+const char* hfp_link_state_name(HfpLinkState state) {
+    switch (state) {
+        case HFP_LINK_DOWN: return "down";
+        case HFP_LINK_CONNECTING: return "connecting";
+        case HFP_LINK_SLC: return "slc";
+        case HFP_LINK_READY: return "ready";
+    }
+    return "?";
+}
@@ -0,0 +1,146 @@
+#ifndef HFP_LINK_H
+#define HFP_LINK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include "at_engine.h"
+#include "io_reactor.h"
+
+// The RFCOMM service level connection (SLC) to the phone, one per device,
+// owned by the reactor thread: non-blocking connect, then the handshake
+// (AT+BRSF, AT+BAC, AT+CIND, AT+CMER, AT+CLIP), each command sent when the
+// previous one is answered. Dial, answer, hangup and any other command are
+// requests on this link: each gets an id and its own result callback, which
+// the AT engine matches to the final result code in order. Requests made
+// while the link is still coming up are held and sent once the SLC is
+// ready; when the link goes down every pending request completes with
+// AT_RESULT_CLOSED. Unsolicited results (+CIEV, RING, +CLIP, +BCS) go to
+// the subscribers of their keyword.
+//
+// The AG's answers that do not change between connections (HfpAgInfo) can
+// be handed back on the next open: AT+CIND=? is then skipped as long as
+// +BRSF and the AT+CIND? value count still match.
+
+#define HFP_LINK_REQUEST_MAX 16
+#define HFP_LINK_SUBSCRIBER_MAX 16
+#define HFP_LINK_ANY_EVENT AT_KW_COUNT   // Subscribe to every unsolicited record
+#define HFP_LINK_INDICATOR_MAX 20
+#define HFP_LINK_INDICATOR_NAME_MAX 16
+
+// Feature bits (AT+BRSF / +BRSF)
+#define HFP_HF_FEATURE_EC_NR 0x0001
+#define HFP_HF_FEATURE_CODEC_NEGOTIATION 0x0080
+#define HFP_AG_FEATURE_EC_NR 0x0002
+#define HFP_AG_FEATURE_CODEC_NEGOTIATION 0x0200
+
+typedef enum {
+    HFP_LINK_DOWN,
+    HFP_LINK_CONNECTING,             // RFCOMM connect in progress
+    HFP_LINK_SLC,                    // Handshake
+    HFP_LINK_READY,
+} HfpLinkState;
+
+typedef enum {
+    HFP_REQ_COMMAND,                 // Anything else (AT+BCS, AT+BAC)
+    HFP_REQ_DIAL,                    // ATD<number>;
+    HFP_REQ_ANSWER,                  // ATA
+    HFP_REQ_HANGUP,                  // AT+CHUP
+} HfpRequestKind;
+
+// Reactor thread. Going DOWN: err is 0 after hfp_link_close(), the connect
+// errno if previous is HFP_LINK_CONNECTING, EPROTO if AT+BRSF was not
+// answered (no HFP gateway on that channel), ECONNRESET if the link was lost
+typedef void (*HfpLinkStateCallback)(HfpLinkState state, HfpLinkState previous, int err, void* user_data);
+
+typedef struct {
+    const char* name;                // For the log
+    IoReactor* reactor;              // Runs the link; must outlive it
+    HfpLinkStateCallback on_state;
+    AtLogCallback log;               // Command round trips, codec offer
+    void* user_data;
+} HfpLinkConfig;
+
+// What the AG said in the SLC, the same on every connection to one phone
+typedef struct {
+    uint32_t features;               // +BRSF
+    int indicator_count;             // 0: unknown
+    char indicators[HFP_LINK_INDICATOR_MAX][HFP_LINK_INDICATOR_NAME_MAX];  // +CIND=? names, index 1 first
+} HfpAgInfo;
+
+typedef struct {
+    uint64_t connects;
+    uint64_t cached;                 // Of those, SLCs without AT+CIND=?
+    uint64_t lost;
+    uint64_t requests;               // Completed, any result
+    uint64_t held;                   // Of those, waited for the SLC
+    double slc_ms;                   // Last handshake
+    double ready_ms;                 // Last hfp_link_open() to ready
+    int slc_cached;                  // Last handshake used the known AG info
+    AtEngineStats at;                // Current connection
+} HfpLinkStats;
+
+typedef struct HfpLink HfpLink;
+
+HfpLink* hfp_link_create(const HfpLinkConfig* config);
+
+// Closes the link first
+void hfp_link_destroy(HfpLink* link);
+
+// Connect to addr ("AA:BB:CC:DD:EE:FF") on channel, any thread, returns at
+// once. hf_features go out in AT+BRSF; with HFP_HF_FEATURE_CODEC_NEGOTIATION
+// mSBC is offered if the AG negotiates codecs too. known (may be NULL) is
+// the AG info from an earlier connection (hfp_link_get_ag_info())
+// Returns 0, -1 if the link is not down
+int hfp_link_open(HfpLink* link, const char* addr, uint8_t channel, int hf_features,
+                  const HfpAgInfo* known);
+
+// Close the socket (closed when this returns); pending requests complete
+// with AT_RESULT_CLOSED
+void hfp_link_close(HfpLink* link);
+
+HfpLinkState hfp_link_state(HfpLink* link);
+
+// AG features from +BRSF, 0 before the SLC
+uint32_t hfp_link_ag_features(HfpLink* link);
+
+// AG info of the current (or last) SLC, complete once it is ready
+void hfp_link_get_ag_info(HfpLink* link, HfpAgInfo* info);
+
+// +CIEV index of the indicator called name ("call", "callsetup"), 0 if unknown
+int hfp_link_indicator(HfpLink* link, const char* name);
+
+// Queue a request, any thread; callback (may be NULL) runs once on the
+// reactor thread, unless cancelled. timeout_ms <= 0 means AT_TIMEOUT_MS
+// Returns the request id (> 0), 0 if the link is down, the table is full,
+// or a request of the same call control kind is still pending
+uint32_t hfp_link_request(HfpLink* link, HfpRequestKind kind, const char* command,
+                          int timeout_ms, AtCallback callback, void* user_data);
+
+uint32_t hfp_link_dial(HfpLink* link, const char* number, AtCallback callback, void* user_data);
+uint32_t hfp_link_answer(HfpLink* link, AtCallback callback, void* user_data);
+uint32_t hfp_link_hangup(HfpLink* link, AtCallback callback, void* user_data);
+
+// Drop the callback of a pending request; a held one is not sent at all
+void hfp_link_cancel(HfpLink* link, uint32_t id);
+
+// handler runs on the reactor thread for every unsolicited record with this
+// keyword (HFP_LINK_ANY_EVENT: all), in subscription order
+// Returns 0, -1 if the table is full
+int hfp_link_subscribe(HfpLink* link, int keyword, AtRecordCallback handler, void* user_data);
+
+void hfp_link_get_stats(HfpLink* link, HfpLinkStats* stats);
+
+// "ready in 1450 ms (SLC 212 ms), 3 requests (1 held), 2 connects (1 cached), 0 lost"
+void hfp_link_format_stats(const HfpLinkStats* stats, char* buf, size_t len);
+
+const char* hfp_link_state_name(HfpLinkState state);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HFP_LINK_H
@@ -0,0 +1,345 @@
+#define _GNU_SOURCE
+#include "io_reactor.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#define WAKE_TAG UINT64_MAX              // epoll data of the eventfd
+
+typedef struct {
+    int fd;                              // -1: free slot
+    uint32_t generation;                 // Bumped on remove: stale events are dropped
+    IoCallback callback;
+    void *user_data;
+} IoWatch;
+
+typedef struct {
+    IoTask task;
+    void *user_data;
+} IoQueuedTask;
+
+struct IoReactor {
+    char name[16];
+    int epoll_fd;
+    int wake_fd;
+    pthread_t thread;
+
+    pthread_mutex_t lock;
+    pthread_cond_t cond;                 // Callback finished, task done, thread exited
+    int stopping;
+    int exited;
+    IoWatch watches[IO_REACTOR_MAX_WATCHES];
+    int running_slot;                    // Watch whose callback runs now, -1 if none
+
+    IoQueuedTask tasks[IO_REACTOR_TASK_MAX];
+    int task_head;
+    int task_count;
+    uint64_t tasks_queued;               // io_reactor_call() waits for tasks_done to pass its number
+    uint64_t tasks_done;
+
+    IoReactorStats stats;
+    int64_t start_us;
+};
+
+static int64_t monotonic_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void wake(IoReactor *r) {
+    uint64_t one = 1;
+    ssize_t n = write(r->wake_fd, &one, sizeof(one));
+    (void)n;  // EAGAIN: counter already non-zero, the thread wakes anyway
+}
+
+// Run queued tasks in order; returns how many ran
+static int run_tasks(IoReactor *r) {
+    uint64_t count;
+    ssize_t n = read(r->wake_fd, &count, sizeof(count));
+    (void)n;
+
+    int ran = 0;
+    pthread_mutex_lock(&r->lock);
+    while (r->task_count > 0) {
+        IoQueuedTask t = r->tasks[r->task_head];
+        r->task_head = (r->task_head + 1) % IO_REACTOR_TASK_MAX;
+        r->task_count--;
+        pthread_mutex_unlock(&r->lock);
+
+        t.task(t.user_data);
+        ran++;
+
+        pthread_mutex_lock(&r->lock);
+        r->tasks_done++;
+        pthread_cond_broadcast(&r->cond);
+    }
+    pthread_mutex_unlock(&r->lock);
+    return ran;
+}
+
+// Watch callback, unless the watch was removed after epoll_wait() returned
+static int run_watch(IoReactor *r, uint64_t data, uint32_t events) {
+    int slot = (int)(data & 0xffffffffu);
+    uint32_t generation = (uint32_t)(data >> 32);
+    if (slot < 0 || slot >= IO_REACTOR_MAX_WATCHES) return 0;
+
+    pthread_mutex_lock(&r->lock);
+    IoWatch w = r->watches[slot];
+    if (w.fd < 0 || w.generation != generation) {
+        pthread_mutex_unlock(&r->lock);
+        return 0;
+    }
+    r->running_slot = slot;
+    pthread_mutex_unlock(&r->lock);
+
+    w.callback(w.fd, events, w.user_data);
+
+    pthread_mutex_lock(&r->lock);
+    r->running_slot = -1;
+    pthread_cond_broadcast(&r->cond);
+    pthread_mutex_unlock(&r->lock);
+    return 1;
+}
+
+static void* reactor_thread(void *data) {
+    IoReactor *r = data;
+    struct epoll_event events[IO_REACTOR_MAX_WATCHES + 1];
+
+    for (;;) {
+        // No timeout: timers are timerfds, everything else is an fd event
+        int n = epoll_wait(r->epoll_fd, events, IO_REACTOR_MAX_WATCHES + 1, -1);
+        uint64_t io = 0, tasks = 0;
+        for (int i = 0; i < n; i++) {
+            if (events[i].data.u64 == WAKE_TAG) {
+                tasks += (uint64_t)run_tasks(r);
+            } else {
+                io += (uint64_t)run_watch(r, events[i].data.u64, events[i].events);
+            }
+        }
+
+        pthread_mutex_lock(&r->lock);
+        r->stats.wakeups++;
+        r->stats.io_events += io;
+        r->stats.tasks += tasks;
+        if (io == 0 && tasks == 0) r->stats.idle_wakeups++;
+        int stopping = r->stopping;
+        pthread_mutex_unlock(&r->lock);
+
+        if (n < 0 && errno != EINTR) break;
+        if (stopping) break;
+    }
+
+    // Nobody waits on io_reactor_call() forever
+    run_tasks(r);
+    pthread_mutex_lock(&r->lock);
+    r->exited = 1;
+    pthread_cond_broadcast(&r->cond);
+    pthread_mutex_unlock(&r->lock);
+    return NULL;
+}
+
+IoReactor* io_reactor_create(const char* name) {
+    IoReactor *r = calloc(1, sizeof(IoReactor));
+    if (!r) return NULL;
+    snprintf(r->name, sizeof(r->name), "%s", name ? name : "reactor");
+    r->running_slot = -1;
+    for (int i = 0; i < IO_REACTOR_MAX_WATCHES; i++) r->watches[i].fd = -1;
+
+    r->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    r->wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    struct epoll_event ev = { .events = EPOLLIN, .data.u64 = WAKE_TAG };
+    if (r->epoll_fd < 0 || r->wake_fd < 0 ||
+        epoll_ctl(r->epoll_fd, EPOLL_CTL_ADD, r->wake_fd, &ev) < 0) {
+        if (r->epoll_fd >= 0) close(r->epoll_fd);
+        if (r->wake_fd >= 0) close(r->wake_fd);
+        free(r);
+        return NULL;
+    }
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&r->cond, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_mutex_init(&r->lock, NULL);
+    r->start_us = monotonic_us();
+
+    if (pthread_create(&r->thread, NULL, reactor_thread, r) != 0) {
+        pthread_cond_destroy(&r->cond);
+        pthread_mutex_destroy(&r->lock);
+        close(r->epoll_fd);
+        close(r->wake_fd);
+        free(r);
+        return NULL;
+    }
+    pthread_setname_np(r->thread, r->name);
+    return r;
+}
+
+void io_reactor_destroy(IoReactor* reactor) {
+    if (!reactor) return;
+    pthread_mutex_lock(&reactor->lock);
+    reactor->stopping = 1;
+    pthread_mutex_unlock(&reactor->lock);
+    wake(reactor);
+    pthread_join(reactor->thread, NULL);
+
+    close(reactor->epoll_fd);
+    close(reactor->wake_fd);
+    pthread_cond_destroy(&reactor->cond);
+    pthread_mutex_destroy(&reactor->lock);
+    free(reactor);
+}
+
+static int find_watch(IoReactor *r, int fd) {
+    for (int i = 0; i < IO_REACTOR_MAX_WATCHES; i++) {
+        if (r->watches[i].fd == fd) return i;
+    }
+    return -1;
+}
+
+int io_reactor_add(IoReactor* reactor, int fd, uint32_t events, IoCallback callback, void* user_data) {
+    if (!reactor || fd < 0 || !callback) return -1;
+
+    pthread_mutex_lock(&reactor->lock);
+    int slot = find_watch(reactor, fd);
+    int op = EPOLL_CTL_MOD;
+    if (slot < 0) {
+        slot = find_watch(reactor, -1);
+        op = EPOLL_CTL_ADD;
+    }
+    if (slot < 0) {
+        pthread_mutex_unlock(&reactor->lock);
+        return -1;
+    }
+
+    IoWatch *w = &reactor->watches[slot];
+    w->generation++;
+    struct epoll_event ev = {
+        .events = events,
+        .data.u64 = ((uint64_t)w->generation << 32) | (uint32_t)slot,
+    };
+    int ret = epoll_ctl(reactor->epoll_fd, op, fd, &ev);
+    if (ret < 0 && op == EPOLL_CTL_MOD && errno == ENOENT) {
+        // Closed without io_reactor_remove(): the kernel dropped it already
+        ret = epoll_ctl(reactor->epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+    }
+    if (ret < 0) {
+        if (op == EPOLL_CTL_ADD) w->fd = -1;
+        pthread_mutex_unlock(&reactor->lock);
+        return -1;
+    }
+    w->fd = fd;
+    w->callback = callback;
+    w->user_data = user_data;
+    pthread_mutex_unlock(&reactor->lock);
+    return 0;
+}
+
+int io_reactor_modify(IoReactor* reactor, int fd, uint32_t events) {
+    if (!reactor || fd < 0) return -1;
+
+    pthread_mutex_lock(&reactor->lock);
+    int slot = find_watch(reactor, fd);
+    int ret = -1;
+    if (slot >= 0) {
+        IoWatch *w = &reactor->watches[slot];
+        struct epoll_event ev = {
+            .events = events,
+            .data.u64 = ((uint64_t)w->generation << 32) | (uint32_t)slot,
+        };
+        ret = epoll_ctl(reactor->epoll_fd, EPOLL_CTL_MOD, fd, &ev);
+    }
+    pthread_mutex_unlock(&reactor->lock);
+    return ret;
+}
+
+void io_reactor_remove(IoReactor* reactor, int fd) {
+    if (!reactor || fd < 0) return;
+    int self = io_reactor_in_thread(reactor);
+
+    pthread_mutex_lock(&reactor->lock);
+    int slot = find_watch(reactor, fd);
+    if (slot >= 0) {
+        epoll_ctl(reactor->epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+        reactor->watches[slot].fd = -1;
+        reactor->watches[slot].generation++;
+        // The callback may still use the fd; the caller closes it next
+        while (!self && reactor->running_slot == slot) {
+            pthread_cond_wait(&reactor->cond, &reactor->lock);
+        }
+    }
+    pthread_mutex_unlock(&reactor->lock);
+}
+
+static int enqueue(IoReactor *r, IoTask task, void *user_data, uint64_t *number) {
+    pthread_mutex_lock(&r->lock);
+    if (r->stopping || r->task_count >= IO_REACTOR_TASK_MAX) {
+        pthread_mutex_unlock(&r->lock);
+        return -1;
+    }
+    r->tasks[(r->task_head + r->task_count) % IO_REACTOR_TASK_MAX] = (IoQueuedTask){ task, user_data };
+    r->task_count++;
+    if ((uint64_t)r->task_count > r->stats.max_task_queue) r->stats.max_task_queue = (uint64_t)r->task_count;
+    *number = ++r->tasks_queued;
+    pthread_mutex_unlock(&r->lock);
+    wake(r);
+    return 0;
+}
+
+int io_reactor_post(IoReactor* reactor, IoTask task, void* user_data) {
+    if (!reactor || !task) return -1;
+    uint64_t number;
+    return enqueue(reactor, task, user_data, &number);
+}
+
+int io_reactor_call(IoReactor* reactor, IoTask task, void* user_data) {
+    if (!reactor || !task) return -1;
+    if (io_reactor_in_thread(reactor)) {
+        task(user_data);
+        return 0;
+    }
+
+    uint64_t number;
+    if (enqueue(reactor, task, user_data, &number) < 0) return -1;
+    pthread_mutex_lock(&reactor->lock);
+    while (reactor->tasks_done < number && !reactor->exited) {
+        pthread_cond_wait(&reactor->cond, &reactor->lock);
+    }
+    int done = reactor->tasks_done >= number;
+    pthread_mutex_unlock(&reactor->lock);
+    return done ? 0 : -1;
+}
+
+int io_reactor_in_thread(IoReactor* reactor) {
+    return reactor && pthread_equal(reactor->thread, pthread_self());
+}
+
+void io_reactor_get_stats(IoReactor* reactor, IoReactorStats* stats) {
+    if (!stats) return;
+    if (!reactor) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+    pthread_mutex_lock(&reactor->lock);
+    *stats = reactor->stats;
+    pthread_mutex_unlock(&reactor->lock);
+    stats->uptime_s = (monotonic_us() - reactor->start_us) / 1e6;
+    stats->wakeups_per_min = stats->uptime_s > 0.0 ? stats->wakeups * 60.0 / stats->uptime_s : 0.0;
+}
+
+void io_reactor_format_stats(const IoReactorStats* stats, char* buf, size_t len) {
+    if (!stats || !buf || !len) return;
+    snprintf(buf, len, "%llu wakeups (%.1f/min): %llu I/O, %llu tasks, %llu idle",
+             (unsigned long long)stats->wakeups, stats->wakeups_per_min,
+             (unsigned long long)stats->io_events, (unsigned long long)stats->tasks,
+             (unsigned long long)stats->idle_wakeups);
+}
@@ -0,0 +1,68 @@
+#ifndef IO_REACTOR_H
+#define IO_REACTOR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+// One epoll thread for the control plane: sockets (RFCOMM links, SCO
+// connects in progress) and timerfds are watched, callbacks run on that
+// thread. Other threads hand work over with io_reactor_post() /
+// io_reactor_call(), which wake it through an eventfd, as does stop.
+// epoll_wait() has no timeout: the thread only wakes up for an event,
+// so an idle link costs no wakeups at all.
+
+#define IO_REACTOR_MAX_WATCHES 16
+#define IO_REACTOR_TASK_MAX 64
+
+// events: EPOLLIN / EPOLLOUT / EPOLLERR / EPOLLHUP as reported
+typedef void (*IoCallback)(int fd, uint32_t events, void* user_data);
+typedef void (*IoTask)(void* user_data);
+
+typedef struct {
+    uint64_t wakeups;                // epoll_wait() returns
+    uint64_t io_events;              // Watch callbacks run
+    uint64_t tasks;                  // Posted / called tasks run
+    uint64_t idle_wakeups;           // Returns with nothing to do
+    uint64_t max_task_queue;
+    double uptime_s;
+    double wakeups_per_min;
+} IoReactorStats;
+
+typedef struct IoReactor IoReactor;
+
+// Starts the thread; NULL on failure
+IoReactor* io_reactor_create(const char* name);
+
+// Stops (eventfd, join) and frees; watched fds are not closed
+void io_reactor_destroy(IoReactor* reactor);
+
+// Watch fd (level triggered). An fd that is already watched gets the new
+// events and callback. Returns 0, -1 if the table is full or epoll fails
+int io_reactor_add(IoReactor* reactor, int fd, uint32_t events, IoCallback callback, void* user_data);
+int io_reactor_modify(IoReactor* reactor, int fd, uint32_t events);
+
+// Stop watching fd before closing it. From another thread this returns
+// once the fd's callback is not running
+void io_reactor_remove(IoReactor* reactor, int fd);
+
+// Run task on the reactor thread. post returns at once (-1 if the queue
+// is full or stopped); call waits for it (runs inline on the reactor thread)
+int io_reactor_post(IoReactor* reactor, IoTask task, void* user_data);
+int io_reactor_call(IoReactor* reactor, IoTask task, void* user_data);
+
+int io_reactor_in_thread(IoReactor* reactor);
+
+void io_reactor_get_stats(IoReactor* reactor, IoReactorStats* stats);
+
+// "128 wakeups (2.1/min): 120 I/O, 8 tasks, 0 idle"
+void io_reactor_format_stats(const IoReactorStats* stats, char* buf, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IO_REACTOR_H
@@ -0,0 +1,221 @@
+#include "jitter_buffer.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define JB_JITTER_SMOOTHING 16.0   // RFC 3550 style 1/16 gain
+#define JB_PEAK_DECAY 0.998        // Per packet, ~1-2 s half-life at SCO rates
+#define JB_PEAK_FACTOR 2.0         // Target = packet + 2 x peak deviation
+
+struct JitterBuffer {
+    int sample_rate;
+    int packet_samples;
+    int min_samples;
+    int max_samples;
+
+    // Sample FIFO
+    int16_t *buf;
+    int capacity;
+    int read_pos;
+    int depth;
+
+    // Adaptation
+    int target;
+    int primed;
+    int64_t last_arrival_us;
+    int last_samples;
+    double jitter_us;
+    double peak_us;
+
+    // Concealment
+    Plc *plc;
+    int late_window;            // Concealed samples since the last arrival
+    int gap_slots;              // Missing slots waiting for late/lost decision
+
+    JitterStats stats;
+};
+
+static int ms_to_samples(const JitterBuffer *jb, double ms) {
+    return (int)(ms * jb->sample_rate / 1000.0);
+}
+
+static void fifo_drop(JitterBuffer *jb, int samples) {
+    if (samples > jb->depth) samples = jb->depth;
+    jb->read_pos = (jb->read_pos + samples) % jb->capacity;
+    jb->depth -= samples;
+    jb->stats.dropped_samples += (uint64_t)samples;
+}
+
+static void fifo_write(JitterBuffer *jb, const int16_t *pcm, int samples) {
+    if (samples > jb->capacity) {
+        pcm += samples - jb->capacity;
+        jb->stats.dropped_samples += (uint64_t)(samples - jb->capacity);
+        samples = jb->capacity;
+    }
+    if (jb->depth + samples > jb->capacity) {
+        fifo_drop(jb, jb->depth + samples - jb->capacity);
+    }
+
+    int write_pos = (jb->read_pos + jb->depth) % jb->capacity;
+    int first = jb->capacity - write_pos;
+    if (first > samples) first = samples;
+    memcpy(jb->buf + write_pos, pcm, first * sizeof(int16_t));
+    memcpy(jb->buf, pcm + first, (samples - first) * sizeof(int16_t));
+    jb->depth += samples;
+}
+
+static void fifo_read(JitterBuffer *jb, int16_t *out, int samples) {
+    int first = jb->capacity - jb->read_pos;
+    if (first > samples) first = samples;
+    memcpy(out, jb->buf + jb->read_pos, first * sizeof(int16_t));
+    memcpy(out + first, jb->buf, (samples - first) * sizeof(int16_t));
+    jb->read_pos = (jb->read_pos + samples) % jb->capacity;
+    jb->depth -= samples;
+}
+
+static void update_target(JitterBuffer *jb) {
+    int wanted = jb->packet_samples + ms_to_samples(jb, JB_PEAK_FACTOR * jb->peak_us / 1000.0);
+    if (wanted < jb->min_samples) wanted = jb->min_samples;
+    if (wanted > jb->max_samples) wanted = jb->max_samples;
+
+    // Grow at once, shrink slowly
+    if (wanted > jb->target) {
+        jb->target = wanted;
+    } else if (wanted < jb->target) {
+        int step = (jb->target - wanted) / 32;
+        jb->target -= step > 0 ? step : 1;
+    }
+}
+
+JitterBuffer* jitter_buffer_create(int sample_rate, int packet_samples, int min_ms, int max_ms) {
+    if (sample_rate <= 0 || packet_samples <= 0 || max_ms <= 0) return NULL;
+
+    JitterBuffer *jb = calloc(1, sizeof(JitterBuffer));
+    if (!jb) return NULL;
+
+    jb->sample_rate = sample_rate;
+    jb->packet_samples = packet_samples;
+    jb->min_samples = ms_to_samples(jb, min_ms);
+    jb->max_samples = ms_to_samples(jb, max_ms);
+    if (jb->min_samples < packet_samples) jb->min_samples = packet_samples;
+    if (jb->max_samples < jb->min_samples) jb->max_samples = jb->min_samples;
+
+    jb->capacity = jb->max_samples * 2 + packet_samples * 4;
+    jb->buf = calloc((size_t)jb->capacity, sizeof(int16_t));
+    jb->plc = plc_create(sample_rate, packet_samples);
+    if (!jb->buf || !jb->plc) {
+        jitter_buffer_destroy(jb);
+        return NULL;
+    }
+
+    jb->target = jb->min_samples;
+    jb->last_arrival_us = -1;
+    return jb;
+}
+
+void jitter_buffer_destroy(JitterBuffer* jb) {
+    if (!jb) return;
+    free(jb->buf);
+    plc_destroy(jb->plc);
+    free(jb);
+}
+
+void jitter_buffer_put(JitterBuffer* jb, const int16_t* pcm, int samples, int64_t arrival_us) {
+    if (!jb || !pcm || samples <= 0) return;
+    jb->stats.packets++;
+
+    // Arrival deviation against the duration of the previous packet
+    double interval = -1.0;
+    double expected = 0.0;
+    if (jb->last_arrival_us >= 0) {
+        expected = jb->last_samples * 1e6 / jb->sample_rate;
+        interval = (double)(arrival_us - jb->last_arrival_us);
+        double deviation = fabs(interval - expected);
+        jb->jitter_us += (deviation - jb->jitter_us) / JB_JITTER_SMOOTHING;
+        jb->peak_us *= JB_PEAK_DECAY;
+        if (deviation > jb->peak_us) jb->peak_us = deviation;
+        update_target(jb);
+    }
+    jb->last_arrival_us = arrival_us;
+    jb->last_samples = samples;
+
+    // CVSD has no sequence numbers: a gap followed by a burst was a delayed
+    // packet, a gap followed by normal spacing was a lost one
+    if (jb->gap_slots > 0) {
+        if (interval < expected * 0.5) {
+            jb->stats.late_packets++;
+        } else {
+            jb->stats.lost_packets += (uint64_t)jb->gap_slots;
+        }
+        jb->gap_slots = 0;
+    }
+    if (interval > expected * 1.5) {
+        jb->gap_slots = (int)(interval / expected + 0.5) - 1;
+    }
+    jb->late_window = 0;
+
+    fifo_write(jb, pcm, samples);
+
+    // Shrink gradually when the buffer sits well above target
+    if (jb->primed && jb->depth > jb->target + 2 * jb->packet_samples) {
+        fifo_drop(jb, jb->packet_samples);
+    }
+}
+
+int jitter_buffer_get(JitterBuffer* jb, int16_t* out, int samples) {
+    if (!jb || !out || samples <= 0) return 0;
+
+    if (!jb->primed) {
+        if (jb->depth < jb->target) {
+            // (Re)building depth: extrapolate, fading to silence
+            if (plc_conceal(jb->plc, out, samples)) {
+                jb->stats.concealed_frames++;
+            }
+            return 0;
+        }
+        jb->primed = 1;
+        jb->late_window = 0;
+    }
+
+    int real = jb->depth < samples ? jb->depth : samples;
+    fifo_read(jb, out, real);
+
+    if (real == samples) {
+        plc_good(jb->plc, out, samples);
+
+        // Depth sagged far below target (losses, target grew): rebuild
+        if (jb->depth < jb->target / 2 && jb->target > 2 * jb->packet_samples) {
+            jb->primed = 0;
+        }
+        return samples;
+    }
+
+    // Underrun: history first, then conceal the remainder
+    plc_good(jb->plc, out, real);
+    plc_conceal(jb->plc, out + real, samples - real);
+    jb->stats.concealed_frames++;
+    jb->late_window += samples - real;
+
+    // A missed slot means the target was too small
+    jb->target += jb->packet_samples;
+    if (jb->target > jb->max_samples) jb->target = jb->max_samples;
+
+    // Long outage: count as lost and re-prime
+    if (jb->late_window > jb->max_samples) {
+        jb->stats.lost_packets += (uint64_t)(jb->late_window / jb->packet_samples);
+        jb->late_window = 0;
+        jb->primed = 0;
+    }
+    return real;
+}
+
+void jitter_buffer_get_stats(const JitterBuffer* jb, JitterStats* stats) {
+    if (!jb || !stats) return;
+    *stats = jb->stats;
+    stats->depth_samples = jb->depth;
+    stats->target_samples = jb->target;
+    stats->jitter_ms = jb->jitter_us / 1000.0;
+    stats->peak_jitter_ms = jb->peak_us / 1000.0;
+    plc_get_stats(jb->plc, &stats->plc);
+}
@@ -0,0 +1,51 @@
+#ifndef JITTER_BUFFER_H
+#define JITTER_BUFFER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include "plc.h"
+
+// Adaptive jitter buffer for the SCO -> speaker path (single thread).
+// put() is fed with decoded PCM and its arrival time, get() is called on
+// the playout clock and conceals (plc.h) when the buffer runs dry.
+typedef struct JitterBuffer JitterBuffer;
+
+typedef struct {
+    int depth_samples;          // Currently buffered
+    int target_samples;         // Adaptive target depth
+    double jitter_ms;           // Smoothed inter-arrival deviation
+    double peak_jitter_ms;      // Decaying peak deviation (drives target)
+    uint64_t packets;           // put() calls
+    uint64_t late_packets;      // Arrived after their slot was concealed
+    uint64_t lost_packets;      // Concealed slots that never arrived
+    uint64_t concealed_frames;  // get() calls that needed concealment
+    uint64_t dropped_samples;   // Discarded to shrink latency or on overflow
+    PlcStats plc;               // Concealment of underruns
+} JitterStats;
+
+// packet_samples: nominal SCO packet (CVSD: mtu/2, mSBC: 120)
+// min_ms / max_ms: bounds for the adaptive target
+JitterBuffer* jitter_buffer_create(int sample_rate, int packet_samples, int min_ms, int max_ms);
+
+// Destroy buffer
+void jitter_buffer_destroy(JitterBuffer* jb);
+
+// Add received audio; arrival_us from a monotonic clock
+void jitter_buffer_put(JitterBuffer* jb, const int16_t* pcm, int samples, int64_t arrival_us);
+
+// Fill exactly `samples` for playout
+// Returns number of real (not concealed) samples in out
+int jitter_buffer_get(JitterBuffer* jb, int16_t* out, int samples);
+
+// Counters and current depth
+void jitter_buffer_get_stats(const JitterBuffer* jb, JitterStats* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // JITTER_BUFFER_H
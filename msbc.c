@@ -0,0 +1,187 @@
+#include "msbc.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <sbc/sbc.h>
+
+// H2 synchronization header: 0x01 followed by the 2-bit sequence number,
+// each bit doubled (SN0 SN0 SN1 SN1) in the upper nibble
+static const uint8_t h2_seq_bytes[4] = { 0x08, 0x38, 0xC8, 0xF8 };
+
+#define MSBC_SYNC_WORD 0xAD
+
+struct MsbcCodec {
+    sbc_t encoder;
+    sbc_t decoder;
+    unsigned int tx_seq;
+    int rx_seq;                           // -1 = unknown
+    uint8_t rx_buf[MSBC_PACKET_BYTES * 2];
+    size_t rx_len;
+    Plc *plc;                             // Conceals lost / corrupt frames
+    MsbcStats stats;
+};
+
+static int h2_seq_index(uint8_t b) {
+    for (int i = 0; i < 4; i++) {
+        if (h2_seq_bytes[i] == b) return i;
+    }
+    return -1;
+}
+
+static int is_h2_header(const uint8_t *p) {
+    return p[0] == 0x01 && h2_seq_index(p[1]) >= 0 && p[2] == MSBC_SYNC_WORD;
+}
+
+MsbcCodec* msbc_create(void) {
+    MsbcCodec *codec = calloc(1, sizeof(MsbcCodec));
+    if (!codec) return NULL;
+
+    if (sbc_init_msbc(&codec->encoder, 0) < 0) {
+        free(codec);
+        return NULL;
+    }
+    if (sbc_init_msbc(&codec->decoder, 0) < 0) {
+        sbc_finish(&codec->encoder);
+        free(codec);
+        return NULL;
+    }
+    codec->plc = plc_create(MSBC_SAMPLE_RATE, MSBC_FRAME_SAMPLES);
+    if (!codec->plc) {
+        sbc_finish(&codec->encoder);
+        sbc_finish(&codec->decoder);
+        free(codec);
+        return NULL;
+    }
+    codec->encoder.endian = SBC_LE;
+    codec->decoder.endian = SBC_LE;
+    codec->rx_seq = -1;
+    return codec;
+}
+
+void msbc_destroy(MsbcCodec* codec) {
+    if (!codec) return;
+    sbc_finish(&codec->encoder);
+    sbc_finish(&codec->decoder);
+    plc_destroy(codec->plc);
+    free(codec);
+}
+
+void msbc_reset(MsbcCodec* codec) {
+    if (!codec) return;
+    sbc_reinit_msbc(&codec->encoder, 0);
+    sbc_reinit_msbc(&codec->decoder, 0);
+    codec->encoder.endian = SBC_LE;
+    codec->decoder.endian = SBC_LE;
+    codec->tx_seq = 0;
+    codec->rx_seq = -1;
+    codec->rx_len = 0;
+    plc_reset(codec->plc);
+    memset(&codec->stats, 0, sizeof(codec->stats));
+}
+
+int msbc_encode_packet(MsbcCodec* codec, const int16_t* pcm, uint8_t* packet) {
+    if (!codec || !pcm || !packet) return -1;
+
+    packet[0] = 0x01;
+    packet[1] = h2_seq_bytes[codec->tx_seq];
+    codec->tx_seq = (codec->tx_seq + 1) & 3;
+
+    ssize_t written = 0;
+    ssize_t consumed = sbc_encode(&codec->encoder,
+                                  pcm, MSBC_FRAME_SAMPLES * sizeof(int16_t),
+                                  packet + 2, MSBC_FRAME_BYTES, &written);
+    if (consumed != MSBC_FRAME_SAMPLES * (ssize_t)sizeof(int16_t) || written != MSBC_FRAME_BYTES) {
+        return -1;
+    }
+
+    packet[MSBC_PACKET_BYTES - 1] = 0;
+    return MSBC_PACKET_BYTES;
+}
+
+// Append one concealed frame if it fits, returns samples written
+static size_t emit_concealed(MsbcCodec *codec, int16_t *pcm, size_t pos, size_t capacity) {
+    if (pos + MSBC_FRAME_SAMPLES > capacity) return 0;
+    plc_conceal(codec->plc, pcm + pos, MSBC_FRAME_SAMPLES);
+    return MSBC_FRAME_SAMPLES;
+}
+
+// Decode one aligned packet at rx_buf[0]
+static size_t decode_packet(MsbcCodec *codec, int16_t *pcm, size_t pos, size_t capacity) {
+    size_t out = 0;
+    int seq = h2_seq_index(codec->rx_buf[1]);
+
+    if (codec->rx_seq >= 0) {
+        int missing = (seq - ((codec->rx_seq + 1) & 3)) & 3;
+        codec->stats.frames_lost += (uint64_t)missing;
+        for (int i = 0; i < missing; i++) {
+            out += emit_concealed(codec, pcm, pos + out, capacity);
+        }
+    }
+    codec->rx_seq = seq;
+
+    if (pos + out + MSBC_FRAME_SAMPLES > capacity) return out;
+
+    size_t written = 0;
+    ssize_t consumed = sbc_decode(&codec->decoder,
+                                  codec->rx_buf + 2, MSBC_FRAME_BYTES,
+                                  pcm + pos + out, MSBC_FRAME_SAMPLES * sizeof(int16_t),
+                                  &written);
+    if (consumed <= 0 || written != MSBC_FRAME_SAMPLES * sizeof(int16_t)) {
+        codec->stats.frames_bad++;
+        out += emit_concealed(codec, pcm, pos + out, capacity);
+    } else {
+        codec->stats.frames_decoded++;
+        plc_good(codec->plc, pcm + pos + out, MSBC_FRAME_SAMPLES);
+        out += MSBC_FRAME_SAMPLES;
+    }
+    return out;
+}
+
+size_t msbc_decode_stream(MsbcCodec* codec, const uint8_t* data, size_t len,
+                          int16_t* pcm, size_t pcm_capacity) {
+    if (!codec || !data || !pcm) return 0;
+
+    size_t produced = 0;
+
+    while (len > 0) {
+        size_t room = sizeof(codec->rx_buf) - codec->rx_len;
+        size_t take = len < room ? len : room;
+        memcpy(codec->rx_buf + codec->rx_len, data, take);
+        codec->rx_len += take;
+        data += take;
+        len -= take;
+
+        for (;;) {
+            // Find H2 header
+            size_t i = 0;
+            while (i + 3 <= codec->rx_len && !is_h2_header(codec->rx_buf + i)) {
+                i++;
+            }
+            if (i + 3 > codec->rx_len) {
+                // Keep a possible partial header at the end
+                size_t keep = codec->rx_len < 2 ? codec->rx_len : 2;
+                i = codec->rx_len - keep;
+            }
+            if (i > 0) {
+                codec->stats.bytes_skipped += i;
+                memmove(codec->rx_buf, codec->rx_buf + i, codec->rx_len - i);
+                codec->rx_len -= i;
+            }
+
+            if (codec->rx_len < MSBC_PACKET_BYTES) break;
+
+            produced += decode_packet(codec, pcm, produced, pcm_capacity);
+            memmove(codec->rx_buf, codec->rx_buf + MSBC_PACKET_BYTES, codec->rx_len - MSBC_PACKET_BYTES);
+            codec->rx_len -= MSBC_PACKET_BYTES;
+        }
+    }
+
+    return produced;
+}
+
+void msbc_get_stats(const MsbcCodec* codec, MsbcStats* stats) {
+    if (!codec || !stats) return;
+    *stats = codec->stats;
+    plc_get_stats(codec->plc, &stats->plc);
+}
@@ -0,0 +1,57 @@
+#ifndef MSBC_H
+#define MSBC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "plc.h"
+
+// mSBC (HFP wideband speech): 16 kHz mono, one SBC frame per 7.5 ms
+#define MSBC_SAMPLE_RATE   16000
+#define MSBC_FRAME_SAMPLES 120
+#define MSBC_FRAME_BYTES   57
+#define MSBC_PACKET_BYTES  60   // H2 header (2) + SBC frame (57) + padding (1)
+
+typedef struct MsbcCodec MsbcCodec;
+
+typedef struct {
+    uint64_t frames_decoded;
+    uint64_t frames_lost;       // Sequence number gaps
+    uint64_t frames_bad;        // Decode failures
+    uint64_t bytes_skipped;     // Bytes dropped while searching for H2 sync
+    PlcStats plc;               // Concealment of lost / bad frames
+} MsbcStats;
+
+// Create encoder + decoder pair
+MsbcCodec* msbc_create(void);
+
+// Destroy codec
+void msbc_destroy(MsbcCodec* codec);
+
+// Forget partial input and sequence state (new SCO link)
+void msbc_reset(MsbcCodec* codec);
+
+// Encode exactly MSBC_FRAME_SAMPLES into one H2-framed packet
+// packet: MSBC_PACKET_BYTES output buffer
+// Returns MSBC_PACKET_BYTES on success, -1 on error
+int msbc_encode_packet(MsbcCodec* codec, const int16_t* pcm, uint8_t* packet);
+
+// Feed raw SCO payload (any size, any alignment to H2 packets)
+// Decodes every complete packet into pcm (MSBC_FRAME_SAMPLES each)
+// Lost or corrupt frames are concealed (plc.h) to keep timing
+// Returns number of samples written to pcm
+size_t msbc_decode_stream(MsbcCodec* codec, const uint8_t* data, size_t len,
+                          int16_t* pcm, size_t pcm_capacity);
+
+// Counters since create/reset
+void msbc_get_stats(const MsbcCodec* codec, MsbcStats* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MSBC_H
@@ -17,18 +17,23 @@
 #include <pthread.h>
 #include <gio/gio.h>
 #include <sys/socket.h>
-#include <sys/select.h>
+#include <sys/epoll.h>
+#include <fcntl.h>
 #include <sys/stat.h>
 #include <bluetooth/bluetooth.h>
 #include <bluetooth/rfcomm.h>
 #include <bluetooth/sco.h>
 #include <bluetooth/sdp.h>
 #include <bluetooth/sdp_lib.h>
-#include <pulse/simple.h>
-#include <pulse/error.h>
 
-#ifdef HAVE_WEBRTC_APM
-#include "audio_processing_wrapper.h"
+#include "at_engine.h"
+#include "audio_backend.h"
+#include "hfp_link.h"
+#include "io_reactor.h"
+#include "sco_audio.h"
+
+#ifdef HAVE_SBC
+#include "msbc.h"
 #endif
 
 // SCO voice settings (if not defined in kernel)
@@ -42,7 +47,8 @@ struct bt_voice {
 #endif
 
 // Forward declarations
-static gboolean sco_connect(void);
+static void sco_connect_async(gboolean replace);
+static void sco_warm_start(void);
 
 // ============================================================================
 // STATE MACHINE
@@ -80,36 +86,47 @@ static CallState current_call_state = CALL_IDLE;
 static char current_call_number[64] = {0};
 static char current_call_name[128] = {0};
 static guint ringtone_timer_id = 0;
-static int hfp_socket = -1;  // HFP RFCOMM socket (keeps open during call)
-static int hfp_listen_socket = -1;  // For listening to incoming calls
+static HfpLink *hfp_link = NULL;  // The RFCOMM link: SLC, dial / answer / hangup, events
+static IoReactor *hfp_reactor = NULL;  // One epoll thread: the RFCOMM link, SCO connects
 static int sco_socket = -1;  // SCO audio socket
-static pthread_t sco_playback_thread;
-static pthread_t sco_capture_thread;
-static gboolean sco_audio_running = FALSE;
-static pa_simple *pulse_playback = NULL;
-static pa_simple *pulse_capture = NULL;
-static GThread *incoming_call_thread = NULL;
-static gboolean incoming_call_running = FALSE;
-static gboolean hfp_listen_paused = FALSE;
-
-// WebRTC AEC
-#define AEC_FRAME_SAMPLES 80  // 10ms @ 8kHz
-#define AEC_FRAME_BYTES (AEC_FRAME_SAMPLES * 2)
-#define AEC_FIFO_CAPACITY (AEC_FRAME_SAMPLES * 50)
-
-static gboolean aec_enabled = FALSE;
-#ifdef HAVE_WEBRTC_APM
-static gboolean aec_force_disable = TRUE;
-#endif
-#ifdef HAVE_WEBRTC_APM
-static AecHandle *aec_handle = NULL;
-#endif
-static pthread_mutex_t aec_mutex = PTHREAD_MUTEX_INITIALIZER;
-static pthread_mutex_t aec_fifo_mutex = PTHREAD_MUTEX_INITIALIZER;
-static int16_t aec_render_fifo[AEC_FIFO_CAPACITY];
-static int aec_fifo_head = 0;
-static int aec_fifo_tail = 0;
-static int aec_fifo_size = 0;
+static int sco_pending_socket = -1;  // SCO connect in progress (reactor thread)
+static gboolean sco_teardown_pending = FALSE;  // Previous link's threads being joined (reactor thread)
+static gboolean sco_connect_deferred = FALSE;  // Connect once that teardown is done (reactor thread)
+static guint sco_generation = 0;  // Bumped per started link, tags remote-closed callbacks
+static AudioBackendType audio_backend = AUDIO_BACKEND_AUTO;  // settings.json "audio_backend"
+static int audio_latency_ms = 30;  // settings.json "audio_latency_ms"
+static char audio_playback_device[128] = "";  // settings.json "playback_device", empty = default
+static char audio_capture_device[128] = "";   // settings.json "capture_device", empty = default
+static int jitter_min_ms = 10;  // settings.json "jitter_min_ms"
+static int jitter_max_ms = 120;  // settings.json "jitter_max_ms"
+static int speaker_gain_db = 0;  // settings.json "speaker_gain_db", 0 = no gain stage
+static int mic_gain_db = 0;  // settings.json "mic_gain_db"
+static gboolean realtime_audio = FALSE;  // settings.json "realtime_audio"
+static int realtime_priority = 10;  // settings.json "realtime_priority"
+static int playback_cpu = -1;  // settings.json "playback_cpu", -1 = any
+static int capture_cpu = -1;  // settings.json "capture_cpu", -1 = any
+static gboolean audio_warm_start = TRUE;  // settings.json "audio_warm_start": open devices on RING
+static gint warm_start_pending = 0;  // A warm start thread is opening devices
+static gint sco_answer_pending = 0;  // on_answer_clicked's SCO connect in progress
+static gint64 answer_started_us = 0;  // Answer click (monotonic), timed until first audio
+
+// HFP codec IDs (AT+BAC / +BCS)
+#define HFP_CODEC_CVSD 1
+#define HFP_CODEC_MSBC 2
+
+static int hfp_codec = HFP_CODEC_CVSD;  // Selected by AG via +BCS
+static int sco_codec = HFP_CODEC_CVSD;  // Codec of the open SCO link
+static gboolean wideband_enabled = TRUE;  // settings.json "wideband_speech"
+
+// WebRTC AEC (run by the SCO audio engine, needs HAVE_WEBRTC_APM)
+static gboolean echo_cancellation = TRUE;  // settings.json "echo_cancellation"
+static ApmProfile apm_profile;  // settings.json "apm_profile" + "apm_*" for "custom"
+
+// Call recording (written by the SCO audio engine's recorder thread)
+static gboolean call_recording = FALSE;  // settings.json "call_recording"
+static int recording_format = CALL_REC_FLAC;  // settings.json "recording_format": "flac" / "opus" / "wav"
+static gboolean recording_stereo = TRUE;  // settings.json "recording_stereo"
+static char recording_dir[512] = "recordings";  // settings.json "recording_dir"
 
 static GDBusConnection *dbus_conn = NULL;
 static GDBusConnection *obex_conn = NULL;
@@ -125,6 +142,9 @@ static gboolean auto_connect_in_progress = FALSE;
 
 // Dynamic HFP channel and SCO MTU
 static uint8_t hfp_channel = 0;  // 0 = not found yet
+static gboolean hfp_channel_cached = FALSE;  // hfp_channel came from hfp_devices.csv, not SDP
+static double hfp_sdp_ms = -1;  // SDP query of this connection, -1 = none
+static gint64 hfp_connect_us = 0;  // CONNECTED, for the reconnect-to-ready time
 static int sco_mtu = 48;  // Default, updated on connection
 
 // Pending dial from command line (tel: URI)
@@ -150,6 +170,17 @@ typedef struct {
 static RecentEntry recent_entries[500];
 static int recent_count = 0;
 
+// Per phone: SDP channel and the AG's SLC answers, so a reconnect skips
+// the SDP query and AT+CIND=?
+typedef struct {
+    char addr[18];
+    uint8_t channel;
+    HfpAgInfo ag;
+} HfpDevice;
+
+static HfpDevice hfp_devices[16];
+static int hfp_device_count = 0;
+
 // Sort recents by time (newest first)
 static int compare_recents(const void *a, const void *b) {
     const RecentEntry *ra = (const RecentEntry *)a;
@@ -195,6 +226,7 @@ static gboolean phonebook_loaded = FALSE;
 static char contacts_csv_path[512] = "contacts.csv";
 static char recents_csv_path[512] = "recents.csv";
 static char settings_json_path[512] = "settings.json";
+static char hfp_devices_csv_path[512] = "hfp_devices.csv";
 
 static void init_data_paths(void) {
     const char *snap_common = getenv("SNAP_USER_COMMON");
@@ -202,6 +234,8 @@ static void init_data_paths(void) {
         snprintf(contacts_csv_path, sizeof(contacts_csv_path), "%s/contacts.csv", snap_common);
         snprintf(recents_csv_path, sizeof(recents_csv_path), "%s/recents.csv", snap_common);
         snprintf(settings_json_path, sizeof(settings_json_path), "%s/settings.json", snap_common);
+        snprintf(hfp_devices_csv_path, sizeof(hfp_devices_csv_path), "%s/hfp_devices.csv", snap_common);
+        snprintf(recording_dir, sizeof(recording_dir), "%s/recordings", snap_common);
     }
 }
 
@@ -229,8 +263,8 @@ static void handle_ciev_event(int ind, int val);
 static void stop_sco_audio(const char *reason);
 static void clear_device_info(void);
 static void cleanup_connection(const char *reason, gboolean clear_device);
-static void start_incoming_call_listener(void);
-static void stop_incoming_call_listener(void);
+static void start_hfp_link(void);
+static void stop_hfp_link(void);
 static gboolean ensure_obexd_running(void);
 static gpointer sync_recents_thread(gpointer data);
 static gpointer load_phonebook_thread(gpointer data);
@@ -431,6 +465,113 @@ static gboolean load_recents_from_csv(void) {
     return (recent_count > 0);
 }
 
+static void save_hfp_devices_to_csv(void) {
+    FILE *f = fopen(hfp_devices_csv_path, "w");
+    if (!f) return;
+    fprintf(f, "address,channel,features,indicators\n");
+    for (int i = 0; i < hfp_device_count; i++) {
+        const HfpDevice *d = &hfp_devices[i];
+        // Indicator names in +CIEV index order, space separated
+        char indicators[HFP_LINK_INDICATOR_MAX * HFP_LINK_INDICATOR_NAME_MAX] = "";
+        for (int j = 0; j < d->ag.indicator_count; j++) {
+            if (j) g_strlcat(indicators, " ", sizeof(indicators));
+            g_strlcat(indicators, d->ag.indicators[j], sizeof(indicators));
+        }
+        fprintf(f, "\"%s\",\"%d\",\"%u\",\"%s\"\n", d->addr, d->channel, d->ag.features, indicators);
+    }
+    fclose(f);
+}
+
+static gboolean load_hfp_devices_from_csv(void) {
+    FILE *f = fopen(hfp_devices_csv_path, "r");
+    if (!f) return FALSE;
+
+    char line[512];
+    hfp_device_count = 0;
+
+    // Skip header
+    if (!fgets(line, sizeof(line), f)) {
+        fclose(f);
+        return FALSE;
+    }
+
+    while (fgets(line, sizeof(line), f) && hfp_device_count < (int)G_N_ELEMENTS(hfp_devices)) {
+        // Format: "address","channel","features","indicators"
+        char *fields[4] = {NULL};
+        char *p = line;
+
+        for (int i = 0; i < 4 && p; i++) {
+            if (*p == '"') p++;
+            fields[i] = p;
+            char *end = strstr(p, "\",\"");
+            if (end) {
+                *end = '\0';
+                p = end + 3;
+            } else {
+                // Last field
+                char *quote = strchr(p, '"');
+                if (quote) *quote = '\0';
+                char *nl = strchr(p, '\n'); if (nl) *nl = '\0';
+                p = NULL;
+            }
+        }
+
+        if (!fields[0] || !fields[1] || !fields[2] || !fields[3]) continue;
+        int channel = atoi(fields[1]);
+        if (strlen(fields[0]) != 17 || channel < 1 || channel > 30) continue;
+
+        HfpDevice *d = &hfp_devices[hfp_device_count];
+        memset(d, 0, sizeof(*d));
+        g_strlcpy(d->addr, fields[0], sizeof(d->addr));
+        d->channel = (uint8_t)channel;
+        d->ag.features = (uint32_t)strtoul(fields[2], NULL, 10);
+        char *save = NULL;
+        for (char *name = strtok_r(fields[3], " ", &save);
+             name && d->ag.indicator_count < HFP_LINK_INDICATOR_MAX;
+             name = strtok_r(NULL, " ", &save)) {
+            g_strlcpy(d->ag.indicators[d->ag.indicator_count++], name, HFP_LINK_INDICATOR_NAME_MAX);
+        }
+        hfp_device_count++;
+    }
+    fclose(f);
+    return (hfp_device_count > 0);
+}
+
+static HfpDevice* hfp_device_find(const char *addr) {
+    for (int i = 0; i < hfp_device_count; i++) {
+        if (g_ascii_strcasecmp(hfp_devices[i].addr, addr) == 0) return &hfp_devices[i];
+    }
+    return NULL;
+}
+
+// Saved after each SLC; the file is only written when something changed
+static void hfp_device_store(const char *addr, uint8_t channel, const HfpAgInfo *ag) {
+    HfpDevice *d = hfp_device_find(addr);
+    if (d && d->channel == channel && memcmp(&d->ag, ag, sizeof(*ag)) == 0) return;
+    if (!d) {
+        // Full: the oldest phone goes
+        if (hfp_device_count == (int)G_N_ELEMENTS(hfp_devices)) {
+            memmove(&hfp_devices[0], &hfp_devices[1], (hfp_device_count - 1) * sizeof(HfpDevice));
+            hfp_device_count--;
+        }
+        d = &hfp_devices[hfp_device_count++];
+    }
+    memset(d, 0, sizeof(*d));
+    g_strlcpy(d->addr, addr, sizeof(d->addr));
+    d->channel = channel;
+    d->ag = *ag;
+    save_hfp_devices_to_csv();
+}
+
+static void hfp_device_forget(const char *addr) {
+    HfpDevice *d = hfp_device_find(addr);
+    if (!d) return;
+    int i = (int)(d - hfp_devices);
+    memmove(&hfp_devices[i], &hfp_devices[i + 1], (hfp_device_count - i - 1) * sizeof(HfpDevice));
+    hfp_device_count--;
+    save_hfp_devices_to_csv();
+}
+
 // ============================================================================
 // LOG
 // ============================================================================
@@ -566,12 +707,20 @@ static const char *lookup_contact_name(const char *number) {
 // ============================================================================
 
 static void load_settings(void) {
+    apm_profile_preset(APM_PROFILE_DEFAULT, &apm_profile);
     FILE *f = fopen(settings_json_path, "r");
     if (!f) return;
     
+    // "apm_*" keys only count for a "custom" profile, whatever their order
+    ApmProfile custom;
+    apm_profile_preset(APM_PROFILE_DEFAULT, &custom);
+    char profile_name[32] = APM_PROFILE_DEFAULT;
+
     char line[256];
     while (fgets(line, sizeof(line), f)) {
         int val;
+        char str[32];
+        char dev[128];
         if (sscanf(line, " \"col_recent_type\" : %d", &val) == 1) col_recent_type = val;
         else if (sscanf(line, " \"col_recent_name\" : %d", &val) == 1) col_recent_name = val;
         else if (sscanf(line, " \"col_recent_number\" : %d", &val) == 1) col_recent_number = val;
@@ -580,8 +729,47 @@ static void load_settings(void) {
         else if (sscanf(line, " \"col_contacts_number\" : %d", &val) == 1) col_contacts_number = val;
         else if (strstr(line, "\"autostart\"") && strstr(line, "true")) autostart_enabled = TRUE;
         else if (strstr(line, "\"autostart\"") && strstr(line, "false")) autostart_enabled = FALSE;
+        else if (strstr(line, "\"wideband_speech\"") && strstr(line, "true")) wideband_enabled = TRUE;
+        else if (strstr(line, "\"wideband_speech\"") && strstr(line, "false")) wideband_enabled = FALSE;
+        else if (strstr(line, "\"echo_cancellation\"") && strstr(line, "true")) echo_cancellation = TRUE;
+        else if (strstr(line, "\"echo_cancellation\"") && strstr(line, "false")) echo_cancellation = FALSE;
+        else if (sscanf(line, " \"apm_profile\" : \"%31[^\"]\"", str) == 1) g_strlcpy(profile_name, str, sizeof(profile_name));
+        else if (sscanf(line, " \"apm_echo_suppression\" : \"%31[^\"]\"", str) == 1 && (val = apm_level_from_name(str)) >= 0) custom.echo_suppression = val;
+        else if (sscanf(line, " \"apm_noise_suppression\" : \"%31[^\"]\"", str) == 1 && (val = apm_level_from_name(str)) >= 0) custom.noise_suppression = val;
+        else if (sscanf(line, " \"apm_agc\" : \"%31[^\"]\"", str) == 1 && (val = apm_agc_from_name(str)) >= 0) custom.agc = val;
+        else if (strstr(line, "\"apm_high_pass\"") && strstr(line, "true")) custom.high_pass = 1;
+        else if (strstr(line, "\"apm_high_pass\"") && strstr(line, "false")) custom.high_pass = 0;
+        else if (strstr(line, "\"call_recording\"") && strstr(line, "true")) call_recording = TRUE;
+        else if (strstr(line, "\"call_recording\"") && strstr(line, "false")) call_recording = FALSE;
+        else if (strstr(line, "\"recording_stereo\"") && strstr(line, "true")) recording_stereo = TRUE;
+        else if (strstr(line, "\"recording_stereo\"") && strstr(line, "false")) recording_stereo = FALSE;
+        else if (sscanf(line, " \"recording_format\" : \"%31[^\"]\"", str) == 1) {
+            recording_format = strcmp(str, "opus") == 0 ? CALL_REC_OPUS : strcmp(str, "wav") == 0 ? CALL_REC_WAV : CALL_REC_FLAC;
+        }
+        else if (sscanf(line, " \"recording_dir\" : \"%127[^\"]\"", dev) == 1) g_strlcpy(recording_dir, dev, sizeof(recording_dir));
+        else if (sscanf(line, " \"audio_latency_ms\" : %d", &val) == 1 && val > 0) audio_latency_ms = val;
+        else if (sscanf(line, " \"jitter_min_ms\" : %d", &val) == 1 && val >= 0) jitter_min_ms = val;
+        else if (sscanf(line, " \"jitter_max_ms\" : %d", &val) == 1 && val > 0) jitter_max_ms = val;
+        else if (sscanf(line, " \"speaker_gain_db\" : %d", &val) == 1 && val >= -40 && val <= 20) speaker_gain_db = val;
+        else if (sscanf(line, " \"mic_gain_db\" : %d", &val) == 1 && val >= -40 && val <= 20) mic_gain_db = val;
+        else if (strstr(line, "\"realtime_audio\"") && strstr(line, "true")) realtime_audio = TRUE;
+        else if (strstr(line, "\"realtime_audio\"") && strstr(line, "false")) realtime_audio = FALSE;
+        else if (sscanf(line, " \"realtime_priority\" : %d", &val) == 1 && val > 0) realtime_priority = val;
+        else if (sscanf(line, " \"playback_cpu\" : %d", &val) == 1) playback_cpu = val;
+        else if (sscanf(line, " \"capture_cpu\" : %d", &val) == 1) capture_cpu = val;
+        else if (strstr(line, "\"audio_warm_start\"") && strstr(line, "true")) audio_warm_start = TRUE;
+        else if (strstr(line, "\"audio_warm_start\"") && strstr(line, "false")) audio_warm_start = FALSE;
+        else if (sscanf(line, " \"audio_backend\" : \"%31[^\"]\"", str) == 1) audio_backend = audio_backend_from_name(str);
+        else if (sscanf(line, " \"playback_device\" : \"%127[^\"]\"", dev) == 1) g_strlcpy(audio_playback_device, dev, sizeof(audio_playback_device));
+        else if (sscanf(line, " \"capture_device\" : \"%127[^\"]\"", dev) == 1) g_strlcpy(audio_capture_device, dev, sizeof(audio_capture_device));
     }
     fclose(f);
+
+    if (apm_profile_preset(profile_name, &apm_profile) < 0) {
+        apm_profile = custom;
+        g_strlcpy(apm_profile.name, "custom", sizeof(apm_profile.name));
+        apm_profile_clamp(&apm_profile);
+    }
 }
 
 
@@ -596,6 +784,31 @@ static void save_settings(void) {
     fprintf(f, "  \"col_recent_time\": %d,\n", col_recent_time);
     fprintf(f, "  \"col_contacts_name\": %d,\n", col_contacts_name);
     fprintf(f, "  \"col_contacts_number\": %d,\n", col_contacts_number);
+    fprintf(f, "  \"wideband_speech\": %s,\n", wideband_enabled ? "true" : "false");
+    fprintf(f, "  \"echo_cancellation\": %s,\n", echo_cancellation ? "true" : "false");
+    fprintf(f, "  \"apm_profile\": \"%s\",\n", apm_profile.name);
+    fprintf(f, "  \"apm_echo_suppression\": \"%s\",\n", apm_level_name(apm_profile.echo_suppression));
+    fprintf(f, "  \"apm_noise_suppression\": \"%s\",\n", apm_level_name(apm_profile.noise_suppression));
+    fprintf(f, "  \"apm_agc\": \"%s\",\n", apm_agc_name(apm_profile.agc));
+    fprintf(f, "  \"apm_high_pass\": %s,\n", apm_profile.high_pass ? "true" : "false");
+    fprintf(f, "  \"call_recording\": %s,\n", call_recording ? "true" : "false");
+    fprintf(f, "  \"recording_format\": \"%s\",\n",
+            recording_format == CALL_REC_OPUS ? "opus" : recording_format == CALL_REC_WAV ? "wav" : "flac");
+    fprintf(f, "  \"recording_stereo\": %s,\n", recording_stereo ? "true" : "false");
+    fprintf(f, "  \"recording_dir\": \"%s\",\n", recording_dir);
+    fprintf(f, "  \"audio_backend\": \"%s\",\n", audio_backend_name(audio_backend));
+    fprintf(f, "  \"audio_latency_ms\": %d,\n", audio_latency_ms);
+    fprintf(f, "  \"playback_device\": \"%s\",\n", audio_playback_device);
+    fprintf(f, "  \"capture_device\": \"%s\",\n", audio_capture_device);
+    fprintf(f, "  \"jitter_min_ms\": %d,\n", jitter_min_ms);
+    fprintf(f, "  \"jitter_max_ms\": %d,\n", jitter_max_ms);
+    fprintf(f, "  \"speaker_gain_db\": %d,\n", speaker_gain_db);
+    fprintf(f, "  \"mic_gain_db\": %d,\n", mic_gain_db);
+    fprintf(f, "  \"realtime_audio\": %s,\n", realtime_audio ? "true" : "false");
+    fprintf(f, "  \"realtime_priority\": %d,\n", realtime_priority);
+    fprintf(f, "  \"playback_cpu\": %d,\n", playback_cpu);
+    fprintf(f, "  \"capture_cpu\": %d,\n", capture_cpu);
+    fprintf(f, "  \"audio_warm_start\": %s,\n", audio_warm_start ? "true" : "false");
     fprintf(f, "  \"autostart\": %s\n", autostart_enabled ? "true" : "false");
     fprintf(f, "}\n");
     fclose(f);
@@ -654,6 +867,16 @@ static void on_autostart_toggled(GtkToggleButton *button, gpointer data) {
     set_autostart(active);
 }
 
+// Audio processing profile; a running call switches without reconnecting
+static void on_apm_profile_changed(GtkComboBox *combo, gpointer data) {
+    (void)data;
+    const char *id = gtk_combo_box_get_active_id(combo);
+    if (!id || strcmp(id, apm_profile.name) == 0) return;
+    if (apm_profile_preset(id, &apm_profile) < 0) return;  // "custom" stays as loaded
+    sco_audio_set_apm_profile(&apm_profile);
+    save_settings();
+}
+
 // GTK destroy callback wrapper
 static void on_window_destroy(GtkWidget *widget, gpointer data) {
     (void)widget; (void)data;
@@ -1954,9 +2177,66 @@ static void on_sync_recents_clicked(GtkWidget *widget, gpointer data) {
     g_thread_new("pbap_recents", sync_recents_thread, NULL);
 }
 
-// HFP monitoring thread - keeps connection open and listens for events
-static gboolean hfp_monitor_running = FALSE;
-static GThread *hfp_monitor_thread_handle = NULL;
+// ============================================================================
+// HFP CODEC NEGOTIATION (CVSD / mSBC)
+// ============================================================================
+
+static gboolean msbc_supported(void) {
+#ifdef HAVE_SBC
+    return wideband_enabled;
+#else
+    return FALSE;
+#endif
+}
+
+// Local AEC runs only when it is built in and switched on in the settings
+static gboolean local_aec_enabled(void) {
+#ifdef HAVE_WEBRTC_APM
+    return echo_cancellation;
+#else
+    return FALSE;
+#endif
+}
+
+// HF feature bits for AT+BRSF; the link sends AT+BAC when both sides negotiate
+// and AT+NREC=0 only when EC/NR is advertised (we cancel the echo ourselves)
+static int hfp_hf_features(void) {
+    return (local_aec_enabled() ? HFP_HF_FEATURE_EC_NR : 0) |
+           (msbc_supported() ? HFP_HF_FEATURE_CODEC_NEGOTIATION : 0);
+}
+
+// Reset per-SLC codec state
+static void hfp_codec_reset(void) {
+    hfp_codec = HFP_CODEC_CVSD;
+}
+
+// +BCS: <id> - AG selected a codec, confirm with AT+BCS
+// Runs in the link's event callback: queue, never wait
+static void hfp_handle_bcs(const char *buf) {
+    const char *p = strstr(buf, "+BCS:");
+    if (!p) return;
+
+    int id = atoi(p + strlen("+BCS:"));
+    char cmd[32];
+
+    if (id != HFP_CODEC_CVSD && !(id == HFP_CODEC_MSBC && msbc_supported())) {
+        // Unsupported codec - repeat the list so the AG selects again
+        snprintf(cmd, sizeof(cmd), "AT+BAC=1%s", msbc_supported() ? ",2" : "");
+        hfp_link_request(hfp_link, HFP_REQ_COMMAND, cmd, AT_TIMEOUT_MS, NULL, NULL);
+        return;
+    }
+
+    snprintf(cmd, sizeof(cmd), "AT+BCS=%d", id);
+    hfp_link_request(hfp_link, HFP_REQ_COMMAND, cmd, AT_TIMEOUT_MS, NULL, NULL);
+    hfp_codec = id;
+    log_msg(id == HFP_CODEC_MSBC ? "🎧 Codec: mSBC (16 kHz wideband)" : "🎧 Codec: CVSD (8 kHz)");
+
+    // Codec change during a call needs a new SCO link
+    if (sco_audio_running() && sco_codec != hfp_codec) {
+        log_msg("ℹ️ Codec changed, reconnecting SCO");
+        sco_connect_async(TRUE);
+    }
+}
 
 // Just refresh UI (without changing state)
 static gboolean hfp_refresh_ui_cb(gpointer data) {
@@ -1965,11 +2245,11 @@ static gboolean hfp_refresh_ui_cb(gpointer data) {
     return G_SOURCE_REMOVE;
 }
 
-static gboolean restart_incoming_listener_cb(gpointer data) {
+static gboolean restart_hfp_link_cb(gpointer data) {
     (void)data;
-    if (current_state == STATE_CONNECTED && !incoming_call_thread) {
-        log_msg("🔁 Restarting listener");
-        start_incoming_call_listener();
+    if (current_state == STATE_CONNECTED && hfp_link_state(hfp_link) == HFP_LINK_DOWN) {
+        log_msg("🔁 Reconnecting HFP link");
+        start_hfp_link();
     }
     return G_SOURCE_REMOVE;
 }
@@ -1992,8 +2272,9 @@ static void handle_ciev_event(int ind, int val) {
     if (ind == 1) {  // Call indicator
         if (val == 1) {
             log_msg("✓ Call active");
-            if (!sco_audio_running && sco_socket < 0) {
-                sco_connect();
+            // After ATA the answer thread is already connecting SCO
+            if (!g_atomic_int_get(&sco_answer_pending)) {
+                sco_connect_async(FALSE);
             }
             g_idle_add(hfp_update_call_state_cb, GINT_TO_POINTER(CALL_ACTIVE));
         } else if (val == 0) {
@@ -2019,6 +2300,7 @@ static void handle_ciev_event(int ind, int val) {
         if (val == 1) {
             if (current_call_state != CALL_RINGING) {
                 log_msg("🔔 INCOMING CALL (CIEV)");
+                sco_warm_start();
                 g_idle_add(hfp_update_call_state_cb, GINT_TO_POINTER(CALL_RINGING));
             }
             return;
@@ -2028,111 +2310,36 @@ static void handle_ciev_event(int ind, int val) {
                 log_msg("📱 Outgoing call (CIEV)");
                 g_idle_add(hfp_update_call_state_cb, GINT_TO_POINTER(CALL_OUTGOING));
             }
-            if (!sco_audio_running && sco_socket < 0) {
-                sco_connect();
-            }
+            sco_connect_async(FALSE);
             return;
         }
     }
 }
 
-static gpointer hfp_monitor_thread(gpointer data) {
-    (void)data;
-    char buf[512];
-    int n;
-    
-    log_msg("🔊 HFP monitor started");
-    
-    while (hfp_monitor_running) {
-        int sock = hfp_socket;  // Local copy
-        if (sock < 0) break;
-        
-        // Non-blocking check
-        fd_set readfds;
-        struct timeval tv;
-        FD_ZERO(&readfds);
-        FD_SET(sock, &readfds);
-        tv.tv_sec = 0;
-        tv.tv_usec = 500000;  // 500ms timeout
-        
-        int ret = select(sock + 1, &readfds, NULL, NULL, &tv);
-        
-        // Check if stopped
-        if (!hfp_monitor_running) break;
-        
-        // Is socket still valid?
-        if (hfp_socket < 0) break;
-        
-        if (ret > 0 && FD_ISSET(sock, &readfds)) {
-            memset(buf, 0, sizeof(buf));
-            n = read(sock, buf, sizeof(buf) - 1);
-            
-            if (n <= 0) {
-                // Connection lost
-                if (hfp_monitor_running) {
-                    log_msg("⚠️ HFP connection lost");
-                    g_idle_add(hfp_update_call_state_cb, GINT_TO_POINTER(CALL_IDLE));
-                }
-                if (hfp_socket >= 0) {
-                    shutdown(hfp_socket, SHUT_RDWR);
-                    close(hfp_socket);
-                    hfp_socket = -1;
-                }
-                break;
-            }
-            
-            // Parse AT events
-            if (strstr(buf, "+CIEV")) {
-                int ind = -1, val = -1;
-                if (parse_ciev(buf, &ind, &val)) {
-                    handle_ciev_event(ind, val);
-                }
-            } else if (strstr(buf, "NO CARRIER") || strstr(buf, "BUSY") || strstr(buf, "NO ANSWER")) {
-                log_msg("📱 Call ended");
-                g_idle_add(hfp_update_call_state_cb, GINT_TO_POINTER(CALL_IDLE));
-                break;
-            }
-        } else if (ret < 0 && errno != EINTR) {
-            break;
-        }
+// Unsolicited results, dispatched by keyword from the HFP link (reactor thread)
+static void at_on_ciev(const AtRecord *rec, void *user_data) {
+    (void)user_data;
+    int ind = -1, val = -1;
+    if (!parse_ciev(rec->line, &ind, &val)) return;
+
+    // Indicator order is the phone's (+CIND=?): 1 = call, 2 = call setup here
+    int call = hfp_link_indicator(hfp_link, "call");
+    int setup = hfp_link_indicator(hfp_link, "callsetup");
+    if (!setup) setup = hfp_link_indicator(hfp_link, "call_setup");  // Pre-1.5 AGs
+    if (call && setup) {
+        ind = ind == call ? 1 : ind == setup ? 2 : 0;
     }
-    
-    log_msg("🔊 HFP monitor stopped");
-    hfp_monitor_running = FALSE;
-    return NULL;
+    handle_ciev_event(ind, val);
 }
 
-// Close HFP connection (thread-safe)
-static void hfp_close(void) {
-    // Stop monitor first
-    hfp_monitor_running = FALSE;
-    sco_audio_running = FALSE;  // Stop audio threads
-    
-    // Close SCO socket - this triggers thread shutdown
-    if (sco_socket >= 0) {
-        shutdown(sco_socket, SHUT_RDWR);
-        close(sco_socket);
-        sco_socket = -1;
-        log_msg("🔊 SCO audio closed");
-    }
-    
-    // Wait for threads to close their PulseAudio
-    usleep(100000);  // 100ms wait
-    
-    // Close socket
-    if (hfp_socket >= 0) {
-        shutdown(hfp_socket, SHUT_RDWR);  // Wake up select
-        close(hfp_socket);
-        hfp_socket = -1;
-    }
-    
-    // Wait for thread to finish (max 1 second)
-    if (hfp_monitor_thread_handle) {
-        g_thread_join(hfp_monitor_thread_handle);
-        hfp_monitor_thread_handle = NULL;
-    }
-    
-    log_msg("✓ HFP connection closed");
+static void hfp_reactor_log_stats(void) {
+    IoReactorStats st;
+    char stats[160];
+    io_reactor_get_stats(hfp_reactor, &st);
+    io_reactor_format_stats(&st, stats, sizeof(stats));
+    char msg[200];
+    snprintf(msg, sizeof(msg), "📊 HFP I/O: %s", stats);
+    log_msg(msg);
 }
 
 // Lambda helper for thread-safe logging
@@ -2146,20 +2353,14 @@ static gboolean lambda_log(char *msg) {
 static gboolean answer_incoming_call_cb(gpointer data) {
     (void)data;
     
-    if (hfp_listen_socket >= 0) {
-        // Send ATA command - answer call
-        char cmd[] = "ATA\r";
-        if (write(hfp_listen_socket, cmd, strlen(cmd)) > 0) {
-            usleep(200000);
-            char buf[256] = {0};
-            read(hfp_listen_socket, buf, sizeof(buf) - 1);
-            log_msg("✓ Call answered");
-            
-            // Establish SCO connection
-            sco_connect();
-            
-            set_call_state(CALL_ACTIVE);
-        }
+    // Send ATA command - answer call; the reactor reads the OK
+    if (hfp_link_answer(hfp_link, NULL, NULL)) {
+        log_msg("✓ Call answered");
+        
+        // Establish SCO connection
+        sco_connect_async(TRUE);
+        
+        set_call_state(CALL_ACTIVE);
     }
     return FALSE;
 }
@@ -2168,15 +2369,9 @@ static gboolean answer_incoming_call_cb(gpointer data) {
 static gboolean reject_incoming_call_cb(gpointer data) {
     (void)data;
     
-    if (hfp_listen_socket >= 0) {
-        // AT+CHUP - reject call
-        char cmd[] = "AT+CHUP\r";
-        if (write(hfp_listen_socket, cmd, strlen(cmd)) > 0) {
-            usleep(200000);
-            char buf[256] = {0};
-            read(hfp_listen_socket, buf, sizeof(buf) - 1);
-            log_msg("📱 Call rejected");
-        }
+    // AT+CHUP - reject call
+    if (hfp_link_hangup(hfp_link, NULL, NULL)) {
+        log_msg("📱 Call rejected");
     }
     set_call_state(CALL_IDLE);
     current_call_number[0] = '\0';
@@ -2184,525 +2379,494 @@ static gboolean reject_incoming_call_cb(gpointer data) {
     return FALSE;
 }
 
-// Incoming call listener thread
-static gpointer incoming_call_listener(gpointer data) {
-    (void)data;
-    
-    log_msg("📞 Incoming call listener started");
-    
-    // Establish HFP connection
-    hfp_listen_socket = socket(AF_BLUETOOTH, SOCK_STREAM, BTPROTO_RFCOMM);
-    if (hfp_listen_socket < 0) {
-        log_msg("⚠️ Listener socket error");
-        return NULL;
-    }
-    
-    struct sockaddr_rc addr = {0};
-    addr.rc_family = AF_BLUETOOTH;
-    addr.rc_channel = hfp_channel ? hfp_channel : 3;  // Dynamic or default
-    str2ba(device_addr, &addr.rc_bdaddr);
-    
-    if (connect(hfp_listen_socket, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
-        char err_msg[128];
-        snprintf(err_msg, sizeof(err_msg), "⚠️ Listener connection error (errno=%d: %s)", errno, strerror(errno));
-        log_msg(err_msg);
-        close(hfp_listen_socket);
-        hfp_listen_socket = -1;
-        return NULL;
-    }
-    // SLC handshake
-    char buf[512];
-    char cmd[64];
-    
-    // AT+BRSF
-    snprintf(cmd, sizeof(cmd), "AT+BRSF=1\r");
-    write(hfp_listen_socket, cmd, strlen(cmd));
-    usleep(100000);
-    read(hfp_listen_socket, buf, sizeof(buf) - 1);
-    
-    // AT+CIND=?
-    snprintf(cmd, sizeof(cmd), "AT+CIND=?\r");
-    write(hfp_listen_socket, cmd, strlen(cmd));
-    usleep(100000);
-    read(hfp_listen_socket, buf, sizeof(buf) - 1);
-    
-    // AT+CIND?
-    snprintf(cmd, sizeof(cmd), "AT+CIND?\r");
-    write(hfp_listen_socket, cmd, strlen(cmd));
-    usleep(100000);
-    read(hfp_listen_socket, buf, sizeof(buf) - 1);
-    
-    // AT+CMER - event reporting active
-    snprintf(cmd, sizeof(cmd), "AT+CMER=3,0,0,1\r");
-    write(hfp_listen_socket, cmd, strlen(cmd));
-    usleep(100000);
-    read(hfp_listen_socket, buf, sizeof(buf) - 1);
-    
-    // AT+CLIP - caller ID display active
-    snprintf(cmd, sizeof(cmd), "AT+CLIP=1\r");
-    write(hfp_listen_socket, cmd, strlen(cmd));
-    usleep(100000);
-    read(hfp_listen_socket, buf, sizeof(buf) - 1);
-    
-    log_msg("✓ Incoming call listener ready");
-    
-    // Pending dial from tel: URI
-    if (pending_dial_number[0]) {
-        char msg[128];
-        snprintf(msg, sizeof(msg), "📞 Auto-dialing: %s", pending_dial_number);
-        log_msg(msg);
-        usleep(500000);  // Wait a bit for connection to stabilize
-        dial_number(pending_dial_number);
-        pending_dial_number[0] = '\0';  // Clear after dialing
-    }
-    
-    // Listen for events
-    while (incoming_call_running && hfp_listen_socket >= 0) {
-        if (hfp_listen_paused) {
-            usleep(100000);
-            continue;
-        }
-        fd_set readfds;
-        struct timeval tv;
-        FD_ZERO(&readfds);
-        FD_SET(hfp_listen_socket, &readfds);
-        tv.tv_sec = 1;
-        tv.tv_usec = 0;
-        
-        int ret = select(hfp_listen_socket + 1, &readfds, NULL, NULL, &tv);
-        
-        if (!incoming_call_running) break;
+static void hfp_on_any(const AtRecord *rec, void *user_data) {
+    (void)user_data;
+    // Debug: log incoming data
+    char debug_msg[128];
+    snprintf(debug_msg, sizeof(debug_msg), "📥 HFP: %.60s", rec->line);
+    log_msg(debug_msg);
+}
 
-        if (hfp_listen_paused) {
-            continue;
-        }
-        
-        if (ret > 0 && FD_ISSET(hfp_listen_socket, &readfds)) {
-            memset(buf, 0, sizeof(buf));
-            ssize_t n = read(hfp_listen_socket, buf, sizeof(buf) - 1);
-            
-            if (n <= 0) {
-                log_msg("⚠️ Listener connection lost");
-                g_idle_add(hfp_update_call_state_cb, GINT_TO_POINTER(CALL_IDLE));
-                g_idle_add(restart_incoming_listener_cb, NULL);
-                break;
-            }
+// Codec selection (before SCO setup)
+static void hfp_on_bcs(const AtRecord *rec, void *user_data) {
+    (void)user_data;
+    hfp_handle_bcs(rec->line);
+}
+
+// +CLIP to get number (may come separately from RING)
+static void hfp_on_clip(const AtRecord *rec, void *user_data) {
+    (void)user_data;
+    char buf[AT_LINE_MAX];
+    snprintf(buf, sizeof(buf), "%s", rec->line);
+
+    // +CLIP: "number",129,,,"name" format
+    char *num_start = strchr(buf, '"');
+    if (num_start) {
+        num_start++;
+        char *num_end = strchr(num_start, '"');
+        if (num_end) {
+            *num_end = '\0';
+            strncpy(current_call_number, num_start, sizeof(current_call_number) - 1);
             
-            // Debug: log incoming data
-            char debug_msg[128];
-            snprintf(debug_msg, sizeof(debug_msg), "📥 HFP: %.60s", buf);
-            log_msg(debug_msg);
+            // Get name from +CLIP (in 5th quote)
+            current_call_name[0] = '\0';
+            char *name_search = num_end + 1;
+            int quote_count = 0;
+            char *name_start = NULL;
             
-            // +CLIP to get number (may come separately from RING)
-            char *clip = strstr(buf, "+CLIP:");
-            if (clip) {
-                // +CLIP: "number",129,,,"name" format
-                char *num_start = strchr(clip, '"');
-                if (num_start) {
-                    num_start++;
-                    char *num_end = strchr(num_start, '"');
-                    if (num_end) {
-                        *num_end = '\0';
-                        strncpy(current_call_number, num_start, sizeof(current_call_number) - 1);
-                        
-                        // Get name from +CLIP (in 5th quote)
-                        current_call_name[0] = '\0';
-                        char *name_search = num_end + 1;
-                        int quote_count = 0;
-                        char *name_start = NULL;
-                        
-                        while (*name_search && quote_count < 4) {
-                            if (*name_search == '"') {
-                                quote_count++;
-                                if (quote_count == 4) {
-                                    name_start = name_search + 1;
-                                }
-                            }
-                            name_search++;
-                        }
-                        
-                        if (name_start) {
-                            char *name_end = strchr(name_start, '"');
-                            if (name_end && name_end > name_start) {
-                                *name_end = '\0';
-                                strncpy(current_call_name, name_start, sizeof(current_call_name) - 1);
-                            }
-                        }
-                        
-                        // If name not from +CLIP, find from contacts
-                        if (!current_call_name[0]) {
-                            char normalized_incoming[32] = {0};
-                            int incoming_len = strlen(current_call_number);
-                            if (incoming_len >= 10) {
-                                strncpy(normalized_incoming, current_call_number + incoming_len - 10, 10);
-                            } else {
-                                strncpy(normalized_incoming, current_call_number, sizeof(normalized_incoming) - 1);
-                            }
-                            
-                            for (int i = 0; i < all_contacts_count; i++) {
-                                char normalized_contact[32] = {0};
-                                int contact_len = strlen(all_contacts[i].number);
-                                if (contact_len >= 10) {
-                                    strncpy(normalized_contact, all_contacts[i].number + contact_len - 10, 10);
-                                } else {
-                                    strncpy(normalized_contact, all_contacts[i].number, sizeof(normalized_contact) - 1);
-                                }
-                                
-                                if (strcmp(normalized_incoming, normalized_contact) == 0) {
-                                    strncpy(current_call_name, all_contacts[i].name, sizeof(current_call_name) - 1);
-                                    break;
-                                }
-                            }
-                        }
-                        
-                        char msg[256];
-                        if (current_call_name[0]) {
-                            snprintf(msg, sizeof(msg), "📱 Caller: %s (%s)", current_call_name, current_call_number);
-                        } else {
-                            snprintf(msg, sizeof(msg), "📱 Caller: %s", current_call_number);
-                        }
-                        log_msg(msg);
-                        
-                        // Update UI (refresh if already RINGING)
-                        if (current_call_state == CALL_RINGING) {
-                            g_idle_add(hfp_refresh_ui_cb, NULL);
-                        } else {
-                            g_idle_add(hfp_update_call_state_cb, GINT_TO_POINTER(CALL_RINGING));
-                        }
+            while (*name_search && quote_count < 4) {
+                if (*name_search == '"') {
+                    quote_count++;
+                    if (quote_count == 4) {
+                        name_start = name_search + 1;
                     }
                 }
+                name_search++;
             }
             
-            // RING - incoming call (may be without number)
-            if (strstr(buf, "RING") && current_call_state != CALL_RINGING) {
-                log_msg("🔔 INCOMING CALL!");
-                g_idle_add(hfp_update_call_state_cb, GINT_TO_POINTER(CALL_RINGING));
+            if (name_start) {
+                char *name_end = strchr(name_start, '"');
+                if (name_end && name_end > name_start) {
+                    *name_end = '\0';
+                    strncpy(current_call_name, name_start, sizeof(current_call_name) - 1);
+                }
             }
             
-            // CIEV events: ind=1 (call), ind=2 (callsetup)
-            if (strstr(buf, "+CIEV:")) {
-                int ind = -1, val = -1;
-                if (parse_ciev(buf, &ind, &val)) {
-                    handle_ciev_event(ind, val);
+            // If name not from +CLIP, find from contacts
+            if (!current_call_name[0]) {
+                char normalized_incoming[32] = {0};
+                int incoming_len = strlen(current_call_number);
+                if (incoming_len >= 10) {
+                    strncpy(normalized_incoming, current_call_number + incoming_len - 10, 10);
+                } else {
+                    strncpy(normalized_incoming, current_call_number, sizeof(normalized_incoming) - 1);
+                }
+                
+                for (int i = 0; i < all_contacts_count; i++) {
+                    char normalized_contact[32] = {0};
+                    int contact_len = strlen(all_contacts[i].number);
+                    if (contact_len >= 10) {
+                        strncpy(normalized_contact, all_contacts[i].number + contact_len - 10, 10);
+                    } else {
+                        strncpy(normalized_contact, all_contacts[i].number, sizeof(normalized_contact) - 1);
+                    }
+                    
+                    if (strcmp(normalized_incoming, normalized_contact) == 0) {
+                        strncpy(current_call_name, all_contacts[i].name, sizeof(current_call_name) - 1);
+                        break;
+                    }
                 }
             }
-            else if (strstr(buf, "NO CARRIER") || strstr(buf, "BUSY") || strstr(buf, "NO ANSWER") || strstr(buf, "ERROR")) {
-                log_msg("📱 Call ended");
-                g_idle_add(hfp_update_call_state_cb, GINT_TO_POINTER(CALL_IDLE));
+            
+            char msg[256];
+            if (current_call_name[0]) {
+                snprintf(msg, sizeof(msg), "📱 Caller: %s (%s)", current_call_name, current_call_number);
+            } else {
+                snprintf(msg, sizeof(msg), "📱 Caller: %s", current_call_number);
+            }
+            log_msg(msg);
+            
+            sco_warm_start();
+
+            // Update UI (refresh if already RINGING)
+            if (current_call_state == CALL_RINGING) {
+                g_idle_add(hfp_refresh_ui_cb, NULL);
+            } else {
+                g_idle_add(hfp_update_call_state_cb, GINT_TO_POINTER(CALL_RINGING));
             }
         }
     }
-    
-    if (hfp_listen_socket >= 0) {
-        close(hfp_listen_socket);
-        hfp_listen_socket = -1;
+}
+
+// RING - incoming call (may be without number)
+static void hfp_on_ring(const AtRecord *rec, void *user_data) {
+    (void)rec; (void)user_data;
+    if (current_call_state != CALL_RINGING) {
+        log_msg("🔔 INCOMING CALL!");
+        sco_warm_start();
+        g_idle_add(hfp_update_call_state_cb, GINT_TO_POINTER(CALL_RINGING));
     }
+}
 
-    incoming_call_running = FALSE;
-    incoming_call_thread = NULL;
+static void hfp_on_call_end(const AtRecord *rec, void *user_data) {
+    (void)rec; (void)user_data;
+    log_msg("📱 Call ended");
+    g_idle_add(hfp_update_call_state_cb, GINT_TO_POINTER(CALL_IDLE));
+}
 
-    log_msg("📞 Incoming call listener stopped");
-    return NULL;
+// CIEV events: ind=1 (call), ind=2 (callsetup); every record is logged first
+static const AtHandler hfp_event_handlers[] = {
+    { HFP_LINK_ANY_EVENT, hfp_on_any },
+    { AT_KW_BCS, hfp_on_bcs },
+    { AT_KW_CLIP, hfp_on_clip },
+    { AT_KW_RING, hfp_on_ring },
+    { AT_KW_CIEV, at_on_ciev },
+    { AT_KW_NO_CARRIER, hfp_on_call_end },
+    { AT_KW_BUSY, hfp_on_call_end },
+    { AT_KW_NO_ANSWER, hfp_on_call_end },
+};
+
+// Pending dial from tel: URI (the ATD result comes back through the main loop)
+static gboolean hfp_auto_dial_cb(gpointer data) {
+    (void)data;
+    if (pending_dial_number[0] && current_state == STATE_CONNECTED) {
+        char msg[128];
+        snprintf(msg, sizeof(msg), "📞 Auto-dialing: %s", pending_dial_number);
+        log_msg(msg);
+        dial_number(pending_dial_number);
+        pending_dial_number[0] = '\0';  // Clear after dialing
+    }
+    return G_SOURCE_REMOVE;
 }
 
-// Start incoming call listener
-static void start_incoming_call_listener(void) {
-    if (incoming_call_thread) return;  // Already running
-    if (!device_addr[0]) return;  // No device
-    
-    incoming_call_running = TRUE;
-    incoming_call_thread = g_thread_new("incoming-call", incoming_call_listener, NULL);
+static void hfp_log_stats(void) {
+    HfpLinkStats st;
+    char stats[160];
+    char msg[200];
+    hfp_link_get_stats(hfp_link, &st);
+    at_engine_format_stats(&st.at, stats, sizeof(stats));
+    snprintf(msg, sizeof(msg), "📊 AT: %s", stats);
+    log_msg(msg);
+    hfp_link_format_stats(&st, stats, sizeof(stats));
+    snprintf(msg, sizeof(msg), "📊 HFP link: %s", stats);
+    log_msg(msg);
+    hfp_reactor_log_stats();
 }
 
-// Stop incoming call listener
-static void stop_incoming_call_listener(void) {
-    incoming_call_running = FALSE;
-    
-    if (hfp_listen_socket >= 0) {
-        shutdown(hfp_listen_socket, SHUT_RDWR);
-        close(hfp_listen_socket);
-        hfp_listen_socket = -1;
-    }
-    
-    if (incoming_call_thread) {
-        g_thread_join(incoming_call_thread);
-        incoming_call_thread = NULL;
+// Reconnect-to-ready time, then the channel and AG answers that worked go
+// to the device cache
+static gboolean hfp_link_ready_cb(gpointer data) {
+    (void)data;
+    if (!device_addr[0] || hfp_link_state(hfp_link) != HFP_LINK_READY) return G_SOURCE_REMOVE;
+
+    HfpLinkStats st;
+    HfpAgInfo ag;
+    hfp_link_get_stats(hfp_link, &st);
+    hfp_link_get_ag_info(hfp_link, &ag);
+    uint8_t channel = hfp_channel ? hfp_channel : 3;
+
+    char channel_info[48];
+    if (hfp_channel_cached) {
+        snprintf(channel_info, sizeof(channel_info), "channel %d cached", channel);
+    } else if (hfp_sdp_ms >= 0) {
+        snprintf(channel_info, sizeof(channel_info), "SDP %.0f ms", hfp_sdp_ms);
+    } else {
+        snprintf(channel_info, sizeof(channel_info), "channel %d", channel);
     }
+    // From CONNECTED on the first SLC, else from the link's own open
+    double ready_ms = hfp_connect_us ? (g_get_monotonic_time() - hfp_connect_us) / 1000.0 : st.ready_ms;
+    hfp_connect_us = 0;
+    hfp_sdp_ms = -1;
+
+    char msg[160];
+    snprintf(msg, sizeof(msg), "✓ HFP link ready in %.0f ms (%s, SLC %.0f ms%s)",
+             ready_ms, channel_info, st.slc_ms, st.slc_cached ? ", indicators cached" : "");
+    log_msg(msg);
+
+    hfp_device_store(device_addr, channel, &ag);
+    return G_SOURCE_REMOVE;
 }
 
-static void aec_fifo_clear(void) {
-    pthread_mutex_lock(&aec_fifo_mutex);
-    aec_fifo_head = 0;
-    aec_fifo_tail = 0;
-    aec_fifo_size = 0;
-    pthread_mutex_unlock(&aec_fifo_mutex);
+// Connect or handshake failed: the cache entry is dropped. If the channel
+// came from it, SDP is asked once and the link tried again
+static gboolean hfp_link_failed_cb(gpointer data) {
+    (void)data;
+    if (!device_addr[0]) return G_SOURCE_REMOVE;
+    hfp_device_forget(device_addr);
+    if (!hfp_channel_cached || current_state != STATE_CONNECTED) return G_SOURCE_REMOVE;
+
+    char msg[96];
+    snprintf(msg, sizeof(msg), "🗂 Cached HFP channel %d failed, asking SDP", hfp_channel);
+    log_msg(msg);
+    hfp_channel_cached = FALSE;
+    gint64 t0 = g_get_monotonic_time();
+    hfp_channel = find_hfp_channel(device_addr);
+    hfp_sdp_ms = (g_get_monotonic_time() - t0) / 1000.0;
+    if (hfp_link_state(hfp_link) == HFP_LINK_DOWN) start_hfp_link();
+    return G_SOURCE_REMOVE;
 }
 
-static void aec_fifo_push(const int16_t *samples, int count) {
-    if (count <= 0) return;
-    pthread_mutex_lock(&aec_fifo_mutex);
-    for (int i = 0; i < count; i++) {
-        aec_render_fifo[aec_fifo_head] = samples[i];
-        aec_fifo_head = (aec_fifo_head + 1) % AEC_FIFO_CAPACITY;
-        if (aec_fifo_size < AEC_FIFO_CAPACITY) {
-            aec_fifo_size++;
-        } else {
-            aec_fifo_tail = (aec_fifo_tail + 1) % AEC_FIFO_CAPACITY;
-        }
+// Reactor thread
+static void hfp_on_link_state(HfpLinkState state, HfpLinkState previous, int err, void *user_data) {
+    (void)user_data;
+    char msg[160];
+
+    switch (state) {
+        case HFP_LINK_CONNECTING:
+            log_msg("📞 HFP link connecting");
+            break;
+        case HFP_LINK_SLC:
+            hfp_codec_reset();
+            break;
+        case HFP_LINK_READY:
+            g_idle_add(hfp_link_ready_cb, NULL);
+            if (pending_dial_number[0]) g_idle_add(hfp_auto_dial_cb, NULL);
+            break;
+        case HFP_LINK_DOWN:
+            if (previous == HFP_LINK_CONNECTING) {
+                if (err) {
+                    snprintf(msg, sizeof(msg), "⚠️ HFP connection error (errno=%d: %s)", err, strerror(err));
+                    log_msg(msg);
+                    g_idle_add(hfp_link_failed_cb, NULL);
+                }
+                break;
+            }
+            hfp_log_stats();
+            if (err == EPROTO) {
+                log_msg("⚠️ HFP handshake failed");
+                g_idle_add(hfp_link_failed_cb, NULL);
+            } else if (err) {
+                log_msg("⚠️ HFP connection lost");
+                g_idle_add(hfp_update_call_state_cb, GINT_TO_POINTER(CALL_IDLE));
+                g_idle_add(restart_hfp_link_cb, NULL);
+            } else {
+                log_msg("📞 HFP link closed");
+            }
+            break;
     }
-    pthread_mutex_unlock(&aec_fifo_mutex);
 }
 
-static gboolean aec_fifo_pop(int16_t *out, int count) {
-    if (count <= 0) return FALSE;
-    gboolean ok = FALSE;
-    pthread_mutex_lock(&aec_fifo_mutex);
-    if (aec_fifo_size >= count) {
-        for (int i = 0; i < count; i++) {
-            out[i] = aec_render_fifo[aec_fifo_tail];
-            aec_fifo_tail = (aec_fifo_tail + 1) % AEC_FIFO_CAPACITY;
-        }
-        aec_fifo_size -= count;
-        ok = TRUE;
-    }
-    pthread_mutex_unlock(&aec_fifo_mutex);
-    return ok;
+static void hfp_at_log_cb(const char *msg, void *user_data) {
+    (void)user_data;
+    log_msg(msg);
 }
 
-static void init_webrtc_aec(void) {
-#ifdef HAVE_WEBRTC_APM
-    if (aec_force_disable) {
-        aec_enabled = FALSE;
-        aec_fifo_clear();
-        log_msg("⚠️ WebRTC AEC disabled (robot voice prevention)");
+// One RFCOMM link to the phone for calls and events, run by the HFP I/O thread
+static void hfp_at_init(void) {
+    hfp_reactor = io_reactor_create("hfp-io");
+    if (!hfp_reactor) {
+        log_msg("⚠️ HFP I/O thread could not start (epoll)");
         return;
     }
-    pthread_mutex_lock(&aec_mutex);
-    if (!aec_handle) {
-        aec_handle = aec_create(8000);
-        aec_enabled = (aec_handle != NULL);
-    } else {
-        aec_enabled = TRUE;
+    HfpLinkConfig cfg = {
+        .name = "hfp",
+        .reactor = hfp_reactor,
+        .on_state = hfp_on_link_state,
+        .log = hfp_at_log_cb,
+    };
+    hfp_link = hfp_link_create(&cfg);
+    for (guint i = 0; hfp_link && i < G_N_ELEMENTS(hfp_event_handlers); i++) {
+        hfp_link_subscribe(hfp_link, hfp_event_handlers[i].keyword, hfp_event_handlers[i].handler, NULL);
     }
-    pthread_mutex_unlock(&aec_mutex);
-#else
-    aec_enabled = FALSE;
-#endif
-    if (aec_enabled) {
-        log_msg("✅ WebRTC AEC active");
-    } else {
-        log_msg("⚠️ WebRTC AEC disabled");
-    }
-    aec_fifo_clear();
 }
 
-static void shutdown_webrtc_aec(void) {
-#ifdef HAVE_WEBRTC_APM
-    pthread_mutex_lock(&aec_mutex);
-    if (aec_handle) {
-        aec_destroy(aec_handle);
-        aec_handle = NULL;
+// Connect the HFP link; returns at once, requests wait for the SLC
+static void start_hfp_link(void) {
+    if (!device_addr[0]) return;  // No device
+    HfpDevice *dev = hfp_device_find(device_addr);
+    hfp_link_open(hfp_link, device_addr, hfp_channel ? hfp_channel : 3,  // Dynamic or default
+                  hfp_hf_features(), dev ? &dev->ag : NULL);
+}
+
+// The socket is closed when this returns
+static void stop_hfp_link(void) {
+    hfp_link_close(hfp_link);
+}
+
+// SCO audio engine callbacks (audio threads)
+static void sco_audio_log_cb(const char *msg, void *user_data) {
+    (void)user_data;
+    g_idle_add((GSourceFunc)lambda_log, g_strdup(msg));
+}
+
+static gboolean sco_remote_closed_idle(gpointer data) {
+    // A newer link may have replaced the one that closed
+    if (GPOINTER_TO_UINT(data) == sco_generation) {
+        stop_sco_audio("🔇 SCO closed (remote closed)");
     }
-    pthread_mutex_unlock(&aec_mutex);
-#endif
-    aec_enabled = FALSE;
-    aec_fifo_clear();
+    return G_SOURCE_REMOVE;
 }
 
-// SCO -> PulseAudio playback thread (phone audio to PC)
-static void* sco_playback_thread_func(void *data) {
-    (void)data;
-    
-    // PulseAudio format: 8kHz mono 16-bit (SCO standard)
-    pa_sample_spec ss = {
-        .format = PA_SAMPLE_S16LE,
-        .rate = 8000,
-        .channels = 1
+// Microphone thread: it cannot join itself, the main loop tears down
+static void sco_audio_closed_cb(void *user_data) {
+    g_idle_add(sco_remote_closed_idle, user_data);
+}
+
+// Engine settings shared by the call and the warm start
+static void sco_audio_config_fill(ScoAudioConfig *audio, int codec, int mtu) {
+    *audio = (ScoAudioConfig){
+        .socket = sco_socket,
+        .mtu = mtu,
+        .codec = codec == HFP_CODEC_MSBC ? SCO_CODEC_MSBC : SCO_CODEC_CVSD,
+        .backend = audio_backend,
+        .latency_ms = audio_latency_ms,
+        .playback_device = audio_playback_device,
+        .capture_device = audio_capture_device,
+        .jitter_min_ms = jitter_min_ms,
+        .jitter_max_ms = jitter_max_ms,
+        .aec = echo_cancellation,
+        .apm_profile = apm_profile,
+        .playback_gain_db = speaker_gain_db,
+        .capture_gain_db = mic_gain_db,
+        .realtime = realtime_audio,
+        .realtime_priority = realtime_priority,
+        .playback_cpu = playback_cpu,
+        .capture_cpu = capture_cpu,
+        .log = sco_audio_log_cb,
     };
-    
-    int err;
-    pulse_playback = pa_simple_new(
-        NULL,               // default server
-        "PCPhone",       // app name
-        PA_STREAM_PLAYBACK,
-        NULL,               // default device
-        "Phone Audio",      // stream description
-        &ss,
-        NULL,               // default channel map
-        NULL,               // default buffering
-        &err
-    );
-    
-    if (!pulse_playback) {
-        g_idle_add((GSourceFunc)lambda_log, g_strdup_printf("⚠️ Speaker could not be opened: %s", pa_strerror(err)));
-        return NULL;
-    }
-    
-    g_idle_add((GSourceFunc)lambda_log, g_strdup("🔊 Speaker active - phone audio coming"));
-    
-    unsigned char buf[240];
-    ssize_t bytes_read;
-    
-    while (sco_audio_running && sco_socket >= 0) {
-        bytes_read = recv(sco_socket, buf, sizeof(buf), 0);
-        if (bytes_read <= 0) {
-            if (sco_audio_running) {
-                g_idle_add((GSourceFunc)lambda_log, g_strdup("⚠️ Phone audio cut"));
-            }
-            break;
-        }
+}
 
-        if (aec_enabled) {
-            int16_t *samples = (int16_t *)buf;
-            int count = (int)(bytes_read / 2);
-            aec_fifo_push(samples, count);
-        }
-        
-        if (pa_simple_write(pulse_playback, buf, bytes_read, &err) < 0) {
-            g_idle_add((GSourceFunc)lambda_log, g_strdup_printf("⚠️ Audio write error: %s", pa_strerror(err)));
-            break;
-        }
-    }
-    
-    if (pulse_playback) {
-        pa_simple_drain(pulse_playback, NULL);
-        pa_simple_free(pulse_playback);
-        pulse_playback = NULL;
-    }
-    
-    g_idle_add((GSourceFunc)lambda_log, g_strdup("🔇 Speaker closed"));
+static gpointer sco_warm_start_thread(gpointer data) {
+    (void)data;
+    // Codec the AG selected last and the MTU of the last link: what the
+    // answer will most likely bring up
+    ScoAudioConfig audio;
+    int codec = (hfp_codec == HFP_CODEC_MSBC && msbc_supported()) ? HFP_CODEC_MSBC : HFP_CODEC_CVSD;
+    sco_audio_config_fill(&audio, codec, sco_mtu);
+    sco_audio_prepare(&audio);
+    g_atomic_int_set(&warm_start_pending, 0);
     return NULL;
 }
 
-// PulseAudio -> SCO capture thread (PC microphone to phone)
-static void* sco_capture_thread_func(void *data) {
-    (void)data;
-    
-    // PulseAudio format: 8kHz mono 16-bit (SCO standard)
-    pa_sample_spec ss = {
-        .format = PA_SAMPLE_S16LE,
-        .rate = 8000,
-        .channels = 1
-    };
-    
-    int err;
-    pulse_capture = pa_simple_new(
-        NULL,               // default server
-        "PcPhone",       // app name
-        PA_STREAM_RECORD,
-        NULL,               // default device (microphone)
-        "PC Microphone",    // stream description
-        &ss,
-        NULL,               // default channel map
-        NULL,               // default buffering
-        &err
-    );
-    
-    if (!pulse_capture) {
-        g_idle_add((GSourceFunc)lambda_log, g_strdup_printf("⚠️ Microphone could not be opened: %s", pa_strerror(err)));
-        return NULL;
+// Phone rings: open speaker, microphone and AEC now, idle until answered
+static void sco_warm_start(void) {
+    if (!audio_warm_start || sco_audio_running() || sco_socket >= 0 || sco_teardown_pending) return;
+    if (!g_atomic_int_compare_and_exchange(&warm_start_pending, 0, 1)) return;
+    g_thread_unref(g_thread_new("audio_warm", sco_warm_start_thread, NULL));
+}
+
+static gboolean sco_connect_retried = FALSE;  // EMLINK / EBUSY retry done (reactor thread)
+static gboolean sco_retry_pending = FALSE;  // Stale SCO being cleared, retry queued (reactor thread)
+
+static void sco_connect_begin(void);
+
+// Link up (reactor thread): MTU, recording, audio threads
+static void sco_connect_finish(void) {
+    log_msg(sco_connect_retried ? "✓ SCO audio connected (retry)" : "✓ SCO audio connected");
+
+    // Read SCO MTU dynamically
+    struct sco_options sco_opts;
+    socklen_t optlen = sizeof(sco_opts);
+    if (getsockopt(sco_socket, SOL_SCO, SCO_OPTIONS, &sco_opts, &optlen) == 0) {
+        sco_mtu = sco_opts.mtu;
+        char msg[64];
+        snprintf(msg, sizeof(msg), "ℹ️ SCO MTU: %d byte", sco_mtu);
+        log_msg(msg);
+    } else {
+        sco_mtu = 48;  // Default
+        log_msg("ℹ️ SCO MTU not readable, default: 48");
     }
-    
-    g_idle_add((GSourceFunc)lambda_log, g_strdup("🎤 Microphone active - your voice going to phone"));
-    
-    const int mtu = sco_mtu;  // Dynamic MTU
-    unsigned char buf[AEC_FRAME_BYTES];
-    int16_t render_frame[AEC_FRAME_SAMPLES];
-    int send_error_logged = 0;
-    
-    while (sco_audio_running && sco_socket >= 0) {
-        int read_bytes = aec_enabled ? AEC_FRAME_BYTES : mtu;
 
-        // Read from microphone
-        if (pa_simple_read(pulse_capture, buf, read_bytes, &err) < 0) {
-            if (sco_audio_running) {
-                g_idle_add((GSourceFunc)lambda_log, g_strdup_printf("⚠️ Microphone read error: %s", pa_strerror(err)));
-            }
-            break;
-        }
+    log_msg(sco_codec == HFP_CODEC_MSBC ? "🎧 Wideband audio (mSBC, 16 kHz)" : "🎧 Narrowband audio (CVSD, 8 kHz)");
 
-        if (aec_enabled) {
-            int16_t *near = (int16_t *)buf;
-            if (!aec_fifo_pop(render_frame, AEC_FRAME_SAMPLES)) {
-                memset(render_frame, 0, sizeof(render_frame));
-            }
-#ifdef HAVE_WEBRTC_APM
-            pthread_mutex_lock(&aec_mutex);
-            if (aec_handle) {
-                aec_process(aec_handle, near, render_frame, AEC_FRAME_SAMPLES);
-            }
-            pthread_mutex_unlock(&aec_mutex);
-#endif
-        }
-        
-        // Send to SCO - split into MTU sized chunks
-        for (int offset = 0; offset < read_bytes; offset += mtu) {
-            int chunk = read_bytes - offset;
-            if (chunk > mtu) chunk = mtu;
-            ssize_t sent = send(sco_socket, buf + offset, chunk, MSG_NOSIGNAL);
-            if (sent <= 0) {
-                if (errno == EPIPE || errno == ENOTCONN || errno == ECONNRESET) {
-                    if (!send_error_logged) {
-                        g_idle_add((GSourceFunc)lambda_log, g_strdup_printf("⚠️ Microphone send error: %s", strerror(errno)));
-                        send_error_logged = 1;
-                    }
-                    stop_sco_audio("🔇 SCO closed (remote closed)");
-                    return NULL;
-                }
-                if (sco_audio_running && errno != EAGAIN && errno != EWOULDBLOCK && !send_error_logged) {
-                    g_idle_add((GSourceFunc)lambda_log, g_strdup_printf("⚠️ Microphone send error: %s", strerror(errno)));
-                    send_error_logged = 1;
-                }
-                usleep(1000);  // Short wait and retry
-                continue;
-            }
+    // Recording: <recording_dir>/call_<date>_<time>_<number>, extension per format
+    char record_base[768] = "";
+    if (call_recording) {
+        if (g_mkdir_with_parents(recording_dir, 0700) == 0) {
+            char stamp[32];
+            time_t now = time(NULL);
+            strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", localtime(&now));
+            char number[64];
+            g_strlcpy(number, current_call_number[0] ? current_call_number : "unknown", sizeof(number));
+            g_strcanon(number, "0123456789+", '_');
+            snprintf(record_base, sizeof(record_base), "%s/call_%s_%s", recording_dir, stamp, number);
+        } else {
+            log_msg("⚠️ Recording folder could not be created");
         }
     }
-    
-    if (pulse_capture) {
-        pa_simple_free(pulse_capture);
-        pulse_capture = NULL;
+
+    ScoAudioConfig audio;
+    sco_audio_config_fill(&audio, sco_codec, sco_mtu);
+    audio.record_path = record_base[0] ? record_base : NULL;
+    audio.record_format = recording_format;
+    audio.record_stereo = recording_stereo;
+    audio.on_remote_closed = sco_audio_closed_cb;
+    audio.user_data = GUINT_TO_POINTER(++sco_generation);
+    audio.answer_us = answer_started_us;  // Only the link brought up by an answer is timed
+    answer_started_us = 0;
+    sco_audio_start(&audio);
+    g_atomic_int_set(&sco_answer_pending, 0);
+}
+
+// Reactor thread; dropped if the connect was cancelled meanwhile
+static void sco_connect_retry_task(void *data) {
+    (void)data;
+    if (!sco_retry_pending) return;
+    sco_retry_pending = FALSE;
+    sco_connect_begin();
+}
+
+// pactl and the wait run here, the reactor goes on with the AT link
+static gpointer sco_reset_thread(gpointer data) {
+    (void)data;
+    // Reload PulseAudio Bluetooth module
+    if (system("pactl unload-module module-bluez5-device 2>/dev/null") < 0) {
+        g_idle_add((GSourceFunc)lambda_log, g_strdup("ℹ️ pactl could not be run"));
+    }
+    g_usleep(200000);  // 200ms wait
+
+    // Try again
+    if (io_reactor_post(hfp_reactor, sco_connect_retry_task, NULL) < 0) {
+        g_idle_add((GSourceFunc)lambda_log, g_strdup("⚠️ SCO retry could not be queued"));
+        g_atomic_int_set(&sco_answer_pending, 0);
     }
-    
-    g_idle_add((GSourceFunc)lambda_log, g_strdup("🔇 Microphone closed"));
     return NULL;
 }
 
-// Establish SCO audio connection
-static gboolean sco_connect(void) {
-    if (!device_addr[0]) {
-        return FALSE;
-    }
+static void sco_connect_failed(int err) {
+    char msg[128];
+    snprintf(msg, sizeof(msg), "⚠️ SCO connection error: %s", strerror(err));
+    log_msg(msg);
 
-    // Wait if previous connection still open
-    if (sco_audio_running) {
-        log_msg("ℹ️ Closing previous SCO...");
-        stop_sco_audio(NULL);
-        usleep(100000);  // 100ms extra wait
+    // EMLINK (Too many links) or EBUSY error - existing SCO
+    if ((err == EMLINK || err == EBUSY) && !sco_connect_retried) {
+        log_msg("ℹ️ Clearing existing SCO connection...");
+        sco_connect_retried = TRUE;
+        sco_retry_pending = TRUE;
+        g_thread_unref(g_thread_new("sco_reset", sco_reset_thread, NULL));
+        return;
     }
+    g_atomic_int_set(&sco_answer_pending, 0);
+}
 
-    if (sco_socket >= 0) {
-        // Socket open but no thread - clean up
-        shutdown(sco_socket, SHUT_RDWR);
-        close(sco_socket);
-        sco_socket = -1;
-        usleep(50000);
+// Non-blocking connect finished
+static void sco_on_connected(int fd, uint32_t events, void *user_data) {
+    (void)events; (void)user_data;
+    int err = 0;
+    socklen_t len = sizeof(err);
+    if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0) err = errno;
+    io_reactor_remove(hfp_reactor, fd);
+    sco_pending_socket = -1;
+    if (err) {
+        close(fd);
+        sco_connect_failed(err);
+        return;
     }
-    
+
+    // The audio threads pass MSG_DONTWAIT where they must not block
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+    sco_socket = fd;
+    sco_connect_finish();
+}
+
+// The controller sets the link up while the reactor goes on with the AT links
+static void sco_connect_begin(void) {
     // Create SCO socket
-    sco_socket = socket(AF_BLUETOOTH, SOCK_SEQPACKET, BTPROTO_SCO);
-    if (sco_socket < 0) {
+    int fd = socket(AF_BLUETOOTH, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, BTPROTO_SCO);
+    if (fd < 0) {
         log_msg("⚠️ SCO socket error");
-        return FALSE;
+        g_atomic_int_set(&sco_answer_pending, 0);
+        return;
     }
     
-    // SCO voice quality settings (for mSBC)
-    struct bt_voice voice = { .setting = BT_VOICE_CVSD_16BIT };  // or BT_VOICE_TRANSPARENT
-    if (setsockopt(sco_socket, SOL_BLUETOOTH, BT_VOICE, &voice, sizeof(voice)) < 0) {
+    // Codec of this link: mSBC needs transparent SCO and 16kHz audio
+    sco_codec = (hfp_codec == HFP_CODEC_MSBC && msbc_supported()) ? HFP_CODEC_MSBC : HFP_CODEC_CVSD;
+    
+    // SCO voice setting: CVSD (air coding in controller) or transparent (mSBC)
+    struct bt_voice voice = {
+        .setting = sco_codec == HFP_CODEC_MSBC ? BT_VOICE_TRANSPARENT : BT_VOICE_CVSD_16BIT
+    };
+    if (setsockopt(fd, SOL_BLUETOOTH, BT_VOICE, &voice, sizeof(voice)) < 0) {
         // Continue even if error - not supported on some systems
         char msg[128];
         snprintf(msg, sizeof(msg), "ℹ️ SCO voice setting: %s", strerror(errno));
         log_msg(msg);
+        if (sco_codec == HFP_CODEC_MSBC) {
+            log_msg("⚠️ Transparent SCO not supported, falling back to CVSD");
+            sco_codec = HFP_CODEC_CVSD;
+            voice.setting = BT_VOICE_CVSD_16BIT;
+            setsockopt(fd, SOL_BLUETOOTH, BT_VOICE, &voice, sizeof(voice));
+        }
     }
     
     // Connection address
@@ -2711,301 +2875,151 @@ static gboolean sco_connect(void) {
     str2ba(device_addr, &addr.sco_bdaddr);
     
     // Connect
-    log_msg("🔊 SCO audio connecting...");
-    if (connect(sco_socket, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+    if (!sco_connect_retried) log_msg("🔊 SCO audio connecting...");
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+        sco_on_connected(fd, EPOLLOUT, NULL);
+    } else if (errno == EINPROGRESS) {
+        sco_pending_socket = fd;
+        io_reactor_add(hfp_reactor, fd, EPOLLOUT, sco_on_connected, NULL);
+    } else {
         int err = errno;
-        char msg[128];
-        snprintf(msg, sizeof(msg), "⚠️ SCO connection error: %s", strerror(err));
-        log_msg(msg);
-        close(sco_socket);
-        sco_socket = -1;
-        
-        // EMLINK (Too many links) or EBUSY error - existing SCO
-        if (err == EMLINK || err == EBUSY) {
-            log_msg("ℹ️ Clearing existing SCO connection...");
-            // Reload PulseAudio Bluetooth module
-            system("pactl unload-module module-bluez5-device 2>/dev/null");
-            usleep(200000);  // 200ms wait
-            
-            // Try again
-            sco_socket = socket(AF_BLUETOOTH, SOCK_SEQPACKET, BTPROTO_SCO);
-            if (sco_socket >= 0) {
-                setsockopt(sco_socket, SOL_BLUETOOTH, BT_VOICE, &voice, sizeof(voice));
-                if (connect(sco_socket, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
-                    log_msg("✓ SCO audio connected (retry)");
-                    goto sco_connected;
-                }
-                close(sco_socket);
-                sco_socket = -1;
-            }
-        }
-        return FALSE;
+        close(fd);
+        sco_connect_failed(err);
     }
-    
-sco_connected:
-    log_msg("✓ SCO audio connected");
+}
 
-    // Read SCO MTU dynamically
-    struct sco_options sco_opts;
-    socklen_t optlen = sizeof(sco_opts);
-    if (getsockopt(sco_socket, SOL_SCO, SCO_OPTIONS, &sco_opts, &optlen) == 0) {
-        sco_mtu = sco_opts.mtu;
-        char msg[64];
-        snprintf(msg, sizeof(msg), "ℹ️ SCO MTU: %d byte", sco_mtu);
-        log_msg(msg);
-    } else {
-        sco_mtu = 48;  // Default
-        log_msg("ℹ️ SCO MTU not readable, default: 48");
+// Reactor thread
+static void sco_connect_cancel(void) {
+    sco_connect_deferred = FALSE;
+    if (sco_pending_socket < 0 && !sco_retry_pending) return;
+    if (sco_pending_socket >= 0) {
+        io_reactor_remove(hfp_reactor, sco_pending_socket);
+        close(sco_pending_socket);
+        sco_pending_socket = -1;
+    }
+    sco_retry_pending = FALSE;
+    g_atomic_int_set(&sco_answer_pending, 0);
+}
+
+static void sco_connect_task(void *data) {
+    gboolean replace = GPOINTER_TO_INT(data);
+    if (!device_addr[0]) {
+        g_atomic_int_set(&sco_answer_pending, 0);
+        return;
     }
+    if (sco_pending_socket >= 0 || sco_retry_pending) return;  // Already connecting
 
-    init_webrtc_aec();
-    
-    // Start playback thread (phone -> PC speaker)
-    sco_audio_running = TRUE;
-    if (pthread_create(&sco_playback_thread, NULL, sco_playback_thread_func, NULL) != 0) {
-        log_msg("⚠️ Speaker thread error");
+    if (sco_audio_running() || sco_socket >= 0) {
+        if (!replace) return;
+        // Previous link: its threads are joined before the socket closes
+        log_msg("ℹ️ Closing previous SCO...");
+        stop_sco_audio(NULL);
     }
-    
-    // Start capture thread (PC microphone -> phone)
-    if (pthread_create(&sco_capture_thread, NULL, sco_capture_thread_func, NULL) != 0) {
-        log_msg("⚠️ Microphone thread error");
+    if (sco_teardown_pending) {
+        sco_connect_deferred = TRUE;  // sco_teardown_done_task() connects
+        return;
     }
-    
-    return TRUE;
+    sco_connect_retried = FALSE;
+    sco_connect_begin();
 }
 
-// Hang up call via HFP
-static void hfp_hangup(void) {
-    hfp_monitor_running = FALSE;  // Stop monitor first
-    
-    if (hfp_socket >= 0) {
-        // Send AT+CHUP
-        char cmd[] = "AT+CHUP\r";
-        if (write(hfp_socket, cmd, strlen(cmd)) > 0) {
-            usleep(200000);
-            char buf[256] = {0};
-            read(hfp_socket, buf, sizeof(buf) - 1);
-        }
-        log_msg("📱 Call terminated");
+// Establish SCO audio connection on the reactor thread, which also puts
+// the callsetup events, the ATD result and the answer button in one order.
+// replace: close a link that is already up (codec change, answer)
+static void sco_connect_async(gboolean replace) {
+    if (io_reactor_post(hfp_reactor, sco_connect_task, GINT_TO_POINTER(replace)) < 0) {
+        log_msg("⚠️ SCO connect could not be queued");
+        g_atomic_int_set(&sco_answer_pending, 0);
     }
-    
-    hfp_close();
-    set_call_state(CALL_IDLE);
-    current_call_number[0] = '\0';
-    current_call_name[0] = '\0';
 }
 
-// Dial number - copy number to clipboard and show notification
-// Start call via HFP (RFCOMM)
-static gboolean hfp_dial(const char *number) {
-    if (!device_addr[0]) {
-        log_msg("⚠️ No phone address");
-        return FALSE;
-    }
+// ATD result, handed from the reactor to the main loop
+typedef struct {
+    char number[64];
+    guint generation;  // dial_generation when dialed
+    AtResult result;
+} HfpDialResult;
+
+static guint dial_generation = 0;  // Bumped on hangup / reject: a late ATD result is ignored
+
+// HFP failed: copy number to clipboard
+static void dial_failed(const char *number) {
+    char msg[256];
+    GtkClipboard *clipboard = gtk_clipboard_get(GDK_SELECTION_CLIPBOARD);
+    gtk_clipboard_set_text(clipboard, number, -1);
+    
+    snprintf(msg, sizeof(msg), "📋 %s copied to clipboard", number);
+    log_msg(msg);
     
-    // Use existing listener socket if available
-    if (hfp_listen_socket >= 0) {
-        log_msg("📱 Using existing HFP connection...");
+    GtkWidget *dialog = gtk_message_dialog_new(
+        GTK_WINDOW(window),
+        GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
+        GTK_MESSAGE_WARNING,
+        GTK_BUTTONS_OK,
+        "📞 %s", number);
+    gtk_message_dialog_format_secondary_text(
+        GTK_MESSAGE_DIALOG(dialog),
+        "HFP connection failed.\nNumber copied to clipboard.");
+    gtk_window_set_title(GTK_WINDOW(dialog), "Call");
+    gtk_dialog_run(GTK_DIALOG(dialog));
+    gtk_widget_destroy(dialog);
+}
 
-        hfp_listen_paused = TRUE;
-        usleep(150000);
-        
-        // Start call
-        char cmd[128];
-        char buf[512];
-        
-        snprintf(cmd, sizeof(cmd), "ATD%s;\r", number);
-        if (write(hfp_listen_socket, cmd, strlen(cmd)) <= 0) {
-            log_msg("⚠️ Call command could not be sent");
-            hfp_listen_paused = FALSE;
-            return FALSE;
-        }
-        
-        usleep(500000);  // 500ms wait
-        memset(buf, 0, sizeof(buf));
-        int n = read(hfp_listen_socket, buf, sizeof(buf) - 1);
-        
-        // Debug log
-        char debug_msg[600];
-        snprintf(debug_msg, sizeof(debug_msg), "📥 HFP response (%d byte): [%s]", n, buf);
-        log_msg(debug_msg);
-        
-        // OK, +CIEV (call setup indicator), or CONNECT = success
-        if (strstr(buf, "OK") || strstr(buf, "+CIEV") || strstr(buf, "CONNECT")) {
-            char msg[128];
-            snprintf(msg, sizeof(msg), "✓ Call started: %s", number);
+static gboolean dial_result_cb(gpointer data) {
+    HfpDialResult *dial = data;
+    AtResult res = dial->result;
+    char msg[256];
+
+    if (dial->generation != dial_generation) {
+        // Hung up while the phone was still answering the ATD
+    } else if (res == AT_RESULT_OK || res == AT_RESULT_TIMEOUT) {
+        if (res == AT_RESULT_OK) {
+            snprintf(msg, sizeof(msg), "✓ Call started: %s", dial->number);
             log_msg(msg);
-            
-            // Establish SCO connection
-            sco_connect();
-            
-            set_call_state(CALL_OUTGOING);
-            hfp_listen_paused = FALSE;
-            return TRUE;
-        } else if (strstr(buf, "ERROR") || strstr(buf, "NO CARRIER")) {
-            log_msg("⚠️ Phone rejected call");
-            hfp_listen_paused = FALSE;
-            return FALSE;
         } else {
-            log_msg("⚠️ Unknown response, trying anyway...");
-            // Try even with unknown response
-            sco_connect();
-            set_call_state(CALL_OUTGOING);
-            hfp_listen_paused = FALSE;
-            return TRUE;
+            log_msg("⚠️ No response to ATD, trying anyway...");
         }
-    }
-    
-    // If no listener, establish new connection
-    hfp_close();
-    
-    // Create RFCOMM socket
-    hfp_socket = socket(AF_BLUETOOTH, SOCK_STREAM, BTPROTO_RFCOMM);
-    if (hfp_socket < 0) {
-        log_msg("⚠️ RFCOMM socket error");
-        return FALSE;
-    }
-    
-    // Connection address
-    struct sockaddr_rc addr = {0};
-    addr.rc_family = AF_BLUETOOTH;
-    addr.rc_channel = hfp_channel ? hfp_channel : 3;  // Dynamic or default
-    str2ba(device_addr, &addr.rc_bdaddr);
-    
-    // Connect
-    log_msg("📱 Establishing HFP connection...");
-    if (connect(hfp_socket, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
-        char err_msg[128];
-        snprintf(err_msg, sizeof(err_msg), "⚠️ HFP connection failed (errno=%d: %s)", errno, strerror(errno));
-        log_msg(err_msg);
-        close(hfp_socket);
-        hfp_socket = -1;
-        return FALSE;
-    }
-    
-    log_msg("✓ HFP connection established");
-    
-    char cmd[128];
-    char buf[512];
-    int n;
-    
-    // HFP SLC (Service Level Connection) Handshake
-    // 1. AT+BRSF - Feature exchange
-    snprintf(cmd, sizeof(cmd), "AT+BRSF=0\r");
-    if (write(hfp_socket, cmd, strlen(cmd)) < 0) goto error;
-    usleep(100000);
-    memset(buf, 0, sizeof(buf));
-    n = read(hfp_socket, buf, sizeof(buf) - 1);
-    if (n <= 0 || !strstr(buf, "OK")) {
-        log_msg("⚠️ AT+BRSF error");
-        goto error;
-    }
-    
-    // 2. AT+CIND=? - Ask indicator support
-    snprintf(cmd, sizeof(cmd), "AT+CIND=?\r");
-    if (write(hfp_socket, cmd, strlen(cmd)) < 0) goto error;
-    usleep(100000);
-    memset(buf, 0, sizeof(buf));
-    n = read(hfp_socket, buf, sizeof(buf) - 1);
-    if (n <= 0 || !strstr(buf, "OK")) {
-        log_msg("⚠️ AT+CIND=? error");
-        goto error;
-    }
-    
-    // 3. AT+CIND? - Get indicator status
-    snprintf(cmd, sizeof(cmd), "AT+CIND?\r");
-    if (write(hfp_socket, cmd, strlen(cmd)) < 0) goto error;
-    usleep(100000);
-    memset(buf, 0, sizeof(buf));
-    n = read(hfp_socket, buf, sizeof(buf) - 1);
-    if (n <= 0 || !strstr(buf, "OK")) {
-        log_msg("⚠️ AT+CIND? error");
-        goto error;
-    }
-    
-    // 4. AT+CMER - Enable event reporting
-    snprintf(cmd, sizeof(cmd), "AT+CMER=3,0,0,1\r");
-    if (write(hfp_socket, cmd, strlen(cmd)) < 0) goto error;
-    usleep(100000);
-    memset(buf, 0, sizeof(buf));
-    n = read(hfp_socket, buf, sizeof(buf) - 1);
-    if (n <= 0 || !strstr(buf, "OK")) {
-        snprintf(cmd, sizeof(cmd), "AT+CMER=3,0,0,0\r");
-        if (write(hfp_socket, cmd, strlen(cmd)) < 0) goto error;
-        usleep(100000);
-        memset(buf, 0, sizeof(buf));
-        read(hfp_socket, buf, sizeof(buf) - 1);
-    }
-    
-    log_msg("✓ HFP SLC established");
-    
-    // 5. AT+NREC=0 - Disable noise reduction (optional)
-    snprintf(cmd, sizeof(cmd), "AT+NREC=0\r");
-    write(hfp_socket, cmd, strlen(cmd));
-    usleep(100000);
-    memset(buf, 0, sizeof(buf));
-    read(hfp_socket, buf, sizeof(buf) - 1);
-    
-    // 6. Start call with ATD
-    snprintf(cmd, sizeof(cmd), "ATD%s;\r", number);
-    if (write(hfp_socket, cmd, strlen(cmd)) < 0) goto error;
-    
-    // Wait for response
-    usleep(1000000);
-    memset(buf, 0, sizeof(buf));
-    n = read(hfp_socket, buf, sizeof(buf) - 1);
-    
-    if (n > 0 && strstr(buf, "OK")) {
-        char msg[256];
-        snprintf(msg, sizeof(msg), "✓ Call started: %s", number);
-        log_msg(msg);
         
-        // 7. Establish SCO audio connection - audio to PC
-        sco_connect();
+        // Establish SCO connection (unless callsetup already did)
+        sco_connect_async(FALSE);
         
-        // 8. Connect HFP audio profile via BlueZ (backup)
-        if (device_path[0] && dbus_conn) {
-            GError *error = NULL;
-            // HFP Handsfree UUID
-            g_dbus_connection_call_sync(
-                dbus_conn, "org.bluez", device_path,
-                "org.bluez.Device1", "ConnectProfile",
-                g_variant_new("(s)", "0000111e-0000-1000-8000-00805f9b34fb"),
-                NULL, G_DBUS_CALL_FLAGS_NONE, 5000, NULL, &error);
-            if (error) {
-                g_error_free(error);
-                // Alternative: Try HSP UUID
-                g_dbus_connection_call_sync(
-                    dbus_conn, "org.bluez", device_path,
-                    "org.bluez.Device1", "ConnectProfile",
-                    g_variant_new("(s)", "0000111f-0000-1000-8000-00805f9b34fb"),
-                    NULL, G_DBUS_CALL_FLAGS_NONE, 5000, NULL, NULL);
+        strncpy(current_call_number, dial->number, sizeof(current_call_number) - 1);
+        current_call_name[0] = '\0';  // Name can be found from contacts
+        
+        // Find name from contacts
+        for (int i = 0; i < all_contacts_count; i++) {
+            if (strcmp(all_contacts[i].number, dial->number) == 0) {
+                strncpy(current_call_name, all_contacts[i].name, sizeof(current_call_name) - 1);
+                break;
             }
         }
         
-        // Start monitor thread - keeps socket open
-        hfp_monitor_running = TRUE;
-        hfp_monitor_thread_handle = g_thread_new("hfp_monitor", hfp_monitor_thread, NULL);
-        
-        return TRUE;
+        if (current_call_state != CALL_ACTIVE) set_call_state(CALL_OUTGOING);
+        update_ui();
     } else {
-        char msg[256];
-        if (n > 0 && strstr(buf, "ERROR")) {
-            snprintf(msg, sizeof(msg), "⚠️ Phone rejected call");
-        } else if (n > 0 && strstr(buf, "NO CARRIER")) {
+        if (res == AT_RESULT_ERROR || res == AT_RESULT_CME_ERROR) {
+            snprintf(msg, sizeof(msg), "⚠️ Phone rejected call (%s)", at_result_name(res));
+        } else if (res == AT_RESULT_NO_CARRIER || res == AT_RESULT_CLOSED) {
             snprintf(msg, sizeof(msg), "⚠️ Connection lost");
         } else {
-            snprintf(msg, sizeof(msg), "⚠️ Call response: %s", n > 0 ? buf : "(empty)");
+            snprintf(msg, sizeof(msg), "⚠️ Call response: %s", at_result_name(res));
         }
         log_msg(msg);
-        goto error;
+        dial_failed(dial->number);
     }
     
-error:
-    hfp_close();
-    return FALSE;
+    g_free(dial);
+    return G_SOURCE_REMOVE;
 }
 
+// Reactor thread
+static void dial_on_result(const AtResponse *response, void *user_data) {
+    HfpDialResult *dial = user_data;
+    dial->result = response->result;
+    g_idle_add(dial_result_cb, dial);
+}
+
+// Start call via HFP: ATD on the link, which is connected first if needed
 static void dial_number(const char *number) {
     if (!number || !*number) {
         log_msg("⚠️ Number empty");
@@ -3020,42 +3034,16 @@ static void dial_number(const char *number) {
     snprintf(msg, sizeof(msg), "📞 Calling: %s", number);
     log_msg(msg);
     
-    // Try HFP call
-    if (hfp_dial(number)) {
-        // Success - update call state
-        strncpy(current_call_number, number, sizeof(current_call_number) - 1);
-        current_call_name[0] = '\0';  // Name can be found from contacts
-        
-        // Find name from contacts
-        for (int i = 0; i < all_contacts_count; i++) {
-            if (strcmp(all_contacts[i].number, number) == 0) {
-                strncpy(current_call_name, all_contacts[i].name, sizeof(current_call_name) - 1);
-                break;
-            }
-        }
-        
-        set_call_state(CALL_OUTGOING);
-        update_ui();
-    } else {
-        // HFP failed, copy to clipboard
-        GtkClipboard *clipboard = gtk_clipboard_get(GDK_SELECTION_CLIPBOARD);
-        gtk_clipboard_set_text(clipboard, number, -1);
-        
-        snprintf(msg, sizeof(msg), "📋 %s copied to clipboard", number);
-        log_msg(msg);
-        
-        GtkWidget *dialog = gtk_message_dialog_new(
-            GTK_WINDOW(window),
-            GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
-            GTK_MESSAGE_WARNING,
-            GTK_BUTTONS_OK,
-            "📞 %s", number);
-        gtk_message_dialog_format_secondary_text(
-            GTK_MESSAGE_DIALOG(dialog),
-            "HFP connection failed.\nNumber copied to clipboard.");
-        gtk_window_set_title(GTK_WINDOW(dialog), "Call");
-        gtk_dialog_run(GTK_DIALOG(dialog));
-        gtk_widget_destroy(dialog);
+    // A link still coming up holds the ATD until its SLC is done
+    start_hfp_link();
+    HfpDialResult *dial = g_new0(HfpDialResult, 1);
+    snprintf(dial->number, sizeof(dial->number), "%s", number);
+    dial->generation = dial_generation;
+    if (!hfp_link_dial(hfp_link, number, dial_on_result, dial)) {
+        log_msg(hfp_link_state(hfp_link) == HFP_LINK_DOWN ? "⚠️ No HFP connection"
+                                                          : "⚠️ Another call is being dialed");
+        g_free(dial);
+        dial_failed(number);
     }
 }
 
@@ -3294,16 +3282,26 @@ static void set_state(AppState new_state) {
     
     // Start background data loading when CONNECTED
     if (new_state == STATE_CONNECTED && old_state != STATE_CONNECTED) {
-        // Find HFP channel via SDP (if not found yet)
+        hfp_connect_us = g_get_monotonic_time();
+        hfp_sdp_ms = -1;
+
+        // HFP channel: from the device cache, else via SDP (if not found yet)
         if (hfp_channel == 0 && device_addr[0]) {
-            uint8_t ch = find_hfp_channel(device_addr);
-            if (ch) {
-                hfp_channel = ch;
+            HfpDevice *dev = hfp_device_find(device_addr);
+            if (dev) {
+                hfp_channel = dev->channel;
+                hfp_channel_cached = TRUE;
+            } else {
+                uint8_t ch = find_hfp_channel(device_addr);
+                hfp_sdp_ms = (g_get_monotonic_time() - hfp_connect_us) / 1000.0;
+                if (ch) {
+                    hfp_channel = ch;
+                }
             }
         }
         
-        // Start incoming call listener
-        start_incoming_call_listener();
+        // HFP link: incoming calls and events, dialing
+        start_hfp_link();
         
         // Load phonebook in background (if not loaded yet)
         // Recent calls will start automatically after phonebook is loaded
@@ -3732,33 +3730,84 @@ static gboolean parse_ciev(const char *buf, int *indicator, int *value) {
     return TRUE;
 }
 
-static void stop_sco_audio(const char *reason) {
-    gboolean was_running = sco_audio_running || (sco_socket >= 0);
+// A link whose audio threads are being joined
+typedef struct {
+    int socket;
+    char *reason;  // Logged once closed, NULL for none
+} ScoTeardown;
 
-    // Close flag first so threads exit loop
-    sco_audio_running = FALSE;
-    
-    // Short wait for threads to exit loop
-    usleep(50000);  // 50ms
-    
-    // Close socket
+// Reactor thread: the threads are gone, the socket can close
+static void sco_teardown_done_task(void *data) {
+    ScoTeardown *t = data;
+    if (t->socket >= 0) {
+        close(t->socket);
+    }
+    if (t->reason) {
+        g_idle_add((GSourceFunc)lambda_log, t->reason);
+    }
+    g_free(t);
+
+    sco_teardown_pending = FALSE;
+    if (sco_connect_deferred && device_addr[0]) {
+        sco_connect_deferred = FALSE;
+        sco_connect_retried = FALSE;
+        sco_connect_begin();
+    }
+}
+
+// The microphone thread leaves after its current device read, up to
+// SCO_AUDIO_JOIN_TIMEOUT_MS: joined here, not on the reactor or the UI.
+// A thread stuck longer still holds the socket: keep waiting, the link stays
+// open and no new one connects until both are gone
+static gpointer sco_teardown_thread(gpointer data) {
+    ScoTeardown *t = data;
+    if (sco_audio_join(SCO_AUDIO_JOIN_TIMEOUT_MS) < 0) {
+        g_idle_add((GSourceFunc)lambda_log, g_strdup("⚠️ Audio threads did not stop in time, still waiting"));
+        while (sco_audio_join(SCO_AUDIO_JOIN_TIMEOUT_MS) < 0) {
+            // Waits on the thread condition, not a busy loop
+        }
+        g_idle_add((GSourceFunc)lambda_log, g_strdup("ℹ️ Audio threads stopped"));
+    }
+    sco_audio_shutdown();
+    if (io_reactor_post(hfp_reactor, sco_teardown_done_task, t) < 0) {
+        sco_teardown_done_task(t);
+    }
+    return NULL;
+}
+
+static void sco_stop_task(void *data) {
+    const char *reason = data;
+    sco_connect_cancel();
+    gboolean was_running = sco_audio_running() || (sco_socket >= 0);
+
+    // Wake the threads; shutdown() ends any socket call still in progress
+    sco_audio_stop();
     if (sco_socket >= 0) {
         shutdown(sco_socket, SHUT_RDWR);
-        close(sco_socket);
-        sco_socket = -1;
-    }
-    
-    // Wait for threads to fully exit (max 500ms)
-    for (int i = 0; i < 10 && (pulse_playback || pulse_capture); i++) {
-        usleep(50000);  // 50ms
     }
+    if (sco_teardown_pending) return;  // The worker releases the engine
 
-    if (reason && was_running) {
-        // Thread-safe log (can be called from background thread)
-        g_idle_add((GSourceFunc)lambda_log, g_strdup(reason));
+    if (!was_running && !sco_audio_active()) {
+        // No threads: only the warm streams, if any
+        sco_audio_shutdown();
+        return;
     }
 
-    shutdown_webrtc_aec();
+    // The socket is closed only after the join so its descriptor cannot be
+    // reused under the threads; until then no new link is connected
+    ScoTeardown *t = g_new0(ScoTeardown, 1);
+    t->socket = sco_socket;
+    t->reason = (reason && was_running) ? g_strdup(reason) : NULL;
+    sco_socket = -1;
+    sco_teardown_pending = TRUE;
+    g_thread_unref(g_thread_new("sco_teardown", sco_teardown_thread, t));
+}
+
+// Any thread, returns at once; runs on the reactor, which owns the SCO sockets
+static void stop_sco_audio(const char *reason) {
+    if (io_reactor_call(hfp_reactor, sco_stop_task, (void *)reason) < 0) {
+        sco_stop_task((void *)reason);
+    }
 }
 
 static void clear_device_info(void) {
@@ -3767,6 +3816,7 @@ static void clear_device_info(void) {
     device_name[0] = '\0';
     device_paired = FALSE;
     hfp_channel = 0;  // Reset HFP channel
+    hfp_channel_cached = FALSE;
 }
 
 static void cleanup_connection(const char *reason, gboolean clear_device) {
@@ -3774,8 +3824,7 @@ static void cleanup_connection(const char *reason, gboolean clear_device) {
         log_msg(reason);
     }
 
-    stop_incoming_call_listener();
-    hfp_close();
+    stop_hfp_link();
     stop_sco_audio(NULL);
     clear_call_info();
     set_call_state(CALL_IDLE);
@@ -3813,17 +3862,18 @@ static void on_answer_clicked(GtkWidget *widget, gpointer data) {
     gtk_widget_set_sensitive(answer_btn, FALSE);
     gtk_widget_set_sensitive(reject_btn, FALSE);
 
-    if (hfp_listen_socket >= 0) {
-        char cmd[] = "ATA\r";
-        if (write(hfp_listen_socket, cmd, strlen(cmd)) > 0) {
-            usleep(200000);
-            char buf[256] = {0};
-            read(hfp_listen_socket, buf, sizeof(buf) - 1);
-        }
+    // Timed until the first phone audio is played
+    answer_started_us = g_get_monotonic_time();
+
+    // The reactor reads the OK, nothing to wait for here
+    if (hfp_link_answer(hfp_link, NULL, NULL)) {
+        log_msg("📱 ATA sent");
     }
 
-    // Establish SCO connection
-    sco_connect();
+    // SCO in parallel with ATA (non-blocking connect on the reactor); the
+    // threads take over the warm devices
+    g_atomic_int_set(&sco_answer_pending, 1);
+    sco_connect_async(TRUE);
 
     set_call_state(CALL_ACTIVE);
     update_ui();
@@ -3840,44 +3890,23 @@ static void on_reject_clicked(GtkWidget *widget, gpointer data) {
     gtk_widget_set_sensitive(reject_btn, FALSE);
     gtk_widget_set_sensitive(hangup_btn, FALSE);
     
+    dial_generation++;
+    
     // Incoming call
-    if (current_call_state == CALL_RINGING && hfp_listen_socket >= 0) {
-        char cmd[] = "AT+CHUP\r";
-        if (write(hfp_listen_socket, cmd, strlen(cmd)) > 0) {
-            usleep(200000);
-            char buf[256] = {0};
-            read(hfp_listen_socket, buf, sizeof(buf) - 1);
-        }
-        set_call_state(CALL_IDLE);
-        clear_call_info();
+    if (current_call_state == CALL_RINGING) {
+        hfp_link_hangup(hfp_link, NULL, NULL);
     }
-    // Outgoing call - if done via listen socket
-    else if (current_call_state == CALL_OUTGOING && hfp_listen_socket >= 0) {
+    // Outgoing call
+    else {
         log_msg("📱 Canceling outgoing call...");
-        char cmd[] = "AT+CHUP\r";
-        if (write(hfp_listen_socket, cmd, strlen(cmd)) > 0) {
-            usleep(200000);
-            char buf[256] = {0};
-            read(hfp_listen_socket, buf, sizeof(buf) - 1);
+        if (hfp_link_hangup(hfp_link, NULL, NULL)) {
             log_msg("📱 AT+CHUP sent");
         }
         // Close SCO
-        sco_audio_running = FALSE;
-        if (sco_socket >= 0) {
-            shutdown(sco_socket, SHUT_RDWR);
-            close(sco_socket);
-            sco_socket = -1;
-        }
-        set_call_state(CALL_IDLE);
-        clear_call_info();
-    }
-    // Outgoing call - via hfp_socket
-    else if (current_call_state == CALL_OUTGOING && hfp_socket >= 0) {
-        hfp_hangup();
-    } else {
-        set_call_state(CALL_IDLE);
-        clear_call_info();
+        stop_sco_audio(NULL);
     }
+    set_call_state(CALL_IDLE);
+    clear_call_info();
 }
 
 static void on_hangup_clicked(GtkWidget *widget, gpointer data) {
@@ -3892,24 +3921,16 @@ static void on_hangup_clicked(GtkWidget *widget, gpointer data) {
     gtk_widget_set_sensitive(reject_btn, FALSE);
     gtk_widget_set_sensitive(hangup_btn, FALSE);
 
-    // Close SCO in background (to avoid UI freeze)
-    sco_audio_running = FALSE;
+    // Wake the audio threads before hanging up
+    sco_audio_stop();
     
-    // Incoming call (via listen socket)
-    if (hfp_listen_socket >= 0) {
-        char cmd[] = "AT+CHUP\r";
-        write(hfp_listen_socket, cmd, strlen(cmd));
-        log_msg("📱 AT+CHUP sent (listen)");
-    }
-    // Outgoing call (via hfp_socket)
-    else if (hfp_socket >= 0) {
-        char cmd[] = "AT+CHUP\r";
-        write(hfp_socket, cmd, strlen(cmd));
+    dial_generation++;
+    if (hfp_link_hangup(hfp_link, NULL, NULL)) {
         log_msg("📱 AT+CHUP sent");
     }
     
-    // Do SCO cleanup in background
-    g_thread_new("hangup_cleanup", (GThreadFunc)stop_sco_audio, "🔊 SCO closed");
+    // The threads are joined on a worker, nothing here waits for them
+    stop_sco_audio("🔊 SCO closed");
     
     set_call_state(CALL_IDLE);
     clear_call_info();
@@ -4451,6 +4472,19 @@ static void create_ui(void) {
     g_signal_connect(autostart_check, "toggled", G_CALLBACK(on_autostart_toggled), NULL);
     gtk_box_pack_start(GTK_BOX(call_btn_box), autostart_check, TRUE, TRUE, 0);
 
+    // Audio processing profile (AEC/NS/AGC/HPF)
+    GtkWidget *apm_combo = gtk_combo_box_text_new();
+    for (const char *const *name = apm_profile_names(); *name; name++) {
+        gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(apm_combo), *name, *name);
+    }
+    if (strcmp(apm_profile.name, "custom") == 0) {
+        gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(apm_combo), "custom", "custom");
+    }
+    gtk_combo_box_set_active_id(GTK_COMBO_BOX(apm_combo), apm_profile.name);
+    gtk_widget_set_tooltip_text(apm_combo, "🎚️ Audio processing (echo, noise, gain)");
+    g_signal_connect(apm_combo, "changed", G_CALLBACK(on_apm_profile_changed), NULL);
+    gtk_box_pack_start(GTK_BOX(call_btn_box), apm_combo, TRUE, TRUE, 0);
+
     // ========== TAB STRUCTURE ==========
     GtkWidget *notebook = gtk_notebook_new();
     gtk_notebook_set_tab_pos(GTK_NOTEBOOK(notebook), GTK_POS_TOP);
@@ -4672,7 +4706,7 @@ static void on_app_activate(GtkApplication *application, gpointer user_data) {
             pending_uri_arg[0] = '\0';
             
             // Eğer bağlıysa hemen ara
-            if (current_state == STATE_CONNECTED && hfp_socket >= 0) {
+            if (current_state == STATE_CONNECTED) {
                 dial_number(pending_dial_number);
                 pending_dial_number[0] = '\0';
             }
@@ -4681,6 +4715,7 @@ static void on_app_activate(GtkApplication *application, gpointer user_data) {
     }
     
     // İlk açılış - UI oluştur
+    hfp_at_init();
     load_settings();
     apply_css();
     create_ui();
@@ -4706,6 +4741,7 @@ static void on_app_activate(GtkApplication *application, gpointer user_data) {
         snprintf(msg, sizeof(msg), "📂 Loaded %d call records from CSV", recent_count);
         log_msg(msg);
     }
+    load_hfp_devices_from_csv();
     
     refresh_contacts_view();
     refresh_recents_view();
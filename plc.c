@@ -0,0 +1,228 @@
+#include "plc.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PLC_TEMPLATE_MS 4.0          // Pattern matched against the history
+#define PLC_OLA_MS 1.0               // Cross-fade at splices
+#define PLC_PITCH_MIN_MS 5.0         // Lag search 5-15 ms: 66-200 Hz, or two periods of
+#define PLC_PITCH_MAX_MS 15.0        // higher voices
+#define PLC_HOLD_MS 10.0             // Full level this long into a gap
+#define PLC_MUTE_MS 60.0             // Silent from here on
+#define PLC_MAX_SCALE 1.2f           // Energy match may not boost more
+
+struct Plc {
+    int sample_rate;
+    int frame;
+    int tmpl;                        // Template length
+    int ola;
+    int lag_min;
+    int lag_max;
+    int hold;
+    int mute;
+
+    int16_t *hist;                   // Newest sample last
+    int hist_len;
+    int hist_fill;
+    float *tail;                     // Extrapolation past the last concealed sample
+    float *fade;                     // Raised cosine 0 -> 1, ola samples
+    int seen_good;
+    int burst;                       // Samples concealed in the current run
+
+    PlcStats stats;
+};
+
+static int ms_samples(int rate, double ms) {
+    int n = (int)(ms * rate / 1000.0);
+    return n > 1 ? n : 1;
+}
+
+static int16_t clamp16(float v) {
+    if (v > 32767.0f) return 32767;
+    if (v < -32768.0f) return -32768;
+    return (int16_t)lrintf(v);
+}
+
+static void hist_push(Plc *plc, const int16_t *pcm, int samples) {
+    const int len = plc->hist_len;
+    if (samples >= len) {
+        memcpy(plc->hist, pcm + samples - len, len * sizeof(int16_t));
+    } else {
+        memmove(plc->hist, plc->hist + samples, (len - samples) * sizeof(int16_t));
+        memcpy(plc->hist + len - samples, pcm, samples * sizeof(int16_t));
+    }
+    plc->hist_fill = plc->hist_fill + samples < len ? plc->hist_fill + samples : len;
+}
+
+static float gain_at(const Plc *plc, int pos) {
+    if (pos < plc->hold) return 1.0f;
+    if (pos >= plc->mute) return 0.0f;
+    return 1.0f - (float)(pos - plc->hold) / (float)(plc->mute - plc->hold);
+}
+
+// Pitch lag: the last tmpl samples against the history lag_min..lag_max
+// earlier. Returns the lag, or 0 if the history is too short
+static int best_lag(const Plc *plc, float *scale) {
+    const int len = plc->hist_len;
+    const int16_t *t = plc->hist + len - plc->tmpl;
+    int max = plc->hist_fill - plc->tmpl;
+    if (max > plc->lag_max) max = plc->lag_max;
+    if (max < plc->lag_min) return 0;
+
+    float et = 0.0f;
+    for (int i = 0; i < plc->tmpl; i++) et += (float)t[i] * t[i];
+
+    int best = 0;
+    float best_score = 0.0f;
+    float best_energy = 0.0f;
+    for (int lag = plc->lag_min; lag <= max; lag++) {
+        const int16_t *h = t - lag;
+        float corr = 0.0f, eh = 0.0f;
+        for (int i = 0; i < plc->tmpl; i++) {
+            corr += (float)t[i] * h[i];
+            eh += (float)h[i] * h[i];
+        }
+        // Normalized correlation, sign kept so anti-phase never wins
+        float score = eh > 0.0f ? corr * fabsf(corr) / eh : 0.0f;
+        if (!best || score > best_score) {
+            best = lag;
+            best_score = score;
+            best_energy = eh;
+        }
+    }
+
+    *scale = best_energy > 1.0f ? sqrtf(et / best_energy) : 0.0f;
+    if (*scale > PLC_MAX_SCALE) *scale = PLC_MAX_SCALE;
+    return best;
+}
+
+// Sample i of the pitch-periodic continuation of the history
+static float extend(const Plc *plc, int lag, int i) {
+    return plc->hist[plc->hist_len - lag + i % lag];
+}
+
+// Conceal up to one frame
+static void conceal_chunk(Plc *plc, int16_t *out, int samples) {
+    if (plc->burst >= plc->mute) {
+        memset(out, 0, samples * sizeof(int16_t));
+        memset(plc->tail, 0, plc->ola * sizeof(float));
+        plc->stats.muted_samples += (uint64_t)samples;
+    } else {
+        float scale = 0.0f;
+        int lag = best_lag(plc, &scale);
+
+        for (int i = 0; i < samples; i++) {
+            float v = lag ? extend(plc, lag, i) * scale * gain_at(plc, plc->burst + i) : 0.0f;
+            // Splice onto the previous chunk's extrapolation
+            if (plc->burst > 0 && i < plc->ola) {
+                v = plc->tail[i] + (v - plc->tail[i]) * plc->fade[i];
+            }
+            out[i] = clamp16(v);
+            if (plc->burst + i >= plc->mute) plc->stats.muted_samples++;
+        }
+        for (int i = 0; i < plc->ola; i++) {
+            plc->tail[i] = lag ? extend(plc, lag, samples + i) * scale * gain_at(plc, plc->burst + samples + i) : 0.0f;
+        }
+    }
+
+    hist_push(plc, out, samples);
+    plc->burst += samples;
+}
+
+Plc* plc_create(int sample_rate, int frame_samples) {
+    if (sample_rate <= 0 || frame_samples <= 0) return NULL;
+
+    Plc *plc = calloc(1, sizeof(Plc));
+    if (!plc) return NULL;
+
+    plc->sample_rate = sample_rate;
+    plc->frame = frame_samples;
+    plc->tmpl = ms_samples(sample_rate, PLC_TEMPLATE_MS);
+    plc->ola = ms_samples(sample_rate, PLC_OLA_MS);
+    plc->lag_min = ms_samples(sample_rate, PLC_PITCH_MIN_MS);
+    plc->lag_max = ms_samples(sample_rate, PLC_PITCH_MAX_MS);
+    plc->hold = ms_samples(sample_rate, PLC_HOLD_MS);
+    plc->mute = ms_samples(sample_rate, PLC_MUTE_MS);
+    plc->hist_len = plc->tmpl + plc->lag_max;
+
+    plc->hist = calloc((size_t)plc->hist_len, sizeof(int16_t));
+    plc->tail = calloc((size_t)plc->ola, sizeof(float));
+    plc->fade = calloc((size_t)plc->ola, sizeof(float));
+    if (!plc->hist || !plc->tail || !plc->fade) {
+        plc_destroy(plc);
+        return NULL;
+    }
+    for (int i = 0; i < plc->ola; i++) {
+        plc->fade[i] = 0.5f - 0.5f * cosf((float)M_PI * (i + 1) / (plc->ola + 1));
+    }
+    return plc;
+}
+
+void plc_destroy(Plc* plc) {
+    if (!plc) return;
+    free(plc->hist);
+    free(plc->tail);
+    free(plc->fade);
+    free(plc);
+}
+
+void plc_reset(Plc* plc) {
+    if (!plc) return;
+    memset(plc->hist, 0, plc->hist_len * sizeof(int16_t));
+    memset(plc->tail, 0, plc->ola * sizeof(float));
+    plc->hist_fill = 0;
+    plc->seen_good = 0;
+    plc->burst = 0;
+    memset(&plc->stats, 0, sizeof(plc->stats));
+}
+
+void plc_good(Plc* plc, int16_t* pcm, int samples) {
+    if (!plc || !pcm || samples <= 0) return;
+
+    if (plc->burst > 0) {
+        int n = samples < plc->ola ? samples : plc->ola;
+        for (int i = 0; i < n; i++) {
+            pcm[i] = clamp16(plc->tail[i] + (pcm[i] - plc->tail[i]) * plc->fade[i]);
+        }
+        double ms = plc->burst * 1000.0 / plc->sample_rate;
+        if (ms > plc->stats.longest_burst_ms) plc->stats.longest_burst_ms = ms;
+        plc->burst = 0;
+    }
+
+    plc->seen_good = 1;
+    plc->stats.good_samples += (uint64_t)samples;
+    hist_push(plc, pcm, samples);
+}
+
+int plc_conceal(Plc* plc, int16_t* out, int samples) {
+    if (!plc || !out || samples <= 0) return 0;
+    if (!plc->seen_good) {
+        memset(out, 0, samples * sizeof(int16_t));
+        return 0;
+    }
+
+    if (plc->burst == 0) plc->stats.bursts++;
+    plc->stats.concealed_frames++;
+    plc->stats.concealed_samples += (uint64_t)samples;
+
+    while (samples > 0) {
+        int n = samples < plc->frame ? samples : plc->frame;
+        conceal_chunk(plc, out, n);
+        out += n;
+        samples -= n;
+    }
+    return 1;
+}
+
+void plc_get_stats(const Plc* plc, PlcStats* stats) {
+    if (!stats) return;
+    if (!plc) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+    *stats = plc->stats;
+    // A run still in progress counts too
+    double ms = plc->burst * 1000.0 / plc->sample_rate;
+    if (ms > stats->longest_burst_ms) stats->longest_burst_ms = ms;
+}
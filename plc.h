@@ -0,0 +1,52 @@
+#ifndef PLC_H
+#define PLC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+// Packet loss concealment by waveform similarity, in the style of the HFP
+// mSBC PLC: the last 4 ms of output are matched against the history, what
+// followed the best match is played (energy matched) in place of the
+// missing audio, and the first real samples after a gap are cross-faded
+// with the extrapolation. Long gaps fade out after 10 ms and are silent
+// from 60 ms on. Works on any chunk size, so the same code serves CVSD
+// packets (8 kHz, 3 ms), mSBC frames (16 kHz, 7.5 ms) and jitter buffer
+// underruns.
+
+typedef struct Plc Plc;
+
+typedef struct {
+    uint64_t good_samples;           // Real audio seen
+    uint64_t concealed_samples;
+    uint64_t concealed_frames;       // plc_conceal() calls after the first real audio
+    uint64_t bursts;                 // Runs of consecutive concealment
+    uint64_t muted_samples;          // Concealed past the fade-out (silence)
+    double longest_burst_ms;
+} PlcStats;
+
+// frame_samples: nominal packet / frame size, the largest chunk
+// extrapolated from one match
+Plc* plc_create(int sample_rate, int frame_samples);
+void plc_destroy(Plc* plc);
+
+// Forget history and counters (new call)
+void plc_reset(Plc* plc);
+
+// Real audio, in playout order. The start of pcm is cross-faded in place
+// when it ends a concealment run
+void plc_good(Plc* plc, int16_t* pcm, int samples);
+
+// Fill out with the extrapolation of the audio so far
+// Returns 0 (and silence) before any real audio was seen, 1 otherwise
+int plc_conceal(Plc* plc, int16_t* out, int samples);
+
+void plc_get_stats(const Plc* plc, PlcStats* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PLC_H
@@ -0,0 +1,166 @@
+#include "resampler.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define RS_USE_SSE2 1
+#endif
+
+#define RS_HISTORY 3          // Taps carried over between blocks
+#define RS_MAX_DEVIATION 0.01
+
+struct Resampler {
+    double ratio;             // Output / input
+    double step;              // Input samples advanced per output sample
+    double pos;               // Next output position in x[]
+    float *x;                 // RS_HISTORY samples of history + current block
+    size_t max_input;
+};
+
+Resampler* resampler_create(size_t max_input) {
+    if (max_input == 0) return NULL;
+
+    Resampler *rs = calloc(1, sizeof(Resampler));
+    if (!rs) return NULL;
+
+    rs->max_input = max_input;
+    rs->x = calloc(max_input + RS_HISTORY + 1, sizeof(float));
+    if (!rs->x) {
+        free(rs);
+        return NULL;
+    }
+    resampler_reset(rs);
+    return rs;
+}
+
+void resampler_destroy(Resampler* rs) {
+    if (!rs) return;
+    free(rs->x);
+    free(rs);
+}
+
+void resampler_reset(Resampler* rs) {
+    if (!rs) return;
+    memset(rs->x, 0, (rs->max_input + RS_HISTORY + 1) * sizeof(float));
+    rs->ratio = 1.0;
+    rs->step = 1.0;
+    rs->pos = RS_HISTORY - 1;  // One sample of look-behind, two of look-ahead
+}
+
+void resampler_set_ratio(Resampler* rs, double ratio) {
+    if (!rs) return;
+    if (ratio < 1.0 - RS_MAX_DEVIATION) ratio = 1.0 - RS_MAX_DEVIATION;
+    if (ratio > 1.0 + RS_MAX_DEVIATION) ratio = 1.0 + RS_MAX_DEVIATION;
+    rs->ratio = ratio;
+    rs->step = 1.0 / ratio;
+}
+
+double resampler_get_ratio(const Resampler* rs) {
+    return rs ? rs->ratio : 1.0;
+}
+
+size_t resampler_max_output(const Resampler* rs, size_t in_samples) {
+    double ratio = rs ? rs->ratio : 1.0 + RS_MAX_DEVIATION;
+    return (size_t)ceil(in_samples * ratio) + 2;
+}
+
+static void load_input(float *dst, const int16_t *in, size_t n) {
+    size_t i = 0;
+#ifdef RS_USE_SSE2
+    for (; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(in + i));
+        // Sign-extend via unpack into the high half and arithmetic shift
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(dst + i, _mm_cvtepi32_ps(lo));
+        _mm_storeu_ps(dst + i + 4, _mm_cvtepi32_ps(hi));
+    }
+#endif
+    for (; i < n; i++) {
+        dst[i] = in[i];
+    }
+}
+
+static inline int16_t clamp_s16(float v) {
+    if (v > 32767.0f) return 32767;
+    if (v < -32768.0f) return -32768;
+    return (int16_t)lrintf(v);
+}
+
+// Catmull-Rom through x[i-1..i+2] at fraction f
+static inline float interp_scalar(const float *x, size_t i, float f) {
+    float xm1 = x[i - 1], x0 = x[i], x1 = x[i + 1], x2 = x[i + 2];
+    float a = -0.5f * xm1 + 1.5f * x0 - 1.5f * x1 + 0.5f * x2;
+    float b = xm1 - 2.5f * x0 + 2.0f * x1 - 0.5f * x2;
+    float c = -0.5f * xm1 + 0.5f * x1;
+    return ((a * f + b) * f + c) * f + x0;
+}
+
+size_t resampler_process(Resampler* rs, const int16_t* in, size_t in_samples,
+                         int16_t* out, size_t out_cap) {
+    if (!rs || !out) return 0;
+    if (!in) in_samples = 0;
+    if (in_samples > rs->max_input) in_samples = rs->max_input;
+
+    float *x = rs->x;
+    load_input(x + RS_HISTORY, in, in_samples);
+
+    // Outputs need x[i + 2]; last usable index is therefore in_samples
+    const double limit = (double)in_samples + 1.0;
+    double pos = rs->pos;
+    const double step = rs->step;
+    size_t n = 0;
+
+#ifdef RS_USE_SSE2
+    // Four outputs per iteration: load each 4-tap window, transpose so every
+    // register holds one tap across the outputs, then evaluate the cubic
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 one_half = _mm_set1_ps(1.5f);
+    const __m128 two = _mm_set1_ps(2.0f);
+    const __m128 two_half = _mm_set1_ps(2.5f);
+    while (n + 4 <= out_cap && pos + 3.0 * step < limit) {
+        double p1 = pos + step, p2 = pos + 2.0 * step, p3 = pos + 3.0 * step;
+        size_t i0 = (size_t)pos, i1 = (size_t)p1, i2 = (size_t)p2, i3 = (size_t)p3;
+
+        __m128 t0 = _mm_loadu_ps(x + i0 - 1);
+        __m128 t1 = _mm_loadu_ps(x + i1 - 1);
+        __m128 t2 = _mm_loadu_ps(x + i2 - 1);
+        __m128 t3 = _mm_loadu_ps(x + i3 - 1);
+        _MM_TRANSPOSE4_PS(t0, t1, t2, t3);  // t0 = x[i-1], t1 = x[i], t2 = x[i+1], t3 = x[i+2]
+
+        __m128 f = _mm_set_ps((float)(p3 - i3), (float)(p2 - i2), (float)(p1 - i1), (float)(pos - i0));
+
+        __m128 a = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(one_half, t1), _mm_mul_ps(half, t0)),
+                              _mm_sub_ps(_mm_mul_ps(half, t3), _mm_mul_ps(one_half, t2)));
+        __m128 b = _mm_sub_ps(_mm_add_ps(t0, _mm_mul_ps(two, t2)),
+                              _mm_add_ps(_mm_mul_ps(two_half, t1), _mm_mul_ps(half, t3)));
+        __m128 c = _mm_mul_ps(half, _mm_sub_ps(t2, t0));
+        __m128 y = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(a, f), b), f), c), f), t1);
+
+        // Round and saturate to int16
+        __m128i yi = _mm_cvtps_epi32(y);
+        __m128i packed = _mm_packs_epi32(yi, yi);
+        _mm_storel_epi64((__m128i *)(out + n), packed);
+
+        n += 4;
+        pos += 4.0 * step;
+    }
+#endif
+
+    while (n < out_cap && pos < limit) {
+        size_t i = (size_t)pos;
+        out[n++] = clamp_s16(interp_scalar(x, i, (float)(pos - i)));
+        pos += step;
+    }
+
+    // Output buffer too small: skip ahead rather than read outside x[]
+    if (pos < limit) pos = limit;
+
+    // Keep the last samples as history for the next block
+    memmove(x, x + in_samples, RS_HISTORY * sizeof(float));
+    rs->pos = pos - (double)in_samples;
+    return n;
+}
@@ -0,0 +1,42 @@
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Fractional mono resampler for small clock corrections (ppm range).
+// 4-tap cubic (Catmull-Rom) interpolation, SSE2 when available.
+typedef struct Resampler Resampler;
+
+// max_input: largest block passed to resampler_process()
+Resampler* resampler_create(size_t max_input);
+
+// Destroy resampler
+void resampler_destroy(Resampler* rs);
+
+// Drop history and restart at ratio 1.0
+void resampler_reset(Resampler* rs);
+
+// Output samples per input sample (1.0 = passthrough rate)
+// Clamped to 1.0 +/- 1%, enough for any real clock drift
+void resampler_set_ratio(Resampler* rs, double ratio);
+
+double resampler_get_ratio(const Resampler* rs);
+
+// Upper bound of output samples for `in_samples` input
+size_t resampler_max_output(const Resampler* rs, size_t in_samples);
+
+// Resample a block; out_cap must be >= resampler_max_output()
+// Returns number of samples written to out
+size_t resampler_process(Resampler* rs, const int16_t* in, size_t in_samples,
+                         int16_t* out, size_t out_cap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RESAMPLER_H
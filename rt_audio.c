@@ -0,0 +1,211 @@
+#define _GNU_SOURCE
+#include "rt_audio.h"
+
+#include <errno.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <gio/gio.h>
+
+#define RT_THREAD_STACK (256 * 1024)
+#define RT_RTTIME_USEC 200000       // CPU time per RT burst before SIGXCPU
+
+static const int64_t hist_edges_us[RT_HIST_BUCKETS - 1] = {
+    50, 100, 200, 500, 1000, 2000, 5000, 10000
+};
+
+// ============================================================================
+// SCHEDULING
+// ============================================================================
+
+void rt_audio_thread_attr(pthread_attr_t* attr) {
+    pthread_attr_init(attr);
+    pthread_attr_setstacksize(attr, RT_THREAD_STACK);
+}
+
+int rt_audio_lock_memory(char* msg, size_t msg_len) {
+    if (mlockall(MCL_CURRENT) == 0) {
+        snprintf(msg, msg_len, "memory locked");
+        return 0;
+    }
+    struct rlimit rl;
+    getrlimit(RLIMIT_MEMLOCK, &rl);
+    snprintf(msg, msg_len, "mlockall: %s (RLIMIT_MEMLOCK %llu KB), locking audio stacks only",
+             strerror(errno), (unsigned long long)(rl.rlim_cur / 1024));
+    return -1;
+}
+
+static gint64 rtkit_property(GDBusConnection *bus, const char *name) {
+    GVariant *ret = g_dbus_connection_call_sync(
+        bus, "org.freedesktop.RealtimeKit1", "/org/freedesktop/RealtimeKit1",
+        "org.freedesktop.DBus.Properties", "Get",
+        g_variant_new("(ss)", "org.freedesktop.RealtimeKit1", name),
+        G_VARIANT_TYPE("(v)"), G_DBUS_CALL_FLAGS_NONE, 1000, NULL, NULL);
+    if (!ret) return -1;
+
+    GVariant *v = NULL;
+    g_variant_get(ret, "(v)", &v);
+    gint64 value = -1;
+    if (g_variant_is_of_type(v, G_VARIANT_TYPE_INT32)) value = g_variant_get_int32(v);
+    else if (g_variant_is_of_type(v, G_VARIANT_TYPE_INT64)) value = g_variant_get_int64(v);
+    g_variant_unref(v);
+    g_variant_unref(ret);
+    return value;
+}
+
+// RealtimeKit grants SCHED_FIFO to unprivileged desktop processes, but only
+// with RLIMIT_RTTIME set and priority within its limit
+static int rtkit_make_realtime(int *priority, char *err, size_t err_len) {
+    GError *error = NULL;
+    GDBusConnection *bus = g_bus_get_sync(G_BUS_TYPE_SYSTEM, NULL, &error);
+    if (!bus) {
+        snprintf(err, err_len, "%s", error ? error->message : "no system bus");
+        g_clear_error(&error);
+        return -1;
+    }
+
+    gint64 max_prio = rtkit_property(bus, "MaxRealtimePriority");
+    gint64 max_rttime = rtkit_property(bus, "RTTimeUSecMax");
+    if (max_prio > 0 && *priority > max_prio) *priority = (int)max_prio;
+
+    struct rlimit rl;
+    rl.rlim_cur = rl.rlim_max = (max_rttime > 0 && max_rttime < RT_RTTIME_USEC) ? (rlim_t)max_rttime
+                                                                                 : RT_RTTIME_USEC;
+    setrlimit(RLIMIT_RTTIME, &rl);
+
+    guint64 tid = (guint64)syscall(SYS_gettid);
+    GVariant *ret = g_dbus_connection_call_sync(
+        bus, "org.freedesktop.RealtimeKit1", "/org/freedesktop/RealtimeKit1",
+        "org.freedesktop.RealtimeKit1", "MakeThreadRealtime",
+        g_variant_new("(tu)", tid, (guint32)*priority),
+        NULL, G_DBUS_CALL_FLAGS_NONE, 1000, NULL, &error);
+    g_object_unref(bus);
+
+    if (!ret) {
+        snprintf(err, err_len, "%s", error ? error->message : "call failed");
+        g_clear_error(&error);
+        return -1;
+    }
+    g_variant_unref(ret);
+    return 0;
+}
+
+// Direct SCHED_FIFO, raising the soft RLIMIT_RTPRIO up to the hard limit
+// (CAP_SYS_NICE works regardless of the limit)
+static int rlimit_make_realtime(int *priority, char *err, size_t err_len) {
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_RTPRIO, &rl) == 0 && rl.rlim_cur < (rlim_t)*priority && rl.rlim_max > 0) {
+        if (rl.rlim_max != RLIM_INFINITY && rl.rlim_max < (rlim_t)*priority) {
+            *priority = (int)rl.rlim_max;
+        }
+        rl.rlim_cur = (rlim_t)*priority;
+        setrlimit(RLIMIT_RTPRIO, &rl);
+    }
+
+    struct sched_param sp = { .sched_priority = *priority };
+    int ret = pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp);
+    if (ret != 0) {
+        snprintf(err, err_len, "%s", strerror(ret));
+        return -1;
+    }
+    return 0;
+}
+
+// Touch and lock this thread's stack so a page fault never stalls audio
+static int lock_thread_stack(void) {
+    pthread_attr_t attr;
+    void *addr;
+    size_t size;
+    if (pthread_getattr_np(pthread_self(), &attr) != 0) return -1;
+    int ret = pthread_attr_getstack(&attr, &addr, &size);
+    pthread_attr_destroy(&attr);
+    if (ret != 0 || size > RT_THREAD_STACK * 2) return -1;
+    return mlock(addr, size);
+}
+
+int rt_audio_enter_thread(const RtAudioConfig* config, char* msg, size_t msg_len) {
+    int priority = config->priority < 1 ? 1 : (config->priority > 99 ? 99 : config->priority);
+    char rtkit_err[128] = "";
+    char rlimit_err[64] = "";
+    const char *via = NULL;
+
+    if (rtkit_make_realtime(&priority, rtkit_err, sizeof(rtkit_err)) == 0) {
+        via = "rtkit";
+    } else if (rlimit_make_realtime(&priority, rlimit_err, sizeof(rlimit_err)) == 0) {
+        via = "rlimit";
+    }
+
+    char pin[32] = "";
+    if (config->cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(config->cpu, &set);
+        int ret = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        snprintf(pin, sizeof(pin), ret == 0 ? ", CPU %d" : ", CPU %d failed", config->cpu);
+    }
+
+    const char *stack = lock_thread_stack() == 0 ? "" : ", stack not locked";
+
+    if (via) {
+        // rtkit hands out SCHED_RR; with one thread per priority it behaves like FIFO
+        snprintf(msg, msg_len, "%s %d via %s%s%s", strcmp(via, "rtkit") == 0 ? "SCHED_RR" : "SCHED_FIFO",
+                 priority, via, pin, stack);
+        return 0;
+    }
+    snprintf(msg, msg_len, "no real-time (rtkit: %s; rlimit: %s)%s%s", rtkit_err, rlimit_err, pin, stack);
+    return -1;
+}
+
+// ============================================================================
+// HISTOGRAM
+// ============================================================================
+
+void rt_hist_reset(RtLatencyHist* h) {
+    memset(h, 0, sizeof(*h));
+}
+
+void rt_hist_add(RtLatencyHist* h, int64_t late_us) {
+    if (late_us < 0) late_us = 0;
+    int b = 0;
+    while (b < RT_HIST_BUCKETS - 1 && late_us >= hist_edges_us[b]) b++;
+    h->buckets[b]++;
+    h->count++;
+    if (late_us > h->max_us) h->max_us = late_us;
+}
+
+static const char* bucket_label(int b) {
+    static const char *labels[RT_HIST_BUCKETS] = {
+        "<50us", "<100us", "<200us", "<500us", "<1ms", "<2ms", "<5ms", "<10ms", ">=10ms"
+    };
+    return labels[b];
+}
+
+static int percentile_bucket(const RtLatencyHist* h, double p) {
+    uint64_t want = (uint64_t)(h->count * p);
+    uint64_t seen = 0;
+    for (int b = 0; b < RT_HIST_BUCKETS; b++) {
+        seen += h->buckets[b];
+        if (seen > want) return b;
+    }
+    return RT_HIST_BUCKETS - 1;
+}
+
+void rt_hist_format(const RtLatencyHist* h, char* buf, size_t len) {
+    if (!h->count) {
+        snprintf(buf, len, "no samples");
+        return;
+    }
+    int n = snprintf(buf, len, "p50 %s, p99 %s, max %lldus |",
+                     bucket_label(percentile_bucket(h, 0.50)),
+                     bucket_label(percentile_bucket(h, 0.99)),
+                     (long long)h->max_us);
+    for (int b = 0; b < RT_HIST_BUCKETS && n > 0 && (size_t)n < len; b++) {
+        if (!h->buckets[b]) continue;
+        n += snprintf(buf + n, len - n, " %s:%llu", bucket_label(b), (unsigned long long)h->buckets[b]);
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef RT_AUDIO_H
+#define RT_AUDIO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Real-time setup for the SCO audio threads: real-time priority via
+// RealtimeKit (D-Bus) or SCHED_FIFO within RLIMIT_RTPRIO, memory locking,
+// CPU pinning, and a wakeup latency histogram to see whether it helped.
+
+typedef struct {
+    int priority;               // SCHED_FIFO priority, 1-99
+    int cpu;                    // Core to pin to, -1 = any
+} RtAudioConfig;
+
+// Attributes for audio threads: small fixed stack that can be locked
+void rt_audio_thread_attr(pthread_attr_t* attr);
+
+// Lock current process memory (mlockall); result text in msg
+// Returns 0 on success, -1 on failure
+int rt_audio_lock_memory(char* msg, size_t msg_len);
+
+// Called from the audio thread itself: SCHED_FIFO, CPU pinning, stack lock
+// msg: summary for the log. Returns 0 if the thread runs real-time
+int rt_audio_enter_thread(const RtAudioConfig* config, char* msg, size_t msg_len);
+
+// Wakeup latency histogram (how late the thread ran vs. when it was due)
+#define RT_HIST_BUCKETS 9
+
+typedef struct {
+    uint64_t buckets[RT_HIST_BUCKETS];   // <50, <100, <200, <500 us, <1, <2, <5, <10 ms, rest
+    uint64_t count;
+    int64_t max_us;
+} RtLatencyHist;
+
+void rt_hist_reset(RtLatencyHist* h);
+void rt_hist_add(RtLatencyHist* h, int64_t late_us);
+
+// "p50 <100us p99 <1ms max 1234us | <50us:... >=10ms:..."
+void rt_hist_format(const RtLatencyHist* h, char* buf, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RT_AUDIO_H
@@ -0,0 +1,1435 @@
+#include "sco_audio.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "audio_graph.h"
+#include "audio_ring.h"
+#include "clock_drift.h"
+#include "jitter_buffer.h"
+#include "resampler.h"
+#include "rt_audio.h"
+#include "sco_rx.h"
+#include "sco_tx.h"
+
+#ifdef HAVE_WEBRTC_APM
+#include "audio_processing_wrapper.h"
+#endif
+
+#ifdef HAVE_SBC
+#include "msbc.h"
+#endif
+
+// WebRTC AEC (frames are always 10ms, sized for the highest rate)
+#define AEC_MAX_FRAME_SAMPLES 160  // 10ms @ 16kHz
+#define AEC_MAX_FRAME_BYTES (AEC_MAX_FRAME_SAMPLES * 2)
+#define AEC_FIFO_FRAMES 50  // 500ms of far-end reference
+#define AEC_LATENCY_POLL_US 250000  // Sink/source latency query interval
+#define SPEAKER_PACE_STEP_DIV 8     // Playout tick shift per latency poll: packet / 8
+#define CLOCK_DRIFT_MAX_PPM 1000  // Largest resampler correction
+#define DRIFT_LOG_INTERVAL_US (30 * 1000000LL)
+#define SCO_MSBC_BYTES_PER_SEC 8000  // One 60 byte H2 frame per 7.5ms
+#define SCO_TX_MAX_QUEUE_MS 60  // Microphone -> SCO queue cap (oldest packets dropped)
+
+// ============================================================================
+// STATE
+// ============================================================================
+
+static ScoAudioConfig cfg;
+static char playback_device[128];
+static char capture_device[128];
+static int sample_rate = 8000;
+
+// Warm start (sco_audio_prepare) keeps its own copy: the live cfg belongs to
+// the call threads and only sco_audio_start writes it
+static ScoAudioConfig warm_cfg;
+static char warm_playback_device[128];
+static char warm_capture_device[128];
+
+static pthread_t playback_thread;
+static pthread_t capture_thread;
+static volatile int running = 0;
+
+// Thread lifecycle: sco_audio_stop signals stop_fd, which wakes the speaker
+// poll at once; each thread counts itself out under thread_lock as its very
+// last step, so sco_audio_join waits on a condition instead of polling
+static int stop_fd = -1;
+static pthread_once_t thread_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t thread_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t thread_cond;   // CLOCK_MONOTONIC
+static int threads_alive = 0;
+static pthread_mutex_t join_lock = PTHREAD_MUTEX_INITIALIZER;  // Start / join callers
+static int playback_joinable = 0;
+static int capture_joinable = 0;
+static __thread int on_audio_thread = 0;
+static AudioStream *volatile audio_playback = NULL;
+static AudioStream *volatile audio_capture = NULL;
+
+// Call recording: set before the threads start, finished in sco_audio_shutdown
+static char record_path[512];
+static CallRecorder *recorder = NULL;
+static CallRecorderStats recorder_last;
+static int recorder_have_last = 0;
+
+// Warm start: sound card streams opened while the phone rings, taken over
+// by the call threads when the link comes up (warm_lock)
+typedef struct {
+    AudioStream *stream;
+    AudioStreamConfig config;        // What it was opened with
+    AudioBackendType backend;
+    char device[128];
+} WarmStream;
+
+static pthread_mutex_t warm_lock = PTHREAD_MUTEX_INITIALIZER;
+static WarmStream warm[2];           // Indexed by AudioStreamDirection
+
+// Answer to first audio of the current / last call
+static double first_audio_ms = -1.0;
+
+static int aec_enabled = 0;
+#ifdef HAVE_WEBRTC_APM
+static AecHandle *aec_handle = NULL;
+static int aec_handle_rate = 0;
+static pthread_mutex_t aec_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+// Far-end reference: playback thread writes, capture thread reads (lock-free)
+static AudioRing *aec_render_fifo = NULL;
+
+// One 10ms far-end frame and when its first sample leaves the speaker
+typedef struct {
+    int64_t play_us;
+    int16_t samples[AEC_MAX_FRAME_SAMPLES];
+} AecFarFrame;
+
+// Playback side: SCO packets regrouped into 10ms far-end frames
+typedef struct {
+    AecFarFrame frame;
+    int len;
+    int frame_samples;
+    int rate;
+} AecFarAccum;
+
+// Capture side alignment counters
+typedef struct {
+    int64_t delay_sum_ms;
+    uint64_t frames;
+    int delay_min_ms;
+    int delay_max_ms;
+    uint64_t stale;             // Far-end frames whose echo had already passed
+    uint64_t missing;           // Near-end frames without a reference
+} AecAlignStats;
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+static int64_t monotonic_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void sco_log(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+static void sco_log(const char *fmt, ...) {
+    // Before the first call only a warm start has set a log callback
+    const ScoAudioConfig *c = cfg.log ? &cfg : &warm_cfg;
+    if (!c->log) return;
+    char msg[512];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(msg, sizeof(msg), fmt, ap);
+    va_end(ap);
+    c->log(msg, c->user_data);
+}
+
+// Called only while the audio threads are stopped
+static void aec_fifo_clear(void) {
+    if (!aec_render_fifo) {
+        aec_render_fifo = audio_ring_create(AEC_FIFO_FRAMES * sizeof(AecFarFrame));
+        if (!aec_render_fifo) {
+            sco_log("⚠️ AEC FIFO allocation failed");
+        }
+        return;
+    }
+
+    uint64_t overruns = audio_ring_overruns(aec_render_fifo);
+    uint64_t underruns = audio_ring_underruns(aec_render_fifo);
+    if (overruns || underruns) {
+        sco_log("ℹ️ AEC FIFO: %llu overrun, %llu underrun",
+                (unsigned long long)overruns, (unsigned long long)underruns);
+    }
+    audio_ring_reset(aec_render_fifo);
+}
+
+// Playback thread only (producer); drops frames if the capture side stalls
+// play_us: when samples[0] is heard (write time + sink latency)
+static void aec_fifo_push(AecFarAccum *acc, const int16_t *samples, int count, int64_t play_us) {
+    if (!aec_render_fifo) return;
+    for (int i = 0; i < count;) {
+        if (acc->len == 0) {
+            acc->frame.play_us = play_us + (int64_t)i * 1000000 / acc->rate;
+        }
+        int n = count - i;
+        if (n > acc->frame_samples - acc->len) n = acc->frame_samples - acc->len;
+        memcpy(acc->frame.samples + acc->len, samples + i, (size_t)n * sizeof(int16_t));
+        acc->len += n;
+        i += n;
+        if (acc->len == acc->frame_samples) {
+            audio_ring_write(aec_render_fifo, &acc->frame, sizeof(acc->frame));
+            acc->len = 0;
+        }
+    }
+}
+
+// Capture thread only (consumer): reference for the near-end frame captured
+// at cap_us. Frames that finished playing before it are useless to the AEC
+// (their echo is already gone) and are dropped; that also re-aligns the
+// FIFO after a stall. delay_ms: play time of the reference vs. capture time
+static int aec_fifo_pop(int16_t *out, int count, int64_t cap_us, int64_t frame_us,
+                        int *delay_ms, AecAlignStats *st) {
+    if (count <= 0 || !aec_render_fifo) return 0;
+    AecFarFrame f;
+    while (audio_ring_read(aec_render_fifo, &f, sizeof(f)) > 0) {
+        if (f.play_us + frame_us <= cap_us) {
+            st->stale++;
+            continue;
+        }
+        memcpy(out, f.samples, (size_t)count * sizeof(int16_t));
+        *delay_ms = (int)((f.play_us - cap_us) / 1000);
+        return 1;
+    }
+    return 0;
+}
+
+// Buffered far-end samples, for drift tracking on the capture side
+static int aec_fifo_level(int frame_samples) {
+    if (!aec_render_fifo) return 0;
+    return (int)(audio_ring_available(aec_render_fifo) / sizeof(AecFarFrame)) * frame_samples;
+}
+
+static void log_aec_alignment(const AecAlignStats *st) {
+    if (!st->frames && !st->missing) return;
+    sco_log("ℹ️ AEC delay: %.1f ms avg (%d..%d), %llu stale far-end frames dropped, %llu without reference",
+            st->frames ? (double)st->delay_sum_ms / st->frames : 0.0, st->delay_min_ms, st->delay_max_ms,
+            (unsigned long long)st->stale, (unsigned long long)st->missing);
+}
+
+static void init_webrtc_aec(const ScoAudioConfig *c, int rate) {
+#ifdef HAVE_WEBRTC_APM
+    if (!c->aec) {
+        aec_enabled = 0;
+        aec_fifo_clear();
+        sco_log("⚠️ WebRTC AEC disabled (settings)");
+        return;
+    }
+    pthread_mutex_lock(&aec_mutex);
+    if (aec_handle && aec_handle_rate != rate) {
+        aec_destroy(aec_handle);
+        aec_handle = NULL;
+    }
+    if (aec_handle) {
+        // Same rate as the last call: keep the instance, only switch modules
+        aec_set_profile(aec_handle, &c->apm_profile);
+    } else {
+        aec_handle = aec_create_profile(rate, &c->apm_profile);
+        aec_handle_rate = aec_handle ? rate : 0;
+    }
+    aec_enabled = (aec_handle != NULL);
+    pthread_mutex_unlock(&aec_mutex);
+#else
+    (void)c;
+    (void)rate;
+    aec_enabled = 0;
+#endif
+    if (aec_enabled) {
+        char profile[96];
+        apm_profile_format(&c->apm_profile, profile, sizeof(profile));
+        sco_log("✅ WebRTC AEC active: %s @ %d Hz", profile, rate);
+    } else {
+        sco_log("⚠️ WebRTC AEC disabled");
+    }
+    aec_fifo_clear();
+}
+
+static void log_recorder_stats(const CallRecorderStats *st) {
+    sco_log("ℹ️ Recorder: %.1f s written, dropped %llu/%llu samples (far/near, %llu/%llu ring full), "
+            "peak ring %d/%d of %d ms, %llu padded, %llu write errors",
+            (double)st->frames_written / sample_rate,
+            (unsigned long long)st->far_dropped, (unsigned long long)st->near_dropped,
+            (unsigned long long)st->far_overruns, (unsigned long long)st->near_overruns,
+            st->far_peak_ms, st->near_peak_ms, st->ring_ms,
+            (unsigned long long)st->gap_samples, (unsigned long long)st->write_errors);
+}
+
+static void finish_recorder(void) {
+    if (!recorder) return;
+    call_recorder_stop(recorder);
+    call_recorder_get_stats(recorder, &recorder_last);
+    recorder_have_last = 1;
+    sco_log("💾 Call recorded: %s", call_recorder_path(recorder));
+    log_recorder_stats(&recorder_last);
+    call_recorder_destroy(recorder);
+    recorder = NULL;
+}
+
+static void start_recorder(void) {
+    finish_recorder();  // Previous call not shut down
+    recorder_have_last = 0;
+    if (!cfg.record_path || !cfg.record_path[0]) return;
+
+    snprintf(record_path, sizeof(record_path), "%s", cfg.record_path);
+    cfg.record_path = record_path;
+    CallRecorderConfig rc = {
+        .path_base = record_path,
+        .format = cfg.record_format,
+        .sample_rate = sample_rate,
+        .stereo = cfg.record_stereo,
+    };
+    char err[160];
+    recorder = call_recorder_create(&rc, err, sizeof(err));
+    if (!recorder) {
+        sco_log("⚠️ Call recording failed: %s", err);
+        return;
+    }
+    sco_log("⏺️ Recording call (%s, %s): %s", call_recorder_format_name(recorder),
+            cfg.record_stereo ? "stereo" : "mono", call_recorder_path(recorder));
+}
+
+static void log_jitter_stats(JitterBuffer *jb, int rate) {
+    JitterStats st;
+    jitter_buffer_get_stats(jb, &st);
+    double ms_per_sample = 1000.0 / rate;
+    sco_log("ℹ️ Jitter buffer: depth %.1f/%.1f ms, jitter %.1f ms (peak %.1f), late %llu, lost %llu, concealed %llu",
+            st.depth_samples * ms_per_sample, st.target_samples * ms_per_sample,
+            st.jitter_ms, st.peak_jitter_ms,
+            (unsigned long long)st.late_packets, (unsigned long long)st.lost_packets,
+            (unsigned long long)st.concealed_frames);
+}
+
+// Per call: what the listener heard that was not sent by the phone
+static void log_plc_stats(const char *stage, const PlcStats *st, int rate) {
+    if (!st->concealed_frames) return;
+    double total = (double)(st->good_samples + st->concealed_samples);
+    sco_log("🩹 PLC (%s): %llu frames concealed (%.1f ms, %.2f%%), %llu gaps, longest %.1f ms, muted %.1f ms",
+            stage, (unsigned long long)st->concealed_frames, st->concealed_samples * 1000.0 / rate,
+            total > 0 ? st->concealed_samples * 100.0 / total : 0.0, (unsigned long long)st->bursts,
+            st->longest_burst_ms, st->muted_samples * 1000.0 / rate);
+}
+
+// Optional real-time priority / pinning, from inside the audio thread
+static void enter_realtime(const char *thread_name, int cpu) {
+    if (!cfg.realtime) return;
+    RtAudioConfig rt = { .priority = cfg.realtime_priority, .cpu = cpu };
+    char msg[256];
+    int ret = rt_audio_enter_thread(&rt, msg, sizeof(msg));
+    sco_log("%s %s thread: %s", ret == 0 ? "⚡" : "⚠️", thread_name, msg);
+}
+
+static void log_wakeup_latency(const char *thread_name, const RtLatencyHist *hist) {
+    char text[256];
+    rt_hist_format(hist, text, sizeof(text));
+    sco_log("ℹ️ %s wakeup latency: %s", thread_name, text);
+}
+
+static void log_sco_rx(ScoRx *rx) {
+    ScoRxStats st;
+    sco_rx_get_stats(rx, &st);
+    if (!st.packets) return;
+    char text[384];
+    sco_rx_format_stats(&st, text, sizeof(text));
+    sco_log("ℹ️ SCO RX: %llu packets, %s", (unsigned long long)st.packets, text);
+}
+
+static void log_graph_stats(AudioGraph *graph) {
+    char text[448];
+    audio_graph_format_stats(graph, text, sizeof(text));
+    sco_log("⏱️ %s pipeline: %s", audio_graph_name(graph), text);
+}
+
+static void log_clock_drift(const char *side, ClockDrift *cd) {
+    sco_log("ℹ️ Clock drift (%s): %+.1f ppm, ratio %.6f, offset %+.2f ms",
+            side, clock_drift_ppm(cd), clock_drift_ratio(cd), clock_drift_offset_ms(cd));
+}
+
+// ============================================================================
+// DEVICES
+// ============================================================================
+
+// Device period follows what the threads read / write: one SCO packet, or
+// 10ms frames for AEC / mSBC on the microphone side
+static void call_stream_config(const ScoAudioConfig *c, int rate, AudioStreamDirection direction, int aec,
+                               AudioStreamConfig *acfg) {
+    size_t period = (size_t)c->mtu;
+    if (direction == AUDIO_STREAM_PLAYBACK) {
+#ifdef HAVE_SBC
+        if (c->codec == SCO_CODEC_MSBC) period = MSBC_FRAME_SAMPLES * 2;
+#endif
+    } else if (aec || c->codec == SCO_CODEC_MSBC) {
+        period = (size_t)(rate / 100) * 2;
+    }
+    const char *device = direction == AUDIO_STREAM_PLAYBACK ? c->playback_device : c->capture_device;
+    *acfg = (AudioStreamConfig){
+        .direction = direction,
+        .sample_rate = rate,
+        .channels = 1,
+        .period_bytes = period,
+        .latency_ms = c->latency_ms,
+        .app_name = direction == AUDIO_STREAM_PLAYBACK ? "PCPhone" : "PcPhone",
+        .stream_name = direction == AUDIO_STREAM_PLAYBACK ? "Phone Audio" : "PC Microphone",
+        .device = device && device[0] ? device : NULL
+    };
+}
+
+static int warm_matches(const WarmStream *w, AudioBackendType backend, const AudioStreamConfig *acfg) {
+    return w->stream && w->backend == backend && w->config.sample_rate == acfg->sample_rate &&
+           w->config.period_bytes == acfg->period_bytes && w->config.latency_ms == acfg->latency_ms &&
+           strcmp(w->device, acfg->device ? acfg->device : "") == 0;
+}
+
+// Take the warm stream if it was opened for the same link, else drop it
+static AudioStream* take_warm_stream(AudioBackendType backend, const AudioStreamConfig *acfg) {
+    pthread_mutex_lock(&warm_lock);
+    WarmStream *w = &warm[acfg->direction];
+    AudioStream *stream = warm_matches(w, backend, acfg) ? w->stream : NULL;
+    AudioStream *stale = stream ? NULL : w->stream;
+    w->stream = NULL;
+    pthread_mutex_unlock(&warm_lock);
+
+    if (stale) {
+        sco_log("ℹ️ Warm %s does not fit the link, reopening",
+                acfg->direction == AUDIO_STREAM_PLAYBACK ? "speaker" : "microphone");
+        audio_stream_close(stale);
+    }
+    // Whatever the microphone picked up while ringing is stale
+    if (stream) audio_stream_flush(stream);
+    return stream;
+}
+
+// Call thread stream: the warm one, or opened now
+static AudioStream* open_call_stream(const AudioStreamConfig *acfg, int *was_warm, char *err, size_t err_len) {
+    AudioStream *stream = take_warm_stream(cfg.backend, acfg);
+    *was_warm = stream != NULL;
+    return stream ? stream : audio_stream_open(cfg.backend, acfg, err, err_len);
+}
+
+static void release_warm_streams(void) {
+    pthread_mutex_lock(&warm_lock);
+    AudioStream *streams[2] = { warm[0].stream, warm[1].stream };
+    warm[0].stream = NULL;
+    warm[1].stream = NULL;
+    pthread_mutex_unlock(&warm_lock);
+    audio_stream_close(streams[0]);
+    audio_stream_close(streams[1]);
+}
+
+// ============================================================================
+// SPEAKER THREAD
+// ============================================================================
+
+// Speaker thread state, shared by its stages
+typedef struct {
+    AudioStream *stream;
+    CallRecorder *rec;               // NULL = not recording
+    JitterBuffer *jb;
+    Resampler *rs;
+    ClockDrift *drift;
+    AudioGain gain;
+#ifdef HAVE_SBC
+    MsbcCodec *msbc;
+#endif
+    const ScoRxPacket *packet;       // Being received
+    int packet_samples;              // Played per tick
+    int64_t now;                     // Time of the playout tick
+
+    // Far-end reference for the AEC, stamped with its play time
+    AecFarAccum far;
+    int64_t sink_latency_us;
+    int64_t next_latency_poll_us;
+    int64_t sink_setpoint_us;        // Sink latency once settled, -1 before
+    int64_t pace_us;                 // Total playout tick shift, for the log
+} SpeakerPipe;
+
+enum { PLAY_RS_MAX_INPUT = 480 };
+
+// SCO packet -> PCM
+static int speaker_receive(void *ctx, AudioBlock *in, AudioBlock *out) {
+    (void)out;
+    SpeakerPipe *sp = ctx;
+    const ScoRxPacket *p = sp->packet;
+    in->time_us = p->arrival_us;
+#ifdef HAVE_SBC
+    if (sp->msbc) {
+        // H2 packets may be split across SCO packets - decoder reassembles
+        in->samples = (int)msbc_decode_stream(sp->msbc, p->data, (size_t)p->len, in->pcm, (size_t)in->capacity);
+        return in->samples > 0 ? AUDIO_STAGE_NEXT : AUDIO_STAGE_DONE;
+    }
+#endif
+    in->samples = p->len / 2 < in->capacity ? p->len / 2 : in->capacity;
+    memcpy(in->pcm, p->data, (size_t)in->samples * sizeof(int16_t));
+    return in->samples > 0 ? AUDIO_STAGE_NEXT : AUDIO_STAGE_DONE;
+}
+
+// Phone clock -> playout clock: the jitter buffer level drives the ratio
+static int speaker_resample(void *ctx, AudioBlock *in, AudioBlock *out) {
+    SpeakerPipe *sp = ctx;
+    size_t samples = (size_t)(in->samples < PLAY_RS_MAX_INPUT ? in->samples : PLAY_RS_MAX_INPUT);
+    out->samples = (int)resampler_process(sp->rs, in->pcm, samples, out->pcm, (size_t)out->capacity);
+    return out->samples > 0 ? AUDIO_STAGE_SWAP : AUDIO_STAGE_DONE;
+}
+
+// Kernel arrival time: a late wakeup is not network jitter
+static int speaker_jitter_put(void *ctx, AudioBlock *in, AudioBlock *out) {
+    (void)out;
+    SpeakerPipe *sp = ctx;
+    jitter_buffer_put(sp->jb, in->pcm, in->samples, in->time_us);
+    return AUDIO_STAGE_NEXT;
+}
+
+// One packet per playout tick, concealed when it did not arrive in time
+static int speaker_jitter_get(void *ctx, AudioBlock *in, AudioBlock *out) {
+    (void)out;
+    SpeakerPipe *sp = ctx;
+    in->samples = sp->packet_samples;
+    in->time_us = sp->now;
+    jitter_buffer_get(sp->jb, in->pcm, in->samples);
+
+    JitterStats jst;
+    jitter_buffer_get_stats(sp->jb, &jst);
+    resampler_set_ratio(sp->rs, clock_drift_update(sp->drift, jst.depth_samples - jst.target_samples, sp->now));
+    return AUDIO_STAGE_NEXT;
+}
+
+static int speaker_record(void *ctx, AudioBlock *in, AudioBlock *out) {
+    (void)out;
+    SpeakerPipe *sp = ctx;
+    call_recorder_push_far(sp->rec, in->pcm, in->samples);
+    return AUDIO_STAGE_NEXT;
+}
+
+static int speaker_aec_reference(void *ctx, AudioBlock *in, AudioBlock *out) {
+    (void)out;
+    SpeakerPipe *sp = ctx;
+    aec_fifo_push(&sp->far, in->pcm, in->samples, monotonic_us() + sp->sink_latency_us);
+    return AUDIO_STAGE_NEXT;
+}
+
+static int speaker_write(void *ctx, AudioBlock *in, AudioBlock *out) {
+    (void)out;
+    SpeakerPipe *sp = ctx;
+    if (audio_stream_write(sp->stream, in->pcm, (size_t)in->samples * sizeof(int16_t)) < 0) {
+        sco_log("⚠️ Audio write error");
+        return AUDIO_STAGE_ERROR;
+    }
+    return AUDIO_STAGE_NEXT;
+}
+
+// The playout ticks run on CLOCK_MONOTONIC, the sink drains on the sound card
+// clock: a card running fast would empty the sink and underrun on a schedule.
+// The sink latency, against its settled value, shifts the next tick by a
+// fraction of a packet per poll, so the ticks follow the card on average and
+// the jitter buffer level (the drift loop input) compares phone and card
+static int64_t speaker_pace(SpeakerPipe *sp, int64_t now, int64_t packet_us) {
+    if (now < sp->next_latency_poll_us) return 0;
+    sp->next_latency_poll_us = now + AEC_LATENCY_POLL_US;
+    int64_t latency = audio_stream_latency_us(sp->stream);
+    if (latency < 0) return 0;
+    sp->sink_latency_us = latency;
+    if (sp->sink_setpoint_us < 0) return 0;
+
+    // Half a packet of dead band: the level moves by one write per tick
+    int64_t error = latency - sp->sink_setpoint_us;
+    if (error > packet_us / 2) return packet_us / SPEAKER_PACE_STEP_DIV;     // Card slow: later
+    if (error < -packet_us / 2) return -packet_us / SPEAKER_PACE_STEP_DIV;   // Card fast: earlier
+    return 0;
+}
+
+static void log_speaker_pace(const SpeakerPipe *sp) {
+    if (sp->sink_setpoint_us < 0) return;
+    sco_log("ℹ️ Speaker pacing: sink %.1f ms (setpoint %.1f ms), ticks shifted %+.1f ms",
+            sp->sink_latency_us / 1000.0, sp->sink_setpoint_us / 1000.0, sp->pace_us / 1000.0);
+}
+
+// SCO -> sound card playback thread (phone audio to PC)
+static void* sco_playback_thread_func(void *data) {
+    (void)data;
+
+    enter_realtime("Speaker", cfg.playback_cpu);
+
+    // Audio format: mono 16-bit, 8kHz (CVSD) or 16kHz (mSBC)
+    const int codec = cfg.codec;
+    const int sco_socket = cfg.socket;
+    AudioStreamConfig acfg;
+    call_stream_config(&cfg, sample_rate, AUDIO_STREAM_PLAYBACK, aec_enabled, &acfg);
+
+    char err[128] = "";
+    int warm_start = 0;
+    AudioStream *stream = open_call_stream(&acfg, &warm_start, err, sizeof(err));
+
+    if (!stream) {
+        sco_log("⚠️ Speaker could not be opened: %s", err);
+        return NULL;
+    }
+    audio_playback = stream;
+    const uint64_t xruns_before = audio_stream_xruns(stream);
+
+    sco_log("🔊 Speaker active - phone audio coming (%s, %d ms target%s)",
+            audio_stream_backend_name(stream), cfg.latency_ms, warm_start ? ", warm" : "");
+
+    ScoRxPacket packets[SCO_RX_MAX_BATCH];
+    size_t bytes_played = 0;
+    int latency_logged = 0;
+    SpeakerPipe sp = {
+        .stream = stream,
+        .rec = recorder,
+        .far = { .len = 0, .frame_samples = acfg.sample_rate / 100, .rate = acfg.sample_rate },
+        .sink_setpoint_us = -1,
+    };
+    audio_gain_set_db(&sp.gain, cfg.playback_gain_db);
+
+    // Playout clock ticks once per nominal SCO packet, paced to the sink (see
+    // speaker_pace); the jitter buffer absorbs arrival bursts and conceals
+    // when a packet is not there in time
+    sp.packet_samples = cfg.mtu / 2;
+#ifdef HAVE_SBC
+    if (codec == SCO_CODEC_MSBC) {
+        sp.packet_samples = MSBC_FRAME_SAMPLES;
+        sp.msbc = msbc_create();
+        if (!sp.msbc) {
+            sco_log("⚠️ mSBC decoder could not be created");
+        }
+    }
+#else
+    (void)codec;
+#endif
+    if (sp.packet_samples <= 0 || sp.packet_samples > SCO_RX_MAX_PACKET / 2) sp.packet_samples = 24;
+    const int64_t packet_us = (int64_t)sp.packet_samples * 1000000 / acfg.sample_rate;
+    int64_t next_play_us = -1;  // Starts with the first packet
+    int64_t first_packet_us = -1;
+    RtLatencyHist wakeup;  // Timer wakeups vs. due playout time
+    rt_hist_reset(&wakeup);
+    int64_t next_stats_us = monotonic_us() + DRIFT_LOG_INTERVAL_US;
+
+    sp.jb = jitter_buffer_create(acfg.sample_rate, sp.packet_samples, cfg.jitter_min_ms, cfg.jitter_max_ms);
+    if (!sp.jb) {
+        sco_log("⚠️ Jitter buffer could not be created");
+    }
+    sp.rs = resampler_create(PLAY_RS_MAX_INPUT);
+    sp.drift = clock_drift_create(acfg.sample_rate, CLOCK_DRIFT_MAX_PPM);
+
+    // Drains every queued packet per wakeup, each with its kernel arrival time
+    ScoRx *rx = sco_rx_create(sco_socket, codec == SCO_CODEC_MSBC ? SCO_MSBC_BYTES_PER_SEC : acfg.sample_rate * 2);
+    if (!rx) {
+        sco_log("⚠️ SCO receiver could not be created");
+    }
+
+    // SCO packet -> jitter buffer, and playout tick -> sound card
+    AudioGraph *receive = audio_graph_create("Speaker receive", acfg.sample_rate,
+                                             PLAY_RS_MAX_INPUT + PLAY_RS_MAX_INPUT / 64 + 4);
+    AudioGraph *playout = audio_graph_create("Speaker playout", acfg.sample_rate, sp.packet_samples);
+    if (receive && playout) {
+        audio_graph_add(receive, AUDIO_STAGE_SOURCE, codec == SCO_CODEC_MSBC ? "msbc-decode" : "sco-rx", 0,
+                        speaker_receive, &sp);
+        audio_graph_add(receive, AUDIO_STAGE_RESAMPLER, "drift", 0, speaker_resample, &sp);
+        audio_graph_add(receive, AUDIO_STAGE_SINK, "jitter-buffer", 0, speaker_jitter_put, &sp);
+
+        audio_graph_add(playout, AUDIO_STAGE_PLC, "jitter-buffer", 0, speaker_jitter_get, &sp);
+        if (cfg.playback_gain_db) audio_graph_add(playout, AUDIO_STAGE_GAIN, "gain", 0, audio_gain_process, &sp.gain);
+        if (sp.rec) audio_graph_add(playout, AUDIO_STAGE_TAP, "recorder", 0, speaker_record, &sp);
+        if (aec_enabled) audio_graph_add(playout, AUDIO_STAGE_AEC, "aec-reference", 0, speaker_aec_reference, &sp);
+        audio_graph_add(playout, AUDIO_STAGE_SINK, "speaker", AUDIO_STAGE_WAITS, speaker_write, &sp);
+    } else {
+        sco_log("⚠️ Speaker pipeline could not be created");
+    }
+
+    while (sp.jb && sp.rs && sp.drift && rx && receive && playout && running) {
+        int64_t now = monotonic_us();
+        int timeout_ms = 1000;
+        if (next_play_us >= 0) {
+            timeout_ms = next_play_us > now ? (int)((next_play_us - now + 999) / 1000) : 0;
+        }
+
+        struct pollfd pfd[2] = {
+            { .fd = sco_socket, .events = POLLIN },
+            { .fd = stop_fd, .events = POLLIN },
+        };
+        int ret = poll(pfd, 2, timeout_ms);
+        if (ret < 0 && errno != EINTR) break;
+        if (!running) break;
+        if (ret == 0 && next_play_us >= 0) {
+            rt_hist_add(&wakeup, monotonic_us() - next_play_us);
+        }
+
+        if (ret > 0 && pfd[0].revents) {
+            int count = sco_rx_recv(rx, packets, SCO_RX_MAX_BATCH);
+            if (count < 0) {
+                if (running) {
+                    sco_log("⚠️ Phone audio cut");
+                }
+                break;
+            }
+
+            if (count > 0 && first_packet_us < 0) first_packet_us = packets[0].arrival_us;
+            for (int i = 0; i < count; i++) {
+                sp.packet = &packets[i];
+                if (audio_graph_run(receive) > 0 && next_play_us < 0) {
+                    next_play_us = packets[i].arrival_us;
+                }
+            }
+        }
+
+        // Playout due packets
+        now = monotonic_us();
+        int write_failed = 0;
+        while (next_play_us >= 0 && now >= next_play_us) {
+            sp.now = now;
+            if (audio_graph_run(playout) < 0) {
+                write_failed = 1;
+                break;
+            }
+            next_play_us += packet_us;
+            if (bytes_played == 0 && cfg.answer_us > 0) {
+                first_audio_ms = (monotonic_us() - cfg.answer_us) / 1000.0;
+                sco_log("⏱️ Answer to first audio: %.1f ms (first SCO packet %.1f ms, devices %s)",
+                        first_audio_ms, (first_packet_us - cfg.answer_us) / 1000.0,
+                        warm_start ? "warm" : "opened on answer");
+            }
+            bytes_played += sp.packet_samples * sizeof(int16_t);
+        }
+        if (write_failed) break;
+
+        // Sink stalled for a long time: restart the clock instead of bursting
+        if (next_play_us >= 0 && now - next_play_us > 100000) {
+            next_play_us = now;
+        }
+
+        // Report measured sink latency once the stream has settled (~1s);
+        // it is the setpoint the playout pacing holds from here on
+        if (!latency_logged && bytes_played >= (size_t)acfg.sample_rate * 2) {
+            int64_t latency = audio_stream_latency_us(stream);
+            if (latency >= 0) {
+                sco_log("ℹ️ Speaker latency: %.1f ms", latency / 1000.0);
+                sp.sink_setpoint_us = latency;
+            }
+            latency_logged = 1;
+        }
+        if (next_play_us >= 0) {
+            int64_t shift = speaker_pace(&sp, now, packet_us);
+            next_play_us += shift;
+            sp.pace_us += shift;
+        }
+
+        if (now >= next_stats_us) {
+            log_jitter_stats(sp.jb, acfg.sample_rate);
+            log_clock_drift("phone", sp.drift);
+            log_speaker_pace(&sp);
+            log_sco_rx(rx);
+            log_graph_stats(receive);
+            log_graph_stats(playout);
+            next_stats_us = now + DRIFT_LOG_INTERVAL_US;
+        }
+    }
+
+    if (rx) {
+        log_sco_rx(rx);
+        sco_rx_destroy(rx);
+    }
+    if (receive && playout) {
+        log_graph_stats(receive);
+        log_graph_stats(playout);
+    }
+    audio_graph_destroy(receive);
+    audio_graph_destroy(playout);
+    if (sp.jb) {
+        log_jitter_stats(sp.jb, acfg.sample_rate);
+        JitterStats jst;
+        jitter_buffer_get_stats(sp.jb, &jst);
+        log_plc_stats("playout", &jst.plc, acfg.sample_rate);
+        jitter_buffer_destroy(sp.jb);
+    }
+    log_wakeup_latency("Speaker", &wakeup);
+    if (sp.drift) {
+        log_clock_drift("phone", sp.drift);
+        clock_drift_destroy(sp.drift);
+    }
+    log_speaker_pace(&sp);
+    resampler_destroy(sp.rs);
+
+    uint64_t xruns = audio_stream_xruns(stream) - xruns_before;
+    if (xruns) {
+        sco_log("ℹ️ Speaker underruns: %llu", (unsigned long long)xruns);
+    }
+    if (running) audio_stream_drain(stream);  // Remote hangup: play out; stop: leave now
+    audio_stream_close(stream);
+    audio_playback = NULL;
+
+#ifdef HAVE_SBC
+    if (sp.msbc) {
+        MsbcStats st;
+        msbc_get_stats(sp.msbc, &st);
+        sco_log("ℹ️ mSBC: %llu frames, %llu lost, %llu bad, %llu bytes resync",
+                (unsigned long long)st.frames_decoded, (unsigned long long)st.frames_lost,
+                (unsigned long long)st.frames_bad, (unsigned long long)st.bytes_skipped);
+        log_plc_stats("mSBC", &st.plc, MSBC_SAMPLE_RATE);
+        msbc_destroy(sp.msbc);
+    }
+#endif
+
+    sco_log("🔇 Speaker closed");
+    return NULL;
+}
+
+// ============================================================================
+// MICROPHONE THREAD
+// ============================================================================
+
+// Paced SCO transmitter thread: same CPU / priority as the microphone thread
+static void tx_thread_init(void *data) {
+    (void)data;
+    enter_realtime("SCO TX", cfg.capture_cpu);
+}
+
+static void log_sco_tx(ScoTx *tx) {
+    ScoTxStats st;
+    sco_tx_get_stats(tx, &st);
+    if (!st.ticks) return;
+    char text[384];
+    sco_tx_format_stats(&st, text, sizeof(text));
+    sco_log("ℹ️ SCO TX: %llu packets, %s", (unsigned long long)st.packets, text);
+}
+
+// Microphone thread state, shared by its stages
+typedef struct {
+    AudioStream *stream;
+    CallRecorder *rec;               // NULL = not recording
+    ScoTx *tx;
+    Resampler *rs;
+    ClockDrift *drift;
+    AudioGain gain;
+#ifdef HAVE_SBC
+    MsbcCodec *msbc;
+    int16_t msbc_pcm[MSBC_FRAME_SAMPLES + AEC_MAX_FRAME_SAMPLES];
+    int msbc_pcm_len;
+#endif
+    int rate;
+    int read_bytes;                  // Per device read
+    int out_samples;                 // Block handed to AEC / encoder / SCO
+    int frame_samples;               // 10ms AEC frame
+    int64_t now;                     // Last read returned
+
+    int bytes_captured;
+    int latency_logged;
+    int64_t last_read_us;
+    RtLatencyHist wakeup;            // Read returns later than one period after the last
+
+    // Microphone clock -> playout/SCO clock. With AEC the far-end FIFO level
+    // shows the drift directly; without it, compare against the monotonic clock
+    int drift_from_fifo;
+    int16_t mic_pcm[AEC_MAX_FRAME_SAMPLES * 3];
+    int mic_len;
+    int64_t mic_start_us;
+    uint64_t mic_produced;
+
+    int64_t source_latency_us;
+    int64_t next_latency_poll_us;
+    AecAlignStats align;
+    int16_t render_batch[AEC_MAX_FRAME_SAMPLES * 3];  // One reference frame per mic_pcm frame
+} MicPipe;
+
+static int mic_read(void *ctx, AudioBlock *in, AudioBlock *out) {
+    (void)out;
+    MicPipe *mp = ctx;
+    if (audio_stream_read(mp->stream, in->pcm, (size_t)mp->read_bytes) < 0) {
+        if (running) {
+            sco_log("⚠️ Microphone read error");
+        }
+        return AUDIO_STAGE_ERROR;
+    }
+    int64_t now = monotonic_us();
+    if (mp->mic_start_us < 0) mp->mic_start_us = now;
+    if (mp->last_read_us >= 0) {
+        rt_hist_add(&mp->wakeup, (now - mp->last_read_us) - (int64_t)mp->read_bytes / 2 * 1000000 / mp->rate);
+    }
+    mp->last_read_us = now;
+    mp->now = now;
+
+    // Report measured source latency once the stream has settled (~1s)
+    mp->bytes_captured += mp->read_bytes;
+    if (!mp->latency_logged && mp->bytes_captured >= mp->rate * 2) {
+        int64_t latency = audio_stream_latency_us(mp->stream);
+        if (latency >= 0) {
+            sco_log("ℹ️ Microphone latency: %.1f ms", latency / 1000.0);
+        }
+        mp->latency_logged = 1;
+    }
+
+    if (aec_enabled && now >= mp->next_latency_poll_us) {
+        int64_t latency = audio_stream_latency_us(mp->stream);
+        if (latency >= 0) mp->source_latency_us = latency;
+        mp->next_latency_poll_us = now + AEC_LATENCY_POLL_US;
+    }
+
+    in->samples = mp->read_bytes / 2;
+    in->time_us = now;
+    return AUDIO_STAGE_NEXT;
+}
+
+// Drift-corrected microphone samples, passed on in whole out_samples blocks
+static int mic_resample(void *ctx, AudioBlock *in, AudioBlock *out) {
+    MicPipe *mp = ctx;
+    size_t produced = resampler_process(mp->rs, in->pcm, (size_t)in->samples, mp->mic_pcm + mp->mic_len,
+                                        sizeof(mp->mic_pcm) / sizeof(mp->mic_pcm[0]) - (size_t)mp->mic_len);
+    mp->mic_len += (int)produced;
+    mp->mic_produced += produced;
+
+    double surplus;
+    if (mp->drift_from_fifo) {
+        // Microphone too fast -> far-end FIFO drains
+        surplus = -(double)aec_fifo_level(mp->frame_samples);
+    } else {
+        surplus = (double)mp->mic_produced - (double)(mp->now - mp->mic_start_us) * mp->rate / 1e6;
+    }
+    resampler_set_ratio(mp->rs, clock_drift_update(mp->drift, surplus, mp->now));
+
+    int samples = mp->mic_len / mp->out_samples * mp->out_samples;
+    if (samples == 0 || samples > out->capacity) return AUDIO_STAGE_DONE;
+
+    // Capture time of the block: read time - source latency - what is queued here
+    out->time_us = mp->now - mp->source_latency_us - (int64_t)mp->mic_len * 1000000 / mp->rate;
+    out->samples = samples;
+    memcpy(out->pcm, mp->mic_pcm, (size_t)samples * sizeof(int16_t));
+    mp->mic_len -= samples;
+    memmove(mp->mic_pcm, mp->mic_pcm + samples, (size_t)mp->mic_len * sizeof(int16_t));
+    return AUDIO_STAGE_SWAP;
+}
+
+// Echo cancellation: every 10ms frame of the block in one call
+static int mic_aec(void *ctx, AudioBlock *in, AudioBlock *out) {
+    (void)out;
+    MicPipe *mp = ctx;
+    AecAlignStats *align = &mp->align;
+    const int frame_samples = mp->frame_samples;
+    const int64_t frame_us = 10000;
+    const int frames = in->samples / frame_samples;
+    int batch_delay_ms = align->frames ? (int)(align->delay_sum_ms / (int64_t)align->frames) : 0;
+
+    for (int k = 0; k < frames; k++) {
+        int16_t *ref = mp->render_batch + k * frame_samples;
+        int64_t cap_us = in->time_us + (int64_t)k * frame_samples * 1000000 / mp->rate;
+        int delay_ms = batch_delay_ms;
+        if (aec_fifo_pop(ref, frame_samples, cap_us, frame_us, &delay_ms, align)) {
+            if (!align->frames || delay_ms < align->delay_min_ms) align->delay_min_ms = delay_ms;
+            if (!align->frames || delay_ms > align->delay_max_ms) align->delay_max_ms = delay_ms;
+            align->delay_sum_ms += delay_ms;
+            align->frames++;
+            if (k == 0) batch_delay_ms = delay_ms;
+        } else {
+            memset(ref, 0, (size_t)frame_samples * sizeof(int16_t));
+            align->missing++;
+        }
+    }
+#ifdef HAVE_WEBRTC_APM
+    if (frames > 0) {
+        pthread_mutex_lock(&aec_mutex);
+        if (aec_handle) {
+            aec_set_stream_delay(aec_handle, batch_delay_ms);
+            aec_process_batch(aec_handle, in->pcm, mp->render_batch, frames * frame_samples);
+        }
+        pthread_mutex_unlock(&aec_mutex);
+    }
+#endif
+    return AUDIO_STAGE_NEXT;
+}
+
+static int mic_record(void *ctx, AudioBlock *in, AudioBlock *out) {
+    (void)out;
+    MicPipe *mp = ctx;
+    call_recorder_push_near(mp->rec, in->pcm, in->samples);
+    return AUDIO_STAGE_NEXT;
+}
+
+// Paced out in MTU sized packets by the TX thread
+static int mic_send(void *ctx, AudioBlock *in, AudioBlock *out) {
+    (void)out;
+    MicPipe *mp = ctx;
+    for (int i = 0; i + mp->out_samples <= in->samples; i += mp->out_samples) {
+        const int16_t *near = in->pcm + i;
+#ifdef HAVE_SBC
+        if (mp->msbc) {
+            // 10ms PCM in, 7.5ms mSBC frames out
+            uint8_t packet[MSBC_PACKET_BYTES];
+            memcpy(mp->msbc_pcm + mp->msbc_pcm_len, near, mp->out_samples * sizeof(int16_t));
+            mp->msbc_pcm_len += mp->out_samples;
+            int consumed = 0;
+            while (mp->msbc_pcm_len - consumed >= MSBC_FRAME_SAMPLES) {
+                if (msbc_encode_packet(mp->msbc, mp->msbc_pcm + consumed, packet) == MSBC_PACKET_BYTES) {
+                    sco_tx_queue(mp->tx, packet, MSBC_PACKET_BYTES);
+                }
+                consumed += MSBC_FRAME_SAMPLES;
+            }
+            mp->msbc_pcm_len -= consumed;
+            memmove(mp->msbc_pcm, mp->msbc_pcm + consumed, mp->msbc_pcm_len * sizeof(int16_t));
+            continue;
+        }
+#endif
+        sco_tx_queue(mp->tx, near, (size_t)mp->out_samples * 2);
+    }
+    return AUDIO_STAGE_NEXT;
+}
+
+// Sound card -> SCO capture thread (PC microphone to phone)
+static void* sco_capture_thread_func(void *data) {
+    (void)data;
+
+    enter_realtime("Microphone", cfg.capture_cpu);
+
+    // Audio format: mono 16-bit, 8kHz (CVSD) or 16kHz (mSBC)
+    const int codec = cfg.codec;
+    const int sco_socket = cfg.socket;
+    const int rate = sample_rate;
+    const int mtu = cfg.mtu;  // Dynamic MTU
+    const int frame_samples = rate / 100;  // 10ms AEC frame
+
+    // Device period follows what the loop reads: 10ms frames for AEC/mSBC, else one SCO packet
+    AudioStreamConfig acfg;
+    call_stream_config(&cfg, sample_rate, AUDIO_STREAM_CAPTURE, aec_enabled, &acfg);
+
+    char err[128] = "";
+    int warm_start = 0;
+    AudioStream *stream = open_call_stream(&acfg, &warm_start, err, sizeof(err));
+
+    if (!stream) {
+        sco_log("⚠️ Microphone could not be opened: %s", err);
+        return NULL;
+    }
+    audio_capture = stream;
+    const uint64_t xruns_before = audio_stream_xruns(stream);
+
+    sco_log("🎤 Microphone active - your voice going to phone (%s%s)", audio_stream_backend_name(stream),
+            warm_start ? ", warm" : "");
+
+    int remote_closed = 0;
+    int first_sent = 0;
+    MicPipe mp = {
+        .stream = stream,
+        .rec = recorder,
+        .rate = rate,
+        .frame_samples = frame_samples,
+        .read_bytes = (int)acfg.period_bytes,
+        .drift_from_fifo = aec_enabled,
+        .mic_start_us = -1,
+        .last_read_us = -1,
+    };
+    if (mp.read_bytes > AEC_MAX_FRAME_BYTES) mp.read_bytes = AEC_MAX_FRAME_BYTES;
+    mp.out_samples = mp.read_bytes / 2;
+    rt_hist_reset(&mp.wakeup);
+    audio_gain_set_db(&mp.gain, cfg.capture_gain_db);
+    int64_t next_stats_us = monotonic_us() + DRIFT_LOG_INTERVAL_US;
+
+    mp.rs = resampler_create(AEC_MAX_FRAME_SAMPLES);
+    mp.drift = clock_drift_create(rate, CLOCK_DRIFT_MAX_PPM);
+    if (!mp.rs || !mp.drift) {
+        sco_log("⚠️ Microphone resampler could not be created");
+    }
+#ifdef HAVE_SBC
+    if (codec == SCO_CODEC_MSBC) {
+        mp.msbc = msbc_create();
+        if (!mp.msbc) {
+            sco_log("⚠️ mSBC encoder could not be created");
+        }
+    }
+#endif
+
+    // SCO slot pacing: one MTU packet per interval from a queue, started
+    // once a microphone block plus one packet is buffered
+    const int tx_bytes_per_sec = codec == SCO_CODEC_MSBC ? SCO_MSBC_BYTES_PER_SEC : rate * 2;
+    const int block_ms = (int)(acfg.period_bytes / 2 * 1000 / (size_t)rate);
+    ScoTxConfig txc = {
+        .socket = sco_socket,
+        .mtu = mtu,
+        .bytes_per_sec = tx_bytes_per_sec,
+        .prefill_ms = block_ms,
+        .max_queue_ms = SCO_TX_MAX_QUEUE_MS,
+        .thread_init = tx_thread_init,
+    };
+    mp.tx = sco_tx_create(&txc);
+    if (!mp.tx) {
+        sco_log("⚠️ SCO transmitter could not be started");
+    }
+
+    AudioGraph *graph = audio_graph_create("Microphone", rate, (int)(sizeof(mp.mic_pcm) / sizeof(mp.mic_pcm[0])));
+    if (graph) {
+        audio_graph_add(graph, AUDIO_STAGE_SOURCE, "microphone", AUDIO_STAGE_WAITS, mic_read, &mp);
+        audio_graph_add(graph, AUDIO_STAGE_RESAMPLER, "drift", 0, mic_resample, &mp);
+        if (aec_enabled && mp.out_samples == frame_samples) {
+            audio_graph_add(graph, AUDIO_STAGE_AEC, "aec", 0, mic_aec, &mp);
+        }
+        if (cfg.capture_gain_db) audio_graph_add(graph, AUDIO_STAGE_GAIN, "gain", 0, audio_gain_process, &mp.gain);
+        if (mp.rec) audio_graph_add(graph, AUDIO_STAGE_TAP, "recorder", 0, mic_record, &mp);
+        audio_graph_add(graph, AUDIO_STAGE_SINK, codec == SCO_CODEC_MSBC ? "msbc-encode" : "sco-tx", 0,
+                        mic_send, &mp);
+    } else {
+        sco_log("⚠️ Microphone pipeline could not be created");
+    }
+
+    while (graph && mp.rs && mp.drift && mp.tx && running) {
+        if (sco_tx_closed(mp.tx)) {
+            sco_log("⚠️ Microphone send error: link closed");
+            remote_closed = 1;
+            break;
+        }
+        int ret = audio_graph_run(graph);
+        if (ret < 0) break;
+        if (ret > 0 && !first_sent && cfg.answer_us > 0) {
+            sco_log("⏱️ Answer to first microphone packet: %.1f ms", (mp.now - cfg.answer_us) / 1000.0);
+        }
+        first_sent |= ret > 0;
+
+        if (mp.now >= next_stats_us) {
+            log_clock_drift("microphone", mp.drift);
+            if (aec_enabled) log_aec_alignment(&mp.align);
+            log_sco_tx(mp.tx);
+            log_graph_stats(graph);
+            next_stats_us = mp.now + DRIFT_LOG_INTERVAL_US;
+        }
+    }
+
+    if (mp.tx) {
+        sco_tx_stop(mp.tx);
+        log_sco_tx(mp.tx);
+        sco_tx_destroy(mp.tx);
+    }
+    if (graph) {
+        log_graph_stats(graph);
+        audio_graph_destroy(graph);
+    }
+
+    if (mp.drift) {
+        log_clock_drift("microphone", mp.drift);
+        clock_drift_destroy(mp.drift);
+    }
+    if (aec_enabled) log_aec_alignment(&mp.align);
+    log_wakeup_latency("Microphone", &mp.wakeup);
+    resampler_destroy(mp.rs);
+
+    uint64_t xruns = audio_stream_xruns(stream) - xruns_before;
+    if (xruns) {
+        sco_log("ℹ️ Microphone overruns: %llu", (unsigned long long)xruns);
+    }
+    audio_stream_close(stream);
+    audio_capture = NULL;
+
+#ifdef HAVE_SBC
+    msbc_destroy(mp.msbc);
+#endif
+
+    sco_log("🔇 Microphone closed");
+    if (remote_closed && cfg.on_remote_closed) {
+        cfg.on_remote_closed(cfg.user_data);
+    }
+    return NULL;
+}
+
+// ============================================================================
+// CONTROL
+// ============================================================================
+
+static void thread_init_once(void) {
+    pthread_condattr_t ca;
+    pthread_condattr_init(&ca);
+    pthread_condattr_setclock(&ca, CLOCK_MONOTONIC);
+    pthread_cond_init(&thread_cond, &ca);
+    pthread_condattr_destroy(&ca);
+    stop_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+}
+
+static void thread_exited(void) {
+    pthread_mutex_lock(&thread_lock);
+    threads_alive--;
+    pthread_cond_broadcast(&thread_cond);
+    pthread_mutex_unlock(&thread_lock);
+}
+
+static void* playback_thread_main(void *data) {
+    on_audio_thread = 1;
+    sco_playback_thread_func(data);
+    thread_exited();
+    return NULL;
+}
+
+static void* capture_thread_main(void *data) {
+    on_audio_thread = 1;
+    sco_capture_thread_func(data);
+    thread_exited();
+    return NULL;
+}
+
+int sco_audio_codec_rate(int codec) {
+    return codec == SCO_CODEC_MSBC ? 16000 : 8000;
+}
+
+int sco_audio_start(const ScoAudioConfig* config) {
+    if (!config || config->socket < 0) return -1;
+
+    // Threads of the previous call must be gone before cfg changes
+    if (sco_audio_join(SCO_AUDIO_JOIN_TIMEOUT_MS) < 0) {
+        if (config->log) config->log("⚠️ Previous audio threads still running", config->user_data);
+        return -1;
+    }
+
+    pthread_mutex_lock(&join_lock);
+    first_audio_ms = -1.0;
+    cfg = *config;
+    snprintf(playback_device, sizeof(playback_device), "%s", config->playback_device ? config->playback_device : "");
+    snprintf(capture_device, sizeof(capture_device), "%s", config->capture_device ? config->capture_device : "");
+    cfg.playback_device = playback_device;
+    cfg.capture_device = capture_device;
+    sample_rate = sco_audio_codec_rate(cfg.codec);
+    apm_profile_clamp(&cfg.apm_profile);
+
+    init_webrtc_aec(&cfg, sample_rate);
+    start_recorder();
+
+    // Real-time mode: lock what is mapped now (buffers, code) once
+    static int memory_locked = 0;
+    if (cfg.realtime && !memory_locked) {
+        char msg[160];
+        memory_locked = rt_audio_lock_memory(msg, sizeof(msg)) == 0;
+        if (memory_locked) {
+            sco_log("⚡ Audio memory locked");
+        } else {
+            sco_log("%s", msg);
+        }
+    }
+
+    // Audio threads get a small fixed stack that can be locked
+    pthread_attr_t attr;
+    rt_audio_thread_attr(&attr);
+    int started = 0;
+
+    // Clear a stop signal left from the previous call (one read resets it)
+    if (stop_fd >= 0) {
+        uint64_t signaled;
+        ssize_t n = read(stop_fd, &signaled, sizeof(signaled));
+        (void)n;
+    }
+
+    // Start playback thread (phone -> PC speaker)
+    running = 1;
+    pthread_mutex_lock(&thread_lock);
+    threads_alive += 2;
+    pthread_mutex_unlock(&thread_lock);
+    if (pthread_create(&playback_thread, &attr, playback_thread_main, NULL) != 0) {
+        sco_log("⚠️ Speaker thread error");
+        thread_exited();
+    } else {
+        playback_joinable = 1;
+        started++;
+    }
+
+    // Start capture thread (PC microphone -> phone)
+    if (pthread_create(&capture_thread, &attr, capture_thread_main, NULL) != 0) {
+        sco_log("⚠️ Microphone thread error");
+        thread_exited();
+    } else {
+        capture_joinable = 1;
+        started++;
+    }
+    pthread_attr_destroy(&attr);
+    pthread_mutex_unlock(&join_lock);
+
+    if (!started) {
+        running = 0;
+        return -1;
+    }
+    return 0;
+}
+
+int sco_audio_prepare(const ScoAudioConfig* config) {
+    if (!config) return -1;
+    pthread_once(&thread_once, thread_init_once);
+
+    // One join_lock section: sco_audio_start cannot start the call threads
+    // between the check and the streams opened below
+    pthread_mutex_lock(&join_lock);
+    pthread_mutex_lock(&thread_lock);
+    int alive = threads_alive;
+    pthread_mutex_unlock(&thread_lock);
+    if (alive > 0) {  // A call is running
+        pthread_mutex_unlock(&join_lock);
+        return -1;
+    }
+
+    warm_cfg = *config;
+    warm_cfg.socket = -1;
+    warm_cfg.record_path = NULL;
+    snprintf(warm_playback_device, sizeof(warm_playback_device), "%s", config->playback_device ? config->playback_device : "");
+    snprintf(warm_capture_device, sizeof(warm_capture_device), "%s", config->capture_device ? config->capture_device : "");
+    warm_cfg.playback_device = warm_playback_device;
+    warm_cfg.capture_device = warm_capture_device;
+    int rate = sco_audio_codec_rate(warm_cfg.codec);
+    apm_profile_clamp(&warm_cfg.apm_profile);
+
+    // RING repeats every few seconds: nothing to do if the same link is ready
+    AudioStreamConfig acfg[2];
+    call_stream_config(&warm_cfg, rate, AUDIO_STREAM_PLAYBACK, aec_enabled, &acfg[AUDIO_STREAM_PLAYBACK]);
+    call_stream_config(&warm_cfg, rate, AUDIO_STREAM_CAPTURE, aec_enabled, &acfg[AUDIO_STREAM_CAPTURE]);
+    pthread_mutex_lock(&warm_lock);
+    int ready = warm_matches(&warm[AUDIO_STREAM_PLAYBACK], warm_cfg.backend, &acfg[AUDIO_STREAM_PLAYBACK]) &&
+                warm_matches(&warm[AUDIO_STREAM_CAPTURE], warm_cfg.backend, &acfg[AUDIO_STREAM_CAPTURE]);
+    pthread_mutex_unlock(&warm_lock);
+    if (ready) {
+        pthread_mutex_unlock(&join_lock);
+        return 0;
+    }
+
+    int64_t t0 = monotonic_us();
+    init_webrtc_aec(&warm_cfg, rate);
+    int opened = 0;
+    for (int d = AUDIO_STREAM_PLAYBACK; d <= AUDIO_STREAM_CAPTURE; d++) {
+        call_stream_config(&warm_cfg, rate, (AudioStreamDirection)d, aec_enabled, &acfg[d]);
+        AudioStream *stream = take_warm_stream(warm_cfg.backend, &acfg[d]);
+        char err[128] = "";
+        if (!stream) stream = audio_stream_open(warm_cfg.backend, &acfg[d], err, sizeof(err));
+        if (!stream) {
+            sco_log("⚠️ Warm start: %s could not be opened: %s", d == AUDIO_STREAM_PLAYBACK ? "speaker" : "microphone", err);
+            continue;
+        }
+        pthread_mutex_lock(&warm_lock);
+        WarmStream *w = &warm[d];
+        w->stream = stream;
+        w->config = acfg[d];
+        w->backend = warm_cfg.backend;
+        snprintf(w->device, sizeof(w->device), "%s", acfg[d].device ? acfg[d].device : "");
+        w->config.device = w->device[0] ? w->device : NULL;
+        pthread_mutex_unlock(&warm_lock);
+        opened++;
+    }
+    if (opened == 2) {
+        sco_log("🔥 Audio devices ready for the call (%s, %d Hz, %.0f ms)", audio_backend_name(warm_cfg.backend),
+                rate, (monotonic_us() - t0) / 1000.0);
+    }
+    pthread_mutex_unlock(&join_lock);
+    return opened == 2 ? 0 : -1;
+}
+
+double sco_audio_first_audio_ms(void) {
+    return first_audio_ms;
+}
+
+void sco_audio_stop(void) {
+    running = 0;
+    pthread_once(&thread_once, thread_init_once);
+    if (stop_fd >= 0) {
+        uint64_t one = 1;
+        ssize_t n = write(stop_fd, &one, sizeof(one));
+        (void)n;
+    }
+}
+
+int sco_audio_join(int timeout_ms) {
+    // An audio thread (remote-closed callback) cannot wait for itself
+    if (on_audio_thread) return -1;
+    pthread_once(&thread_once, thread_init_once);
+
+    pthread_mutex_lock(&join_lock);
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_nsec -= 1000000000L;
+        deadline.tv_sec++;
+    }
+
+    pthread_mutex_lock(&thread_lock);
+    int rc = 0;
+    while (threads_alive > 0 && rc != ETIMEDOUT) {
+        rc = pthread_cond_timedwait(&thread_cond, &thread_lock, &deadline);
+    }
+    int alive = threads_alive;
+    pthread_mutex_unlock(&thread_lock);
+
+    // Both have counted themselves out: the joins return at once
+    if (alive == 0) {
+        if (playback_joinable) pthread_join(playback_thread, NULL);
+        if (capture_joinable) pthread_join(capture_thread, NULL);
+        playback_joinable = 0;
+        capture_joinable = 0;
+    }
+    pthread_mutex_unlock(&join_lock);
+    return alive == 0 ? 0 : -1;
+}
+
+int sco_audio_running(void) {
+    return running;
+}
+
+int sco_audio_active(void) {
+    return audio_playback != NULL || audio_capture != NULL;
+}
+
+void sco_audio_set_apm_profile(const ApmProfile* profile) {
+    if (!profile) return;
+    ApmProfile p = *profile;
+    apm_profile_clamp(&p);
+    char text[96];
+    apm_profile_format(&p, text, sizeof(text));
+#ifdef HAVE_WEBRTC_APM
+    // The microphone thread holds aec_mutex per batch: the switch lands
+    // between two 10ms frames
+    pthread_mutex_lock(&aec_mutex);
+    cfg.apm_profile = p;
+    int live = aec_handle != NULL && aec_enabled;
+    int rc = live ? aec_set_profile(aec_handle, &p) : 0;
+    pthread_mutex_unlock(&aec_mutex);
+    if (!live) return;
+    if (rc == 0) {
+        sco_log("🎚️ Audio processing: %s", text);
+    } else {
+        sco_log("⚠️ Audio processing profile rejected: %s", text);
+    }
+#else
+    cfg.apm_profile = p;
+#endif
+}
+
+int sco_audio_recorder_stats(CallRecorderStats* stats) {
+    if (!stats) return -1;
+    if (recorder) {
+        call_recorder_get_stats(recorder, stats);
+        return 0;
+    }
+    if (!recorder_have_last) return -1;
+    *stats = recorder_last;
+    return 0;
+}
+
+void sco_audio_shutdown(void) {
+    finish_recorder();
+#ifdef HAVE_WEBRTC_APM
+    pthread_mutex_lock(&aec_mutex);
+    if (aec_handle) {
+        aec_destroy(aec_handle);
+        aec_handle = NULL;
+        aec_handle_rate = 0;
+    }
+    pthread_mutex_unlock(&aec_mutex);
+#endif
+    aec_enabled = 0;
+    aec_fifo_clear();
+
+    // Waits for a prepare still opening streams
+    pthread_mutex_lock(&join_lock);
+    release_warm_streams();
+    pthread_mutex_unlock(&join_lock);
+}
@@ -0,0 +1,112 @@
+#ifndef SCO_AUDIO_H
+#define SCO_AUDIO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include "apm_profile.h"
+#include "audio_backend.h"
+#include "call_recorder.h"
+
+// SCO call audio engine: speaker thread (SCO -> decoder -> drift resampler
+// -> jitter buffer / PLC -> sound card) and microphone thread (sound card ->
+// resampler -> AEC -> encoder -> SCO), each an audio_graph.h pipeline. Needs only a connected SOCK_SEQPACKET
+// socket, no GTK or BlueZ, so tools can drive it over a socketpair.
+
+// Codec IDs, same values as HFP AT+BCS
+#define SCO_CODEC_CVSD 1             // 8 kHz, 16-bit PCM over the air codec
+#define SCO_CODEC_MSBC 2             // 16 kHz, H2-framed mSBC (HAVE_SBC)
+
+// Called from the audio threads (and from sco_audio_start)
+typedef void (*ScoAudioLogFunc)(const char* msg, void* user_data);
+
+// Remote side closed the link, called from the microphone thread after it
+// released its audio stream. Must not join: hand the teardown to another thread
+typedef void (*ScoAudioClosedFunc)(void* user_data);
+
+typedef struct {
+    int socket;                      // Connected SCO (or test) socket, not owned
+    int mtu;                         // SCO packet size in bytes
+    int codec;                       // SCO_CODEC_*
+    AudioBackendType backend;
+    int latency_ms;                  // Sound card buffer target
+    const char* playback_device;     // NULL/"" = default
+    const char* capture_device;
+    int jitter_min_ms;
+    int jitter_max_ms;
+    int aec;                         // Use WebRTC AEC when built in
+    ApmProfile apm_profile;          // AEC/NS/AGC/HPF settings for the call
+    const char* record_path;         // Call recording without extension, NULL = off
+    int record_format;               // CALL_REC_*
+    int record_stereo;               // Far end left, near end right; else mixed
+    int playback_gain_db;            // Gain stages, 0 = not in the pipeline
+    int capture_gain_db;
+    int realtime;                    // Real-time priority / memory locking
+    int realtime_priority;
+    int playback_cpu;                // -1 = any
+    int capture_cpu;
+    int64_t answer_us;               // CLOCK_MONOTONIC time the call was answered, 0 = not timed
+    ScoAudioLogFunc log;
+    ScoAudioClosedFunc on_remote_closed;
+    void* user_data;
+} ScoAudioConfig;
+
+// Start both threads on config->socket; threads of a previous call are
+// joined first (SCO_AUDIO_JOIN_TIMEOUT_MS)
+// Returns 0 if at least one thread started, -1 otherwise
+int sco_audio_start(const ScoAudioConfig* config);
+
+// Warm start, while the phone rings: open the sound card streams and the
+// AEC for the link config describes (socket unused, mtu / codec as
+// expected) and keep them idle. sco_audio_start hands them to its threads
+// if the real link matches, otherwise they are reopened. May block for the
+// stream setup, call it off the UI thread. Keeps its own copy of config,
+// the running call's config is never touched. Returns 0 when both streams
+// are ready, -1 otherwise (or while a call runs)
+int sco_audio_prepare(const ScoAudioConfig* config);
+
+// Answer (config->answer_us) to the first playout tick of the current or
+// last call, -1 if not timed yet
+double sco_audio_first_audio_ms(void);
+
+#define SCO_AUDIO_JOIN_TIMEOUT_MS 1000
+
+// Ask the threads to leave their loops. Does not block, safe from any
+// thread: the speaker thread wakes at once, the microphone thread after its
+// current device read (one period)
+void sco_audio_stop(void);
+
+// Wait until both threads have exited and join them. Close the socket only
+// after this, so no thread ever touches a reused descriptor. Returns 0, or
+// -1 on timeout or when called from an audio thread (remote-closed callback)
+int sco_audio_join(int timeout_ms);
+
+// Started and not asked to stop
+int sco_audio_running(void);
+
+// A thread still holds its sound card stream
+int sco_audio_active(void);
+
+// Switch the audio processing profile; applies at once during a call,
+// otherwise from the next sco_audio_start on. Thread safe
+void sco_audio_set_apm_profile(const ApmProfile* profile);
+
+// Recorder counters of the running call, or of the last one after
+// sco_audio_shutdown. Returns 0 if there is a recording, -1 otherwise
+int sco_audio_recorder_stats(CallRecorderStats* stats);
+
+// Release the AEC instance, warm streams and finish the recording, once
+// the threads are gone
+void sco_audio_shutdown(void);
+
+// Sample rate of a codec (8000 / 16000)
+int sco_audio_codec_rate(int codec);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SCO_AUDIO_H
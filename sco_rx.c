@@ -0,0 +1,173 @@
+#define _GNU_SOURCE
+#include "sco_rx.h"
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+
+#define RX_RATE_WINDOW_US 1000000
+
+static const int64_t gap_edges_us[SCO_RX_GAP_BUCKETS - 1] = {
+    1000, 2000, 4000, 6000, 8000, 12000, 20000, 40000
+};
+
+static const char *const gap_labels[SCO_RX_GAP_BUCKETS] = {
+    "<1ms", "<2ms", "<4ms", "<6ms", "<8ms", "<12ms", "<20ms", "<40ms", ">=40ms"
+};
+
+struct ScoRx {
+    int socket;
+    int bytes_per_sec;
+    ScoRxStats stats;
+
+    int64_t last_arrival_us;         // -1 before the first packet
+    int64_t last_nominal_us;         // Nominal interval of the last packet
+    int64_t window_start_us;
+    uint64_t window_packets;
+
+    // recvmmsg() scratch, filled per call
+    struct mmsghdr msgs[SCO_RX_MAX_BATCH];
+    struct iovec iov[SCO_RX_MAX_BATCH];
+    char control[SCO_RX_MAX_BATCH][CMSG_SPACE(sizeof(struct timespec))];
+};
+
+static int64_t clock_us(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+ScoRx* sco_rx_create(int socket, int bytes_per_sec) {
+    if (socket < 0 || bytes_per_sec <= 0) return NULL;
+    ScoRx *rx = calloc(1, sizeof(ScoRx));
+    if (!rx) return NULL;
+    rx->socket = socket;
+    rx->bytes_per_sec = bytes_per_sec;
+    rx->last_arrival_us = -1;
+    rx->window_start_us = -1;
+
+    // Without kernel timestamps every packet gets its receive time
+    int on = 1;
+    setsockopt(socket, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on));
+    return rx;
+}
+
+void sco_rx_destroy(ScoRx* rx) {
+    free(rx);
+}
+
+static void account(ScoRx *rx, const ScoRxPacket *p) {
+    ScoRxStats *st = &rx->stats;
+    st->packets++;
+    st->bytes += (uint64_t)p->len;
+
+    if (rx->last_arrival_us >= 0) {
+        int64_t gap = p->arrival_us - rx->last_arrival_us;
+        int b = 0;
+        while (b < SCO_RX_GAP_BUCKETS - 1 && gap >= gap_edges_us[b]) b++;
+        st->gap_hist[b]++;
+
+        // Deviation from the nominal spacing of the previous packet
+        double d = fabs((double)(gap - rx->last_nominal_us)) / 1000.0;
+        st->jitter_ms += (d - st->jitter_ms) / 16.0;
+        if (st->jitter_ms > st->peak_jitter_ms) st->peak_jitter_ms = st->jitter_ms;
+    }
+    rx->last_arrival_us = p->arrival_us;
+    rx->last_nominal_us = (int64_t)p->len * 1000000 / rx->bytes_per_sec;
+
+    if (rx->window_start_us < 0) rx->window_start_us = p->arrival_us;
+    rx->window_packets++;
+    int64_t span = p->arrival_us - rx->window_start_us;
+    if (span >= RX_RATE_WINDOW_US) {
+        double rate = (double)(rx->window_packets - 1) * 1e6 / (double)span;
+        if (st->rate_min == 0.0 || rate < st->rate_min) st->rate_min = rate;
+        if (rate > st->rate_max) st->rate_max = rate;
+        st->rate_last = rate;
+        rx->window_start_us = p->arrival_us;
+        rx->window_packets = 1;
+    }
+}
+
+int sco_rx_recv(ScoRx* rx, ScoRxPacket* packets, int max) {
+    if (!rx || !packets || max <= 0) return -1;
+    if (max > SCO_RX_MAX_BATCH) max = SCO_RX_MAX_BATCH;
+
+    for (int i = 0; i < max; i++) {
+        rx->iov[i].iov_base = packets[i].data;
+        rx->iov[i].iov_len = sizeof(packets[i].data);
+        memset(&rx->msgs[i], 0, sizeof(rx->msgs[i]));
+        rx->msgs[i].msg_hdr.msg_iov = &rx->iov[i];
+        rx->msgs[i].msg_hdr.msg_iovlen = 1;
+        rx->msgs[i].msg_hdr.msg_control = rx->control[i];
+        rx->msgs[i].msg_hdr.msg_controllen = sizeof(rx->control[i]);
+    }
+
+    int n = recvmmsg(rx->socket, rx->msgs, (unsigned int)max, MSG_DONTWAIT, NULL);
+    if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ? 0 : -1;
+
+    // Kernel stamps are CLOCK_REALTIME: shift them onto the monotonic clock
+    const int64_t mono_now = clock_us(CLOCK_MONOTONIC);
+    const int64_t offset = clock_us(CLOCK_REALTIME) - mono_now;
+
+    int count = 0;
+    for (int i = 0; i < n; i++) {
+        if (rx->msgs[i].msg_len == 0) return count ? count : -1;  // Orderly shutdown
+        ScoRxPacket *p = &packets[count];
+        p->len = (int)rx->msgs[i].msg_len;
+        p->arrival_us = -1;
+
+        for (struct cmsghdr *c = CMSG_FIRSTHDR(&rx->msgs[i].msg_hdr); c;
+             c = CMSG_NXTHDR(&rx->msgs[i].msg_hdr, c)) {
+            if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_TIMESTAMPNS) {
+                struct timespec ts;
+                memcpy(&ts, CMSG_DATA(c), sizeof(ts));
+                p->arrival_us = (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000 - offset;
+            }
+        }
+        if (p->arrival_us < 0 || p->arrival_us > mono_now) {
+            if (p->arrival_us < 0) rx->stats.no_timestamp++;
+            p->arrival_us = mono_now;
+        }
+        account(rx, p);
+        count++;
+    }
+    if (count > 0) {
+        rx->stats.wakeups++;
+        rx->stats.batch_hist[count - 1]++;
+    }
+    return count;
+}
+
+void sco_rx_get_stats(const ScoRx* rx, ScoRxStats* stats) {
+    if (!stats) return;
+    if (!rx) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+    *stats = rx->stats;
+}
+
+void sco_rx_format_stats(const ScoRxStats* stats, char* buf, size_t len) {
+    if (!stats || !buf || !len) return;
+    int n = snprintf(buf, len, "%.0f pkt/s (%.0f..%.0f), jitter %.2f ms (peak %.2f), %.2f pkt/wakeup",
+                     stats->rate_last, stats->rate_min, stats->rate_max, stats->jitter_ms,
+                     stats->peak_jitter_ms,
+                     stats->wakeups ? (double)stats->packets / stats->wakeups : 0.0);
+    if (stats->no_timestamp && n > 0 && (size_t)n < len) {
+        n += snprintf(buf + n, len - n, ", %llu without timestamp", (unsigned long long)stats->no_timestamp);
+    }
+    if (n > 0 && (size_t)n < len) n += snprintf(buf + n, len - n, " | gaps");
+    for (int b = 0; b < SCO_RX_GAP_BUCKETS && n > 0 && (size_t)n < len; b++) {
+        if (!stats->gap_hist[b]) continue;
+        n += snprintf(buf + n, len - n, " %s:%llu", gap_labels[b], (unsigned long long)stats->gap_hist[b]);
+    }
+    if (n > 0 && (size_t)n < len) n += snprintf(buf + n, len - n, " | batch");
+    for (int b = 0; b < SCO_RX_MAX_BATCH && n > 0 && (size_t)n < len; b++) {
+        if (!stats->batch_hist[b]) continue;
+        n += snprintf(buf + n, len - n, " %d:%llu", b + 1, (unsigned long long)stats->batch_hist[b]);
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef SCO_RX_H
+#define SCO_RX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Batched SCO receive: one recvmmsg() drains every queued packet, and
+// SO_TIMESTAMPNS gives each one its kernel arrival time (converted to
+// CLOCK_MONOTONIC), so a late wakeup of the speaker thread does not look
+// like network jitter to the jitter buffer and drift estimator.
+
+#define SCO_RX_MAX_BATCH 8
+#define SCO_RX_MAX_PACKET 240
+
+typedef struct {
+    uint8_t data[SCO_RX_MAX_PACKET];
+    int len;
+    int64_t arrival_us;              // CLOCK_MONOTONIC
+} ScoRxPacket;
+
+// Inter-arrival histogram: <1, <2, <4, <6, <8, <12, <20, <40 ms, rest
+#define SCO_RX_GAP_BUCKETS 9
+
+typedef struct {
+    uint64_t packets;
+    uint64_t bytes;
+    uint64_t wakeups;                // recvmmsg() calls that returned data
+    uint64_t batch_hist[SCO_RX_MAX_BATCH];   // Packets per call: [0] = 1 ... [7] = 8
+    uint64_t gap_hist[SCO_RX_GAP_BUCKETS];
+    uint64_t no_timestamp;           // Packets without SCM_TIMESTAMPNS (receive time used)
+    double jitter_ms;                // RFC 3550 style, vs. the nominal packet interval
+    double peak_jitter_ms;
+    double rate_min;                 // Packets/s over 1s windows
+    double rate_max;
+    double rate_last;
+} ScoRxStats;
+
+typedef struct ScoRx ScoRx;
+
+// socket: connected SCO socket, not owned. SO_TIMESTAMPNS is enabled on it
+// bytes_per_sec: air byte rate, gives the nominal interval of each packet
+ScoRx* sco_rx_create(int socket, int bytes_per_sec);
+void sco_rx_destroy(ScoRx* rx);
+
+// Non-blocking: up to `max` packets that are already queued
+// Returns packet count, 0 if none, -1 if the remote closed or on error
+int sco_rx_recv(ScoRx* rx, ScoRxPacket* packets, int max);
+
+// Same thread as sco_rx_recv
+void sco_rx_get_stats(const ScoRx* rx, ScoRxStats* stats);
+
+// "333 pkt/s (331..334), jitter 0.27 ms (peak 1.03), 1.00 pkt/wakeup | gaps <4ms:3326 ... | batch 1:3331 3:1"
+void sco_rx_format_stats(const ScoRxStats* stats, char* buf, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SCO_RX_H
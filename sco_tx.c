@@ -0,0 +1,261 @@
+#define _GNU_SOURCE
+#include "sco_tx.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "audio_ring.h"
+
+#define TX_MAX_BATCH 8               // Packets owed per tick at most; older slots are skipped
+#define TX_MAX_MTU 512
+#define TX_RING_MS 200               // Producer headroom above max_queue_ms
+#define TX_STATS_INTERVAL_US 1000000
+
+struct ScoTx {
+    ScoTxConfig cfg;
+    AudioRing *ring;
+    int64_t interval_ns;
+    size_t prefill_bytes;
+    size_t max_queue_bytes;
+
+    pthread_t thread;
+    int thread_started;
+    atomic_int stop;
+    atomic_int closed;
+
+    // TX thread only
+    uint8_t pending[TX_MAX_BATCH][TX_MAX_MTU];
+    int pending_count;               // Packets taken from the ring, not yet accepted by the socket
+    ScoTxStats work;
+    double queue_sum_ms;
+    uint64_t queue_samples;
+
+    pthread_mutex_t stats_lock;
+    ScoTxStats stats;                // Published snapshot
+};
+
+static int64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static double bytes_ms(const ScoTx *tx, size_t bytes) {
+    return (double)bytes * 1000.0 / tx->cfg.bytes_per_sec;
+}
+
+// Never waits on the audio path: a busy reader just gets the previous snapshot
+static void publish_stats(ScoTx *tx, int wait) {
+    if (wait) {
+        pthread_mutex_lock(&tx->stats_lock);
+    } else if (pthread_mutex_trylock(&tx->stats_lock) != 0) {
+        return;
+    }
+    tx->work.queue_avg_ms = tx->queue_samples ? tx->queue_sum_ms / tx->queue_samples : 0.0;
+    tx->stats = tx->work;
+    pthread_mutex_unlock(&tx->stats_lock);
+}
+
+// Send what is owed this tick; returns -1 once the link is gone
+static int tx_send(ScoTx *tx, int owed) {
+    const size_t mtu = (size_t)tx->cfg.mtu;
+
+    // Cap the queue: drop the oldest whole packets
+    while (audio_ring_available(tx->ring) > tx->max_queue_bytes) {
+        audio_ring_skip(tx->ring, mtu);
+        tx->work.dropped++;
+    }
+
+    while (tx->pending_count < owed && audio_ring_available(tx->ring) >= mtu) {
+        audio_ring_read(tx->ring, tx->pending[tx->pending_count], mtu);
+        tx->pending_count++;
+    }
+
+    double depth = bytes_ms(tx, audio_ring_available(tx->ring) + (size_t)tx->pending_count * mtu);
+    tx->queue_sum_ms += depth;
+    tx->queue_samples++;
+    if (depth > tx->work.queue_max_ms) tx->work.queue_max_ms = depth;
+
+    if (tx->pending_count < owed) tx->work.starved += (uint64_t)(owed - tx->pending_count);
+    if (tx->pending_count == 0) return 0;
+
+    struct mmsghdr msgs[TX_MAX_BATCH];
+    struct iovec iov[TX_MAX_BATCH];
+    memset(msgs, 0, sizeof(msgs));
+    for (int i = 0; i < tx->pending_count; i++) {
+        iov[i].iov_base = tx->pending[i];
+        iov[i].iov_len = mtu;
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int sent = sendmmsg(tx->cfg.socket, msgs, (unsigned int)tx->pending_count, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (sent < 0) {
+        if (errno == EPIPE || errno == ENOTCONN || errno == ECONNRESET) return -1;
+        tx->work.eagain++;  // EAGAIN / ENOBUFS: keep the packets for the next tick
+        return 0;
+    }
+
+    tx->work.packets += (uint64_t)sent;
+    tx->work.batches++;
+    if ((uint64_t)sent > tx->work.max_batch) tx->work.max_batch = (uint64_t)sent;
+    tx->pending_count -= sent;
+    if (tx->pending_count > 0) {
+        memmove(tx->pending[0], tx->pending[sent], (size_t)tx->pending_count * sizeof(tx->pending[0]));
+    }
+    return 0;
+}
+
+static void* tx_thread_func(void *data) {
+    ScoTx *tx = data;
+    if (tx->cfg.thread_init) tx->cfg.thread_init(tx->cfg.user_data);
+
+    int tfd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if (tfd < 0) return NULL;
+    int64_t start = monotonic_ns() + tx->interval_ns;
+    struct itimerspec its = {
+        .it_interval = { (time_t)(tx->interval_ns / 1000000000LL), (long)(tx->interval_ns % 1000000000LL) },
+        .it_value = { (time_t)(start / 1000000000LL), (long)(start % 1000000000LL) },
+    };
+    timerfd_settime(tfd, TFD_TIMER_ABSTIME, &its, NULL);
+
+    int64_t due = start - tx->interval_ns;
+    int64_t next_publish = start + TX_STATS_INTERVAL_US * 1000LL;
+    int started = 0;
+
+    while (!atomic_load(&tx->stop)) {
+        uint64_t expirations = 0;
+        if (read(tfd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        int64_t now = monotonic_ns();
+        due += (int64_t)expirations * tx->interval_ns;
+        rt_hist_add(&tx->work.late, (now - due) / 1000);
+        tx->work.ticks++;
+        if (expirations > 1) tx->work.late_ticks++;
+
+        // Audio starts once one microphone block is queued; until then
+        // there is nothing to pace
+        if (!started) {
+            if (audio_ring_available(tx->ring) < tx->prefill_bytes) continue;
+            started = 1;
+            expirations = 1;
+        }
+
+        int owed = tx->pending_count + (int)(expirations < TX_MAX_BATCH ? expirations : TX_MAX_BATCH);
+        if (owed > TX_MAX_BATCH) owed = TX_MAX_BATCH;
+        if (tx_send(tx, owed) < 0) {
+            atomic_store(&tx->closed, 1);
+            break;
+        }
+
+        if (now >= next_publish) {
+            publish_stats(tx, 0);
+            next_publish = now + TX_STATS_INTERVAL_US * 1000LL;
+        }
+    }
+    close(tfd);
+    publish_stats(tx, 1);
+    return NULL;
+}
+
+// ============================================================================
+// API
+// ============================================================================
+
+ScoTx* sco_tx_create(const ScoTxConfig* config) {
+    if (!config || config->socket < 0 || config->mtu <= 0 || config->mtu > TX_MAX_MTU ||
+        config->bytes_per_sec <= 0) {
+        return NULL;
+    }
+
+    ScoTx *tx = calloc(1, sizeof(ScoTx));
+    if (!tx) return NULL;
+    tx->cfg = *config;
+    pthread_mutex_init(&tx->stats_lock, NULL);
+    atomic_init(&tx->stop, 0);
+    atomic_init(&tx->closed, 0);
+    rt_hist_reset(&tx->work.late);
+    tx->stats = tx->work;
+
+    const size_t mtu = (size_t)config->mtu;
+    tx->interval_ns = (int64_t)config->mtu * 1000000000LL / config->bytes_per_sec;
+    tx->prefill_bytes = (size_t)config->prefill_ms * (size_t)config->bytes_per_sec / 1000;
+    tx->prefill_bytes = tx->prefill_bytes / mtu * mtu;  // Never wait for a second block
+    if (tx->prefill_bytes < mtu) tx->prefill_bytes = mtu;
+    tx->max_queue_bytes = (size_t)config->max_queue_ms * (size_t)config->bytes_per_sec / 1000;
+    if (tx->max_queue_bytes < tx->prefill_bytes + 2 * mtu) tx->max_queue_bytes = tx->prefill_bytes + 2 * mtu;
+
+    tx->ring = audio_ring_create(tx->max_queue_bytes + (size_t)TX_RING_MS * (size_t)config->bytes_per_sec / 1000);
+    if (!tx->ring) {
+        sco_tx_destroy(tx);
+        return NULL;
+    }
+
+    pthread_attr_t attr;
+    rt_audio_thread_attr(&attr);
+    tx->thread_started = pthread_create(&tx->thread, &attr, tx_thread_func, tx) == 0;
+    pthread_attr_destroy(&attr);
+    if (!tx->thread_started) {
+        sco_tx_destroy(tx);
+        return NULL;
+    }
+    return tx;
+}
+
+void sco_tx_stop(ScoTx* tx) {
+    if (!tx || !tx->thread_started) return;
+    atomic_store(&tx->stop, 1);
+    pthread_join(tx->thread, NULL);  // Timer ticks every few ms
+    tx->thread_started = 0;
+}
+
+void sco_tx_destroy(ScoTx* tx) {
+    if (!tx) return;
+    sco_tx_stop(tx);
+    audio_ring_destroy(tx->ring);
+    pthread_mutex_destroy(&tx->stats_lock);
+    free(tx);
+}
+
+size_t sco_tx_queue(ScoTx* tx, const void* data, size_t bytes) {
+    if (!tx || !bytes) return 0;
+    return audio_ring_write(tx->ring, data, bytes);
+}
+
+int sco_tx_closed(const ScoTx* tx) {
+    return tx ? atomic_load(&((ScoTx *)tx)->closed) : 1;
+}
+
+void sco_tx_get_stats(ScoTx* tx, ScoTxStats* stats) {
+    if (!stats) return;
+    memset(stats, 0, sizeof(*stats));
+    if (!tx) return;
+    pthread_mutex_lock(&tx->stats_lock);
+    *stats = tx->stats;
+    pthread_mutex_unlock(&tx->stats_lock);
+    // Producer side: queue full is a drop too
+    stats->dropped += audio_ring_overruns(tx->ring);
+}
+
+void sco_tx_format_stats(const ScoTxStats* stats, char* buf, size_t len) {
+    if (!stats || !buf || !len) return;
+    char late[256];
+    rt_hist_format(&stats->late, late, sizeof(late));
+    snprintf(buf, len, "queue %.1f/%.1f ms, %llu late ticks, %llu starved, %llu dropped, %llu EAGAIN, "
+             "%.2f pkt/sendmmsg (max %llu) | wakeup %s",
+             stats->queue_avg_ms, stats->queue_max_ms, (unsigned long long)stats->late_ticks,
+             (unsigned long long)stats->starved, (unsigned long long)stats->dropped,
+             (unsigned long long)stats->eagain,
+             stats->batches ? (double)stats->packets / stats->batches : 0.0,
+             (unsigned long long)stats->max_batch, late);
+}
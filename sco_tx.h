@@ -0,0 +1,73 @@
+#ifndef SCO_TX_H
+#define SCO_TX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rt_audio.h"
+
+// Paced SCO transmitter: the microphone thread queues encoded bytes, a
+// timerfd-driven thread sends one MTU packet per SCO interval (MTU /
+// byte rate: 3 ms for 48 byte CVSD, 7.5 ms for 60 byte mSBC). Late ticks
+// send the packets they owe in one sendmmsg() call instead of a burst of
+// send()s, and the queue is capped so latency cannot pile up.
+
+typedef void (*ScoTxThreadInit)(void* user_data);
+
+typedef struct {
+    int socket;                      // Connected SCO socket, not owned
+    int mtu;                         // Packet size in bytes
+    int bytes_per_sec;               // Air rate: 16000 (CVSD PCM), 8000 (mSBC)
+    int prefill_ms;                  // Queue this much before the first packet
+    int max_queue_ms;                // Oldest packets dropped above this
+    ScoTxThreadInit thread_init;     // Called first in the TX thread (RT setup)
+    void* user_data;
+} ScoTxConfig;
+
+typedef struct {
+    uint64_t packets;                // Sent
+    uint64_t batches;                // sendmmsg() calls
+    uint64_t max_batch;              // Most packets in one call
+    uint64_t ticks;
+    uint64_t late_ticks;             // Timer overran: more than one interval due
+    uint64_t starved;                // Packet due but queue empty
+    uint64_t dropped;                // Packets dropped at the queue cap
+    uint64_t eagain;                 // Socket buffer full, retried next tick
+    double queue_avg_ms;             // Queue depth at send time
+    double queue_max_ms;
+    RtLatencyHist late;              // Tick wakeup vs. due time
+} ScoTxStats;
+
+typedef struct ScoTx ScoTx;
+
+// Create the queue and start the TX thread; NULL on error
+ScoTx* sco_tx_create(const ScoTxConfig* config);
+
+// Stop and join the TX thread; stats stay readable until destroy
+void sco_tx_stop(ScoTx* tx);
+
+// Stop (if needed) and free the queue
+void sco_tx_destroy(ScoTx* tx);
+
+// Microphone thread (single producer): queue bytes, never blocks
+// Returns bytes queued (0 if the queue is full)
+size_t sco_tx_queue(ScoTx* tx, const void* data, size_t bytes);
+
+// Remote closed the link (send failed with EPIPE / ENOTCONN / ECONNRESET)
+int sco_tx_closed(const ScoTx* tx);
+
+// Snapshot, refreshed about once a second by the TX thread and on exit
+void sco_tx_get_stats(ScoTx* tx, ScoTxStats* stats);
+
+// "queue 9.1/21.0 ms, 3 late, 0 starved, 0 dropped, 0 EAGAIN, 1.02 pkt/sendmmsg"
+void sco_tx_format_stats(const ScoTxStats* stats, char* buf, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SCO_TX_H
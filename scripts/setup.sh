@@ -36,6 +36,10 @@ install_packages() {
       libdbus-1-dev \
       libgtk-3-dev \
       libpulse-dev \
+      libsbc-dev \
+      libpipewire-0.3-dev \
+      libasound2-dev \
+      libsndfile1-dev \
       pkg-config \
       gcc \
       g++ \
@@ -49,6 +53,10 @@ install_packages() {
       dbus-devel \
       gtk3-devel \
       pulseaudio-libs-devel \
+      sbc-devel \
+      pipewire-devel \
+      alsa-lib-devel \
+      libsndfile-devel \
       pkgconf-pkg-config \
       gcc \
       g++ \
@@ -60,6 +68,10 @@ install_packages() {
       libdbus \
       gtk3 \
       libpulse \
+      sbc \
+      libpipewire \
+      alsa-lib \
+      libsndfile \
       pkgconf \
       gcc \
       make
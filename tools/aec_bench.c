@@ -0,0 +1,478 @@
+/*
+ * aec_bench - Offline WebRTC AEC/APM benchmark
+ * Feeds a near-end (microphone) and far-end (speaker) recording through the
+ * audio processing wrapper at each rate and profile, 10ms frame by frame,
+ * and reports echo return loss enhancement, per-frame CPU time and how
+ * much faster than real time the processing runs.
+ *
+ * ERLE = near-end energy / output energy over frames with far-end activity,
+ * after a convergence period. It is only meaningful when the near-end file
+ * is echo (plus noise) without local speech during those frames.
+ *
+ * Without WAV files a synthetic call is used: speech-like bursts on the far
+ * end, and a delayed, reverberant echo of them plus a noise floor on the
+ * near end. Deterministic, so CPU numbers can be compared between builds.
+ *
+ * Build: make bench-aec (needs webrtc-audio-processing)
+ * Run: ./tools/aec_bench [--near near.wav --far far.wav] [--rate 8000,16000]
+ *                        [--profile low-cpu,standard,full] [--delay ms]
+ *                        [--api int16|float] [--seconds n] [--output out.wav]
+ *                        [--max-p99-us n]
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../apm_profile.h"
+#include "../audio_processing_wrapper.h"
+
+#define CONVERGE_MS 2000             // Left out of ERLE
+#define FAR_ACTIVE_DBFS -40.0        // Far-end frame counts as active above this
+#define SYNTH_RATE 16000
+#define SYNTH_DELAY_MS 40            // Echo path delay of the synthetic call
+#define MAX_FRAME 480                // 10ms @ 48kHz
+
+typedef struct {
+    float *samples;                  // Mono, [-1, 1]
+    size_t count;
+    int rate;
+} Signal;
+
+typedef struct {
+    double erle_db;
+    int erle_frames;
+    double cpu_us[4];                // p50, p90, p99, max
+    double realtime_factor;
+    int errors;
+} BenchResult;
+
+// ============================================================================
+// SIGNALS
+// ============================================================================
+
+static uint32_t rng_state = 0x12345678;
+
+static double rng_uniform(void) {
+    // xorshift32: same sequence on every run
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return (double)rng_state / 4294967296.0 * 2.0 - 1.0;
+}
+
+static int signal_alloc(Signal *s, size_t count, int rate) {
+    s->samples = calloc(count ? count : 1, sizeof(float));
+    s->count = count;
+    s->rate = rate;
+    return s->samples ? 0 : -1;
+}
+
+static uint32_t rd_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static uint16_t rd_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+// PCM 16-bit or 32-bit float WAV; first channel only
+static int wav_read(const char *path, Signal *s) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    uint8_t hdr[12];
+    if (fread(hdr, 1, 12, f) != 12 || memcmp(hdr, "RIFF", 4) != 0 || memcmp(hdr + 8, "WAVE", 4) != 0) {
+        fprintf(stderr, "%s: not a WAV file\n", path);
+        fclose(f);
+        return -1;
+    }
+
+    int format = 0, channels = 0, rate = 0, bits = 0;
+    for (;;) {
+        uint8_t ch[8];
+        if (fread(ch, 1, 8, f) != 8) break;
+        uint32_t size = rd_u32(ch + 4);
+
+        if (memcmp(ch, "fmt ", 4) == 0 && size >= 16) {
+            uint8_t fmt[40] = { 0 };
+            size_t want = size < sizeof(fmt) ? size : sizeof(fmt);
+            if (fread(fmt, 1, want, f) != want) break;
+            format = rd_u16(fmt);
+            channels = rd_u16(fmt + 2);
+            rate = (int)rd_u32(fmt + 4);
+            bits = rd_u16(fmt + 14);
+            if (format == 0xFFFE && want >= 26) format = rd_u16(fmt + 24);  // WAVE_FORMAT_EXTENSIBLE
+            fseek(f, (long)(size - want + (size & 1)), SEEK_CUR);
+            continue;
+        }
+        if (memcmp(ch, "data", 4) != 0) {
+            fseek(f, (long)(size + (size & 1)), SEEK_CUR);
+            continue;
+        }
+
+        int pcm16 = format == 1 && bits == 16;
+        int float32 = format == 3 && bits == 32;
+        if (!(pcm16 || float32) || channels < 1 || rate < 8000) {
+            fprintf(stderr, "%s: need 16-bit PCM or 32-bit float, >= 8 kHz\n", path);
+            break;
+        }
+        size_t frame_bytes = (size_t)channels * (size_t)bits / 8;
+        size_t frames = size / frame_bytes;
+        uint8_t *raw = malloc(frames * frame_bytes);
+        if (!raw || signal_alloc(s, frames, rate) < 0) {
+            free(raw);
+            break;
+        }
+        frames = fread(raw, frame_bytes, frames, f);
+        s->count = frames;
+        for (size_t i = 0; i < frames; i++) {
+            const uint8_t *p = raw + i * frame_bytes;
+            if (pcm16) {
+                s->samples[i] = (int16_t)rd_u16(p) / 32768.0f;
+            } else {
+                uint32_t u = rd_u32(p);
+                float v;
+                memcpy(&v, &u, sizeof(v));
+                s->samples[i] = v;
+            }
+        }
+        free(raw);
+        fclose(f);
+        return 0;
+    }
+    fprintf(stderr, "%s: no usable audio data\n", path);
+    fclose(f);
+    return -1;
+}
+
+static void wr_u32(uint8_t *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static void wr_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+// Mono 16-bit PCM
+static int wav_write(const char *path, const int16_t *pcm, size_t count, int rate) {
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    uint32_t data = (uint32_t)(count * 2);
+    uint8_t h[44];
+    memcpy(h, "RIFF", 4);
+    wr_u32(h + 4, 36 + data);
+    memcpy(h + 8, "WAVEfmt ", 8);
+    wr_u32(h + 16, 16);
+    wr_u16(h + 20, 1);               // PCM
+    wr_u16(h + 22, 1);               // Mono
+    wr_u32(h + 24, (uint32_t)rate);
+    wr_u32(h + 28, (uint32_t)rate * 2);
+    wr_u16(h + 32, 2);               // Block align
+    wr_u16(h + 34, 16);
+    memcpy(h + 36, "data", 4);
+    wr_u32(h + 40, data);
+    int ok = fwrite(h, 1, 44, f) == 44 && fwrite(pcm, 2, count, f) == count;
+    fclose(f);
+    return ok ? 0 : -1;
+}
+
+// Linear interpolation: good enough for 8/16/48 kHz speech test material
+static int signal_resample(const Signal *in, int rate, Signal *out) {
+    size_t count = (size_t)((double)in->count * rate / in->rate);
+    if (signal_alloc(out, count, rate) < 0) return -1;
+    double step = (double)in->rate / rate;
+    for (size_t i = 0; i < count; i++) {
+        double pos = i * step;
+        size_t k = (size_t)pos;
+        double frac = pos - (double)k;
+        float a = in->samples[k];
+        float b = k + 1 < in->count ? in->samples[k + 1] : a;
+        out->samples[i] = (float)(a + (b - a) * frac);
+    }
+    return 0;
+}
+
+// Far end: band-limited noise in syllable-like bursts with pauses.
+// Near end: the far end through a 40ms delayed, decaying echo path
+// (-6 dB) plus a -60 dBFS noise floor
+static int synth_call(double seconds, Signal *near, Signal *far) {
+    size_t count = (size_t)(seconds * SYNTH_RATE);
+    if (signal_alloc(near, count, SYNTH_RATE) < 0 || signal_alloc(far, count, SYNTH_RATE) < 0) return -1;
+
+    double lp = 0.0, hp_prev = 0.0;
+    for (size_t i = 0; i < count; i++) {
+        double t = (double)i / SYNTH_RATE;
+        double syllable = 0.5 - 0.5 * cos(2.0 * M_PI * 4.0 * t);             // 4 Hz
+        double phrase = fmod(t, 3.0) < 2.0 ? 1.0 : 0.0;                     // 2s talk, 1s pause
+        lp += 0.25 * (rng_uniform() - lp);                                  // ~ 1 kHz low pass
+        double band = lp - hp_prev;                                         // Drop DC / rumble
+        hp_prev += 0.02 * (lp - hp_prev);
+        far->samples[i] = (float)(0.5 * syllable * phrase * band * 3.0);
+    }
+
+    const int delay = SYNTH_DELAY_MS * SYNTH_RATE / 1000;
+    const int taps = 30 * SYNTH_RATE / 1000;                                // 30ms tail
+    float *rir = malloc((size_t)taps * sizeof(float));
+    if (!rir) return -1;
+    for (int k = 0; k < taps; k++) {
+        rir[k] = (float)(rng_uniform() * exp(-6.0 * k / taps) * (k == 0 ? 1.0 : 0.25));
+    }
+    rir[0] = 0.5f;
+    for (size_t i = 0; i < count; i++) {
+        double echo = 0.0;
+        for (int k = 0; k < taps; k++) {
+            long j = (long)i - delay - k;
+            if (j >= 0) echo += rir[k] * far->samples[j];
+        }
+        near->samples[i] = (float)(echo + 0.001 * rng_uniform());
+    }
+    free(rir);
+    return 0;
+}
+
+// ============================================================================
+// BENCH
+// ============================================================================
+
+static int64_t cpu_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double *sorted, size_t n, double p) {
+    return sorted[(size_t)(p * (double)(n - 1) + 0.5)];
+}
+
+static int16_t to_pcm(float v) {
+    double s = v * 32768.0;
+    if (s > 32767.0) s = 32767.0;
+    if (s < -32768.0) s = -32768.0;
+    return (int16_t)lrint(s);
+}
+
+static int run_bench(const Signal *near, const Signal *far, const ApmProfile *profile, int delay_ms,
+                     int use_float, int16_t *out_pcm, BenchResult *res) {
+    memset(res, 0, sizeof(*res));
+    const int rate = near->rate;
+    const int frame = rate / 100;
+    size_t count = near->count < far->count ? near->count : far->count;
+    size_t frames = count / (size_t)frame;
+    if (frames == 0) return -1;
+
+    AecHandle *aec = aec_create_profile(rate, profile);
+    if (!aec) return -1;
+    aec_set_stream_delay(aec, delay_ms);
+
+    double *cpu = malloc(frames * sizeof(double));
+    if (!cpu) {
+        aec_destroy(aec);
+        return -1;
+    }
+
+    int16_t near16[MAX_FRAME], far16[MAX_FRAME];
+    float nearf[MAX_FRAME], farf[MAX_FRAME];
+    const double active = pow(10.0, FAR_ACTIVE_DBFS / 10.0) * frame;
+    const size_t converge = (size_t)CONVERGE_MS / 10;
+    double in_energy = 0.0, out_energy = 0.0;
+    int64_t total_ns = 0;
+
+    for (size_t n = 0; n < frames; n++) {
+        const float *np = near->samples + n * (size_t)frame;
+        const float *fp = far->samples + n * (size_t)frame;
+        double e_far = 0.0, e_in = 0.0, e_out = 0.0;
+        for (int i = 0; i < frame; i++) {
+            near16[i] = to_pcm(np[i]);
+            far16[i] = to_pcm(fp[i]);
+            nearf[i] = near16[i] / 32768.0f;  // Same input for both APIs
+            farf[i] = far16[i] / 32768.0f;
+            e_far += (double)farf[i] * farf[i];
+            e_in += (double)nearf[i] * nearf[i];
+        }
+
+        int rc;
+        int64_t t0 = cpu_ns();
+        if (use_float) {
+            float *nch[1] = { nearf };
+            const float *fch[1] = { farf };
+            rc = aec_process_float(aec, nch, fch, frame);
+        } else {
+            rc = aec_process(aec, near16, far16, frame);
+        }
+        int64_t dt = cpu_ns() - t0;
+        total_ns += dt;
+        cpu[n] = dt / 1000.0;
+        if (rc != 0) res->errors++;
+
+        for (int i = 0; i < frame; i++) {
+            int16_t s = use_float ? to_pcm(nearf[i]) : near16[i];
+            e_out += (double)s * s / (32768.0 * 32768.0);
+            if (out_pcm) out_pcm[n * (size_t)frame + (size_t)i] = s;
+        }
+        if (n >= converge && e_far > active) {
+            in_energy += e_in;
+            out_energy += e_out;
+            res->erle_frames++;
+        }
+    }
+    aec_destroy(aec);
+
+    res->erle_db = res->erle_frames ? 10.0 * log10((in_energy + 1e-12) / (out_energy + 1e-12)) : 0.0;
+    qsort(cpu, frames, sizeof(double), cmp_double);
+    res->cpu_us[0] = percentile(cpu, frames, 0.50);
+    res->cpu_us[1] = percentile(cpu, frames, 0.90);
+    res->cpu_us[2] = percentile(cpu, frames, 0.99);
+    res->cpu_us[3] = cpu[frames - 1];
+    res->realtime_factor = total_ns > 0 ? (double)frames * 10e6 / (double)total_ns : 0.0;
+    free(cpu);
+    return 0;
+}
+
+// ============================================================================
+// MAIN
+// ============================================================================
+
+static int parse_list(const char *arg, char items[][32], int max) {
+    int count = 0;
+    char copy[256];
+    snprintf(copy, sizeof(copy), "%s", arg);
+    for (char *save = NULL, *tok = strtok_r(copy, ",", &save); tok && count < max;
+         tok = strtok_r(NULL, ",", &save)) {
+        snprintf(items[count++], 32, "%s", tok);
+    }
+    return count;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [--near near.wav --far far.wav] [--rate 8000,16000]\n"
+            "          [--profile low-cpu,standard,full] [--delay ms] [--api int16|float]\n"
+            "          [--seconds n] [--output out.wav] [--max-p99-us n]\n", prog);
+}
+
+int main(int argc, char **argv) {
+    const char *near_path = NULL, *far_path = NULL, *output = NULL;
+    char rates[8][32] = { "8000", "16000" };
+    char profiles[8][32] = { "low-cpu", "standard", "full" };
+    int rate_count = 2, profile_count = 3;
+    int delay_ms = -1, use_float = 0;
+    double seconds = 20.0, max_p99_us = 0.0;
+
+    for (int i = 1; i < argc; i++) {
+        const char *opt = argv[i];
+        const char *val = i + 1 < argc ? argv[i + 1] : NULL;
+        if (!val) {
+            usage(argv[0]);
+            return 1;
+        }
+        i++;
+        if (strcmp(opt, "--near") == 0) near_path = val;
+        else if (strcmp(opt, "--far") == 0) far_path = val;
+        else if (strcmp(opt, "--rate") == 0) rate_count = parse_list(val, rates, 8);
+        else if (strcmp(opt, "--profile") == 0) profile_count = parse_list(val, profiles, 8);
+        else if (strcmp(opt, "--delay") == 0) delay_ms = atoi(val);
+        else if (strcmp(opt, "--api") == 0) use_float = strcmp(val, "float") == 0;
+        else if (strcmp(opt, "--seconds") == 0) seconds = atof(val);
+        else if (strcmp(opt, "--output") == 0) output = val;
+        else if (strcmp(opt, "--max-p99-us") == 0) max_p99_us = atof(val);
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (!near_path != !far_path || seconds <= 0.0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    Signal near = { 0 }, far = { 0 };
+    if (near_path) {
+        if (wav_read(near_path, &near) < 0 || wav_read(far_path, &far) < 0) return 1;
+        if (near.rate != far.rate) {
+            Signal tmp;
+            if (signal_resample(&far, near.rate, &tmp) < 0) return 1;
+            free(far.samples);
+            far = tmp;
+        }
+        if (delay_ms < 0) delay_ms = 0;
+        printf("Input: %s + %s, %.1f s @ %d Hz, stream delay %d ms\n", near_path, far_path,
+               (double)near.count / near.rate, near.rate, delay_ms);
+    } else {
+        if (synth_call(seconds, &near, &far) < 0) return 1;
+        if (delay_ms < 0) delay_ms = SYNTH_DELAY_MS;
+        printf("Input: synthetic call, %.1f s, %d ms echo path, stream delay %d ms\n", seconds,
+               SYNTH_DELAY_MS, delay_ms);
+    }
+
+    printf("%-6s %-10s %-5s %8s %8s %8s %8s %8s %10s\n", "rate", "profile", "api", "ERLE dB",
+           "p50 us", "p90 us", "p99 us", "max us", "x realtime");
+
+    int failures = 0, written = 0;
+    for (int r = 0; r < rate_count; r++) {
+        int rate = atoi(rates[r]);
+        Signal n = { 0 }, f = { 0 };
+        if (rate <= 0 || rate / 100 > MAX_FRAME || signal_resample(&near, rate, &n) < 0 ||
+            signal_resample(&far, rate, &f) < 0) {
+            printf("%-6s unsupported rate\n", rates[r]);
+            failures++;
+            free(n.samples);
+            free(f.samples);
+            continue;
+        }
+        int16_t *out_pcm = output && !written ? malloc(n.count * sizeof(int16_t)) : NULL;
+
+        for (int p = 0; p < profile_count; p++) {
+            ApmProfile profile;
+            if (apm_profile_preset(profiles[p], &profile) < 0) {
+                printf("%-6d %-10s unknown profile\n", rate, profiles[p]);
+                failures++;
+                continue;
+            }
+            BenchResult res;
+            if (run_bench(&n, &f, &profile, delay_ms, use_float, out_pcm, &res) < 0) {
+                printf("%-6d %-10s AEC could not be created\n", rate, profiles[p]);
+                failures++;
+                continue;
+            }
+            printf("%-6d %-10s %-5s %8.1f %8.1f %8.1f %8.1f %8.1f %10.0f", rate, profiles[p],
+                   use_float ? "float" : "int16", res.erle_db, res.cpu_us[0], res.cpu_us[1],
+                   res.cpu_us[2], res.cpu_us[3], res.realtime_factor);
+            if (res.errors) printf("  %d frame errors", res.errors);
+            if (max_p99_us > 0.0 && res.cpu_us[2] > max_p99_us) printf("  p99 over %.0f us", max_p99_us);
+            printf("\n");
+            if (res.errors || (max_p99_us > 0.0 && res.cpu_us[2] > max_p99_us)) failures++;
+
+            if (out_pcm) {
+                // First rate/profile only
+                size_t len = n.count < f.count ? n.count : f.count;
+                len -= len % (size_t)(rate / 100);
+                if (wav_write(output, out_pcm, len, rate) == 0) written = 1;
+                free(out_pcm);
+                out_pcm = NULL;
+            }
+        }
+        free(out_pcm);
+        free(n.samples);
+        free(f.samples);
+    }
+    printf("ERLE over frames with far-end activity after %d ms; CPU = thread time per 10ms frame\n",
+           CONVERGE_MS);
+    free(near.samples);
+    free(far.samples);
+    return failures ? 1 : 0;
+}
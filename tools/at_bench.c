@@ -0,0 +1,210 @@
+/*
+ * at_bench - AT line framer throughput and correctness
+ * Feeds a synthetic phone (AG) stream in RFCOMM-sized reads to the old
+ * reader (memset, one read, strstr over the blob) and to AtFramer, and
+ * counts the events each one sees against what was sent
+ *
+ * Build: make bench-at
+ * Run: ./tools/at_bench [megabytes]
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../at_framer.h"
+
+#define OLD_BUF 512                  // pc_phone_gui.c listener buffer
+#define MAX_READ 127                 // RFCOMM default MTU
+
+typedef struct {
+    const char *text;
+    int ciev, clip, ring, end;       // Events in this message
+} AgMessage;
+
+// What phones send around calls; some coalesce several codes in one packet
+static const AgMessage messages[] = {
+    { "\r\nRING\r\n", 0, 0, 1, 0 },
+    { "\r\n+CLIP: \"+905551234567\",145,,,\"Ayşe Yılmaz\"\r\n", 0, 1, 0, 0 },
+    { "\r\nRING\r\n\r\n+CLIP: \"05321112233\",129\r\n", 0, 1, 1, 0 },
+    { "\r\n+CIEV: 2,1\r\n", 1, 0, 0, 0 },
+    { "\r\n+CIEV: 1,1\r\n\r\n+CIEV: 2,0\r\n", 2, 0, 0, 0 },
+    { "\r\n+CIEV: 2,0\r\n\r\nNO CARRIER\r\n", 1, 0, 0, 1 },
+    { "\r\nNO CARRIER\r\n", 0, 0, 0, 1 },
+    { "\r\nBUSY\r\n", 0, 0, 0, 1 },
+    { "\r\nOK\r\n", 0, 0, 0, 0 },
+    { "\r\n+BCS: 2\r\n", 0, 0, 0, 0 },
+    { "\r\n+VGS: 9\r\n", 0, 0, 0, 0 },
+    { "\r\n+CIND: (\"service\",(0,1)),(\"call\",(0,1)),(\"callsetup\",(0-3)),"
+      "(\"callheld\",(0-2)),(\"signal\",(0-5)),(\"roam\",(0,1)),(\"battchg\",(0-5))\r\n\r\nOK\r\n",
+      0, 0, 0, 0 },
+};
+#define MESSAGE_COUNT (sizeof(messages) / sizeof(messages[0]))
+
+typedef struct {
+    uint64_t ciev, clip, ring, end;
+} Events;
+
+static uint64_t rng_state = 0x9e3779b97f4a7c15ULL;
+
+static uint32_t rng(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (uint32_t)(rng_state >> 32);
+}
+
+static inline uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Old listener: memset, read, strstr the blob (if/else as in the original)
+static void old_reader(const char *data, size_t len, Events *ev) {
+    char buf[OLD_BUF];
+    memset(buf, 0, sizeof(buf));
+    memcpy(buf, data, len);
+    if (strstr(buf, "+CLIP:")) ev->clip++;
+    if (strstr(buf, "RING")) ev->ring++;
+    if (strstr(buf, "+CIEV:")) {
+        ev->ciev++;
+    } else if (strstr(buf, "NO CARRIER") || strstr(buf, "BUSY") || strstr(buf, "NO ANSWER")) {
+        ev->end++;
+    }
+}
+
+static void framer_reader(AtFramer *f, const char *data, size_t len, Events *ev, uint64_t *lines) {
+    AtRecord rec;
+    at_framer_push(f, data, len);
+    while (at_framer_next(f, &rec)) {
+        (*lines)++;
+        switch (rec.keyword) {
+            case AT_KW_CIEV: ev->ciev++; break;
+            case AT_KW_CLIP: ev->clip++; break;
+            case AT_KW_RING: ev->ring++; break;
+            case AT_KW_NO_CARRIER:
+            case AT_KW_BUSY:
+            case AT_KW_NO_ANSWER: ev->end++; break;
+            default: break;
+        }
+    }
+}
+
+typedef struct {
+    const char *name;
+    int split;                       // 0: reads end on message boundaries, 1: anywhere
+} ReadMode;
+
+static const ReadMode modes[] = {
+    { "packets", 0 },
+    { "split", 1 },
+};
+
+int main(int argc, char *argv[]) {
+    size_t megabytes = 16;
+    if (argc > 1) {
+        megabytes = (size_t)atoi(argv[1]);
+        if (megabytes == 0) {
+            fprintf(stderr, "usage: %s [megabytes]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // One stream for all runs
+    size_t total = megabytes << 20;
+    char *stream = malloc(total + 512);
+    AtFramer *framer = at_framer_create();
+    if (!stream || !framer) {
+        fprintf(stderr, "allocation failed\n");
+        return 1;
+    }
+
+    Events sent = {0};
+    size_t len = 0;
+    size_t msg_ends_cap = total / 8 + 1;
+    size_t *msg_ends = malloc(msg_ends_cap * sizeof(size_t));
+    size_t msg_count = 0;
+    if (!msg_ends) {
+        fprintf(stderr, "allocation failed\n");
+        return 1;
+    }
+    while (len < total && msg_count < msg_ends_cap) {
+        const AgMessage *m = &messages[rng() % MESSAGE_COUNT];
+        size_t n = strlen(m->text);
+        memcpy(stream + len, m->text, n);
+        len += n;
+        msg_ends[msg_count++] = len;
+        sent.ciev += (uint64_t)m->ciev;
+        sent.clip += (uint64_t)m->clip;
+        sent.ring += (uint64_t)m->ring;
+        sent.end += (uint64_t)m->end;
+    }
+
+    printf("%.1f MB AG stream, %zu messages (%llu +CIEV, %llu +CLIP, %llu RING, %llu call end)\n\n",
+           len / 1048576.0, msg_count, (unsigned long long)sent.ciev, (unsigned long long)sent.clip,
+           (unsigned long long)sent.ring, (unsigned long long)sent.end);
+    printf("%-8s %-7s %9s %10s %9s %9s %9s %9s\n",
+           "reads", "reader", "MB/s", "ns/read", "+CIEV", "+CLIP", "RING", "end");
+
+    for (size_t mi = 0; mi < sizeof(modes) / sizeof(modes[0]); mi++) {
+        const ReadMode *mode = &modes[mi];
+
+        uint64_t seed = rng_state;
+        for (int reader = 0; reader < 2; reader++) {
+            Events seen = {0};
+            uint64_t lines = 0;
+            size_t nreads = 0;
+            at_framer_reset(framer);
+            rng_state = seed;  // Same cuts for both readers
+
+            uint64_t t0 = now_ns();
+            size_t pos = 0, msg = 0;
+            while (pos < len) {
+                // Whole messages (1-3 per read, within the old buffer) or arbitrary cuts
+                size_t n;
+                if (mode->split) {
+                    n = 1 + rng() % MAX_READ;
+                    if (n > len - pos) n = len - pos;
+                } else {
+                    size_t k = 1 + rng() % 3;
+                    if (msg + k > msg_count) k = msg_count - msg;
+                    if (k > 1 && msg_ends[msg + k - 1] - pos > OLD_BUF - 1) k = 1;
+                    n = msg_ends[msg + k - 1] - pos;
+                    msg += k;
+                }
+                if (reader == 0) {
+                    old_reader(stream + pos, n, &seen);
+                } else {
+                    framer_reader(framer, stream + pos, n, &seen, &lines);
+                }
+                pos += n;
+                nreads++;
+            }
+            uint64_t ns = now_ns() - t0;
+
+            printf("%-8s %-7s %9.1f %10.1f %9llu %9llu %9llu %9llu\n",
+                   mode->name, reader ? "framer" : "old",
+                   len / 1048576.0 / (ns / 1e9), (double)ns / (double)nreads,
+                   (unsigned long long)seen.ciev, (unsigned long long)seen.clip,
+                   (unsigned long long)seen.ring, (unsigned long long)seen.end);
+            if (reader == 1 && (seen.ciev != sent.ciev || seen.clip != sent.clip ||
+                                seen.ring != sent.ring || seen.end != sent.end)) {
+                fprintf(stderr, "❌ framer lost events in %s reads\n", mode->name);
+                return 1;
+            }
+        }
+    }
+
+    AtFramerStats st;
+    at_framer_get_stats(framer, &st);
+    printf("\nframer (last run): %llu lines, %llu copied at the ring wrap, %llu overlong\n",
+           (unsigned long long)st.lines, (unsigned long long)st.wrapped, (unsigned long long)st.overlong);
+
+    at_framer_destroy(framer);
+    free(msg_ends);
+    free(stream);
+    return 0;
+}
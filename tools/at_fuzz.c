@@ -0,0 +1,240 @@
+/*
+ * at_fuzz - AtFramer against a reference line splitter
+ * Each input is cut into reads of varying size (the first byte picks the
+ * cut pattern) and fed to the framer; every record must be NUL terminated,
+ * free of \r and \n, shorter than AT_LINE_MAX and match the reference:
+ * split on \r or \n, drop empty lines and lines of AT_LINE_MAX or more.
+ *
+ * Build: make fuzz-at (ASan + UBSan)
+ * Run: ./tools/at_fuzz [-n iterations] [corpus files...]
+ * libFuzzer: clang -fsanitize=fuzzer,address -DAT_FUZZ_LIBFUZZER ...
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../at_framer.h"
+
+#define MAX_INPUT (64 * 1024)
+
+static void fail(const char *what, size_t line_no) {
+    fprintf(stderr, "❌ line %zu: %s\n", line_no, what);
+    abort();
+}
+
+// Reference: next line of [*pos, len) that the framer must emit, 0 at the end
+// A trailing line without its end is never emitted
+static int reference_next(const uint8_t *data, size_t len, size_t *pos,
+                          const uint8_t **line, size_t *line_len) {
+    while (*pos < len) {
+        size_t start = *pos;
+        while (*pos < len && data[*pos] != '\r' && data[*pos] != '\n') (*pos)++;
+        if (*pos == len) return 0;
+        size_t n = *pos - start;
+        (*pos)++;
+        if (n == 0 || n >= AT_LINE_MAX) continue;
+        *line = data + start;
+        *line_len = n;
+        return 1;
+    }
+    return 0;
+}
+
+static void check_record(const AtRecord *rec, const uint8_t *data, size_t len,
+                         size_t *ref_pos, size_t line_no) {
+    if (rec->len == 0 || rec->len >= AT_LINE_MAX) fail("bad length", line_no);
+    if (rec->line[rec->len] != '\0') fail("not NUL terminated", line_no);
+    if (memchr(rec->line, '\r', rec->len) || memchr(rec->line, '\n', rec->len)) {
+        fail("line end inside the record", line_no);
+    }
+
+    const uint8_t *expect;
+    size_t expect_len;
+    if (!reference_next(data, len, ref_pos, &expect, &expect_len)) fail("extra record", line_no);
+    if (rec->len != expect_len || memcmp(rec->line, expect, expect_len) != 0) {
+        fail("record differs from the reference", line_no);
+    }
+
+    // Classification must agree with parsing the line on its own
+    const char *args;
+    AtKeyword kw = at_keyword_parse(rec->line, rec->len, &args);
+    if (kw != rec->keyword || args != rec->args) fail("keyword differs", line_no);
+    if (rec->args < rec->line || rec->args > rec->line + rec->len) fail("args outside the line", line_no);
+    if (rec->final != at_keyword_is_final(kw)) fail("final flag", line_no);
+}
+
+static void run_one(const uint8_t *data, size_t len) {
+    static AtFramer *framer;
+    if (!framer) framer = at_framer_create();
+    if (!framer) abort();
+    at_framer_reset(framer);
+    if (len == 0) return;
+
+    // First byte: cut pattern, the rest is the stream
+    uint8_t pattern = data[0];
+    data++;
+    len--;
+
+    size_t pos = 0, ref_pos = 0, lines = 0, step = 0;
+    AtRecord rec;
+    while (pos < len) {
+        size_t n;
+        switch (pattern & 3) {
+            case 0: n = 1; break;                                   // Byte by byte
+            case 1: n = 1 + ((pattern >> 2) + step * 7) % 127; break; // RFCOMM-sized
+            case 2: n = len - pos; break;                           // One write
+            default: n = 1 + (data[(pos * 31) % len] % 64); break;  // Data driven
+        }
+        if (n > len - pos) n = len - pos;
+
+        // Zero-copy path on odd steps, push on even ones
+        size_t done = 0;
+        while (done < n) {
+            size_t space;
+            char *dst = at_framer_write_ptr(framer, &space);
+            if (space == 0) {
+                // Full ring without a line end: next() must make room
+                if (at_framer_next(framer, &rec)) check_record(&rec, data, len, &ref_pos, ++lines);
+                dst = at_framer_write_ptr(framer, &space);
+                if (space == 0) fail("ring stuck full", lines);
+            }
+            size_t take = n - done < space ? n - done : space;
+            if (step & 1) {
+                memcpy(dst, data + pos + done, take);
+                at_framer_commit(framer, take);
+            } else {
+                take = at_framer_push(framer, data + pos + done, take);
+            }
+            done += take;
+            while (at_framer_next(framer, &rec)) check_record(&rec, data, len, &ref_pos, ++lines);
+        }
+        pos += n;
+        step++;
+    }
+
+    const uint8_t *expect;
+    size_t expect_len;
+    if (reference_next(data, len, &ref_pos, &expect, &expect_len)) fail("record missing", lines + 1);
+
+    AtFramerStats st;
+    at_framer_get_stats(framer, &st);
+    if (st.bytes != len || st.lines != lines) fail("stats", lines);
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    if (size <= MAX_INPUT) run_one(data, size);
+    return 0;
+}
+
+#ifndef AT_FUZZ_LIBFUZZER
+
+static uint64_t rng_state = 0x2545f4914f6cdd1dULL;
+
+static uint32_t rng(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (uint32_t)(rng_state >> 32);
+}
+
+// Tokens the mutator splices in
+static const char *const tokens[] = {
+    "\r", "\n", "\r\n", "\r\n\r\n", "OK", "ERROR", "RING", "NO CARRIER", "BUSY",
+    "+CIEV: 2,1", "+CLIP: \"123\",129", "+BCS: 2", "+CME ERROR: 3", "+CIEV:",
+    "+", ":", " ", "+CIND: (\"call\",(0,1))", "\0",
+};
+
+static size_t mutate(uint8_t *buf, size_t len, size_t cap) {
+    int rounds = 1 + rng() % 8;
+    for (int r = 0; r < rounds; r++) {
+        switch (rng() % 5) {
+            case 0:                                                  // Flip a byte
+                if (len) buf[rng() % len] = (uint8_t)rng();
+                break;
+            case 1: {                                                // Splice a token
+                const char *t = tokens[rng() % (sizeof(tokens) / sizeof(tokens[0]))];
+                size_t tl = t[0] ? strlen(t) : 1;
+                if (len + tl > cap) break;
+                size_t at = len ? rng() % (len + 1) : 0;
+                memmove(buf + at + tl, buf + at, len - at);
+                memcpy(buf + at, t, tl);
+                len += tl;
+                break;
+            }
+            case 2:                                                  // Cut a range
+                if (len > 1) {
+                    size_t at = rng() % len, n = 1 + rng() % (len - at);
+                    memmove(buf + at, buf + at + n, len - at - n);
+                    len -= n;
+                }
+                break;
+            case 3: {                                                // Long run, no line end
+                size_t n = 1 + rng() % (AT_LINE_MAX * 3);
+                if (len + n > cap) n = cap - len;
+                memset(buf + len, 'A' + rng() % 26, n);
+                len += n;
+                break;
+            }
+            default:                                                 // New cut pattern
+                if (len) buf[0] = (uint8_t)rng();
+                break;
+        }
+    }
+    return len;
+}
+
+static size_t read_file(const char *path, uint8_t *buf, size_t cap) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        exit(1);
+    }
+    size_t n = fread(buf, 1, cap, f);
+    fclose(f);
+    return n;
+}
+
+int main(int argc, char *argv[]) {
+    long iterations = 100000;
+    int first = 1;
+    if (argc > 2 && strcmp(argv[1], "-n") == 0) {
+        iterations = atol(argv[2]);
+        first = 3;
+    }
+
+    static uint8_t seed[MAX_INPUT], buf[MAX_INPUT];
+    int files = argc - first;
+    size_t runs = 0;
+
+    // Corpus as is, with every cut pattern
+    for (int i = first; i < argc; i++) {
+        size_t n = read_file(argv[i], seed + 1, sizeof(seed) - 1);
+        for (int pattern = 0; pattern < 256; pattern++) {
+            seed[0] = (uint8_t)pattern;
+            LLVMFuzzerTestOneInput(seed, n + 1);
+            runs++;
+        }
+    }
+
+    // Mutations of the corpus (or of nothing)
+    for (long it = 0; it < iterations; it++) {
+        size_t n = 1;
+        buf[0] = (uint8_t)rng();
+        if (files > 0) {
+            n = read_file(argv[first + rng() % files], buf + 1, sizeof(buf) - 1) + 1;
+        }
+        n = mutate(buf, n, sizeof(buf));
+        LLVMFuzzerTestOneInput(buf, n);
+        runs++;
+    }
+
+    printf("✅ %zu inputs (%d corpus files, %ld mutations), framer matches the reference\n",
+           runs, files, iterations);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,636 @@
+/*
+ * latency_harness - Round trip latency of the SCO audio pipeline
+ * A socketpair stands in for the SCO link: this program plays the phone,
+ * sends chirps into the speaker thread and finds them again in what the
+ * microphone thread sends back. Needs no Bluetooth hardware.
+ *
+ * The default "loopback" backend is an in-process virtual sound card, so
+ * the numbers cover jitter buffer, resamplers, framing and device buffers.
+ * Real backends need the speaker routed to the microphone, e.g.:
+ *   pactl load-module module-null-sink sink_name=pcphone_loop
+ *   ./tools/latency_harness --backend pulse,pipewire \
+ *       --playback-device pcphone_loop --capture-device pcphone_loop.monitor
+ *
+ * Build: make bench-latency
+ * Run: ./tools/latency_harness [--backend list] [--latency list] [--codec cvsd|msbc]
+ *                              [--seconds n] [--mtu bytes] [--record base] [--loss percent]
+ *                              [--cycles n] [--warm] [--verbose]
+ * --record also runs the call recorder (base_<backend>_<ms>.flac/.wav) and
+ * prints its drop counters: the audio threads must not lose anything to it.
+ * --loss drops that share of the phone's packets; with --verbose the PLC
+ * counters show how much of the call was concealed.
+ * --warm opens the sound card streams with sco_audio_prepare() before the
+ * link is up, as the GUI does on RING; "first audio" is the time from
+ * sco_audio_start() to the first playout tick either way.
+ * --cycles n (make test-cycles) instead connects and tears down the engine n
+ * times, each call a few to a few tens of ms long and every eighth ended by
+ * the phone, and fails on a join timeout or a leaked thread / descriptor.
+ */
+
+#define _GNU_SOURCE
+#include <dirent.h>
+#include <errno.h>
+#include <math.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../audio_backend.h"
+#include "../sco_audio.h"
+
+#ifdef HAVE_SBC
+#include "../msbc.h"
+#endif
+
+#define CHIRP_MS 20
+#define CHIRP_INTERVAL_MS 500
+#define WARMUP_MS 1500               // Jitter buffer / drift loop settle first
+#define DETECT_THRESHOLD 0.5         // Normalized correlation
+#define MAX_CHIRP_SAMPLES (16000 * CHIRP_MS / 1000)
+#define MAX_CHIRPS 4096
+#define CYCLE_MAX_CALL_MS 40         // Calls of 0..40 ms: some end before the streams open
+#define CYCLE_HANGUP_EVERY 8         // Every eighth call is ended by the phone
+#define CYCLE_HANGUP_WAIT_MS 100
+
+typedef struct {
+    AudioBackendType backend;
+    int latency_ms;
+    int codec;
+    int mtu;
+    int seconds;
+    const char *playback_device;
+    const char *capture_device;
+    const char *record_base;
+    double loss_pct;                 // Phone packets dropped at random (PLC test)
+    int cycles;                      // Connect / disconnect test instead of latency
+    int warm;                        // Devices opened before the link (warm start)
+    int verbose;
+} HarnessConfig;
+
+typedef struct {
+    int rate;
+    int16_t chirp[MAX_CHIRP_SAMPLES];
+    int chirp_len;
+    double chirp_energy;
+
+    // Sent chirps, oldest first
+    int64_t sent_ns[MAX_CHIRPS];
+    int sent_count;
+    int matched;                     // sent_ns[0..matched) are resolved
+    int lost;
+
+    // Received stream: last chirp_len samples and their capture times
+    int16_t rx[MAX_CHIRP_SAMPLES];
+    int64_t rx_ns[MAX_CHIRP_SAMPLES];
+    uint64_t rx_count;
+
+    // Correlation peak being tracked
+    double peak;
+    int64_t peak_ns;
+    uint64_t peak_at;
+
+    double latency_ms[MAX_CHIRPS];
+    int latency_count;
+} Probe;
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+static int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void engine_log(const char *msg, void *user_data) {
+    const HarnessConfig *hc = user_data;
+    if (hc->verbose) fprintf(stderr, "  %s\n", msg);
+}
+
+// Teardown: stop, wake the socket, join (shutdown before close, as the GUI does)
+static int engine_teardown(int sco_fd) {
+    sco_audio_stop();
+    shutdown(sco_fd, SHUT_RDWR);
+    if (sco_audio_join(SCO_AUDIO_JOIN_TIMEOUT_MS) < 0) return -1;
+    sco_audio_shutdown();
+    return 0;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double *sorted, int n, double p) {
+    int i = (int)(p * (n - 1) + 0.5);
+    return sorted[i];
+}
+
+// Hann windowed linear sweep 400 -> 3400 Hz (fits CVSD and mSBC)
+static void probe_init(Probe *pr, int rate) {
+    memset(pr, 0, sizeof(*pr));
+    pr->rate = rate;
+    pr->chirp_len = rate * CHIRP_MS / 1000;
+    const double f0 = 400.0, f1 = 3400.0, T = CHIRP_MS / 1000.0;
+    for (int i = 0; i < pr->chirp_len; i++) {
+        double t = (double)i / rate;
+        double w = 0.5 - 0.5 * cos(2.0 * M_PI * i / (pr->chirp_len - 1));
+        double v = sin(2.0 * M_PI * (f0 * t + (f1 - f0) * t * t / (2.0 * T)));
+        pr->chirp[i] = (int16_t)(12000.0 * w * v);
+        pr->chirp_energy += (double)pr->chirp[i] * pr->chirp[i];
+    }
+}
+
+// Sample n of the phone's outgoing signal: a chirp every CHIRP_INTERVAL_MS
+static int16_t probe_tx_sample(const Probe *pr, uint64_t n) {
+    uint64_t interval = (uint64_t)pr->rate * CHIRP_INTERVAL_MS / 1000;
+    uint64_t warmup = (uint64_t)pr->rate * WARMUP_MS / 1000;
+    if (n < warmup) return 0;
+    uint64_t k = (n - warmup) % interval;
+    return k < (uint64_t)pr->chirp_len ? pr->chirp[k] : 0;
+}
+
+static void probe_sent(Probe *pr, int64_t ns) {
+    if (pr->sent_count < MAX_CHIRPS) pr->sent_ns[pr->sent_count++] = ns;
+}
+
+// Chirp found in the received stream, starting at capture time ns.
+// Round trip must stay below CHIRP_INTERVAL_MS: the detection belongs to the
+// newest chirp sent before it, older unmatched ones were lost.
+static void probe_found(Probe *pr, int64_t ns) {
+    if (pr->matched >= pr->sent_count || pr->sent_ns[pr->matched] > ns) return;  // Echo of nothing
+    while (pr->matched + 1 < pr->sent_count && pr->sent_ns[pr->matched + 1] <= ns) {
+        pr->matched++;
+        pr->lost++;
+    }
+    pr->latency_ms[pr->latency_count++] = (ns - pr->sent_ns[pr->matched]) / 1e6;
+    pr->matched++;
+}
+
+// Matched filter over the received stream
+static void probe_rx_sample(Probe *pr, int16_t s, int64_t ns) {
+    int len = pr->chirp_len;
+    int slot = (int)(pr->rx_count % (uint64_t)len);
+    pr->rx[slot] = s;
+    pr->rx_ns[slot] = ns;
+    pr->rx_count++;
+    if (pr->rx_count < (uint64_t)len) return;
+
+    // Oldest sample in the window lines up with chirp[0]
+    int start = (int)(pr->rx_count % (uint64_t)len);
+    double dot = 0.0, energy = 0.0;
+    for (int i = 0; i < len; i++) {
+        double x = pr->rx[(start + i) % len];
+        dot += x * pr->chirp[i];
+        energy += x * x;
+    }
+    double c = energy > 0.0 ? dot / sqrt(energy * pr->chirp_energy) : 0.0;
+
+    if (c > DETECT_THRESHOLD && c > pr->peak) {
+        pr->peak = c;
+        pr->peak_ns = pr->rx_ns[start];
+        pr->peak_at = pr->rx_count;
+    } else if (pr->peak > 0.0 && pr->rx_count - pr->peak_at >= (uint64_t)len) {
+        probe_found(pr, pr->peak_ns);
+        pr->peak = 0.0;
+    }
+}
+
+// ============================================================================
+// PHONE SIDE
+// ============================================================================
+
+static int run_one(const HarnessConfig *hc, Probe *pr) {
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv) < 0) {
+        perror("socketpair");
+        return -1;
+    }
+
+    const int rate = sco_audio_codec_rate(hc->codec);
+    probe_init(pr, rate);
+
+    char record_path[512] = "";
+    if (hc->record_base) {
+        snprintf(record_path, sizeof(record_path), "%s_%s_%d", hc->record_base,
+                 audio_backend_name(hc->backend), hc->latency_ms);
+    }
+
+    ScoAudioConfig audio = {
+        .socket = sv[0],
+        .mtu = hc->mtu,
+        .codec = hc->codec,
+        .backend = hc->backend,
+        .latency_ms = hc->latency_ms,
+        .playback_device = hc->playback_device,
+        .capture_device = hc->capture_device,
+        .jitter_min_ms = 10,
+        .jitter_max_ms = 120,
+        .aec = 0,                    // The loop is an echo path on purpose
+        .record_path = record_path[0] ? record_path : NULL,
+        .record_format = CALL_REC_FLAC,
+        .record_stereo = 1,
+        .playback_cpu = -1,
+        .capture_cpu = -1,
+        .log = engine_log,
+        .user_data = (void *)hc,
+    };
+    if (hc->warm && sco_audio_prepare(&audio) < 0) {
+        fprintf(stderr, "warm start failed, devices open on start\n");
+    }
+    audio.answer_us = now_ns() / 1000;
+    if (sco_audio_start(&audio) < 0) {
+        close(sv[0]);
+        close(sv[1]);
+        return -1;
+    }
+
+    // Phone packet: one SCO MTU of PCM (CVSD) or one H2 mSBC frame
+    int packet_samples = hc->mtu / 2;
+#ifdef HAVE_SBC
+    MsbcCodec *msbc = NULL;
+    if (hc->codec == SCO_CODEC_MSBC) {
+        packet_samples = MSBC_FRAME_SAMPLES;
+        msbc = msbc_create();
+    }
+#endif
+    const int64_t packet_ns = (int64_t)packet_samples * 1000000000LL / rate;
+    const int64_t start = now_ns();
+    const int64_t end = start + (int64_t)hc->seconds * 1000000000LL;
+    int64_t next_send = start;
+    uint64_t tx_pos = 0;
+    const uint64_t interval = (uint64_t)rate * CHIRP_INTERVAL_MS / 1000;
+    const uint64_t warmup = (uint64_t)rate * WARMUP_MS / 1000;
+    unsigned int loss_seed = 1;
+
+    while (now_ns() < end) {
+        int64_t now = now_ns();
+        if (now >= next_send) {
+            int16_t pcm[240];
+            for (int i = 0; i < packet_samples; i++) {
+                uint64_t n = tx_pos + (uint64_t)i;
+                if (n >= warmup && (n - warmup) % interval == 0) {
+                    // Phone "plays" sample n at the packet time + offset
+                    probe_sent(pr, next_send + (int64_t)i * 1000000000LL / rate);
+                }
+                pcm[i] = probe_tx_sample(pr, n);
+            }
+            tx_pos += (uint64_t)packet_samples;
+
+            const void *payload = pcm;
+            size_t payload_len = (size_t)packet_samples * 2;
+#ifdef HAVE_SBC
+            uint8_t packet[MSBC_PACKET_BYTES];
+            if (msbc) {
+                if (msbc_encode_packet(msbc, pcm, packet) != MSBC_PACKET_BYTES) break;
+                payload = packet;
+                payload_len = MSBC_PACKET_BYTES;
+            }
+#endif
+            int drop = hc->loss_pct > 0.0 && rand_r(&loss_seed) < hc->loss_pct / 100.0 * RAND_MAX;
+            if (!drop && send(sv[1], payload, payload_len, MSG_NOSIGNAL) < 0 && errno != EAGAIN) break;
+            next_send += packet_ns;
+            continue;
+        }
+
+        struct timespec timeout = { 0, (long)(next_send - now) };
+        struct pollfd pfd = { .fd = sv[1], .events = POLLIN };
+        if (ppoll(&pfd, 1, &timeout, NULL) <= 0) continue;
+
+        uint8_t buf[512];
+        ssize_t n = recv(sv[1], buf, sizeof(buf), MSG_DONTWAIT);
+        if (n <= 0) continue;
+        int64_t rx_time = now_ns();
+
+        const int16_t *rx = (const int16_t *)buf;
+        int samples = (int)(n / 2);
+#ifdef HAVE_SBC
+        int16_t decoded[MSBC_FRAME_SAMPLES * 4];
+        if (msbc) {
+            samples = (int)msbc_decode_stream(msbc, buf, (size_t)n, decoded,
+                                              sizeof(decoded) / sizeof(decoded[0]));
+            rx = decoded;
+        }
+#endif
+        // Last sample of the packet was captured most recently
+        for (int i = 0; i < samples; i++) {
+            probe_rx_sample(pr, rx[i], rx_time - (int64_t)(samples - 1 - i) * 1000000000LL / rate);
+        }
+    }
+
+    // Chirps sent within the last interval may still be in flight
+    int64_t cutoff = now_ns() - (int64_t)CHIRP_INTERVAL_MS * 1000000;
+    while (pr->matched < pr->sent_count && pr->sent_ns[pr->matched] < cutoff) {
+        pr->matched++;
+        pr->lost++;
+    }
+
+    shutdown(sv[1], SHUT_RDWR);
+    int joined = engine_teardown(sv[0]);
+    close(sv[0]);
+    close(sv[1]);
+#ifdef HAVE_SBC
+    msbc_destroy(msbc);
+#endif
+    return joined;
+}
+
+// ============================================================================
+// CONNECT / DISCONNECT CYCLES
+// ============================================================================
+
+static atomic_int remote_closed_calls;
+static atomic_int self_joins;
+
+// Microphone thread: joining from here must be refused, not deadlock
+static void cycle_remote_closed(void *user_data) {
+    (void)user_data;
+    atomic_fetch_add(&remote_closed_calls, 1);
+    if (sco_audio_join(0) == 0) atomic_fetch_add(&self_joins, 1);
+}
+
+static int count_dir(const char *path) {
+    DIR *d = opendir(path);
+    if (!d) return -1;
+    int n = 0;
+    for (struct dirent *e; (e = readdir(d));) {
+        if (e->d_name[0] != '.') n++;
+    }
+    closedir(d);
+    return n - (strcmp(path, "/proc/self/fd") == 0);  // opendir's own descriptor
+}
+
+static int run_cycles(const HarnessConfig *hc) {
+    const int rate = sco_audio_codec_rate(hc->codec);
+    int packet_samples = hc->mtu / 2;
+#ifdef HAVE_SBC
+    MsbcCodec *msbc = NULL;
+    if (hc->codec == SCO_CODEC_MSBC) {
+        packet_samples = MSBC_FRAME_SAMPLES;
+        msbc = msbc_create();
+    }
+#endif
+    const int64_t packet_ns = (int64_t)packet_samples * 1000000000LL / rate;
+    double *teardown_ms = calloc((size_t)hc->cycles, sizeof(double));
+    if (!teardown_ms) return -1;
+
+    int threads_before = -1, fds_before = -1;
+    int done = 0, timeouts = 0, start_failures = 0, hangups = 0;
+
+    for (int c = 0; c < hc->cycles; c++) {
+        int sv[2];
+        if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv) < 0) {
+            perror("socketpair");
+            break;
+        }
+        char record_path[512] = "";
+        if (hc->record_base) snprintf(record_path, sizeof(record_path), "%s_cycle", hc->record_base);
+
+        ScoAudioConfig audio = {
+            .socket = sv[0],
+            .mtu = hc->mtu,
+            .codec = hc->codec,
+            .backend = hc->backend,
+            .latency_ms = hc->latency_ms,
+            .playback_device = hc->playback_device,
+            .capture_device = hc->capture_device,
+            .jitter_min_ms = 10,
+            .jitter_max_ms = 120,
+            .record_path = record_path[0] ? record_path : NULL,
+            .record_format = CALL_REC_WAV,
+            .playback_cpu = -1,
+            .capture_cpu = -1,
+            .log = engine_log,
+            .on_remote_closed = cycle_remote_closed,
+            .user_data = (void *)hc,
+        };
+        if (sco_audio_start(&audio) < 0) {
+            start_failures++;
+            close(sv[0]);
+            close(sv[1]);
+            continue;
+        }
+
+        // Phone sends silence for a while, then one of the sides hangs up
+        const int64_t end = now_ns() + (int64_t)(c * 7 % (CYCLE_MAX_CALL_MS + 1)) * 1000000;
+        for (int64_t next = now_ns(); next < end; next += packet_ns) {
+            int16_t pcm[240] = { 0 };
+            const void *payload = pcm;
+            size_t payload_len = (size_t)packet_samples * 2;
+#ifdef HAVE_SBC
+            uint8_t packet[MSBC_PACKET_BYTES];
+            if (msbc && msbc_encode_packet(msbc, pcm, packet) == MSBC_PACKET_BYTES) {
+                payload = packet;
+                payload_len = MSBC_PACKET_BYTES;
+            }
+#endif
+            send(sv[1], payload, payload_len, MSG_NOSIGNAL | MSG_DONTWAIT);
+            uint8_t drain[512];  // What the microphone side sends back
+            while (recv(sv[1], drain, sizeof(drain), MSG_DONTWAIT) > 0) continue;
+            int64_t wait = next + packet_ns - now_ns();
+            if (wait > 0) {
+                struct timespec ts = { 0, (long)wait };
+                nanosleep(&ts, NULL);
+            }
+        }
+        if (c % CYCLE_HANGUP_EVERY == CYCLE_HANGUP_EVERY - 1) {
+            // Give the microphone thread time to notice and call back
+            int seen = atomic_load(&remote_closed_calls);
+            shutdown(sv[1], SHUT_RDWR);
+            for (int i = 0; i < CYCLE_HANGUP_WAIT_MS && atomic_load(&remote_closed_calls) == seen; i++) {
+                usleep(1000);
+            }
+            hangups++;
+        }
+
+        int64_t t0 = now_ns();
+        int rc = engine_teardown(sv[0]);
+        double ms = (now_ns() - t0) / 1e6;
+        close(sv[0]);
+        close(sv[1]);
+        if (rc < 0) {
+            fprintf(stderr, "cycle %d: audio threads did not stop in %d ms\n", c, SCO_AUDIO_JOIN_TIMEOUT_MS);
+            timeouts++;
+            break;                   // Later starts would only be refused
+        }
+        teardown_ms[done++] = ms;
+
+        // Baseline after the first call: the engine keeps its stop eventfd
+        if (c == 0) {
+            threads_before = count_dir("/proc/self/task");
+            fds_before = count_dir("/proc/self/fd");
+        }
+    }
+
+    const int threads_after = count_dir("/proc/self/task");
+    const int fds_after = count_dir("/proc/self/fd");
+
+    printf("Connect / disconnect: %d of %d cycles (%s, %s, %d ms buffer), %d phone hangups, "
+           "%d remote-closed callbacks\n", done, hc->cycles, audio_backend_name(hc->backend),
+           hc->codec == SCO_CODEC_MSBC ? "msbc" : "cvsd", hc->latency_ms, hangups,
+           atomic_load(&remote_closed_calls));
+    if (done > 0) {
+        qsort(teardown_ms, (size_t)done, sizeof(double), cmp_double);
+        printf("  teardown (stop -> joined): p50 %.2f ms, p99 %.2f ms, max %.2f ms\n",
+               percentile(teardown_ms, done, 0.50), percentile(teardown_ms, done, 0.99), teardown_ms[done - 1]);
+    }
+    printf("  threads %d -> %d, descriptors %d -> %d, join timeouts %d, start failures %d, self joins %d\n",
+           threads_before, threads_after, fds_before, fds_after, timeouts, start_failures,
+           atomic_load(&self_joins));
+
+    free(teardown_ms);
+#ifdef HAVE_SBC
+    msbc_destroy(msbc);
+#endif
+    int ok = done == hc->cycles && threads_after == threads_before && fds_after == fds_before &&
+             atomic_load(&self_joins) == 0;
+    printf("%s\n", ok ? "OK" : "FAILED");
+    return ok ? 0 : -1;
+}
+
+// ============================================================================
+// MAIN
+// ============================================================================
+
+static void report(const HarnessConfig *hc, Probe *pr) {
+    printf("%-13s %5d ms  %-5s %6d %5d", audio_backend_name(hc->backend), hc->latency_ms,
+           hc->codec == SCO_CODEC_MSBC ? "msbc" : "cvsd", pr->latency_count, pr->lost);
+    int n = pr->latency_count;
+    if (n == 0) {
+        printf("   (no chirp came back)\n");
+        return;
+    }
+
+    double mean = 0.0;
+    for (int i = 0; i < n; i++) mean += pr->latency_ms[i];
+    mean /= n;
+    double var = 0.0;
+    for (int i = 0; i < n; i++) var += (pr->latency_ms[i] - mean) * (pr->latency_ms[i] - mean);
+    double jitter = sqrt(var / n);
+
+    qsort(pr->latency_ms, (size_t)n, sizeof(double), cmp_double);
+    printf(" %8.1f %8.1f %8.1f %8.1f %8.2f\n", percentile(pr->latency_ms, n, 0.50),
+           percentile(pr->latency_ms, n, 0.99), pr->latency_ms[0], pr->latency_ms[n - 1], jitter);
+    printf("  first audio %.1f ms after start (%s)\n", sco_audio_first_audio_ms(),
+           hc->warm ? "warm devices" : "devices opened on start");
+}
+
+static int report_recorder(void) {
+    CallRecorderStats st;
+    if (sco_audio_recorder_stats(&st) < 0) return 0;
+    printf("  recorder: %llu frames, dropped far %llu / near %llu, peak ring %d/%d of %d ms, %llu padded\n",
+           (unsigned long long)st.frames_written, (unsigned long long)st.far_dropped,
+           (unsigned long long)st.near_dropped, st.far_peak_ms, st.near_peak_ms, st.ring_ms,
+           (unsigned long long)st.gap_samples);
+    return st.far_dropped || st.near_dropped || st.write_errors ? -1 : 0;
+}
+
+static int parse_list(const char *arg, char items[][32], int max) {
+    int count = 0;
+    char copy[256];
+    snprintf(copy, sizeof(copy), "%s", arg);
+    for (char *save = NULL, *tok = strtok_r(copy, ",", &save); tok && count < max;
+         tok = strtok_r(NULL, ",", &save)) {
+        snprintf(items[count++], 32, "%s", tok);
+    }
+    return count;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [--backend loopback,pulse,...] [--latency 10,20,40] [--codec cvsd|msbc]\n"
+            "          [--seconds n] [--mtu bytes] [--playback-device name] [--capture-device name]\n"
+            "          [--record base] [--loss percent] [--cycles n] [--warm] [--verbose]\n", prog);
+}
+
+int main(int argc, char **argv) {
+    char backends[8][32] = { "loopback" };
+    char latencies[8][32] = { "10", "20", "40" };
+    int backend_count = 1, latency_count = 3;
+    HarnessConfig hc = {
+        .codec = SCO_CODEC_CVSD,
+        .mtu = 48,
+        .seconds = 10,
+    };
+
+    for (int i = 1; i < argc; i++) {
+        const char *opt = argv[i];
+        const char *val = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(opt, "--verbose") == 0) {
+            hc.verbose = 1;
+            continue;
+        }
+        if (strcmp(opt, "--warm") == 0) {
+            hc.warm = 1;
+            continue;
+        }
+        if (!val) {
+            usage(argv[0]);
+            return 1;
+        }
+        i++;
+        if (strcmp(opt, "--backend") == 0) backend_count = parse_list(val, backends, 8);
+        else if (strcmp(opt, "--latency") == 0) latency_count = parse_list(val, latencies, 8);
+        else if (strcmp(opt, "--codec") == 0) hc.codec = strcmp(val, "msbc") == 0 ? SCO_CODEC_MSBC : SCO_CODEC_CVSD;
+        else if (strcmp(opt, "--seconds") == 0) hc.seconds = atoi(val);
+        else if (strcmp(opt, "--mtu") == 0) hc.mtu = atoi(val);
+        else if (strcmp(opt, "--playback-device") == 0) hc.playback_device = val;
+        else if (strcmp(opt, "--capture-device") == 0) hc.capture_device = val;
+        else if (strcmp(opt, "--record") == 0) hc.record_base = val;
+        else if (strcmp(opt, "--loss") == 0) hc.loss_pct = atof(val);
+        else if (strcmp(opt, "--cycles") == 0) hc.cycles = atoi(val);
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+#ifndef HAVE_SBC
+    if (hc.codec == SCO_CODEC_MSBC) {
+        fprintf(stderr, "mSBC needs a build with libsbc\n");
+        return 1;
+    }
+#endif
+    if (hc.seconds * 1000 < WARMUP_MS + CHIRP_INTERVAL_MS || hc.mtu <= 0 || hc.mtu > 480) {
+        usage(argv[0]);
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    if (hc.cycles > 0) {
+        hc.backend = audio_backend_from_name(backends[0]);
+        hc.latency_ms = atoi(latencies[0]);
+        return run_cycles(&hc) < 0 ? 1 : 0;
+    }
+
+    printf("Round trip: phone -> speaker thread -> sound card -> microphone thread -> phone\n");
+    printf("%-13s %8s  %-5s %6s %5s %8s %8s %8s %8s %8s\n", "backend", "buffer", "codec", "chirps", "lost",
+           "p50 ms", "p99 ms", "min ms", "max ms", "jitter");
+
+    static Probe probe;
+    int failures = 0;
+    for (int b = 0; b < backend_count; b++) {
+        hc.backend = audio_backend_from_name(backends[b]);
+        for (int l = 0; l < latency_count; l++) {
+            hc.latency_ms = atoi(latencies[l]);
+            int rc = run_one(&hc, &probe);
+            if (rc < 0) {
+                printf("%-13s %5d ms  engine did not %s\n", backends[b], hc.latency_ms,
+                       probe.sent_count ? "stop" : "start");
+                failures++;
+                continue;
+            }
+            report(&hc, &probe);
+            if (probe.latency_count == 0) failures++;
+            if (report_recorder() < 0) failures++;
+        }
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,259 @@
+/*
+ * reactor_bench - HFP control plane: per-link threads vs one epoll reactor
+ * Two AT links over socketpairs (listener and dial, as in pc_phone_gui.c).
+ * "threads" is the old layout: a thread per link around at_engine_pump()
+ * with the 1000 / 500 ms timeouts. "reactor" is IoReactor with the engines
+ * in event loop mode. Measured: wakeups per minute on idle links, +CIEV
+ * write-to-handler latency, and the time to stop.
+ *
+ * Build: make bench-reactor
+ * Run: ./tools/reactor_bench [idle_seconds] [events]
+ */
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../at_engine.h"
+#include "../io_reactor.h"
+
+#define LINK_COUNT 2
+
+typedef struct {
+    const char *name;
+    int timeout_ms;                  // Old thread's pump timeout
+    int fds[2];                      // [0] engine side, [1] phone side
+    AtEngine *at;
+    pthread_t thread;
+    volatile int running;
+    uint64_t wakeups;
+} Link;
+
+static Link links[LINK_COUNT] = {
+    { .name = "listen", .timeout_ms = 1000 },
+    { .name = "dial", .timeout_ms = 500 },
+};
+
+static uint64_t *sent_ns;
+static uint64_t *latency_ns;
+static volatile uint64_t received;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void sleep_us(long us) {
+    struct timespec ts = { us / 1000000, (us % 1000000) * 1000 };
+    nanosleep(&ts, NULL);
+}
+
+// +CIEV: 2,<sequence>
+static void on_ciev(const AtRecord *rec, void *user_data) {
+    (void)user_data;
+    const char *comma = strchr(rec->args, ',');
+    if (!comma) return;
+    long seq = atol(comma + 1);
+    latency_ns[seq] = now_ns() - sent_ns[seq];
+    __atomic_add_fetch(&received, 1, __ATOMIC_RELAXED);
+}
+
+static const AtHandler handlers[] = {
+    { AT_KW_CIEV, on_ciev },
+};
+
+static void links_open(int event_loop) {
+    for (int i = 0; i < LINK_COUNT; i++) {
+        Link *l = &links[i];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, l->fds) < 0) {
+            perror("socketpair");
+            exit(1);
+        }
+        AtEngineConfig cfg = {
+            .name = l->name,
+            .handlers = handlers,
+            .handler_count = 1,
+            .event_loop = event_loop,
+        };
+        l->at = at_engine_create(&cfg);
+        at_engine_attach(l->at, l->fds[0]);
+        l->wakeups = 0;
+    }
+}
+
+static void links_close(void) {
+    for (int i = 0; i < LINK_COUNT; i++) {
+        at_engine_destroy(links[i].at);
+        close(links[i].fds[0]);
+        close(links[i].fds[1]);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Old layout: incoming_call_listener / hfp_monitor_thread
+// ----------------------------------------------------------------------------
+
+static void* link_thread(void *data) {
+    Link *l = data;
+    while (l->running) {
+        int ret = at_engine_pump(l->at, l->timeout_ms);
+        __atomic_add_fetch(&l->wakeups, 1, __ATOMIC_RELAXED);
+        if (ret < 0) break;
+    }
+    return NULL;
+}
+
+static void threads_start(void) {
+    for (int i = 0; i < LINK_COUNT; i++) {
+        links[i].running = 1;
+        pthread_create(&links[i].thread, NULL, link_thread, &links[i]);
+    }
+}
+
+static uint64_t threads_wakeups(void) {
+    uint64_t total = 0;
+    for (int i = 0; i < LINK_COUNT; i++) total += __atomic_load_n(&links[i].wakeups, __ATOMIC_RELAXED);
+    return total;
+}
+
+// As stop_incoming_call_listener() / hfp_close(): flag, shutdown, join
+static void threads_stop(void) {
+    for (int i = 0; i < LINK_COUNT; i++) {
+        links[i].running = 0;
+        at_engine_detach(links[i].at);
+        shutdown(links[i].fds[0], SHUT_RDWR);
+    }
+    for (int i = 0; i < LINK_COUNT; i++) pthread_join(links[i].thread, NULL);
+}
+
+// ----------------------------------------------------------------------------
+// Reactor
+// ----------------------------------------------------------------------------
+
+static IoReactor *reactor;
+
+static void on_data(int fd, uint32_t events, void *user_data) {
+    (void)events;
+    if (at_engine_process(user_data) < 0) io_reactor_remove(reactor, fd);
+}
+
+static void on_timer(int fd, uint32_t events, void *user_data) {
+    (void)fd; (void)events;
+    at_engine_expire(user_data);
+}
+
+static void reactor_start(void) {
+    reactor = io_reactor_create("bench-io");
+    if (!reactor) {
+        fprintf(stderr, "io_reactor_create failed\n");
+        exit(1);
+    }
+    for (int i = 0; i < LINK_COUNT; i++) {
+        io_reactor_add(reactor, links[i].fds[0], EPOLLIN, on_data, links[i].at);
+        io_reactor_add(reactor, at_engine_timer_fd(links[i].at), EPOLLIN, on_timer, links[i].at);
+    }
+}
+
+static uint64_t reactor_wakeups(void) {
+    IoReactorStats st;
+    io_reactor_get_stats(reactor, &st);
+    return st.wakeups;
+}
+
+static void reactor_stop(void) {
+    io_reactor_destroy(reactor);
+    reactor = NULL;
+}
+
+// ----------------------------------------------------------------------------
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+typedef struct {
+    const char *name;
+    void (*start)(void);
+    uint64_t (*wakeups)(void);
+    void (*stop)(void);
+    int event_loop;
+} Model;
+
+static const Model models[] = {
+    { "threads", threads_start, threads_wakeups, threads_stop, 0 },
+    { "reactor", reactor_start, reactor_wakeups, reactor_stop, 1 },
+};
+
+int main(int argc, char *argv[]) {
+    int idle_s = argc > 1 ? atoi(argv[1]) : 5;
+    long events = argc > 2 ? atol(argv[2]) : 2000;
+    if (idle_s <= 0 || events <= 0) {
+        fprintf(stderr, "usage: %s [idle_seconds] [events]\n", argv[0]);
+        return 1;
+    }
+    sent_ns = calloc((size_t)events, sizeof(uint64_t));
+    latency_ns = calloc((size_t)events, sizeof(uint64_t));
+    if (!sent_ns || !latency_ns) return 1;
+
+    printf("%d links, %d s idle, %ld +CIEV events\n\n", LINK_COUNT, idle_s, events);
+    printf("%-8s %14s %10s %10s %10s %9s\n", "model", "idle wake/min", "p50 us", "p99 us", "max us", "stop ms");
+
+    int failed = 0;
+    for (size_t m = 0; m < sizeof(models) / sizeof(models[0]); m++) {
+        const Model *model = &models[m];
+        links_open(model->event_loop);
+        model->start();
+
+        // Idle links: every wakeup is a timeout
+        sleep_us(100000);
+        uint64_t w0 = model->wakeups();
+        sleep_us((long)idle_s * 1000000L);
+        double per_min = (double)(model->wakeups() - w0) * 60.0 / idle_s;
+
+        // Events on alternating links, 0-400 us apart
+        received = 0;
+        memset(latency_ns, 0, (size_t)events * sizeof(uint64_t));
+        unsigned seed = 1;
+        for (long i = 0; i < events; i++) {
+            char line[48];
+            int len = snprintf(line, sizeof(line), "\r\n+CIEV: 2,%ld\r\n", i);
+            sent_ns[i] = now_ns();
+            if (write(links[i % LINK_COUNT].fds[1], line, (size_t)len) != len) {
+                perror("write");
+                return 1;
+            }
+            sleep_us(rand_r(&seed) % 400);
+        }
+        uint64_t deadline = now_ns() + 2000000000ULL;
+        while (__atomic_load_n(&received, __ATOMIC_RELAXED) < (uint64_t)events && now_ns() < deadline) {
+            sleep_us(1000);
+        }
+        uint64_t got = __atomic_load_n(&received, __ATOMIC_RELAXED);
+
+        uint64_t t0 = now_ns();
+        model->stop();
+        double stop_ms = (now_ns() - t0) / 1e6;
+
+        qsort(latency_ns, (size_t)events, sizeof(uint64_t), cmp_u64);
+        printf("%-8s %14.1f %10.1f %10.1f %10.1f %9.2f\n", model->name, per_min,
+               latency_ns[events / 2] / 1e3, latency_ns[(size_t)(events * 0.99)] / 1e3,
+               latency_ns[events - 1] / 1e3, stop_ms);
+        if (got != (uint64_t)events) {
+            fprintf(stderr, "❌ %s: %llu of %ld events handled\n", model->name, (unsigned long long)got, events);
+            failed = 1;
+        }
+        links_close();
+    }
+
+    free(sent_ns);
+    free(latency_ns);
+    return failed;
+}
@@ -0,0 +1,199 @@
+/*
+ * ring_bench - AEC far-end FIFO microbenchmark
+ * Compares the old mutex FIFO (per-sample copy + modulo) with AudioRing
+ *
+ * Build: make bench-ring
+ * Run: ./tools/ring_bench [chunks]
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../audio_ring.h"
+
+#define FRAME_SAMPLES 80                     // 10ms @ 8kHz (capture side)
+#define CHUNK_SAMPLES 24                     // 48 byte SCO packet (playback side)
+#define FIFO_CAPACITY (FRAME_SAMPLES * 50)
+#define LAT_BUCKET_NS 10
+#define LAT_BUCKETS 10000                    // 10ns buckets, last one = overflow
+
+// ----------------------------------------------------------------------------
+// Old implementation (copied from pc_phone_gui.c before the ring)
+// The bench refuses a push instead of overwriting so both sides move the
+// same amount of audio.
+// ----------------------------------------------------------------------------
+
+static pthread_mutex_t fifo_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int16_t fifo[FIFO_CAPACITY];
+static int fifo_head = 0;
+static int fifo_tail = 0;
+static int fifo_size = 0;
+
+static int mutex_fifo_push(const int16_t *samples, int count) {
+    pthread_mutex_lock(&fifo_mutex);
+    if (FIFO_CAPACITY - fifo_size < count) {
+        pthread_mutex_unlock(&fifo_mutex);
+        return 0;
+    }
+    for (int i = 0; i < count; i++) {
+        fifo[fifo_head] = samples[i];
+        fifo_head = (fifo_head + 1) % FIFO_CAPACITY;
+        if (fifo_size < FIFO_CAPACITY) {
+            fifo_size++;
+        } else {
+            fifo_tail = (fifo_tail + 1) % FIFO_CAPACITY;
+        }
+    }
+    pthread_mutex_unlock(&fifo_mutex);
+    return 1;
+}
+
+static int mutex_fifo_pop(int16_t *out, int count) {
+    int ok = 0;
+    pthread_mutex_lock(&fifo_mutex);
+    if (fifo_size >= count) {
+        for (int i = 0; i < count; i++) {
+            out[i] = fifo[fifo_tail];
+            fifo_tail = (fifo_tail + 1) % FIFO_CAPACITY;
+        }
+        fifo_size -= count;
+        ok = 1;
+    }
+    pthread_mutex_unlock(&fifo_mutex);
+    return ok;
+}
+
+// ----------------------------------------------------------------------------
+// Harness
+// ----------------------------------------------------------------------------
+
+typedef struct {
+    const char *name;
+    int (*push)(const int16_t *samples, int count);
+    int (*pop)(int16_t *out, int count);
+} FifoImpl;
+
+static AudioRing *ring = NULL;
+
+static int ring_push(const int16_t *samples, int count) {
+    return audio_ring_write(ring, samples, (size_t)count * sizeof(int16_t)) > 0;
+}
+
+static int ring_pop(int16_t *out, int count) {
+    return audio_ring_read(ring, out, (size_t)count * sizeof(int16_t)) > 0;
+}
+
+static const FifoImpl impls[] = {
+    { "mutex fifo", mutex_fifo_push, mutex_fifo_pop },
+    { "spsc ring",  ring_push,       ring_pop },
+};
+
+// Multiple of both chunk and frame size so the consumer drains everything
+static long chunks_total = 10000000;
+static const FifoImpl *current;
+
+static inline uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void *producer_func(void *data) {
+    (void)data;
+    int16_t chunk[CHUNK_SAMPLES];
+    for (int i = 0; i < CHUNK_SAMPLES; i++) chunk[i] = (int16_t)i;
+
+    for (long i = 0; i < chunks_total; i++) {
+        while (!current->push(chunk, CHUNK_SAMPLES)) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static uint64_t percentile(const uint64_t *hist, uint64_t total, double p) {
+    uint64_t target = (uint64_t)(total * p);
+    uint64_t seen = 0;
+    for (int i = 0; i < LAT_BUCKETS; i++) {
+        seen += hist[i];
+        if (seen > target) return (uint64_t)i * LAT_BUCKET_NS;
+    }
+    return (uint64_t)LAT_BUCKETS * LAT_BUCKET_NS;
+}
+
+static void run(const FifoImpl *impl) {
+    static uint64_t hist[LAT_BUCKETS];
+    memset(hist, 0, sizeof(hist));
+    current = impl;
+
+    int16_t frame[FRAME_SAMPLES];
+    const uint64_t frames_total = (uint64_t)chunks_total * CHUNK_SAMPLES / FRAME_SAMPLES;
+    uint64_t pops = 0, empty = 0, max_ns = 0;
+
+    pthread_t producer;
+    uint64_t start = now_ns();
+    pthread_create(&producer, NULL, producer_func, NULL);
+
+    while (pops < frames_total) {
+        uint64_t t0 = now_ns();
+        int ok = impl->pop(frame, FRAME_SAMPLES);
+        uint64_t dt = now_ns() - t0;
+
+        if (!ok) {
+            empty++;
+            sched_yield();
+            continue;
+        }
+        pops++;
+
+        uint64_t bucket = dt / LAT_BUCKET_NS;
+        hist[bucket < LAT_BUCKETS ? bucket : LAT_BUCKETS - 1]++;
+        if (dt > max_ns) max_ns = dt;
+    }
+
+    pthread_join(producer, NULL);
+    double secs = (now_ns() - start) / 1e9;
+    double mbytes = (double)chunks_total * CHUNK_SAMPLES * sizeof(int16_t) / (1024.0 * 1024.0);
+
+    printf("%-12s %8.1f MB/s  pop p50 %5llu ns  p99 %6llu ns  p99.9 %6llu ns  max %8llu ns  empty polls %llu\n",
+           impl->name, mbytes / secs,
+           (unsigned long long)percentile(hist, pops, 0.50),
+           (unsigned long long)percentile(hist, pops, 0.99),
+           (unsigned long long)percentile(hist, pops, 0.999),
+           (unsigned long long)max_ns,
+           (unsigned long long)empty);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1) chunks_total = atol(argv[1]);
+    while (chunks_total > 0 && (chunks_total * CHUNK_SAMPLES) % FRAME_SAMPLES) {
+        chunks_total--;
+    }
+    if (chunks_total <= 0) {
+        fprintf(stderr, "usage: %s [chunks]\n", argv[0]);
+        return 1;
+    }
+
+    ring = audio_ring_create(FIFO_CAPACITY * sizeof(int16_t));
+    if (!ring) {
+        fprintf(stderr, "ring allocation failed\n");
+        return 1;
+    }
+
+    printf("push %d samples x %ld, pop %d samples\n", CHUNK_SAMPLES, chunks_total, FRAME_SAMPLES);
+    for (size_t i = 0; i < sizeof(impls) / sizeof(impls[0]); i++) {
+        run(&impls[i]);
+    }
+
+    printf("ring overruns %llu, underruns %llu\n",
+           (unsigned long long)audio_ring_overruns(ring),
+           (unsigned long long)audio_ring_underruns(ring));
+
+    audio_ring_destroy(ring);
+    return 0;
+}